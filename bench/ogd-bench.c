@@ -0,0 +1,556 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <ogd.h>
+
+#include "ogd-mock-server.h"
+
+/*
+    Runs the most common paths of the library against the mock server, and for each one reports
+    objects handled per second, requests sent per logical operation, median and 99th percentile
+    latency of a logical operation, and peak resident memory of the process at the end of the
+    scenario
+*/
+
+typedef struct {
+    const gchar     *name;
+    GArray          *latencies;
+    guint           objects;
+    guint           operations;
+    guint           requests;
+    gdouble         elapsed;
+} BenchResult;
+
+typedef struct {
+    GMainLoop       *loop;
+    guint           objects;
+} AsyncState;
+
+static gint Scale           = 1;
+static gint Latency         = 0;
+static gdouble ErrorRate    = 0;
+static gint Seed            = 42;
+static gint Iterations      = 5;
+static gchar *RecordDir     = NULL;
+static gchar *ReplayDir     = NULL;
+static gdouble TimeScale    = 1;
+static gboolean IdentityMap = FALSE;
+
+static GOptionEntry Entries [] = {
+    { "scale", 's', 0, G_OPTION_ARG_INT, &Scale, "Multiplier for the number of items on the mock server", "N" },
+    { "latency", 'l', 0, G_OPTION_ARG_INT, &Latency, "Milliseconds waited by the mock server before each response", "MS" },
+    { "error-rate", 'e', 0, G_OPTION_ARG_DOUBLE, &ErrorRate, "Probability of each request to fail", "P" },
+    { "seed", 0, 0, G_OPTION_ARG_INT, &Seed, "Seed for error injection", "N" },
+    { "iterations", 'i', 0, G_OPTION_ARG_INT, &Iterations, "Logical operations performed for each scenario", "N" },
+    { "record", 0, 0, G_OPTION_ARG_FILENAME, &RecordDir, "Directory in which save the traffic of each scenario", "DIR" },
+    { "replay", 0, 0, G_OPTION_ARG_FILENAME, &ReplayDir, "Directory from which replay the traffic of each scenario", "DIR" },
+    { "time-scale", 't', 0, G_OPTION_ARG_DOUBLE, &TimeScale, "Factor applied to recorded timings when replaying", "F" },
+    { "identity-map", 0, 0, G_OPTION_ARG_NONE, &IdentityMap, "Enable the identity map of the providers", NULL },
+    { NULL }
+};
+
+static BenchResult* result_new (const gchar *name)
+{
+    BenchResult *result;
+
+    result = g_new0 (BenchResult, 1);
+    result->name = name;
+    result->latencies = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    return result;
+}
+
+static void result_free (BenchResult *result)
+{
+    g_array_free (result->latencies, TRUE);
+    g_free (result);
+}
+
+static gint compare_doubles (gconstpointer a, gconstpointer b)
+{
+    gdouble first;
+    gdouble second;
+
+    first = *((gdouble*) a);
+    second = *((gdouble*) b);
+    return (first > second) - (first < second);
+}
+
+static gdouble percentile (GArray *values, gdouble rank)
+{
+    if (values->len == 0)
+        return 0;
+
+    return g_array_index (values, gdouble, (guint) ((values->len - 1) * rank + 0.5));
+}
+
+static glong peak_rss ()
+{
+    struct rusage usage;
+
+    getrusage (RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void print_header ()
+{
+    printf ("%-18s %12s %10s %10s %10s %12s\n", "scenario", "objects/s", "req/op", "p50 ms", "p99 ms", "peak RSS KB");
+}
+
+static void print_result (BenchResult *result)
+{
+    g_array_sort (result->latencies, compare_doubles);
+
+    printf ("%-18s %12.1f %10.2f %10.2f %10.2f %12ld\n", result->name,
+            result->elapsed > 0 ? result->objects / result->elapsed : 0,
+            result->operations > 0 ? (gdouble) result->requests / result->operations : 0,
+            percentile (result->latencies, 0.5), percentile (result->latencies, 0.99), peak_rss ());
+}
+
+static void add_sample (BenchResult *result, GTimer *timer)
+{
+    gdouble ms;
+
+    ms = g_timer_elapsed (timer, NULL) * 1000;
+    g_array_append_val (result->latencies, ms);
+    result->elapsed += ms / 1000;
+    result->operations++;
+}
+
+static void free_objects (GList *list)
+{
+    GList *iter;
+
+    for (iter = list; iter; iter = g_list_next (iter))
+        g_object_unref (iter->data);
+
+    g_list_free (list);
+}
+
+static OGDCategory* first_category (OGDProvider *provider)
+{
+    GList *categories;
+    OGDCategory *ret;
+
+    categories = ogd_category_fetch_all (provider);
+    if (categories == NULL)
+        return NULL;
+
+    ret = g_object_ref (categories->data);
+    free_objects (categories);
+    return ret;
+}
+
+static void bench_iterator_sync (OGDProvider *provider, OGDMockServer *server, BenchResult *result)
+{
+    int i;
+    guint before;
+    GList *slice;
+    GTimer *timer;
+    OGDCategory *category;
+    OGDIterator *iterator;
+
+    category = first_category (provider);
+    if (category == NULL)
+        return;
+
+    timer = g_timer_new ();
+
+    for (i = 0; i < Iterations; i++) {
+        before = ogd_mock_server_get_requests (server);
+        g_timer_start (timer);
+
+        iterator = ogd_category_get_contents (category, OGD_CATEGORY_SORT_NEWEST);
+
+        while ((slice = ogd_iterator_fetch_next_slice (iterator)) != NULL) {
+            result->objects += g_list_length (slice);
+            free_objects (slice);
+        }
+
+        g_object_unref (iterator);
+
+        g_timer_stop (timer);
+        add_sample (result, timer);
+        result->requests += ogd_mock_server_get_requests (server) - before;
+    }
+
+    g_timer_destroy (timer);
+    g_object_unref (category);
+}
+
+static void count_async_object (OGDObject *obj, gpointer userdata)
+{
+    AsyncState *state;
+
+    state = (AsyncState*) userdata;
+
+    if (obj == NULL)
+        g_main_loop_quit (state->loop);
+    else
+        state->objects++;
+}
+
+static void bench_iterator_async (OGDProvider *provider, OGDMockServer *server, BenchResult *result)
+{
+    int i;
+    guint before;
+    GTimer *timer;
+    AsyncState state;
+    OGDCategory *category;
+    OGDIterator *iterator;
+
+    category = first_category (provider);
+    if (category == NULL)
+        return;
+
+    timer = g_timer_new ();
+    state.loop = g_main_loop_new (NULL, FALSE);
+
+    for (i = 0; i < Iterations; i++) {
+        state.objects = 0;
+        before = ogd_mock_server_get_requests (server);
+        g_timer_start (timer);
+
+        iterator = ogd_category_get_contents (category, OGD_CATEGORY_SORT_NEWEST);
+        ogd_iterator_fetch_async (iterator, count_async_object, &state);
+        g_main_loop_run (state.loop);
+        g_object_unref (iterator);
+
+        g_timer_stop (timer);
+        add_sample (result, timer);
+        result->objects += state.objects;
+        result->requests += ogd_mock_server_get_requests (server) - before;
+    }
+
+    g_main_loop_unref (state.loop);
+    g_timer_destroy (timer);
+    g_object_unref (category);
+}
+
+static OGDPerson* person_by_index (OGDProvider *provider, int index)
+{
+    gchar *id;
+    OGDPerson *person;
+
+    id = g_strdup_printf ("user%d", index);
+    person = g_object_new (OGD_PERSON_TYPE, NULL);
+    ogd_object_set_provider (OGD_OBJECT (person), provider);
+
+    if (ogd_object_fill_by_id (OGD_OBJECT (person), id, NULL) == FALSE) {
+        g_object_unref (person);
+        person = NULL;
+    }
+
+    g_free (id);
+    return person;
+}
+
+static void bench_people_sync (OGDProvider *provider, OGDMockServer *server, BenchResult *result)
+{
+    int i;
+    guint before;
+    GList *friends;
+    GTimer *timer;
+    OGDPerson *person;
+
+    timer = g_timer_new ();
+
+    for (i = 0; i < Iterations; i++) {
+        person = person_by_index (provider, i);
+        if (person == NULL)
+            continue;
+
+        before = ogd_mock_server_get_requests (server);
+        g_timer_start (timer);
+
+        friends = (GList*) ogd_person_get_friends (person);
+        result->objects += g_list_length (friends);
+        free_objects (friends);
+
+        g_timer_stop (timer);
+        add_sample (result, timer);
+        result->requests += ogd_mock_server_get_requests (server) - before;
+        g_object_unref (person);
+    }
+
+    g_timer_destroy (timer);
+}
+
+static void bench_people_async (OGDProvider *provider, OGDMockServer *server, BenchResult *result)
+{
+    int i;
+    guint before;
+    GTimer *timer;
+    AsyncState state;
+    OGDPerson *person;
+
+    timer = g_timer_new ();
+    state.loop = g_main_loop_new (NULL, FALSE);
+
+    for (i = 0; i < Iterations; i++) {
+        person = person_by_index (provider, i);
+        if (person == NULL)
+            continue;
+
+        state.objects = 0;
+        before = ogd_mock_server_get_requests (server);
+        g_timer_start (timer);
+
+        ogd_person_get_friends_async (person, count_async_object, &state);
+        g_main_loop_run (state.loop);
+
+        g_timer_stop (timer);
+        add_sample (result, timer);
+        result->objects += state.objects;
+        result->requests += ogd_mock_server_get_requests (server) - before;
+        g_object_unref (person);
+    }
+
+    g_main_loop_unref (state.loop);
+    g_timer_destroy (timer);
+}
+
+static void bench_save (OGDProvider *provider, OGDMockServer *server, BenchResult *result)
+{
+    int i;
+    guint before;
+    gchar *name;
+    GTimer *timer;
+    OGDContent *content;
+    OGDCategory *category;
+
+    category = first_category (provider);
+    if (category == NULL)
+        return;
+
+    timer = g_timer_new ();
+
+    /*
+        Each logical operation creates a content and then edits it, as an editor application
+        would do
+    */
+    for (i = 0; i < Iterations; i++) {
+        before = ogd_mock_server_get_requests (server);
+        g_timer_start (timer);
+
+        name = g_strdup_printf ("Bench content %d", i);
+        content = ogd_content_new (provider);
+        ogd_content_set_name (content, name);
+        ogd_content_set_category (content, category);
+        ogd_content_set_description (content, "Created by the benchmark suite");
+        ogd_content_save (content);
+
+        ogd_content_set_version (content, "1.1");
+        ogd_content_save (content);
+
+        g_object_unref (content);
+        g_free (name);
+
+        g_timer_stop (timer);
+        add_sample (result, timer);
+        result->objects += 1;
+        result->requests += ogd_mock_server_get_requests (server) - before;
+    }
+
+    g_timer_destroy (timer);
+    g_object_unref (category);
+}
+
+/*
+    Writes are sent to a port on which nobody is listening, so that each one fails and is saved in
+    the journal at @path
+*/
+static void fill_journal (const gchar *path, guint writes)
+{
+    guint i;
+    gchar *query;
+    GHashTable *data;
+    OGDProvider *offline;
+
+    offline = ogd_provider_new ("127.0.0.1:1");
+    ogd_provider_auth_user_and_pwd (offline, OGD_MOCK_SERVER_USER, OGD_MOCK_SERVER_USER);
+    ogd_provider_set_journal (offline, path, NULL, NULL, NULL);
+
+    data = g_hash_table_new (g_str_hash, g_str_equal);
+    g_hash_table_insert (data, "vote", "good");
+
+    for (i = 0; i < writes; i++) {
+        query = g_strdup_printf ("content/vote/%u", i + 1);
+        ogd_provider_put (offline, query, data);
+        g_free (query);
+    }
+
+    g_hash_table_unref (data);
+    g_object_unref (offline);
+}
+
+static void bench_journal_replay (OGDProvider *provider, OGDMockServer *server, BenchResult *result)
+{
+    int i;
+    guint before;
+    guint pending;
+    gchar *path;
+    gchar *filename;
+    GTimer *timer;
+
+    filename = g_strdup_printf ("ogd-bench-journal-%d", (int) getpid ());
+    path = g_build_filename (g_get_tmp_dir (), filename, NULL);
+    timer = g_timer_new ();
+
+    /*
+        Each logical operation sends a journal filled while offline, as an application coming back
+        online would do. Writes are counted as objects, so objects per second is the replay
+        throughput
+    */
+    for (i = 0; i < Iterations; i++) {
+        g_unlink (path);
+        fill_journal (path, Scale * 50);
+
+        if (ogd_provider_set_journal (provider, path, NULL, NULL, NULL) == FALSE)
+            break;
+
+        pending = ogd_provider_get_journal_length (provider);
+        before = ogd_mock_server_get_requests (server);
+        g_timer_start (timer);
+
+        ogd_provider_replay_journal (provider, NULL);
+
+        g_timer_stop (timer);
+        add_sample (result, timer);
+        result->objects += pending - ogd_provider_get_journal_length (provider);
+        result->requests += ogd_mock_server_get_requests (server) - before;
+
+        ogd_provider_set_journal (provider, NULL, NULL, NULL, NULL);
+    }
+
+    g_unlink (path);
+    g_timer_destroy (timer);
+    g_free (filename);
+    g_free (path);
+}
+
+/*
+    Each scenario has its own archive, named after it in the directory passed with --record or
+    --replay
+*/
+static gboolean setup_archive (OGDProvider *provider, const gchar *name)
+{
+    gboolean ret;
+    gchar *path;
+    gchar *filename;
+    GError *error;
+
+    if (RecordDir == NULL && ReplayDir == NULL)
+        return TRUE;
+
+    error = NULL;
+    filename = g_strdup_printf ("%s.archive", name);
+
+    if (ReplayDir != NULL) {
+        path = g_build_filename (ReplayDir, filename, NULL);
+        ret = ogd_provider_replay_traffic (provider, path, TimeScale, &error);
+    }
+    else {
+        path = g_build_filename (RecordDir, filename, NULL);
+        ret = ogd_provider_record_traffic (provider, path, &error);
+    }
+
+    if (ret == FALSE) {
+        printf ("%-18s %s\n", name, error->message);
+        g_error_free (error);
+    }
+
+    g_free (filename);
+    g_free (path);
+    return ret;
+}
+
+static void run_scenario (const gchar *name, OGDMockServer *server,
+                          void (*scenario) (OGDProvider *provider, OGDMockServer *server, BenchResult *result))
+{
+    BenchResult *result;
+    OGDProvider *provider;
+
+    /*
+        Each scenario uses a fresh provider, so no cache nor connection is shared among them
+    */
+    provider = ogd_provider_new ((gchar*) ogd_mock_server_get_address (server));
+    ogd_provider_auth_user_and_pwd (provider, OGD_MOCK_SERVER_USER, OGD_MOCK_SERVER_USER);
+    ogd_provider_set_identity_map (provider, IdentityMap);
+
+    if (setup_archive (provider, name) == FALSE) {
+        g_object_unref (provider);
+        return;
+    }
+
+    result = result_new (name);
+    scenario (provider, server, result);
+    print_result (result);
+
+    result_free (result);
+    g_object_unref (provider);
+}
+
+int main (int argc, char **argv)
+{
+    GError *error;
+    GOptionContext *options;
+    OGDMockServer *server;
+
+    g_type_init ();
+    g_thread_init (NULL);
+
+    error = NULL;
+    options = g_option_context_new ("- benchmark libopengdesktop against a local mock server");
+    g_option_context_add_main_entries (options, Entries, NULL);
+
+    if (g_option_context_parse (options, &argc, &argv, &error) == FALSE) {
+        printf ("%s\n", error->message);
+        g_error_free (error);
+        exit (1);
+    }
+
+    g_option_context_free (options);
+
+    server = ogd_mock_server_new (Scale, Latency, ErrorRate, Seed);
+    if (server == NULL)
+        exit (1);
+
+    printf ("mock server on %s: scale %d, latency %d ms, error rate %.3f, seed %d, %d iterations\n",
+            ogd_mock_server_get_address (server), Scale, Latency, ErrorRate, Seed, Iterations);
+
+    /*
+        When replaying the mock server is not contacted, so requests per operation are not counted
+    */
+    if (ReplayDir != NULL)
+        printf ("replaying traffic from %s, time scale %.2f\n", ReplayDir, TimeScale);
+
+    printf ("\n");
+
+    print_header ();
+    run_scenario ("iterator-sync", server, bench_iterator_sync);
+    run_scenario ("iterator-async", server, bench_iterator_async);
+    run_scenario ("people-list-sync", server, bench_people_sync);
+    run_scenario ("people-list-async", server, bench_people_async);
+    run_scenario ("content-save", server, bench_save);
+    run_scenario ("journal-replay", server, bench_journal_replay);
+
+    ogd_mock_server_free (server);
+    exit (0);
+}
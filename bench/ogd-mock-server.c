@@ -0,0 +1,767 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <libsoup/soup.h>
+
+#include "ogd-mock-server.h"
+
+/*
+    An in-process stand-in for an Open Collaboration Services provider. It runs in its own thread
+    with its own main context, so that sync requests from the library (which block the calling
+    thread) are served as well as async ones. All data are synthetic and derived from the ID of
+    each item, so two runs with the same parameters always produce the same responses; the only
+    randomness is in error injection, driven by a GRand with explicit seed
+*/
+
+#define DEFAULT_PAGESIZE            10
+#define CATEGORIES                  10
+#define FOLDERS                     3
+
+struct _OGDMockServer {
+    SoupServer      *soup;
+    GMainContext    *context;
+    GMainLoop       *loop;
+    GThread         *thread;
+    gchar           *address;
+
+    guint           contents;
+    guint           persons;
+    guint           events;
+    guint           messages;
+    guint           friends;
+    guint           fans;
+    guint           comments;
+    guint           activities;
+
+    guint           latency;
+    gdouble         error_rate;
+    GRand           *rand;
+
+    volatile gint   requests;
+    volatile gint   next_id;
+
+    GMutex          *repeats_lock;
+    GHashTable      *repeats;
+
+    gdouble         throttle_rate;
+    guint           retry_after;
+    GTimer          *clock;
+    GHashTable      *throttled;
+    volatile gint   throttles;
+    volatile gint   early_retries;
+};
+
+typedef struct {
+    SoupServer      *soup;
+    SoupMessage     *msg;
+} DelayedResponse;
+
+static const gchar *EventCategories [] = {
+    "Party", "User Group", "Conference", "Developer Meeting", "Install Party", "otherParty"
+};
+
+static const gchar *FolderTypes [] = {
+    "inbox", "send", "trash"
+};
+
+static void append_date (GString *xml, const gchar *tag, guint id)
+{
+    g_string_append_printf (xml, "<%s>20%02u-%02u-%02uT%02u:%02u:00+00:00</%s>",
+                            tag, 5 + (id % 6), 1 + (id % 12), 1 + (id % 28), id % 24, id % 60, tag);
+}
+
+static void append_content (OGDMockServer *server, GString *xml, guint id)
+{
+    g_string_append_printf (xml, "<content><id>%u</id><typeid>%u</typeid><name>Content %u</name>"
+                            "<version>%u.%u</version><language>en</language><personid>user%u</personid>",
+                            id, 1 + (id % CATEGORIES), id, id % 5, id % 10, id % server->persons);
+    append_date (xml, "created", id);
+    append_date (xml, "changed", id + 7);
+    g_string_append_printf (xml, "<downloads>%u</downloads><score>%u</score>"
+                            "<description>Synthetic content number %u, generated by the mock server to "
+                            "exercise the parser with a description of realistic length.</description>"
+                            "<changelog>Version %u.%u: fixed things</changelog>"
+                            "<detailpage>http://example.org/content/show.php?content=%u</detailpage>"
+                            "<comments>%u</comments><fans>%u</fans></content>",
+                            id * 7, id % 100, id, id % 5, id % 10, id, id % 13, server->fans);
+}
+
+static void append_person (OGDMockServer *server, GString *xml, const gchar *id)
+{
+    guint num;
+
+    num = (guint) strtoul (id + strcspn (id, "0123456789"), NULL, 10);
+
+    g_string_append_printf (xml, "<person><personid>%s</personid><privacy>0</privacy>"
+                            "<firstname>First%u</firstname><lastname>Last%u</lastname>"
+                            "<gender>%s</gender><communityrole>user</communityrole>"
+                            "<homepage>http://example.org/~%s</homepage><company>Company %u</company>"
+                            "<bigavatarpic>http://example.org/avatar/%s.png</bigavatarpic>",
+                            id, num, num, (num % 2) ? "man" : "woman", id, num % 50, id);
+    append_date (xml, "birthday", num);
+    g_string_append_printf (xml, "<jobstatus>working</jobstatus><city>City %u</city><country>Country %u</country>"
+                            "<latitude>%.4f</latitude><longitude>%.4f</longitude>"
+                            "<likes>things</likes><dontlikes>other things</dontlikes>"
+                            "<interests>free software</interests><languages>en</languages>"
+                            "<description>Synthetic person %s</description></person>",
+                            num % 100, num % 30, ((gdouble) (num % 1800) / 10) - 90,
+                            ((gdouble) (num % 3600) / 10) - 180, id);
+}
+
+static void append_person_id (GString *xml, guint num)
+{
+    g_string_append_printf (xml, "<person><personid>user%u</personid></person>", num);
+}
+
+static void append_event (GString *xml, guint id)
+{
+    g_string_append_printf (xml, "<event><id>%u</id><name>Event %u</name>"
+                            "<description>Synthetic event number %u</description><category>%s</category>",
+                            id, id, id, EventCategories [id % G_N_ELEMENTS (EventCategories)]);
+    append_date (xml, "startdate", id);
+    append_date (xml, "enddate", id + 1);
+    g_string_append_printf (xml, "<user>user%u</user><organizer>Organizer %u</organizer>"
+                            "<location>Place %u</location><city>City %u</city><country>Country %u</country>"
+                            "<latitude>%.4f</latitude><longitude>%.4f</longitude>"
+                            "<homepage>http://example.org/event/%u</homepage><tel>555%04u</tel>"
+                            "<fax>556%04u</fax><email>event%u@example.org</email>",
+                            id % 50, id, id, id % 100, id % 30, ((gdouble) (id % 1800) / 10) - 90,
+                            ((gdouble) (id % 3600) / 10) - 180, id, id, id, id);
+    append_date (xml, "changed", id + 3);
+    g_string_append_printf (xml, "<comments>%u</comments><partecipants>%u</partecipants>"
+                            "<image>http://example.org/event/%u.png</image></event>",
+                            id % 11, id % 40, id);
+}
+
+static void append_message (GString *xml, guint id)
+{
+    g_string_append_printf (xml, "<message><messageid>%u</messageid><messagefrom>user%u</messagefrom>",
+                            id, id % 50);
+    append_date (xml, "senddate", id);
+    g_string_append_printf (xml, "<status>%u</status><subject>Subject %u</subject>"
+                            "<body>Body of synthetic message number %u</body></message>",
+                            id % 2, id, id);
+}
+
+/*
+    Each comment has two answers, each one with an answer on its own
+*/
+static void append_comment (GString *xml, guint id, guint depth)
+{
+    guint i;
+
+    g_string_append_printf (xml, "<comment><id>%u</id><subject>Subject %u</subject>"
+                            "<text>Text of synthetic comment number %u</text><user>user%u</user>",
+                            id, id, id, id % 50);
+    append_date (xml, "date", id);
+
+    if (depth < 2) {
+        g_string_append (xml, "<childs>");
+
+        for (i = 0; i < (depth == 0 ? 2 : 1); i++)
+            append_comment (xml, (id * 10) + i + 1, depth + 1);
+
+        g_string_append (xml, "</childs>");
+    }
+
+    g_string_append (xml, "</comment>");
+}
+
+static void append_activity (GString *xml, guint id)
+{
+    g_string_append_printf (xml, "<activity><personid>user%u</personid>", id % 50);
+    append_date (xml, "timestamp", id);
+    g_string_append_printf (xml, "<type>%u</type><message>Synthetic activity number %u</message>"
+                            "<link>http://example.org/activity/%u</link></activity>",
+                            id % 12, id, id);
+}
+
+static void append_category (GString *xml, guint id)
+{
+    g_string_append_printf (xml, "<category><id>%u</id><name>Category %u</name></category>", id, id);
+}
+
+static void append_folder (OGDMockServer *server, GString *xml, guint id)
+{
+    g_string_append_printf (xml, "<folder><id>%u</id><name>%s</name><messagecount>%u</messagecount>"
+                            "<type>%s</type></folder>",
+                            id, FolderTypes [id], server->messages, FolderTypes [id]);
+}
+
+static void open_response (GString *xml, guint total, guint pagesize)
+{
+    g_string_append (xml, "<?xml version=\"1.0\"?><ocs><meta><status>ok</status>"
+                     "<statuscode>100</statuscode><message></message>");
+    g_string_append_printf (xml, "<totalitems>%u</totalitems><itemsperpage>%u</itemsperpage></meta><data>",
+                            total, pagesize);
+}
+
+static void close_response (GString *xml)
+{
+    g_string_append (xml, "</data></ocs>");
+}
+
+/*
+    Fills xml with the requested page of a list of given type. Returns FALSE if the type is not
+    handled
+*/
+static gboolean build_list (OGDMockServer *server, GString *xml, const gchar *type, const gchar *owner,
+                            guint page, guint pagesize)
+{
+    guint i;
+    guint total;
+    guint first;
+    guint last;
+    gchar *id;
+
+    if (strcmp (type, "content") == 0)
+        total = server->contents;
+    else if (strcmp (type, "person") == 0)
+        total = server->persons;
+    else if (strcmp (type, "event") == 0)
+        total = server->events;
+    else if (strcmp (type, "message") == 0)
+        total = server->messages;
+    else if (strcmp (type, "category") == 0)
+        total = CATEGORIES;
+    else if (strcmp (type, "folder") == 0)
+        total = FOLDERS;
+    else if (strcmp (type, "friend") == 0)
+        total = server->friends;
+    else if (strcmp (type, "fan") == 0)
+        total = server->fans;
+    else if (strcmp (type, "comment") == 0)
+        total = server->comments;
+    else if (strcmp (type, "activity") == 0)
+        total = server->activities;
+    else
+        return FALSE;
+
+    if (pagesize == 0)
+        pagesize = DEFAULT_PAGESIZE;
+
+    first = page * pagesize;
+    last = MIN (first + pagesize, total);
+    open_response (xml, total, pagesize);
+
+    for (i = first; i < last; i++) {
+        if (strcmp (type, "content") == 0) {
+            append_content (server, xml, i + 1);
+        }
+        else if (strcmp (type, "person") == 0) {
+            id = g_strdup_printf ("user%u", i);
+            append_person (server, xml, id);
+            g_free (id);
+        }
+        else if (strcmp (type, "event") == 0) {
+            append_event (xml, i + 1);
+        }
+        else if (strcmp (type, "message") == 0) {
+            append_message (xml, i + 1);
+        }
+        else if (strcmp (type, "category") == 0) {
+            append_category (xml, i + 1);
+        }
+        else if (strcmp (type, "folder") == 0) {
+            append_folder (server, xml, i);
+        }
+        else if (strcmp (type, "comment") == 0) {
+            append_comment (xml, i + 1, 0);
+        }
+        else if (strcmp (type, "activity") == 0) {
+            append_activity (xml, i + 1);
+        }
+        else {
+            /*
+                Friends and fans of an item are a window over all persons, starting from a point
+                which depends on the owner
+            */
+            append_person_id (xml, (g_str_hash (owner) + i) % server->persons);
+        }
+    }
+
+    close_response (xml);
+    return TRUE;
+}
+
+static void build_single (OGDMockServer *server, GString *xml, const gchar *type, const gchar *id)
+{
+    open_response (xml, 1, 1);
+
+    if (strcmp (type, "content") == 0)
+        append_content (server, xml, (guint) strtoul (id, NULL, 10));
+    else if (strcmp (type, "person") == 0)
+        append_person (server, xml, id);
+    else if (strcmp (type, "event") == 0)
+        append_event (xml, (guint) strtoul (id, NULL, 10));
+
+    close_response (xml);
+}
+
+static void build_empty (GString *xml)
+{
+    open_response (xml, 0, 0);
+    close_response (xml);
+}
+
+static void build_created (OGDMockServer *server, GString *xml, const gchar *type)
+{
+    open_response (xml, 1, 1);
+    g_string_append_printf (xml, "<%s><id>%d</id></%s>", type, g_atomic_int_exchange_and_add (&(server->next_id), 1), type);
+    close_response (xml);
+}
+
+static guint query_param (GHashTable *query, const gchar *name, guint fallback)
+{
+    const gchar *value;
+
+    if (query == NULL)
+        return fallback;
+
+    value = g_hash_table_lookup (query, name);
+    if (value == NULL)
+        return fallback;
+    else
+        return (guint) strtoul (value, NULL, 10);
+}
+
+/*
+    Maps the OCS query on synthetic data. Returns FALSE if the path is not handled
+*/
+static gboolean route_request (OGDMockServer *server, gchar **parts, GHashTable *query, GString *xml)
+{
+    guint page;
+    guint pagesize;
+    guint n;
+
+    page = query_param (query, "page", 0);
+    pagesize = query_param (query, "pagesize", DEFAULT_PAGESIZE);
+
+    for (n = 0; parts [n] != NULL; n++);
+
+    if (n == 0)
+        return FALSE;
+
+    if (strcmp (parts [0], "person") == 0) {
+        if (n == 2 && strcmp (parts [1], "self") == 0)
+            build_single (server, xml, "person", OGD_MOCK_SERVER_USER);
+        else if (n == 3 && strcmp (parts [1], "data") == 0)
+            build_single (server, xml, "person", parts [2]);
+        else if (n == 2 && strcmp (parts [1], "data") == 0)
+            build_list (server, xml, "person", NULL, page, pagesize);
+        else
+            return FALSE;
+    }
+    else if (strcmp (parts [0], "content") == 0) {
+        if (n == 2 && strcmp (parts [1], "categories") == 0)
+            build_list (server, xml, "category", NULL, 0, CATEGORIES);
+        else if (n == 2 && strcmp (parts [1], "data") == 0)
+            build_list (server, xml, "content", NULL, page, pagesize);
+        else if (n == 3 && strcmp (parts [1], "data") == 0)
+            build_single (server, xml, "content", parts [2]);
+        else if (n == 2 && strcmp (parts [1], "add") == 0)
+            build_created (server, xml, "content");
+        else if (n == 3)
+            build_empty (xml);
+        else
+            return FALSE;
+    }
+    else if (strcmp (parts [0], "event") == 0) {
+        if (n == 2 && strcmp (parts [1], "data") == 0)
+            build_list (server, xml, "event", NULL, page, pagesize);
+        else if (n == 3 && strcmp (parts [1], "data") == 0)
+            build_single (server, xml, "event", parts [2]);
+        else if (n == 2 && strcmp (parts [1], "add") == 0)
+            build_created (server, xml, "event");
+        else if (n == 3)
+            build_empty (xml);
+        else
+            return FALSE;
+    }
+    else if (strcmp (parts [0], "friend") == 0 || strcmp (parts [0], "fan") == 0) {
+        if (n == 3 && strcmp (parts [1], "data") == 0)
+            build_list (server, xml, parts [0], parts [2], page, pagesize);
+        else if (n == 3)
+            build_empty (xml);
+        else
+            return FALSE;
+    }
+    else if (strcmp (parts [0], "comments") == 0) {
+        if (n >= 3 && strcmp (parts [1], "data") == 0)
+            build_list (server, xml, "comment", NULL, page, pagesize);
+        else if (n == 2 && strcmp (parts [1], "add") == 0)
+            build_created (server, xml, "comment");
+        else
+            return FALSE;
+    }
+    else if (strcmp (parts [0], "activity") == 0) {
+        if (n == 1)
+            build_list (server, xml, "activity", NULL, page, pagesize);
+        else
+            return FALSE;
+    }
+    else if (strcmp (parts [0], "message") == 0) {
+        if (n == 1)
+            build_list (server, xml, "folder", NULL, 0, FOLDERS);
+        else if (n == 2)
+            build_list (server, xml, "message", NULL, page, pagesize);
+        else
+            return FALSE;
+    }
+    else {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean send_delayed_response (gpointer userdata)
+{
+    DelayedResponse *delayed;
+
+    delayed = (DelayedResponse*) userdata;
+    soup_server_unpause_message (delayed->soup, delayed->msg);
+    g_free (delayed);
+    return FALSE;
+}
+
+static gchar* request_key (SoupMessage *msg)
+{
+    gchar *uri;
+    gchar *key;
+    SoupBuffer *body;
+
+    uri = soup_uri_to_string (soup_message_get_uri (msg), TRUE);
+    body = soup_message_body_flatten (msg->request_body);
+    key = g_strdup_printf ("%s %s %.*s", msg->method, uri, (int) body->length, body->data);
+    soup_buffer_free (body);
+    g_free (uri);
+    return key;
+}
+
+/*
+    Identical requests (same method, URI and body) are counted, to verify how many times the
+    library sent again the same request
+*/
+static void count_repeat (OGDMockServer *server, const gchar *key)
+{
+    guint count;
+
+    g_mutex_lock (server->repeats_lock);
+    count = GPOINTER_TO_UINT (g_hash_table_lookup (server->repeats, key));
+    g_hash_table_insert (server->repeats, g_strdup (key), GUINT_TO_POINTER (count + 1));
+    g_mutex_unlock (server->repeats_lock);
+}
+
+/*
+    A request sent again after being throttled is early if it arrives before the time given with
+    Retry-After. Only accessed by the thread of the server
+*/
+static void check_throttled_retry (OGDMockServer *server, const gchar *key)
+{
+    gdouble *when;
+
+    when = g_hash_table_lookup (server->throttled, key);
+    if (when == NULL)
+        return;
+
+    if (g_timer_elapsed (server->clock, NULL) < *when)
+        g_atomic_int_inc (&(server->early_retries));
+
+    g_hash_table_remove (server->throttled, key);
+}
+
+static void throttle (OGDMockServer *server, SoupMessage *msg, const gchar *key)
+{
+    gchar *value;
+    gdouble *when;
+
+    when = g_new (gdouble, 1);
+    *when = g_timer_elapsed (server->clock, NULL) + server->retry_after;
+    g_hash_table_insert (server->throttled, g_strdup (key), when);
+    g_atomic_int_inc (&(server->throttles));
+
+    value = g_strdup_printf ("%u", server->retry_after);
+    soup_message_set_status (msg, 429);
+    soup_message_headers_replace (msg->response_headers, "Retry-After", value);
+    g_free (value);
+}
+
+static void handle_request (SoupServer *soup, SoupMessage *msg, const char *path, GHashTable *query,
+                            SoupClientContext *client, gpointer userdata)
+{
+    gchar **parts;
+    gchar *key;
+    GString *xml;
+    GSource *source;
+    OGDMockServer *server;
+    DelayedResponse *delayed;
+
+    server = (OGDMockServer*) userdata;
+    g_atomic_int_inc (&(server->requests));
+
+    key = request_key (msg);
+    count_repeat (server, key);
+    check_throttled_retry (server, key);
+
+    if (server->throttle_rate > 0 && g_rand_double (server->rand) < server->throttle_rate) {
+        throttle (server, msg, key);
+    }
+    else if (server->error_rate > 0 && g_rand_double (server->rand) < server->error_rate) {
+        soup_message_set_status (msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+    }
+    else {
+        /*
+            Paths are in the form /v1/<query>
+        */
+        parts = g_strsplit (path + strlen ("/v1/"), "/", -1);
+        xml = g_string_new (NULL);
+
+        if (route_request (server, parts, query, xml) == TRUE) {
+            soup_message_set_status (msg, SOUP_STATUS_OK);
+            soup_message_set_response (msg, "text/xml", SOUP_MEMORY_TAKE, xml->str, xml->len);
+            g_string_free (xml, FALSE);
+        }
+        else {
+            soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+            g_string_free (xml, TRUE);
+        }
+
+        g_strfreev (parts);
+    }
+
+    g_free (key);
+
+    if (server->latency != 0) {
+        delayed = g_new0 (DelayedResponse, 1);
+        delayed->soup = soup;
+        delayed->msg = msg;
+        soup_server_pause_message (soup, msg);
+
+        source = g_timeout_source_new (server->latency);
+        g_source_set_callback (source, send_delayed_response, delayed, NULL);
+        g_source_attach (source, server->context);
+        g_source_unref (source);
+    }
+}
+
+static gpointer run_server (gpointer userdata)
+{
+    OGDMockServer *server;
+
+    server = (OGDMockServer*) userdata;
+    g_main_loop_run (server->loop);
+    return NULL;
+}
+
+static void init_data (OGDMockServer *server, guint scale)
+{
+    scale = MAX (scale, 1);
+
+    server->contents = 100 * scale;
+    server->persons = 50 * scale;
+    server->events = 20 * scale;
+    server->messages = 20 * scale;
+    server->friends = 5 * scale;
+    server->fans = 5 * scale;
+    server->comments = 10 * scale;
+    server->activities = 50 * scale;
+}
+
+/*
+    Params:
+        scale:      multiplier for the number of items served: each unit is 100 contents, 50
+                    persons, 20 events, 20 messages per folder, 5 friends per person, 5 fans per
+                    content, 10 comment threads (of 5 comments each) and 50 activities
+        latency:    milliseconds waited before sending each response
+        error_rate: probability (between 0 and 1) for each request to fail with status 500
+        seed:       seed for the error injection
+*/
+OGDMockServer* ogd_mock_server_new (guint scale, guint latency, gdouble error_rate, guint32 seed)
+{
+    OGDMockServer *server;
+
+    server = g_new0 (OGDMockServer, 1);
+    init_data (server, scale);
+    server->latency = latency;
+    server->error_rate = error_rate;
+    server->rand = g_rand_new_with_seed (seed);
+    server->next_id = server->contents + 1;
+    server->repeats_lock = g_mutex_new ();
+    server->repeats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    server->clock = g_timer_new ();
+    server->throttled = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    server->context = g_main_context_new ();
+    server->loop = g_main_loop_new (server->context, FALSE);
+
+    server->soup = soup_server_new (SOUP_SERVER_PORT, 0, SOUP_SERVER_ASYNC_CONTEXT, server->context, NULL);
+    if (server->soup == NULL) {
+        g_warning ("Unable to start mock server");
+        ogd_mock_server_free (server);
+        return NULL;
+    }
+
+    soup_server_add_handler (server->soup, "/v1", handle_request, server, NULL);
+    soup_server_run_async (server->soup);
+    server->address = g_strdup_printf ("127.0.0.1:%u", soup_server_get_port (server->soup));
+
+    server->thread = g_thread_create (run_server, server, TRUE, NULL);
+    return server;
+}
+
+void ogd_mock_server_free (OGDMockServer *server)
+{
+    if (server->thread != NULL) {
+        g_main_loop_quit (server->loop);
+        g_thread_join (server->thread);
+    }
+
+    if (server->soup != NULL) {
+        soup_server_quit (server->soup);
+        g_object_unref (server->soup);
+    }
+
+    g_main_loop_unref (server->loop);
+    g_main_context_unref (server->context);
+    g_hash_table_destroy (server->repeats);
+    g_mutex_free (server->repeats_lock);
+    g_hash_table_destroy (server->throttled);
+    g_timer_destroy (server->clock);
+    g_rand_free (server->rand);
+    g_free (server->address);
+    g_free (server);
+}
+
+/*
+    Host and port to use in ogd_provider_new()
+*/
+const gchar* ogd_mock_server_get_address (OGDMockServer *server)
+{
+    return server->address;
+}
+
+/*
+    Number of requests received so far, including failed ones
+*/
+guint ogd_mock_server_get_requests (OGDMockServer *server)
+{
+    return (guint) g_atomic_int_get (&(server->requests));
+}
+
+/*
+    Highest number of times a single request with the given method ("GET" or "POST") has been
+    received since the server started or since the last ogd_mock_server_reset_repeats(). 0 if no
+    request with that method has been received
+*/
+guint ogd_mock_server_get_max_repeats (OGDMockServer *server, const gchar *method)
+{
+    guint ret;
+    gsize len;
+    gpointer key;
+    gpointer value;
+    GHashTableIter iter;
+
+    ret = 0;
+    len = strlen (method);
+
+    g_mutex_lock (server->repeats_lock);
+    g_hash_table_iter_init (&iter, server->repeats);
+
+    while (g_hash_table_iter_next (&iter, &key, &value))
+        if (strncmp (key, method, len) == 0 && ((gchar*) key) [len] == ' ')
+            ret = MAX (ret, GPOINTER_TO_UINT (value));
+
+    g_mutex_unlock (server->repeats_lock);
+    return ret;
+}
+
+void ogd_mock_server_reset_repeats (OGDMockServer *server)
+{
+    g_mutex_lock (server->repeats_lock);
+    g_hash_table_remove_all (server->repeats);
+    g_mutex_unlock (server->repeats_lock);
+}
+
+/*
+    Params:
+        rate:           probability (between 0 and 1) for each request to be refused with status
+                        429, before the error injection
+        retry_after:    seconds suggested in the Retry-After header of those responses
+
+    To be called while no request is running. A throttled request sent again before the time
+    suggested is counted by ogd_mock_server_get_early_retries()
+*/
+void ogd_mock_server_set_throttling (OGDMockServer *server, gdouble rate, guint retry_after)
+{
+    server->throttle_rate = rate;
+    server->retry_after = retry_after;
+}
+
+guint ogd_mock_server_get_throttles (OGDMockServer *server)
+{
+    return (guint) g_atomic_int_get (&(server->throttles));
+}
+
+guint ogd_mock_server_get_early_retries (OGDMockServer *server)
+{
+    return (guint) g_atomic_int_get (&(server->early_retries));
+}
+
+guint ogd_mock_server_get_contents (OGDMockServer *server)
+{
+    return server->contents;
+}
+
+guint ogd_mock_server_get_persons (OGDMockServer *server)
+{
+    return server->persons;
+}
+
+guint ogd_mock_server_get_events (OGDMockServer *server)
+{
+    return server->events;
+}
+
+guint ogd_mock_server_get_friends (OGDMockServer *server)
+{
+    return server->friends;
+}
+
+/*
+    Builds the same OCS document a mock server of given scale would send for a page of the given
+    type ("content", "person", "event", "message", "comment", "activity", "category" or "folder"),
+    without any server running. Returns NULL for unknown types
+*/
+gchar* ogd_mock_server_build_page (guint scale, const gchar *type, guint page, guint pagesize)
+{
+    GString *xml;
+    OGDMockServer data;
+
+    memset (&data, 0, sizeof (OGDMockServer));
+    init_data (&data, scale);
+    xml = g_string_new (NULL);
+
+    if (build_list (&data, xml, type, "", page, pagesize) == FALSE) {
+        g_string_free (xml, TRUE);
+        return NULL;
+    }
+
+    return g_string_free (xml, FALSE);
+}
@@ -0,0 +1,49 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_MOCK_SERVER_H
+#define OGD_MOCK_SERVER_H
+
+#include <glib.h>
+
+/*
+    Username of the person returned by "person/self", and author of the contents created on
+    the mock server
+*/
+#define OGD_MOCK_SERVER_USER        "bench"
+
+typedef struct _OGDMockServer OGDMockServer;
+
+OGDMockServer*  ogd_mock_server_new                 (guint scale, guint latency, gdouble error_rate, guint32 seed);
+void            ogd_mock_server_free                (OGDMockServer *server);
+
+const gchar*    ogd_mock_server_get_address         (OGDMockServer *server);
+guint           ogd_mock_server_get_requests        (OGDMockServer *server);
+guint           ogd_mock_server_get_max_repeats     (OGDMockServer *server, const gchar *method);
+void            ogd_mock_server_reset_repeats       (OGDMockServer *server);
+void            ogd_mock_server_set_throttling      (OGDMockServer *server, gdouble rate, guint retry_after);
+guint           ogd_mock_server_get_throttles       (OGDMockServer *server);
+guint           ogd_mock_server_get_early_retries   (OGDMockServer *server);
+
+guint           ogd_mock_server_get_contents        (OGDMockServer *server);
+guint           ogd_mock_server_get_persons         (OGDMockServer *server);
+guint           ogd_mock_server_get_events          (OGDMockServer *server);
+guint           ogd_mock_server_get_friends         (OGDMockServer *server);
+
+gchar*          ogd_mock_server_build_page          (guint scale, const gchar *type, guint page, guint pagesize);
+
+#endif /* OGD_MOCK_SERVER_H */
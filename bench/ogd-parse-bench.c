@@ -0,0 +1,353 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ogd.h>
+#include <ogd-provider-private.h>
+
+#include "ogd-mock-server.h"
+
+/*
+    Measures the parsing layer alone: the same OCS pages are passed again and again to the code
+    used for responses from the server, which parses the XML and builds objects with their
+    fill_by_xml(). Pages are generated as the mock server would send them, or read from files
+    previously recorded (named <type>.xml in the directory passed with --data).
+    All allocations performed by GLib and libxml2 are counted, to report how many are required
+    for each object and how much memory remains held by objects once the XML is freed
+*/
+
+#define HEADER_SIZE         16
+
+static const gchar *Types [] = {
+    "content", "person", "event", "comment", "activity", "message"
+};
+
+static gint Rounds          = 50;
+static gint PageSize        = 100;
+static gint Scale           = 10;
+static gchar *DataDir       = NULL;
+static gboolean Arena       = FALSE;
+
+static GOptionEntry Entries [] = {
+    { "rounds", 'r', 0, G_OPTION_ARG_INT, &Rounds, "Times each page is parsed", "N" },
+    { "pagesize", 'p', 0, G_OPTION_ARG_INT, &PageSize, "Items in each generated page", "N" },
+    { "scale", 's', 0, G_OPTION_ARG_INT, &Scale, "Scale of the generated data set", "N" },
+    { "data", 'd', 0, G_OPTION_ARG_FILENAME, &DataDir, "Directory with recorded pages, named <type>.xml", "DIR" },
+    { "arena", 'a', 0, G_OPTION_ARG_NONE, &Arena, "Allocate fields of objects from an arena for each page", NULL },
+    { NULL }
+};
+
+static guint64 Allocations  = 0;
+static gint64 LiveBytes     = 0;
+
+/*
+    Each block is prefixed by an header keeping its size, so the amount of memory still allocated
+    is always known
+*/
+
+static gpointer counting_malloc (gsize size)
+{
+    gchar *block;
+
+    block = malloc (size + HEADER_SIZE);
+    if (block == NULL)
+        return NULL;
+
+    *((gsize*) block) = size;
+    Allocations++;
+    LiveBytes += size;
+    return block + HEADER_SIZE;
+}
+
+static void counting_free (gpointer mem)
+{
+    gchar *block;
+
+    if (mem == NULL)
+        return;
+
+    block = ((gchar*) mem) - HEADER_SIZE;
+    LiveBytes -= *((gsize*) block);
+    free (block);
+}
+
+static gpointer counting_realloc (gpointer mem, gsize size)
+{
+    gchar *block;
+
+    if (mem == NULL)
+        return counting_malloc (size);
+
+    block = ((gchar*) mem) - HEADER_SIZE;
+    LiveBytes -= *((gsize*) block);
+
+    block = realloc (block, size + HEADER_SIZE);
+    if (block == NULL)
+        return NULL;
+
+    *((gsize*) block) = size;
+    Allocations++;
+    LiveBytes += size;
+    return block + HEADER_SIZE;
+}
+
+static gpointer counting_calloc (gsize n_blocks, gsize size)
+{
+    gpointer mem;
+
+    mem = counting_malloc (n_blocks * size);
+    if (mem != NULL)
+        memset (mem, 0, n_blocks * size);
+
+    return mem;
+}
+
+static char* counting_strdup (const char *str)
+{
+    gsize len;
+    char *ret;
+
+    len = strlen (str) + 1;
+    ret = counting_malloc (len);
+    if (ret != NULL)
+        memcpy (ret, str, len);
+
+    return ret;
+}
+
+static GMemVTable CountingVTable = {
+    counting_malloc,
+    counting_realloc,
+    counting_free,
+    counting_calloc,
+    counting_malloc,
+    counting_realloc
+};
+
+static void install_counting_allocator ()
+{
+    /*
+        GSlice keeps its own pools, which would hide allocations of GObjects
+    */
+    setenv ("G_SLICE", "always-malloc", 1);
+    g_mem_set_vtable (&CountingVTable);
+    xmlMemSetup (counting_free, counting_malloc, counting_realloc, counting_strdup);
+}
+
+static guint count_objects (GList *list)
+{
+    guint ret;
+    GList *iter;
+
+    for (iter = list, ret = 0; iter; iter = g_list_next (iter)) {
+        ret++;
+
+        if (IS_OGD_COMMENT (iter->data))
+            ret += count_objects ((GList*) ogd_comment_get_children (OGD_COMMENT (iter->data)));
+    }
+
+    return ret;
+}
+
+static void free_objects (GList *list)
+{
+    GList *iter;
+
+    for (iter = list; iter; iter = g_list_next (iter))
+        g_object_unref (iter->data);
+
+    g_list_free (list);
+}
+
+static gchar* load_page (const gchar *type, gsize *length)
+{
+    gchar *path;
+    gchar *name;
+    gchar *ret;
+    GError *error;
+
+    if (DataDir == NULL) {
+        ret = ogd_mock_server_build_page (Scale, type, 0, PageSize);
+        *length = strlen (ret);
+        return ret;
+    }
+
+    error = NULL;
+    name = g_strdup_printf ("%s.xml", type);
+    path = g_build_filename (DataDir, name, NULL);
+
+    if (g_file_get_contents (path, &ret, length, &error) == FALSE) {
+        g_warning ("Unable to read %s: %s", path, error->message);
+        g_error_free (error);
+        ret = NULL;
+    }
+
+    g_free (name);
+    g_free (path);
+    return ret;
+}
+
+static void bench_type (OGDProvider *provider, const gchar *type)
+{
+    int i;
+    gsize length;
+    guint objects;
+    guint64 allocations;
+    gint64 retained;
+    gdouble elapsed;
+    gchar *page;
+    GList *list;
+    GTimer *timer;
+
+    page = load_page (type, &length);
+    if (page == NULL)
+        return;
+
+    /*
+        A first round out of timing, to check the page and to measure memory held by objects
+    */
+    allocations = Allocations;
+    retained = LiveBytes;
+
+    list = ogd_provider_parse_objects (provider, page, length, NULL);
+    objects = count_objects (list);
+
+    allocations = Allocations - allocations;
+    retained = LiveBytes - retained;
+    free_objects (list);
+
+    if (objects == 0) {
+        printf ("%-10s no objects parsed\n", type);
+        g_free (page);
+        return;
+    }
+
+    timer = g_timer_new ();
+
+    for (i = 0; i < Rounds; i++) {
+        list = ogd_provider_parse_objects (provider, page, length, NULL);
+        free_objects (list);
+    }
+
+    g_timer_stop (timer);
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    printf ("%-10s %8u %12.1f %12.1f %12.1f %12.1f\n", type, objects,
+            elapsed > 0 ? (objects * Rounds) / elapsed : 0,
+            elapsed > 0 ? ((gdouble) length * Rounds) / elapsed / 1024 : 0,
+            (gdouble) allocations / objects, (gdouble) retained / objects);
+
+    g_free (page);
+}
+
+/*
+    Contents are also read in columns, to compare with the construction of complete objects
+*/
+static void bench_columns ()
+{
+    int i;
+    gsize length;
+    gulong rows;
+    guint64 allocations;
+    gint64 retained;
+    gdouble elapsed;
+    gchar *page;
+    GTimer *timer;
+    OGDContentColumns *columns;
+
+    page = load_page ("content", &length);
+    if (page == NULL)
+        return;
+
+    allocations = Allocations;
+    retained = LiveBytes;
+
+    columns = ogd_content_columns_new ();
+    rows = ogd_content_columns_parse (columns, page, length, NULL);
+
+    allocations = Allocations - allocations;
+    retained = LiveBytes - retained;
+    ogd_content_columns_free (columns);
+
+    if (rows == 0) {
+        printf ("%-10s no rows parsed\n", "columns");
+        g_free (page);
+        return;
+    }
+
+    timer = g_timer_new ();
+
+    for (i = 0; i < Rounds; i++) {
+        columns = ogd_content_columns_new ();
+        ogd_content_columns_parse (columns, page, length, NULL);
+        ogd_content_columns_free (columns);
+    }
+
+    g_timer_stop (timer);
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    printf ("%-10s %8lu %12.1f %12.1f %12.1f %12.1f\n", "columns", rows,
+            elapsed > 0 ? (rows * Rounds) / elapsed : 0,
+            elapsed > 0 ? ((gdouble) length * Rounds) / elapsed / 1024 : 0,
+            (gdouble) allocations / rows, (gdouble) retained / rows);
+
+    g_free (page);
+}
+
+int main (int argc, char **argv)
+{
+    guint i;
+    GError *error;
+    GOptionContext *options;
+    OGDProvider *provider;
+
+    install_counting_allocator ();
+    g_type_init ();
+
+    error = NULL;
+    options = g_option_context_new ("- benchmark parsing of OCS responses");
+    g_option_context_add_main_entries (options, Entries, NULL);
+
+    if (g_option_context_parse (options, &argc, &argv, &error) == FALSE) {
+        printf ("%s\n", error->message);
+        g_error_free (error);
+        exit (1);
+    }
+
+    g_option_context_free (options);
+
+    /*
+        Never used to contact any server, but objects require one
+    */
+    provider = ogd_provider_new ("localhost");
+    ogd_provider_set_arena_allocation (provider, Arena);
+
+    printf ("%d rounds per page, %s%s\n\n", Rounds, DataDir != NULL ? DataDir : "generated pages",
+            Arena == TRUE ? ", arena allocation" : "");
+    printf ("%-10s %8s %12s %12s %12s %12s\n", "type", "objects", "objects/s", "KB/s", "allocs/obj", "bytes/obj");
+
+    for (i = 0; i < G_N_ELEMENTS (Types); i++)
+        bench_type (provider, Types [i]);
+
+    bench_columns ();
+
+    g_object_unref (provider);
+    exit (0);
+}
@@ -0,0 +1,394 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <ogd.h>
+
+#include "ogd-mock-server.h"
+
+/*
+    Checks the retry policy against a mock server failing a fraction of the requests: async
+    listings always terminate with the final NULL (exactly once) even when all attempts for a page
+    fail, no GET is sent more times than the configured attempts, and no POST is ever sent twice.
+    Retries have also to be effective: failed GETs are sent again, most of the listings deliver
+    all the expected objects, and requests refused with 429 are sent again only after the time
+    suggested by Retry-After.
+    Run by "make check"; exits with status 1 at the first violation
+*/
+
+#define MAX_ATTEMPTS        3
+#define ROUNDS              20
+#define THROTTLED_ROUNDS    5
+#define THROTTLE_RATE       0.2
+#define RETRY_AFTER         1
+#define TIMEOUT             30
+
+static gint Scale           = 1;
+static gdouble ErrorRate    = 0.3;
+static gint Seed            = 42;
+static guint MaxGetRepeats  = 0;
+
+static GOptionEntry Entries [] = {
+    { "scale", 's', 0, G_OPTION_ARG_INT, &Scale, "Multiplier for the number of items on the mock server", "N" },
+    { "error-rate", 'e', 0, G_OPTION_ARG_DOUBLE, &ErrorRate, "Probability of each request to fail", "P" },
+    { "seed", 0, 0, G_OPTION_ARG_INT, &Seed, "Seed for error injection", "N" },
+    { NULL }
+};
+
+typedef struct {
+    GMainLoop       *loop;
+    guint           objects;
+    guint           terminations;
+    gboolean        timedout;
+} AsyncState;
+
+static void fail (const gchar *scenario, const gchar *message)
+{
+    printf ("FAIL %s: %s\n", scenario, message);
+    exit (1);
+}
+
+static void free_objects (GList *list)
+{
+    GList *iter;
+
+    for (iter = list; iter; iter = g_list_next (iter))
+        g_object_unref (iter->data);
+
+    g_list_free (list);
+}
+
+static void check_repeats (OGDMockServer *server, const gchar *scenario)
+{
+    gchar *message;
+
+    MaxGetRepeats = MAX (MaxGetRepeats, ogd_mock_server_get_max_repeats (server, "GET"));
+
+    if (ogd_mock_server_get_max_repeats (server, "GET") > MAX_ATTEMPTS) {
+        message = g_strdup_printf ("a GET has been sent %u times, limit is %u",
+                                   ogd_mock_server_get_max_repeats (server, "GET"), MAX_ATTEMPTS);
+        fail (scenario, message);
+    }
+
+    if (ogd_mock_server_get_max_repeats (server, "POST") > 1) {
+        message = g_strdup_printf ("a POST has been sent %u times",
+                                   ogd_mock_server_get_max_repeats (server, "POST"));
+        fail (scenario, message);
+    }
+
+    ogd_mock_server_reset_repeats (server);
+}
+
+static gboolean async_timeout (gpointer userdata)
+{
+    AsyncState *state;
+
+    state = (AsyncState*) userdata;
+    state->timedout = TRUE;
+    g_main_loop_quit (state->loop);
+    return FALSE;
+}
+
+static void count_async_object (OGDObject *obj, gpointer userdata)
+{
+    AsyncState *state;
+
+    state = (AsyncState*) userdata;
+
+    if (obj == NULL) {
+        state->terminations++;
+        g_main_loop_quit (state->loop);
+    }
+    else {
+        state->objects++;
+    }
+}
+
+static void count_saved (OGDObject *obj, const GError *error, gpointer userdata)
+{
+    AsyncState *state;
+
+    state = (AsyncState*) userdata;
+    state->terminations++;
+    g_main_loop_quit (state->loop);
+}
+
+/*
+    Runs the main loop until the operation notifies its end, and then flushes pending events to
+    catch further notifications
+*/
+static void wait_termination (AsyncState *state, const gchar *scenario)
+{
+    guint timer;
+
+    timer = g_timeout_add_seconds (TIMEOUT, async_timeout, state);
+    g_main_loop_run (state->loop);
+
+    if (state->timedout == TRUE)
+        fail (scenario, "operation never terminated");
+
+    g_source_remove (timer);
+
+    while (g_main_context_pending (NULL))
+        g_main_context_iteration (NULL, FALSE);
+
+    if (state->terminations != 1)
+        fail (scenario, "termination notified more than once");
+}
+
+/*
+    Without retries each request of a round fails with probability ErrorRate, so with the default
+    rate less than half of the rounds would be complete
+*/
+static void check_complete_rounds (const gchar *scenario, guint complete, guint rounds, guint expected)
+{
+    gchar *message;
+
+    if (complete * 2 < rounds) {
+        message = g_strdup_printf ("only %u of %u rounds delivered all the %u objects", complete, rounds, expected);
+        fail (scenario, message);
+    }
+}
+
+static void reset_state (AsyncState *state)
+{
+    state->objects = 0;
+    state->terminations = 0;
+    state->timedout = FALSE;
+}
+
+static OGDCategory* first_category (OGDProvider *provider)
+{
+    int i;
+    GList *categories;
+    OGDCategory *ret;
+
+    for (i = 0; i < ROUNDS; i++) {
+        categories = ogd_category_fetch_all (provider);
+
+        if (categories != NULL) {
+            ret = g_object_ref (categories->data);
+            free_objects (categories);
+            return ret;
+        }
+    }
+
+    return NULL;
+}
+
+static OGDPerson* any_person (OGDProvider *provider)
+{
+    int i;
+    gchar *id;
+    OGDPerson *person;
+
+    person = g_object_new (OGD_PERSON_TYPE, NULL);
+    ogd_object_set_provider (OGD_OBJECT (person), provider);
+
+    for (i = 0; i < ROUNDS; i++) {
+        id = g_strdup_printf ("user%d", i);
+
+        if (ogd_object_fill_by_id (OGD_OBJECT (person), id, NULL) == TRUE) {
+            g_free (id);
+            return person;
+        }
+
+        g_free (id);
+    }
+
+    g_object_unref (person);
+    return NULL;
+}
+
+static void test_iterator_async (OGDProvider *provider, OGDMockServer *server, AsyncState *state,
+                                 const gchar *scenario, guint rounds)
+{
+    int i;
+    guint complete;
+    guint expected;
+    OGDCategory *category;
+    OGDIterator *iterator;
+
+    category = first_category (provider);
+    if (category == NULL)
+        fail (scenario, "unable to fetch categories");
+
+    check_repeats (server, "category-sync");
+    complete = 0;
+    expected = ogd_mock_server_get_contents (server);
+
+    for (i = 0; i < rounds; i++) {
+        reset_state (state);
+        iterator = ogd_category_get_contents (category, OGD_CATEGORY_SORT_NEWEST);
+        ogd_iterator_fetch_async (iterator, count_async_object, state);
+        wait_termination (state, scenario);
+        g_object_unref (iterator);
+        check_repeats (server, scenario);
+
+        if (state->objects == expected)
+            complete++;
+    }
+
+    check_complete_rounds (scenario, complete, rounds, expected);
+    g_object_unref (category);
+}
+
+static void test_people_async (OGDProvider *provider, OGDMockServer *server, AsyncState *state)
+{
+    int i;
+    guint complete;
+    guint expected;
+    OGDPerson *person;
+
+    person = any_person (provider);
+    if (person == NULL)
+        fail ("people-list-async", "unable to fetch a person");
+
+    check_repeats (server, "person-sync");
+    complete = 0;
+    expected = ogd_mock_server_get_friends (server);
+
+    for (i = 0; i < ROUNDS; i++) {
+        reset_state (state);
+        ogd_person_get_friends_async (person, count_async_object, state);
+        wait_termination (state, "people-list-async");
+        check_repeats (server, "people-list-async");
+
+        if (state->objects == expected)
+            complete++;
+    }
+
+    check_complete_rounds ("people-list-async", complete, ROUNDS, expected);
+    g_object_unref (person);
+}
+
+static void test_save (OGDProvider *provider, OGDMockServer *server, AsyncState *state)
+{
+    int i;
+    gchar *name;
+    OGDContent *content;
+    OGDCategory *category;
+
+    category = first_category (provider);
+    if (category == NULL)
+        fail ("content-save", "unable to fetch categories");
+
+    ogd_mock_server_reset_repeats (server);
+
+    /*
+        Each content has a different name, so that the POSTs sent for different contents are
+        different requests for the mock server
+    */
+    for (i = 0; i < ROUNDS; i++) {
+        name = g_strdup_printf ("Retry test content %d", i);
+        content = ogd_content_new (provider);
+        ogd_content_set_name (content, name);
+        ogd_content_set_category (content, category);
+
+        if (i % 2 == 0) {
+            ogd_content_save (content);
+        }
+        else {
+            reset_state (state);
+            ogd_content_save_async (content, count_saved, state);
+            wait_termination (state, "content-save-async");
+        }
+
+        g_object_unref (content);
+        g_free (name);
+    }
+
+    check_repeats (server, "content-save");
+    g_object_unref (category);
+}
+
+/*
+    Listings are repeated while the server also refuses a fraction of the requests with 429: they
+    still have to complete, and no refused request has to be sent again before Retry-After
+*/
+static void test_throttling (OGDProvider *provider, OGDMockServer *server, AsyncState *state)
+{
+    gchar *message;
+
+    ogd_mock_server_set_throttling (server, THROTTLE_RATE, RETRY_AFTER);
+    test_iterator_async (provider, server, state, "throttled-iterator-async", THROTTLED_ROUNDS);
+    ogd_mock_server_set_throttling (server, 0, 0);
+
+    if (ogd_mock_server_get_throttles (server) == 0)
+        fail ("throttling", "no request has been throttled");
+
+    if (ogd_mock_server_get_early_retries (server) != 0) {
+        message = g_strdup_printf ("%u requests sent again before Retry-After",
+                                   ogd_mock_server_get_early_retries (server));
+        fail ("throttling", message);
+    }
+}
+
+static void check_retried ()
+{
+    if (ErrorRate > 0 && MaxGetRepeats < 2)
+        fail ("retries", "no failed GET has ever been sent again");
+}
+
+int main (int argc, char **argv)
+{
+    GError *error;
+    AsyncState state;
+    GOptionContext *options;
+    OGDMockServer *server;
+    OGDProvider *provider;
+
+    g_type_init ();
+    g_thread_init (NULL);
+
+    error = NULL;
+    options = g_option_context_new ("- check the retry policy against a failing mock server");
+    g_option_context_add_main_entries (options, Entries, NULL);
+
+    if (g_option_context_parse (options, &argc, &argv, &error) == FALSE) {
+        printf ("%s\n", error->message);
+        g_error_free (error);
+        exit (1);
+    }
+
+    g_option_context_free (options);
+
+    server = ogd_mock_server_new (Scale, 0, ErrorRate, Seed);
+    if (server == NULL)
+        exit (1);
+
+    provider = ogd_provider_new ((gchar*) ogd_mock_server_get_address (server));
+    ogd_provider_auth_user_and_pwd (provider, OGD_MOCK_SERVER_USER, OGD_MOCK_SERVER_USER);
+    ogd_provider_set_retry_policy (provider, MAX_ATTEMPTS, 1, 2, 10,
+                                   OGD_RETRY_TRANSPORT_ERRORS | OGD_RETRY_SERVER_ERRORS | OGD_RETRY_THROTTLING);
+
+    state.loop = g_main_loop_new (NULL, FALSE);
+
+    test_iterator_async (provider, server, &state, "iterator-async", ROUNDS);
+    test_people_async (provider, server, &state);
+    test_save (provider, server, &state);
+    test_throttling (provider, server, &state);
+    check_retried ();
+
+    printf ("PASS: %u requests, error rate %.2f, %d attempts, %u throttled\n",
+            ogd_mock_server_get_requests (server), ErrorRate, MAX_ATTEMPTS, ogd_mock_server_get_throttles (server));
+
+    g_main_loop_unref (state.loop);
+    g_object_unref (provider);
+    ogd_mock_server_free (server);
+    exit (0);
+}
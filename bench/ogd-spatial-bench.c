@@ -0,0 +1,188 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <sys/resource.h>
+#include <ogd.h>
+
+/*
+    Measures OGDSpatialIndex alone: points spread uniformly on the globe are inserted one by one,
+    as iterators would deliver them, and then queried for those within a radius and for the
+    nearest ones. The same radius queries are also answered scanning all points, to compare.
+    A single object is shared by all points, so the memory reported is the one of the index
+*/
+
+static gint Points          = 1000000;
+static gint Queries         = 1000;
+static gint ScanQueries     = 10;
+static gdouble Radius       = 100;
+static gint Nearest         = 10;
+static gint Seed            = 42;
+
+static GOptionEntry Entries [] = {
+    { "points", 'n', 0, G_OPTION_ARG_INT, &Points, "Points inserted in the index", "N" },
+    { "queries", 'q', 0, G_OPTION_ARG_INT, &Queries, "Queries of each kind performed on the index", "N" },
+    { "scan-queries", 0, 0, G_OPTION_ARG_INT, &ScanQueries, "Radius queries answered scanning all points", "N" },
+    { "radius", 'r', 0, G_OPTION_ARG_DOUBLE, &Radius, "Radius of the queries, in kilometers", "KM" },
+    { "nearest", 'k', 0, G_OPTION_ARG_INT, &Nearest, "Objects asked by nearest neighbours queries", "N" },
+    { "seed", 0, 0, G_OPTION_ARG_INT, &Seed, "Seed for generated points", "N" },
+    { NULL }
+};
+
+static gdouble random_latitude (GRand *rand)
+{
+    /*
+        Uniform on the surface of the sphere, not in degrees
+    */
+    return asin (g_rand_double_range (rand, -1, 1)) * 180 / G_PI;
+}
+
+static gdouble random_longitude (GRand *rand)
+{
+    return g_rand_double_range (rand, -180, 180);
+}
+
+static gdouble surface_distance (gdouble lat1, gdouble lon1, gdouble lat2, gdouble lon2)
+{
+    gdouble a;
+    gdouble b;
+
+    lat1 *= G_PI / 180;
+    lon1 *= G_PI / 180;
+    lat2 *= G_PI / 180;
+    lon2 *= G_PI / 180;
+
+    a = sin ((lat2 - lat1) / 2);
+    b = sin ((lon2 - lon1) / 2);
+    return 2 * 6371.0 * asin (sqrt (a * a + cos (lat1) * cos (lat2) * b * b));
+}
+
+static glong peak_memory ()
+{
+    struct rusage usage;
+
+    getrusage (RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void print_result (const gchar *name, gint operations, gdouble elapsed, gdouble results)
+{
+    printf ("%-12s %10d %14.1f %12.1f\n", name, operations, elapsed > 0 ? operations / elapsed : 0, results);
+}
+
+int main (int argc, char **argv)
+{
+    int i;
+    int j;
+    gulong found;
+    glong memory;
+    gdouble latitude;
+    gdouble longitude;
+    gdouble *latitudes;
+    gdouble *longitudes;
+    GList *list;
+    GRand *rand;
+    GTimer *timer;
+    GError *error;
+    GOptionContext *options;
+    OGDProvider *provider;
+    OGDEvent *event;
+    OGDSpatialIndex *index;
+
+    g_type_init ();
+
+    error = NULL;
+    options = g_option_context_new ("- benchmark the spatial index of persons and events");
+    g_option_context_add_main_entries (options, Entries, NULL);
+
+    if (g_option_context_parse (options, &argc, &argv, &error) == FALSE) {
+        printf ("%s\n", error->message);
+        g_error_free (error);
+        exit (1);
+    }
+
+    g_option_context_free (options);
+
+    provider = ogd_provider_new ("localhost");
+    event = ogd_event_new (provider);
+    rand = g_rand_new_with_seed (Seed);
+
+    latitudes = g_new (gdouble, Points);
+    longitudes = g_new (gdouble, Points);
+
+    for (i = 0; i < Points; i++) {
+        latitudes [i] = random_latitude (rand);
+        longitudes [i] = random_longitude (rand);
+    }
+
+    printf ("%d points, radius %.1f km, %d nearest\n\n", Points, Radius, Nearest);
+    printf ("%-12s %10s %14s %12s\n", "operation", "count", "operations/s", "results/op");
+
+    memory = peak_memory ();
+    index = ogd_spatial_index_new ();
+    timer = g_timer_new ();
+
+    for (i = 0; i < Points; i++)
+        ogd_spatial_index_insert_point (index, latitudes [i], longitudes [i], OGD_OBJECT (event));
+
+    print_result ("insert", Points, g_timer_elapsed (timer, NULL), 0);
+    memory = peak_memory () - memory;
+
+    g_timer_start (timer);
+
+    for (i = 0, found = 0; i < Queries; i++) {
+        list = ogd_spatial_index_within_radius (index, random_latitude (rand), random_longitude (rand), Radius);
+        found += g_list_length (list);
+        g_list_free (list);
+    }
+
+    print_result ("radius", Queries, g_timer_elapsed (timer, NULL), Queries > 0 ? (gdouble) found / Queries : 0);
+    g_timer_start (timer);
+
+    for (i = 0, found = 0; i < Queries; i++) {
+        list = ogd_spatial_index_nearest (index, random_latitude (rand), random_longitude (rand), Nearest);
+        found += g_list_length (list);
+        g_list_free (list);
+    }
+
+    print_result ("nearest", Queries, g_timer_elapsed (timer, NULL), Queries > 0 ? (gdouble) found / Queries : 0);
+    g_timer_start (timer);
+
+    for (i = 0, found = 0; i < ScanQueries; i++) {
+        latitude = random_latitude (rand);
+        longitude = random_longitude (rand);
+
+        for (j = 0; j < Points; j++)
+            if (surface_distance (latitude, longitude, latitudes [j], longitudes [j]) <= Radius)
+                found++;
+    }
+
+    print_result ("radius scan", ScanQueries, g_timer_elapsed (timer, NULL),
+                  ScanQueries > 0 ? (gdouble) found / ScanQueries : 0);
+
+    printf ("\nindex memory: %ld KB\n", memory);
+
+    g_timer_destroy (timer);
+    ogd_spatial_index_free (index);
+    g_object_unref (event);
+    g_object_unref (provider);
+    g_free (latitudes);
+    g_free (longitudes);
+    g_rand_free (rand);
+    exit (0);
+}
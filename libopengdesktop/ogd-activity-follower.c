@@ -0,0 +1,427 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-activity-follower.h"
+#include "ogd-provider-private.h"
+#include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
+
+/**
+ * SECTION: ogd-activity-follower
+ * @short_description:  following of the activities of the current user
+ *
+ * An #OGDActivityFollower periodically checks the activities of the user inited with
+ * ogd_provider_auth_user_and_pwd() and passes to a callback only those not delivered yet. It
+ * keeps a cursor, the most recent time of creation of the activities delivered, and pages stop
+ * being requested as soon as an older activity is found. Activities with the same time of the
+ * cursor are recognized by author, time and link, compared with a fixed number of the last
+ * delivered ones. The first poll, with no cursor, delivers only the first page of activities.
+ * Since at most a fixed number of pages is requested by each poll, the memory used does not
+ * grow with the time the #OGDActivityFollower runs: if more activities arrived between two
+ * polls, the oldest of them are skipped, see ogd_activity_follower_get_skipped().
+ * When started with ogd_activity_follower_start() the interval between polls adapts to the
+ * activity: after a poll delivering something the next one is performed after the minimum
+ * interval, otherwise the interval is doubled up to the maximum one
+ */
+
+#define FOLLOWER_PAGE_SIZE          50
+#define FOLLOWER_MAX_PAGES          4
+#define FOLLOWER_SEEN_SIZE          64
+#define FOLLOWER_MIN_INTERVAL       30
+#define FOLLOWER_MAX_INTERVAL       900
+
+struct _OGDActivityFollower {
+    OGDProvider                 *provider;
+    gint64                      cursor;
+
+    gchar                       *seen [FOLLOWER_SEEN_SIZE];
+    guint                       seen_next;
+    guint                       skipped;
+
+    OGDActivityFollowerCallback callback;
+    gpointer                    userdata;
+
+    OGDPollTimer                timer;
+};
+
+typedef struct {
+    OGDActivityFollower         *follower;
+    guint                       page;
+    gint64                      newest;
+    gulong                      received;
+    gboolean                    truncated;
+    GList                       *fresh;
+} FollowerPoll;
+
+static void poll_async (gpointer userdata);
+
+/**
+ * ogd_activity_follower_new:
+ * @provider:       the #OGDProvider from which activities are fetched
+ * @callback:       callback invoked for each new activity
+ * @userdata:       the user data for @callback
+ *
+ * To create a new #OGDActivityFollower. Use ogd_activity_follower_poll() to check for new
+ * activities once, or ogd_activity_follower_start() to check them periodically
+ *
+ * Return value:    a newly allocated #OGDActivityFollower, to be freed with
+ *                  ogd_activity_follower_free()
+ */
+OGDActivityFollower* ogd_activity_follower_new (OGDProvider *provider, OGDActivityFollowerCallback callback,
+                                                gpointer userdata)
+{
+    OGDActivityFollower *follower;
+
+    follower = g_new0 (OGDActivityFollower, 1);
+    follower->provider = provider;
+    follower->callback = callback;
+    follower->userdata = userdata;
+    poll_timer_init (&(follower->timer), FOLLOWER_MIN_INTERVAL, FOLLOWER_MAX_INTERVAL, poll_async, follower);
+    return follower;
+}
+
+static void forget_seen (OGDActivityFollower *follower)
+{
+    int i;
+
+    for (i = 0; i < FOLLOWER_SEEN_SIZE; i++)
+        PTR_CHECK_FREE_NULLIFY (follower->seen [i]);
+
+    follower->seen_next = 0;
+}
+
+static void destroy_follower (OGDActivityFollower *follower)
+{
+    forget_seen (follower);
+    g_free (follower);
+}
+
+/**
+ * ogd_activity_follower_free:
+ * @follower:       the #OGDActivityFollower to free
+ *
+ * Stops and frees an #OGDActivityFollower. If a poll is running the #OGDActivityFollower is
+ * released when it completes, but no more activities are passed to the callback
+ */
+void ogd_activity_follower_free (OGDActivityFollower *follower)
+{
+    if (poll_timer_dispose (&(follower->timer)) == TRUE)
+        destroy_follower (follower);
+}
+
+/**
+ * ogd_activity_follower_get_cursor:
+ * @follower:       the #OGDActivityFollower to query
+ *
+ * To know up to when activities have been delivered, e.g. to save it and resume following from
+ * the same point with ogd_activity_follower_set_cursor() in the next run of the application
+ *
+ * Return value:    the most recent time of creation of the activities delivered, in seconds
+ *                  since the Epoch, or 0 if nothing has been delivered yet
+ */
+gint64 ogd_activity_follower_get_cursor (OGDActivityFollower *follower)
+{
+    return follower->cursor;
+}
+
+/**
+ * ogd_activity_follower_set_cursor:
+ * @follower:       the #OGDActivityFollower to modify
+ * @cursor:         time in seconds since the Epoch
+ *
+ * To explicitely set from when activities have to be delivered: the next poll will deliver
+ * activities created at @cursor or later. Activities delivered so far are forgotten, so those
+ * created exactly at @cursor may be delivered again
+ */
+void ogd_activity_follower_set_cursor (OGDActivityFollower *follower, gint64 cursor)
+{
+    follower->cursor = cursor;
+    forget_seen (follower);
+}
+
+/**
+ * ogd_activity_follower_get_skipped:
+ * @follower:       the #OGDActivityFollower to query
+ *
+ * To know how many times more activities than those fetched by a single poll arrived between
+ * two polls, so that the oldest of them have been skipped. A growing value suggests to shorten
+ * the intervals with ogd_activity_follower_set_intervals()
+ *
+ * Return value:    the number of polls which skipped some activity, since @follower has been
+ *                  created
+ */
+guint ogd_activity_follower_get_skipped (OGDActivityFollower *follower)
+{
+    return follower->skipped;
+}
+
+/**
+ * ogd_activity_follower_set_intervals:
+ * @follower:       the #OGDActivityFollower to configure
+ * @min_seconds:    interval between polls while new activities are arriving. Must be at least 1
+ * @max_seconds:    maximum interval between polls, reached when no activity arrives for a while
+ *
+ * To set the range in which the interval between polls performed after
+ * ogd_activity_follower_start() adapts. Defaults are 30 and 900 seconds
+ */
+void ogd_activity_follower_set_intervals (OGDActivityFollower *follower, guint min_seconds, guint max_seconds)
+{
+    poll_timer_set_intervals (&(follower->timer), min_seconds, max_seconds);
+}
+
+/**
+ * ogd_activity_follower_get_interval:
+ * @follower:       the #OGDActivityFollower to query
+ *
+ * To know after how long the next poll will be performed, accordly the activity observed so far
+ *
+ * Return value:    the current interval between polls, in seconds
+ */
+guint ogd_activity_follower_get_interval (OGDActivityFollower *follower)
+{
+    return follower->timer.interval;
+}
+
+static gchar* activity_key (OGDActivity *activity)
+{
+    const gchar *author;
+    const gchar *link;
+
+    author = ogd_activity_get_authorid (activity);
+    link = ogd_activity_get_link (activity);
+
+    return g_strdup_printf ("%s\n%" G_GINT64_FORMAT "\n%s", author ? author : "",
+                            ogd_activity_get_time (activity), link ? link : "");
+}
+
+static gboolean already_seen (OGDActivityFollower *follower, OGDActivity *activity)
+{
+    int i;
+    gboolean ret;
+    gchar *key;
+
+    ret = FALSE;
+    key = activity_key (activity);
+
+    for (i = 0; i < FOLLOWER_SEEN_SIZE && follower->seen [i] != NULL; i++) {
+        if (strcmp (follower->seen [i], key) == 0) {
+            ret = TRUE;
+            break;
+        }
+    }
+
+    g_free (key);
+    return ret;
+}
+
+static void remember_seen (OGDActivityFollower *follower, OGDActivity *activity)
+{
+    g_free (follower->seen [follower->seen_next]);
+    follower->seen [follower->seen_next] = activity_key (activity);
+    follower->seen_next = (follower->seen_next + 1) % FOLLOWER_SEEN_SIZE;
+}
+
+static FollowerPoll* new_poll (OGDActivityFollower *follower)
+{
+    FollowerPoll *poll;
+
+    poll = g_new0 (FollowerPoll, 1);
+    poll->follower = follower;
+    poll->newest = follower->cursor;
+    return poll;
+}
+
+static gchar* poll_query (gpointer userdata)
+{
+    FollowerPoll *poll;
+
+    poll = (FollowerPoll*) userdata;
+    return g_strdup_printf ("activity?page=%u&pagesize=%d", poll->page, FOLLOWER_PAGE_SIZE);
+}
+
+/*
+    New activities are collected in poll->fresh from the oldest, to be delivered only if all the
+    required pages are received
+*/
+static gboolean process_page (GList *activities, gpointer userdata)
+{
+    guint count;
+    gint64 time;
+    gboolean older;
+    GList *iter;
+    OGDActivity *activity;
+    OGDActivityFollower *follower;
+    FollowerPoll *poll;
+
+    poll = (FollowerPoll*) userdata;
+    count = 0;
+    older = FALSE;
+    follower = poll->follower;
+
+    for (iter = activities; iter; iter = g_list_next (iter)) {
+        count++;
+
+        if (IS_OGD_ACTIVITY (iter->data) == FALSE) {
+            g_object_unref (iter->data);
+            continue;
+        }
+
+        activity = OGD_ACTIVITY (iter->data);
+        time = ogd_activity_get_time (activity);
+
+        if (older == TRUE || (time != 0 && time < follower->cursor)) {
+            older = TRUE;
+            g_object_unref (activity);
+        }
+        else if (already_seen (follower, activity) == TRUE) {
+            g_object_unref (activity);
+        }
+        else {
+            poll->fresh = g_list_prepend (poll->fresh, activity);
+            poll->newest = MAX (poll->newest, time);
+        }
+    }
+
+    g_list_free (activities);
+    poll->page++;
+
+    if (older == FALSE && count == FOLLOWER_PAGE_SIZE && follower->cursor != 0) {
+        if (poll->page < FOLLOWER_MAX_PAGES)
+            return TRUE;
+
+        poll->truncated = TRUE;
+    }
+
+    return FALSE;
+}
+
+static void finish_poll_pages (FollowerPoll *poll, const GError *error)
+{
+    GList *iter;
+    OGDActivity *activity;
+    OGDActivityFollower *follower;
+
+    follower = poll->follower;
+
+    if (error == NULL) {
+        for (iter = poll->fresh; iter; iter = g_list_next (iter)) {
+            activity = (OGDActivity*) iter->data;
+            remember_seen (follower, activity);
+
+            if (follower->timer.disposed == FALSE) {
+                TRACED_CALLBACK ("callback", follower->callback (follower, activity, follower->userdata));
+                poll->received++;
+            }
+        }
+
+        follower->cursor = poll->newest;
+
+        if (poll->truncated == TRUE)
+            follower->skipped++;
+    }
+
+    g_list_foreach (poll->fresh, (GFunc) g_object_unref, NULL);
+    g_list_free (poll->fresh);
+    poll->fresh = NULL;
+}
+
+/**
+ * ogd_activity_follower_poll:
+ * @follower:       the #OGDActivityFollower used to poll
+ * @received:       if not %NULL, filled with the number of activities passed to the callback
+ * @error:          a #GError filled if the function returns %FALSE
+ *
+ * Checks once for new activities, passing them to the callback of @follower
+ *
+ * Return value:    %TRUE if the check completed, %FALSE otherwise
+ */
+gboolean ogd_activity_follower_poll (OGDActivityFollower *follower, gulong *received, GError **error)
+{
+    gulong ret;
+    GError *page_error;
+    FollowerPoll *poll;
+
+    poll = new_poll (follower);
+    page_error = NULL;
+    fetch_pages (follower->provider, poll_query, process_page, poll, &page_error);
+    finish_poll_pages (poll, page_error);
+    ret = poll->received;
+    g_free (poll);
+
+    if (received != NULL)
+        *received = ret;
+
+    poll_timer_adapt (&(follower->timer), ret);
+
+    if (page_error != NULL) {
+        g_propagate_error (error, page_error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void finish_poll (gpointer userdata, const GError *error)
+{
+    OGDActivityFollower *follower;
+    FollowerPoll *poll;
+
+    poll = (FollowerPoll*) userdata;
+    follower = poll->follower;
+    finish_poll_pages (poll, error);
+
+    if (poll_timer_done (&(follower->timer), poll->received) == TRUE)
+        destroy_follower (follower);
+
+    g_free (poll);
+}
+
+static void poll_async (gpointer userdata)
+{
+    OGDActivityFollower *follower;
+    FollowerPoll *poll;
+
+    follower = (OGDActivityFollower*) userdata;
+    poll = new_poll (follower);
+    fetch_pages_async (follower->provider, poll, poll_query, process_page, finish_poll, poll);
+}
+
+/**
+ * ogd_activity_follower_start:
+ * @follower:       the #OGDActivityFollower to start
+ *
+ * Starts to poll periodically for new activities, with the first poll performed immediately.
+ * Pages are requested one after the other, with %OGD_PROVIDER_PRIORITY_BULK priority. If a poll
+ * fails it is repeated later, and the reason is available from ogd_provider_get_last_error()
+ */
+void ogd_activity_follower_start (OGDActivityFollower *follower)
+{
+    poll_timer_start (&(follower->timer));
+}
+
+/**
+ * ogd_activity_follower_stop:
+ * @follower:       the #OGDActivityFollower to stop
+ *
+ * Stops polling for new activities. A poll already running is completed anyway, and new
+ * activities it finds are still passed to the callback
+ */
+void ogd_activity_follower_stop (OGDActivityFollower *follower)
+{
+    poll_timer_stop (&(follower->timer));
+}
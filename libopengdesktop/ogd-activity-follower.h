@@ -0,0 +1,54 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_ACTIVITY_FOLLOWER_H
+#define OGD_ACTIVITY_FOLLOWER_H
+
+G_BEGIN_DECLS
+
+#include "ogd-activity.h"
+
+typedef struct _OGDActivityFollower OGDActivityFollower;
+
+/**
+ * OGDActivityFollowerCallback:
+ * @follower:       the #OGDActivityFollower which found the activity
+ * @activity:       an #OGDActivity not yet delivered
+ * @userdata:       the user data passed with the callback
+ *
+ * Invoked by an #OGDActivityFollower for each new activity, from the oldest to the newest.
+ * @activity is unref'd after the callback, which has to take its own reference to keep it
+ */
+typedef void (*OGDActivityFollowerCallback) (OGDActivityFollower *follower, OGDActivity *activity, gpointer userdata);
+
+OGDActivityFollower*    ogd_activity_follower_new               (OGDProvider *provider, OGDActivityFollowerCallback callback,
+                                                                 gpointer userdata);
+void                    ogd_activity_follower_free              (OGDActivityFollower *follower);
+
+gint64                  ogd_activity_follower_get_cursor        (OGDActivityFollower *follower);
+void                    ogd_activity_follower_set_cursor        (OGDActivityFollower *follower, gint64 cursor);
+guint                   ogd_activity_follower_get_skipped       (OGDActivityFollower *follower);
+void                    ogd_activity_follower_set_intervals     (OGDActivityFollower *follower, guint min_seconds, guint max_seconds);
+guint                   ogd_activity_follower_get_interval      (OGDActivityFollower *follower);
+
+gboolean                ogd_activity_follower_poll              (OGDActivityFollower *follower, gulong *received, GError **error);
+void                    ogd_activity_follower_start             (OGDActivityFollower *follower);
+void                    ogd_activity_follower_stop              (OGDActivityFollower *follower);
+
+G_END_DECLS
+
+#endif /* OGD_ACTIVITY_FOLLOWER_H */
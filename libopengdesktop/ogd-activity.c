@@ -36,6 +36,7 @@
 struct _OGDActivityPrivate {
     gchar                   *authorid;
     GDate                   *date;
+    gint64                  time;
     OGD_ACTIVITY_CATEGORY   category;
     gchar                   *message;
     gchar                   *link;
@@ -49,10 +50,13 @@ static void ogd_activity_finalize (GObject *obj)
 
     activity = OGD_ACTIVITY (obj);
 
-    PTR_CHECK_FREE_NULLIFY (activity->priv->authorid);
+    ARENA_CHECK_FREE_NULLIFY (activity->priv->authorid);
     DATE_CHECK_FREE_NULLIFY (activity->priv->date);
-    PTR_CHECK_FREE_NULLIFY (activity->priv->message);
-    PTR_CHECK_FREE_NULLIFY (activity->priv->link);
+    activity->priv->time = 0;
+    ARENA_CHECK_FREE_NULLIFY (activity->priv->message);
+    ARENA_CHECK_FREE_NULLIFY (activity->priv->link);
+
+    ogd_object_release_arena (OGD_OBJECT (obj));
 }
 
 static gboolean ogd_activity_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
@@ -72,8 +76,10 @@ static gboolean ogd_activity_fill_by_xml (OGDObject *obj, const xmlNode *xml, GE
     for (cursor = xml->children; cursor; cursor = cursor->next) {
         if (MYSTRCMP (cursor->name, "personid") == 0)
             activity->priv->authorid = MYGETCONTENT (cursor);
-        else if (MYSTRCMP (cursor->name, "timestamp") == 0)
+        else if (MYSTRCMP (cursor->name, "timestamp") == 0) {
             activity->priv->date = node_to_date (cursor);
+            activity->priv->time = node_to_time (cursor);
+        }
         else if (MYSTRCMP (cursor->name, "type") == 0)
             activity->priv->category = (guint) node_to_num (cursor);
         else if (MYSTRCMP (cursor->name, "message") == 0)
@@ -132,6 +138,20 @@ const GDate* ogd_activity_get_date (OGDActivity *activity)
     return (const GDate*) activity->priv->date;
 }
 
+/**
+ * ogd_activity_get_time:
+ * @activity:		an #OGDActivity to read
+ *
+ * As ogd_activity_get_date(), but with the time of creation of the activity
+ *
+ * Return value:	the time of creation of the activity, in seconds since the Epoch, or 0 if
+ *                  unknown
+ */
+gint64 ogd_activity_get_time (OGDActivity *activity)
+{
+    return activity->priv->time;
+}
+
 /**
  * ogd_activity_get_category:
  * @activity:		an #OGDActivity to read
@@ -97,6 +97,7 @@ GType                   ogd_activity_get_type                   ();
 
 const gchar*            ogd_activity_get_authorid               (OGDActivity *activity);
 const GDate*            ogd_activity_get_date                   (OGDActivity *activity);
+gint64                  ogd_activity_get_time                   (OGDActivity *activity);
 OGD_ACTIVITY_CATEGORY   ogd_activity_get_category               (OGDActivity *activity);
 const gchar*            ogd_activity_get_message                (OGDActivity *activity);
 const gchar*            ogd_activity_get_link                   (OGDActivity *activity);
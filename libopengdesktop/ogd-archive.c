@@ -0,0 +1,354 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+
+#include "ogd.h"
+#include "ogd-archive.h"
+#include "ogd-private-utils.h"
+
+/*
+    An archive holds request/response pairs exchanged with a provider, to be served again later
+    without any network. While recording, messages are observed directly from the SoupSessions of
+    the OGDProvider, so every request (sync or async, and each retry) is saved with the time it
+    took. While replaying, the OGDProvider and its scheduler ask the archive to fill each message
+    in place of sending it, and wait the recorded time (scaled) before completing it.
+
+    The file starts with a line identifying the format, followed by one record for each
+    response:
+
+        <method> <query> <status> <microseconds> <number of headers> <body length>
+        <name>: <value>             repeated for each header
+        <body>
+
+    where the query is relative to the access URL of the provider. Responses to the same request
+    are served in the order they were recorded, and the last one is repeated once all have been
+    used
+*/
+
+#define ARCHIVE_SIGNATURE       "OGD-ARCHIVE 1\n"
+#define TIMING_KEY              "ogd-archive-start"
+
+typedef struct {
+    guint       status;
+    gint64      elapsed;
+    GList       *headers;
+    gchar       *body;
+    gsize       length;
+} ArchivedResponse;
+
+typedef struct {
+    GList       *responses;
+    GList       *next;
+} ArchivedRequest;
+
+struct _OGDArchive {
+    FILE        *output;
+
+    gchar       *contents;
+    gdouble     time_scale;
+    GHashTable  *requests;
+};
+
+/*
+    Headers are kept as a list of name, value, name, value... pointing to the loaded contents
+*/
+static void free_request (ArchivedRequest *request)
+{
+    GList *iter;
+    ArchivedResponse *response;
+
+    for (iter = request->responses; iter; iter = g_list_next (iter)) {
+        response = (ArchivedResponse*) iter->data;
+        g_list_free (response->headers);
+        g_free (response);
+    }
+
+    g_list_free (request->responses);
+    g_free (request);
+}
+
+/*
+    Opens @path for writing and returns an archive to be attached to the sessions of the provider
+    with ogd_archive_watch_session()
+*/
+OGDArchive* ogd_archive_new_recording (const gchar *path, GError **error)
+{
+    FILE *output;
+    OGDArchive *archive;
+
+    output = fopen (path, "w");
+    if (output == NULL) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to open archive %s: %s", path, g_strerror (errno));
+        return NULL;
+    }
+
+    fputs (ARCHIVE_SIGNATURE, output);
+
+    archive = g_new0 (OGDArchive, 1);
+    archive->output = output;
+    return archive;
+}
+
+static gchar* next_line (gchar **cursor, gchar *end)
+{
+    gchar *ret;
+    gchar *newline;
+
+    if (*cursor >= end)
+        return NULL;
+
+    newline = memchr (*cursor, '\n', end - *cursor);
+    if (newline == NULL)
+        return NULL;
+
+    *newline = '\0';
+    ret = *cursor;
+    *cursor = newline + 1;
+    return ret;
+}
+
+static gboolean load_response (OGDArchive *archive, gchar **cursor, gchar *end)
+{
+    int i;
+    guint headers;
+    gchar *line;
+    gchar *separator;
+    gchar *key;
+    gchar **tokens;
+    ArchivedRequest *request;
+    ArchivedResponse *response;
+
+    line = next_line (cursor, end);
+    if (line == NULL)
+        return FALSE;
+
+    tokens = g_strsplit (line, " ", 6);
+    if (g_strv_length (tokens) != 6) {
+        g_strfreev (tokens);
+        return FALSE;
+    }
+
+    response = g_new0 (ArchivedResponse, 1);
+    response->status = strtoul (tokens [2], NULL, 10);
+    response->elapsed = g_ascii_strtoll (tokens [3], NULL, 10);
+    headers = strtoul (tokens [4], NULL, 10);
+    response->length = strtoul (tokens [5], NULL, 10);
+
+    for (i = 0; i < headers; i++) {
+        line = next_line (cursor, end);
+        if (line == NULL)
+            break;
+
+        separator = strstr (line, ": ");
+        if (separator == NULL)
+            continue;
+
+        *separator = '\0';
+        response->headers = g_list_prepend (response->headers, separator + 2);
+        response->headers = g_list_prepend (response->headers, line);
+    }
+
+    if (i < headers || *cursor + response->length > end) {
+        g_list_free (response->headers);
+        g_free (response);
+        g_strfreev (tokens);
+        return FALSE;
+    }
+
+    response->body = *cursor;
+    *cursor += response->length + 1;
+
+    key = g_strdup_printf ("%s %s", tokens [0], tokens [1]);
+    request = g_hash_table_lookup (archive->requests, key);
+
+    if (request == NULL) {
+        request = g_new0 (ArchivedRequest, 1);
+        g_hash_table_insert (archive->requests, key, request);
+    }
+    else {
+        g_free (key);
+    }
+
+    request->responses = g_list_append (request->responses, response);
+    if (request->next == NULL)
+        request->next = request->responses;
+
+    g_strfreev (tokens);
+    return TRUE;
+}
+
+/*
+    Params:
+        time_scale:     factor applied to recorded timings: 1 reproduces them, 0 serves all
+                        responses immediately
+*/
+OGDArchive* ogd_archive_new_replay (const gchar *path, gdouble time_scale, GError **error)
+{
+    gsize length;
+    gchar *contents;
+    gchar *cursor;
+    gchar *end;
+    OGDArchive *archive;
+
+    if (g_file_get_contents (path, &contents, &length, error) == FALSE)
+        return NULL;
+
+    if (length < strlen (ARCHIVE_SIGNATURE) || strncmp (contents, ARCHIVE_SIGNATURE, strlen (ARCHIVE_SIGNATURE)) != 0) {
+        g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR, "%s is not a traffic archive", path);
+        g_free (contents);
+        return NULL;
+    }
+
+    archive = g_new0 (OGDArchive, 1);
+    archive->contents = contents;
+    archive->time_scale = MAX (time_scale, 0);
+    archive->requests = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) free_request);
+
+    cursor = contents + strlen (ARCHIVE_SIGNATURE);
+    end = contents + length;
+
+    while (cursor < end) {
+        if (load_response (archive, &cursor, end) == FALSE) {
+            g_warning ("Archive %s is truncated or corrupted, only the first valid records are used", path);
+            break;
+        }
+    }
+
+    return archive;
+}
+
+void ogd_archive_free (OGDArchive *archive)
+{
+    if (archive->output != NULL)
+        fclose (archive->output);
+
+    if (archive->requests != NULL)
+        g_hash_table_destroy (archive->requests);
+
+    PTR_CHECK_FREE_NULLIFY (archive->contents);
+    g_free (archive);
+}
+
+static void request_queued (SoupSession *session, SoupMessage *msg, OGDArchive *archive)
+{
+    gint64 *start;
+
+    start = g_new (gint64, 1);
+    *start = current_usec ();
+    g_object_set_data_full (G_OBJECT (msg), TIMING_KEY, start, g_free);
+}
+
+static void write_header (const char *name, const char *value, gpointer userdata)
+{
+    fprintf ((FILE*) userdata, "%s: %s\n", name, value);
+}
+
+static void count_header (const char *name, const char *value, gpointer userdata)
+{
+    (*((guint*) userdata))++;
+}
+
+static void request_unqueued (SoupSession *session, SoupMessage *msg, OGDArchive *archive)
+{
+    guint headers;
+    gint64 *start;
+    gchar *query;
+    SoupBuffer *body;
+
+    start = g_object_get_data (G_OBJECT (msg), TIMING_KEY);
+    if (start == NULL || msg->status_code == SOUP_STATUS_CANCELLED)
+        return;
+
+    headers = 0;
+    soup_message_headers_foreach (msg->response_headers, count_header, &headers);
+    body = soup_message_body_flatten (msg->response_body);
+    query = message_to_query (msg);
+
+    fprintf (archive->output, "%s %s %u %" G_GINT64_FORMAT " %u %" G_GSIZE_FORMAT "\n", msg->method, query,
+             msg->status_code, current_usec () - *start, headers, body->length);
+    soup_message_headers_foreach (msg->response_headers, write_header, archive->output);
+    fwrite (body->data, 1, body->length, archive->output);
+    fputs ("\n", archive->output);
+
+    g_free (query);
+    soup_buffer_free (body);
+    g_object_set_data (G_OBJECT (msg), TIMING_KEY, NULL);
+}
+
+/*
+    To be called for each session owned by the OGDProvider, to record messages sent from now on
+*/
+void ogd_archive_watch_session (OGDArchive *archive, SoupSession *session)
+{
+    g_signal_connect (session, "request-queued", G_CALLBACK (request_queued), archive);
+    g_signal_connect (session, "request-unqueued", G_CALLBACK (request_unqueued), archive);
+}
+
+void ogd_archive_unwatch_session (OGDArchive *archive, SoupSession *session)
+{
+    g_signal_handlers_disconnect_matched (session, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, archive);
+    fflush (archive->output);
+}
+
+/*
+    Fills @msg with the response recorded for the same request, or with a 404 status if none is
+    available, and returns the microseconds the caller has to wait before considering the message
+    completed
+*/
+gint64 ogd_archive_replay (OGDArchive *archive, SoupMessage *msg)
+{
+    gchar *query;
+    gchar *key;
+    GList *iter;
+    SoupBuffer *body;
+    ArchivedRequest *request;
+    ArchivedResponse *response;
+
+    query = message_to_query (msg);
+    key = g_strdup_printf ("%s %s", msg->method, query);
+    request = g_hash_table_lookup (archive->requests, key);
+
+    if (request == NULL) {
+        g_warning ("No response in archive for %s", key);
+        soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+        g_free (query);
+        g_free (key);
+        return 0;
+    }
+
+    response = (ArchivedResponse*) request->next->data;
+    if (request->next->next != NULL)
+        request->next = request->next->next;
+
+    soup_message_set_status (msg, response->status);
+    soup_message_headers_clear (msg->response_headers);
+
+    for (iter = response->headers; iter && iter->next; iter = iter->next->next)
+        soup_message_headers_append (msg->response_headers, (gchar*) iter->data, (gchar*) iter->next->data);
+
+    soup_message_body_truncate (msg->response_body);
+    soup_message_body_append (msg->response_body, SOUP_MEMORY_COPY, response->body, response->length);
+    body = soup_message_body_flatten (msg->response_body);
+    soup_buffer_free (body);
+
+    g_free (query);
+    g_free (key);
+    return (gint64) (response->elapsed * archive->time_scale);
+}
@@ -0,0 +1,33 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_ARCHIVE_H
+#define OGD_ARCHIVE_H
+
+#include "ogd-provider-private.h"
+
+typedef struct _OGDArchive OGDArchive;
+
+OGDArchive*     ogd_archive_new_recording           (const gchar *path, GError **error);
+OGDArchive*     ogd_archive_new_replay              (const gchar *path, gdouble time_scale, GError **error);
+void            ogd_archive_free                    (OGDArchive *archive);
+
+void            ogd_archive_watch_session           (OGDArchive *archive, SoupSession *session);
+void            ogd_archive_unwatch_session         (OGDArchive *archive, SoupSession *session);
+gint64          ogd_archive_replay                  (OGDArchive *archive, SoupMessage *msg);
+
+#endif /* OGD_ARCHIVE_H */
@@ -0,0 +1,293 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-arena.h"
+
+/*
+    A refcounted region from which strings and dates of the objects built from the same response
+    are carved, instead of allocating each of them on their own. Memory is obtained in chunks and
+    never given back until the last reference to the arena is dropped, when all chunks are freed
+    at once.
+    While parsing a response the arena is set as current, and helpers used by fill_by_xml()
+    callbacks (MYGETCONTENT() and node_to_date()) allocate from it. Each object keeps a reference
+    to the arena it has been filled from.
+    Finalize callbacks of objects release their fields without knowing where they come from:
+    chunks of all arenas alive are registered in a tree ordered by address, so that
+    ogd_arena_release() may skip memory which belongs to an arena and free the rest as usual. The
+    tree is shared by all threads and guarded by a lock, but is not even looked at while no arena
+    is alive, as when arena allocation is disabled. The current arena is kept per thread, so
+    responses may be parsed concurrently.
+    An arena may also wrap a block of memory it has not allocated (e.g. a mapped file), so that
+    objects may point directly into it
+*/
+
+#define CHUNK_SIZE          4096
+#define ALIGNMENT           sizeof (gdouble)
+
+typedef struct {
+    gchar           *start;
+    gchar           *end;
+    gboolean        borrowed;
+} ArenaChunk;
+
+struct _OGDArena {
+    volatile gint   refs;
+    GList           *chunks;
+    gchar           *cursor;
+    gchar           *limit;
+
+    GDestroyNotify  destroy;
+    gpointer        destroy_data;
+};
+
+static GTree            *LiveChunks         = NULL;
+static volatile gint    LiveArenas          = 0;
+static GStaticPrivate   CurrentArena        = G_STATIC_PRIVATE_INIT;
+
+G_LOCK_DEFINE_STATIC (LiveChunks);
+
+static gint compare_chunks (gconstpointer a, gconstpointer b)
+{
+    const ArenaChunk *first;
+    const ArenaChunk *second;
+
+    first = a;
+    second = b;
+
+    if (first->start < second->start)
+        return -1;
+    else if (first->start > second->start)
+        return 1;
+    else
+        return 0;
+}
+
+static gint search_chunk (gconstpointer key, gconstpointer mem)
+{
+    const ArenaChunk *chunk;
+
+    chunk = key;
+
+    if ((const gchar*) mem < chunk->start)
+        return -1;
+    else if ((const gchar*) mem >= chunk->end)
+        return 1;
+    else
+        return 0;
+}
+
+OGDArena* ogd_arena_new ()
+{
+    OGDArena *arena;
+
+    G_LOCK (LiveChunks);
+
+    if (LiveChunks == NULL)
+        LiveChunks = g_tree_new (compare_chunks);
+
+    G_UNLOCK (LiveChunks);
+
+    arena = g_new0 (OGDArena, 1);
+    arena->refs = 1;
+    g_atomic_int_inc (&LiveArenas);
+    return arena;
+}
+
+OGDArena* ogd_arena_ref (OGDArena *arena)
+{
+    g_atomic_int_inc (&(arena->refs));
+    return arena;
+}
+
+void ogd_arena_unref (OGDArena *arena)
+{
+    GList *iter;
+    ArenaChunk *chunk;
+
+    if (g_atomic_int_dec_and_test (&(arena->refs)) == FALSE)
+        return;
+
+    if (ogd_arena_get_current () == arena)
+        ogd_arena_set_current (NULL);
+
+    G_LOCK (LiveChunks);
+
+    for (iter = arena->chunks; iter; iter = g_list_next (iter))
+        g_tree_remove (LiveChunks, iter->data);
+
+    G_UNLOCK (LiveChunks);
+
+    for (iter = arena->chunks; iter; iter = g_list_next (iter)) {
+        chunk = iter->data;
+
+        if (chunk->borrowed == FALSE)
+            g_free (chunk->start);
+
+        g_free (chunk);
+    }
+
+    if (arena->destroy != NULL)
+        arena->destroy (arena->destroy_data);
+
+    g_list_free (arena->chunks);
+    g_free (arena);
+
+    g_atomic_int_add (&LiveArenas, -1);
+}
+
+/*
+    Params:
+        data:       a block of memory which has to be considered part of the arena
+        size:       size of @data
+        destroy:    function called with @destroy_data when the arena is destroyed, to release
+                    @data (which is never freed by the arena itself)
+
+    Further allocations from the returned arena are carved from new chunks as usual: @data is not
+    touched and may be read-only
+*/
+OGDArena* ogd_arena_new_for_data (gconstpointer data, gsize size, GDestroyNotify destroy, gpointer destroy_data)
+{
+    OGDArena *arena;
+    ArenaChunk *chunk;
+
+    arena = ogd_arena_new ();
+    arena->destroy = destroy;
+    arena->destroy_data = destroy_data;
+
+    if (size != 0) {
+        chunk = g_new0 (ArenaChunk, 1);
+        chunk->start = (gchar*) data;
+        chunk->end = chunk->start + size;
+        chunk->borrowed = TRUE;
+        arena->chunks = g_list_prepend (arena->chunks, chunk);
+
+        G_LOCK (LiveChunks);
+        g_tree_insert (LiveChunks, chunk, chunk);
+        G_UNLOCK (LiveChunks);
+    }
+
+    return arena;
+}
+
+/*
+    Space left in the current chunk is abandoned: this wastes a few bytes at the end of each chunk,
+    but a chunk is dedicated to allocations bigger than usual so that they do not waste more
+*/
+static void new_chunk (OGDArena *arena, gsize size)
+{
+    ArenaChunk *chunk;
+
+    chunk = g_new0 (ArenaChunk, 1);
+    size = MAX (size, CHUNK_SIZE);
+    chunk->start = g_malloc (size);
+    chunk->end = chunk->start + size;
+
+    arena->chunks = g_list_prepend (arena->chunks, chunk);
+    arena->cursor = chunk->start;
+    arena->limit = chunk->end;
+
+    G_LOCK (LiveChunks);
+    g_tree_insert (LiveChunks, chunk, chunk);
+    G_UNLOCK (LiveChunks);
+}
+
+static gpointer carve (OGDArena *arena, gsize size, gboolean aligned)
+{
+    gchar *ret;
+    gsize padding;
+
+    padding = 0;
+
+    if (aligned == TRUE && ((gsize) arena->cursor % ALIGNMENT) != 0)
+        padding = ALIGNMENT - ((gsize) arena->cursor % ALIGNMENT);
+
+    if (arena->cursor == NULL || arena->cursor + padding + size > arena->limit) {
+        new_chunk (arena, size);
+        padding = 0;
+    }
+
+    ret = arena->cursor + padding;
+    arena->cursor = ret + size;
+    return ret;
+}
+
+/*
+    Memory is aligned as required by any structure
+*/
+gpointer ogd_arena_alloc (OGDArena *arena, gsize size)
+{
+    return carve (arena, size, TRUE);
+}
+
+/*
+    @len is the length of @str, excluding the terminator
+*/
+gchar* ogd_arena_strndup (OGDArena *arena, const gchar *str, gsize len)
+{
+    gchar *ret;
+
+    ret = carve (arena, len + 1, FALSE);
+    memcpy (ret, str, len);
+    ret [len] = '\0';
+    return ret;
+}
+
+/*
+    The current arena belongs to the calling thread, and is not referenced: who sets it has to
+    unset it (restoring the previous one, which is returned) before releasing it
+*/
+OGDArena* ogd_arena_set_current (OGDArena *arena)
+{
+    OGDArena *ret;
+
+    ret = g_static_private_get (&CurrentArena);
+    g_static_private_set (&CurrentArena, arena, NULL);
+    return ret;
+}
+
+OGDArena* ogd_arena_get_current ()
+{
+    return g_static_private_get (&CurrentArena);
+}
+
+/*
+    Memory of an arena is only carved while that arena is referenced, so when none is alive @mem
+    cannot belong to one
+*/
+gboolean ogd_arena_owns (gconstpointer mem)
+{
+    gboolean ret;
+
+    if (g_atomic_int_get (&LiveArenas) == 0)
+        return FALSE;
+
+    G_LOCK (LiveChunks);
+    ret = (g_tree_search (LiveChunks, search_chunk, mem) != NULL);
+    G_UNLOCK (LiveChunks);
+
+    return ret;
+}
+
+/*
+    To be used in place of g_free() for all memory which may come from an arena
+*/
+void ogd_arena_release (gpointer mem)
+{
+    if (mem != NULL && ogd_arena_owns (mem) == FALSE)
+        g_free (mem);
+}
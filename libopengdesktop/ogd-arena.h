@@ -0,0 +1,39 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_ARENA_H
+#define OGD_ARENA_H
+
+#include <glib.h>
+
+typedef struct _OGDArena OGDArena;
+
+OGDArena*       ogd_arena_new                       ();
+OGDArena*       ogd_arena_new_for_data              (gconstpointer data, gsize size, GDestroyNotify destroy, gpointer destroy_data);
+OGDArena*       ogd_arena_ref                       (OGDArena *arena);
+void            ogd_arena_unref                     (OGDArena *arena);
+
+gpointer        ogd_arena_alloc                     (OGDArena *arena, gsize size);
+gchar*          ogd_arena_strndup                   (OGDArena *arena, const gchar *str, gsize len);
+
+OGDArena*       ogd_arena_set_current               (OGDArena *arena);
+OGDArena*       ogd_arena_get_current               ();
+
+gboolean        ogd_arena_owns                      (gconstpointer mem);
+void            ogd_arena_release                   (gpointer mem);
+
+#endif /* OGD_ARENA_H */
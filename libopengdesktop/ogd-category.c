@@ -17,6 +17,7 @@
 
 #include "ogd.h"
 #include "ogd-private-utils.h"
+#include "ogd-snapshot-private.h"
 
 #define OGD_CATEGORY_GET_PRIVATE(obj)       (G_TYPE_INSTANCE_GET_PRIVATE ((obj),    \
                                              OGD_CATEGORY_TYPE, OGDCategoryPrivate))
@@ -43,8 +44,10 @@ static void ogd_category_finalize (GObject *obj)
 
     category = OGD_CATEGORY (obj);
 
-    PTR_CHECK_FREE_NULLIFY (category->priv->id);
-    PTR_CHECK_FREE_NULLIFY (category->priv->name);
+    ARENA_CHECK_FREE_NULLIFY (category->priv->id);
+    ARENA_CHECK_FREE_NULLIFY (category->priv->name);
+
+    ogd_object_release_arena (OGD_OBJECT (obj));
 }
 
 static gboolean ogd_category_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
@@ -71,6 +74,11 @@ static gboolean ogd_category_fill_by_xml (OGDObject *obj, const xmlNode *xml, GE
     return TRUE;
 }
 
+static const gchar* ogd_category_get_object_id (OGDObject *obj)
+{
+    return ogd_category_get_id (OGD_CATEGORY (obj));
+}
+
 static void ogd_category_class_init (OGDCategoryClass *klass)
 {
     GObjectClass *gobject_class;
@@ -83,6 +91,7 @@ static void ogd_category_class_init (OGDCategoryClass *klass)
 
     ogd_object_class = OGD_OBJECT_CLASS (klass);
     ogd_object_class->fill_by_xml = ogd_category_fill_by_xml;
+    ogd_object_class_set_id_func (ogd_object_class, ogd_category_get_object_id);
 }
 
 static void ogd_category_init (OGDCategory *item)
@@ -91,6 +100,43 @@ static void ogd_category_init (OGDCategory *item)
     memset (item->priv, 0, sizeof (OGDCategoryPrivate));
 }
 
+static const OGD_SNAPSHOT_KIND CategorySnapshotKinds [] = {
+    OGD_SNAPSHOT_STRING,        /* id */
+    OGD_SNAPSHOT_STRING,        /* name */
+};
+
+static void ogd_category_to_snapshot (OGDObject *obj, OGDSnapshotValue *values)
+{
+    OGDCategory *category;
+
+    category = OGD_CATEGORY (obj);
+    values [0].string = category->priv->id;
+    values [1].string = category->priv->name;
+}
+
+static void ogd_category_fill_by_snapshot (OGDObject *obj, const OGDSnapshotValue *values)
+{
+    OGDCategory *category;
+
+    category = OGD_CATEGORY (obj);
+    ogd_category_finalize (G_OBJECT (obj));
+
+    category->priv->id = (gchar*) values [0].string;
+    category->priv->name = (gchar*) values [1].string;
+}
+
+const OGDSnapshotSchema* ogd_category_get_snapshot_schema ()
+{
+    static const OGDSnapshotSchema schema = {
+        G_N_ELEMENTS (CategorySnapshotKinds),
+        CategorySnapshotKinds,
+        ogd_category_to_snapshot,
+        ogd_category_fill_by_snapshot
+    };
+
+    return &schema;
+}
+
 /**
  * ogd_category_new_by_id:
  * @provider:       the parent #OGDProvider of the desidered category
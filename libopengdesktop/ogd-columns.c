@@ -0,0 +1,373 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libxml/xmlreader.h>
+
+#include "ogd.h"
+#include "ogd-columns.h"
+#include "ogd-private-utils.h"
+
+/**
+ * SECTION: ogd-columns
+ * @short_description:  bulk storage of scalar values of many contents
+ *
+ * When long lists of contents are only used for analysis, building an #OGDContent for each of
+ * them is expensive and wastes memory. An #OGDContentColumns keeps just the scalar values, column
+ * by column, and is filled reading the responses of the server as a stream, without building the
+ * XML tree nor any object
+ */
+
+#define INITIAL_ROWS        64
+
+typedef enum {
+    COLUMN_NONE,
+    COLUMN_ID,
+    COLUMN_TYPEID,
+    COLUMN_DOWNLOADS,
+    COLUMN_SCORE,
+    COLUMN_CREATED,
+    COLUMN_CHANGED,
+    COLUMN_PERSONID,
+    COLUMN_STATUS,
+    COLUMN_MESSAGE
+} COLUMN;
+
+/**
+ * ogd_content_columns_new:
+ *
+ * To allocate an empty #OGDContentColumns
+ *
+ * Return value:    a newly allocated #OGDContentColumns, to be freed with
+ *                  ogd_content_columns_free()
+ */
+OGDContentColumns* ogd_content_columns_new ()
+{
+    OGDContentColumns *columns;
+
+    columns = g_new0 (OGDContentColumns, 1);
+    columns->strings = g_string_chunk_new (4096);
+    return columns;
+}
+
+/**
+ * ogd_content_columns_free:
+ * @columns:        the #OGDContentColumns to free
+ *
+ * Frees all arrays and strings of @columns
+ */
+void ogd_content_columns_free (OGDContentColumns *columns)
+{
+    g_free (columns->ids);
+    g_free (columns->typeids);
+    g_free (columns->downloads);
+    g_free (columns->scores);
+    g_free (columns->created);
+    g_free (columns->changed);
+    g_free (columns->personids);
+    g_string_chunk_free (columns->strings);
+    g_free (columns);
+}
+
+static void append_row (OGDContentColumns *columns)
+{
+    gulong row;
+
+    if (columns->rows == columns->allocated) {
+        columns->allocated = MAX (columns->allocated * 2, INITIAL_ROWS);
+        columns->ids = g_renew (const gchar*, columns->ids, columns->allocated);
+        columns->typeids = g_renew (guint, columns->typeids, columns->allocated);
+        columns->downloads = g_renew (guint, columns->downloads, columns->allocated);
+        columns->scores = g_renew (guint, columns->scores, columns->allocated);
+        columns->created = g_renew (gint64, columns->created, columns->allocated);
+        columns->changed = g_renew (gint64, columns->changed, columns->allocated);
+        columns->personids = g_renew (const gchar*, columns->personids, columns->allocated);
+    }
+
+    row = columns->rows;
+    columns->ids [row] = NULL;
+    columns->typeids [row] = 0;
+    columns->downloads [row] = 0;
+    columns->scores [row] = 0;
+    columns->created [row] = 0;
+    columns->changed [row] = 0;
+    columns->personids [row] = NULL;
+    columns->rows++;
+}
+
+/*
+    Dates of objects have no time, so midnight is assumed. 719163 is the julian day of the Epoch
+*/
+static gint64 date_to_time (const GDate *date)
+{
+    if (date == NULL || g_date_valid (date) == FALSE)
+        return 0;
+
+    return ((gint64) g_date_get_julian (date) - 719163) * 86400;
+}
+
+static guint string_to_uint (const gchar *value)
+{
+    if (value == NULL)
+        return 0;
+
+    return (guint) g_ascii_strtoull (value, NULL, 10);
+}
+
+static const gchar* intern (OGDContentColumns *columns, const gchar *value)
+{
+    if (value == NULL)
+        return NULL;
+
+    return g_string_chunk_insert_const (columns->strings, value);
+}
+
+/**
+ * ogd_content_columns_append_contents:
+ * @columns:        #OGDContentColumns to which append the contents
+ * @contents:       a #GList of #OGDContent
+ *
+ * Appends a row for each content in the list, so that contents already fetched as objects (for
+ * example kept in a cache) may be analyzed as those fetched in columns. The creation date of
+ * #OGDContent has no time, so midnight of the day is used
+ */
+void ogd_content_columns_append_contents (OGDContentColumns *columns, GList *contents)
+{
+    gulong row;
+    GList *iter;
+    OGDContent *content;
+    OGDCategory *category;
+
+    for (iter = contents; iter; iter = g_list_next (iter)) {
+        content = OGD_CONTENT (iter->data);
+        category = (OGDCategory*) ogd_content_get_category (content);
+
+        append_row (columns);
+        row = columns->rows - 1;
+
+        columns->ids [row] = intern (columns, ogd_content_get_id (content));
+        columns->typeids [row] = (category != NULL) ? string_to_uint (ogd_category_get_id (category)) : 0;
+        columns->downloads [row] = (guint) ogd_content_get_num_downloads (content);
+        columns->scores [row] = ogd_content_get_score (content);
+        columns->created [row] = date_to_time (ogd_content_get_creation_date (content));
+        columns->changed [row] = ogd_content_get_change_time (content);
+        columns->personids [row] = intern (columns, ogd_content_get_authorid (content));
+    }
+}
+
+static COLUMN name_to_column (const gchar *name)
+{
+    if (strcmp (name, "id") == 0)
+        return COLUMN_ID;
+    else if (strcmp (name, "typeid") == 0)
+        return COLUMN_TYPEID;
+    else if (strcmp (name, "downloads") == 0)
+        return COLUMN_DOWNLOADS;
+    else if (strcmp (name, "score") == 0)
+        return COLUMN_SCORE;
+    else if (strcmp (name, "created") == 0)
+        return COLUMN_CREATED;
+    else if (strcmp (name, "changed") == 0)
+        return COLUMN_CHANGED;
+    else if (strcmp (name, "personid") == 0)
+        return COLUMN_PERSONID;
+    else
+        return COLUMN_NONE;
+}
+
+static gint64 string_to_time (const gchar *value)
+{
+    GTimeVal timeval;
+
+    if (g_time_val_from_iso8601 (value, &timeval))
+        return timeval.tv_sec;
+    else
+        return 0;
+}
+
+static void set_column (OGDContentColumns *columns, COLUMN column, const gchar *value)
+{
+    gulong row;
+
+    row = columns->rows - 1;
+
+    switch (column) {
+        case COLUMN_ID:
+            columns->ids [row] = intern (columns, value);
+            break;
+
+        case COLUMN_TYPEID:
+            columns->typeids [row] = string_to_uint (value);
+            break;
+
+        case COLUMN_DOWNLOADS:
+            columns->downloads [row] = string_to_uint (value);
+            break;
+
+        case COLUMN_SCORE:
+            columns->scores [row] = string_to_uint (value);
+            break;
+
+        case COLUMN_CREATED:
+            columns->created [row] = string_to_time (value);
+            break;
+
+        case COLUMN_CHANGED:
+            columns->changed [row] = string_to_time (value);
+            break;
+
+        case COLUMN_PERSONID:
+            columns->personids [row] = intern (columns, value);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void set_status_error (GError **error, const gchar *message)
+{
+    if (message != NULL)
+        g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                     "Failed to retrieve informations on server: %s", message);
+    else
+        g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                     "Failed to retrieve informations on server");
+}
+
+/*
+    Reads a complete OCS response and appends a row for each content found in it. The document is
+    read as a stream: <ocs> is at depth 0, so <status> is found at depth 1 or 2 (if wrapped into
+    <meta>), each <content> at depth 2 and its values at depth 3, and text is always read in place
+    from the reader. When the response is not valid no row is added.
+    Returns the number of rows added
+*/
+gulong ogd_content_columns_parse (OGDContentColumns *columns, const gchar *buffer, gsize length, GError **error)
+{
+    int ret;
+    int type;
+    int depth;
+    gulong start;
+    gboolean in_content;
+    gboolean status_ok;
+    gboolean failed;
+    gchar *message;
+    const gchar *name;
+    const gchar *value;
+    COLUMN column;
+    xmlTextReaderPtr reader;
+
+    reader = xmlReaderForMemory (buffer, length, NULL, NULL, XML_PARSE_NOBLANKS);
+    if (reader == NULL) {
+        g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                     "Unable to parse response from server.");
+        return 0;
+    }
+
+    ret = 0;
+    start = columns->rows;
+    in_content = FALSE;
+    status_ok = FALSE;
+    failed = FALSE;
+    message = NULL;
+    column = COLUMN_NONE;
+
+    while (failed == FALSE && (ret = xmlTextReaderRead (reader)) == 1) {
+        type = xmlTextReaderNodeType (reader);
+        depth = xmlTextReaderDepth (reader);
+
+        switch (type) {
+            case XML_READER_TYPE_ELEMENT:
+                name = (const gchar*) xmlTextReaderConstLocalName (reader);
+
+                if (depth == 0 && strcmp (name, "ocs") != 0) {
+                    g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR, "Unidentified root XML block");
+                    failed = TRUE;
+                }
+                else if ((depth == 1 || depth == 2) && in_content == FALSE && strcmp (name, "status") == 0) {
+                    column = COLUMN_STATUS;
+                }
+                else if ((depth == 1 || depth == 2) && in_content == FALSE && strcmp (name, "message") == 0) {
+                    column = COLUMN_MESSAGE;
+                }
+                else if (depth == 2 && strcmp (name, "content") == 0) {
+                    if (status_ok == FALSE) {
+                        set_status_error (error, message);
+                        failed = TRUE;
+                    }
+                    else {
+                        append_row (columns);
+                        in_content = TRUE;
+                    }
+                }
+                else if (depth == 3 && in_content == TRUE) {
+                    column = name_to_column (name);
+                }
+
+                if (xmlTextReaderIsEmptyElement (reader) == 1) {
+                    column = COLUMN_NONE;
+
+                    if (depth == 2)
+                        in_content = FALSE;
+                }
+
+                break;
+
+            case XML_READER_TYPE_TEXT:
+            case XML_READER_TYPE_CDATA:
+                value = (const gchar*) xmlTextReaderConstValue (reader);
+
+                if (column == COLUMN_STATUS)
+                    status_ok = (strcmp (value, "ok") == 0);
+                else if (column == COLUMN_MESSAGE && message == NULL)
+                    message = g_strdup (value);
+                else if (column != COLUMN_NONE)
+                    set_column (columns, column, value);
+
+                break;
+
+            case XML_READER_TYPE_END_ELEMENT:
+                column = COLUMN_NONE;
+
+                if (depth == 2)
+                    in_content = FALSE;
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (failed == FALSE) {
+        if (ret == -1) {
+            g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                         "Unable to parse response from server.");
+            failed = TRUE;
+        }
+        else if (status_ok == FALSE) {
+            set_status_error (error, message);
+            failed = TRUE;
+        }
+    }
+
+    if (failed == TRUE)
+        columns->rows = start;
+
+    g_free (message);
+    xmlFreeTextReader (reader);
+    return columns->rows - start;
+}
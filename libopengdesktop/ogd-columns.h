@@ -0,0 +1,63 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_COLUMNS_H
+#define OGD_COLUMNS_H
+
+G_BEGIN_DECLS
+
+/**
+ * OGDContentColumns:
+ * @rows:           number of contents stored
+ * @ids:            ID of each content
+ * @typeids:        ID of the category of each content
+ * @downloads:      number of downloads of each content
+ * @scores:         score of each content
+ * @created:        creation time of each content, in seconds since the Epoch, or 0 if unknown
+ * @changed:        time of the last change of each content, in seconds since the Epoch, or 0 if
+ *                  unknown
+ * @personids:      ID of the author of each content
+ *
+ * Scalar values of many contents, stored column by column in contiguous arrays of @rows elements:
+ * the i-th content is described by the i-th element of each array. Strings are interned, so
+ * equal strings are always the same pointer and may be compared directly. Filled with
+ * ogd_iterator_fetch_next_columns() and ogd_iterator_fetch_all_columns(), which do not build any
+ * #OGDContent, or with ogd_content_columns_append_contents(). All arrays and strings are owned by
+ * the structure, and arrays may be moved when new rows are added
+ */
+typedef struct {
+    gulong          rows;
+    const gchar     **ids;
+    guint           *typeids;
+    guint           *downloads;
+    guint           *scores;
+    gint64          *created;
+    gint64          *changed;
+    const gchar     **personids;
+
+    /*< private >*/
+    gulong          allocated;
+    GStringChunk    *strings;
+} OGDContentColumns;
+
+OGDContentColumns*  ogd_content_columns_new                 ();
+void                ogd_content_columns_free                (OGDContentColumns *columns);
+void                ogd_content_columns_append_contents     (OGDContentColumns *columns, GList *contents);
+
+G_END_DECLS
+
+#endif /* OGD_COLUMNS_H */
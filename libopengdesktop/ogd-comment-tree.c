@@ -0,0 +1,571 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libxml/xmlreader.h>
+
+#include "ogd.h"
+#include "ogd-comment-tree.h"
+#include "ogd-private-utils.h"
+
+/**
+ * SECTION: ogd-comment-tree
+ * @short_description:  compact representation of long threads of comments
+ *
+ * An #OGDCommentTree holds the comments of an #OGDContent or an #OGDEvent without building an
+ * #OGDComment for each of them, and is filled one page of threads at a time reading responses
+ * of the server as a stream, so that the first comments are available as soon as possible and
+ * memory grows only with the threads actually loaded.
+ * Comments are identified by their index, from 0 to ogd_comment_tree_get_length() - 1, and are
+ * stored in depth-first order: each comment is followed by its replies. The tree may be walked
+ * with ogd_comment_tree_get_first_child() and ogd_comment_tree_get_next_sibling() (the first
+ * thread is at index 0), or just scanned in order using ogd_comment_tree_get_depth() for
+ * indentation. Indexes are stable: loading more pages only appends new comments
+ */
+
+#define DEFAULT_PAGE_SIZE       20
+
+typedef struct {
+    const gchar     *id;
+    const gchar     *authorid;
+    const gchar     *subject;
+    const gchar     *message;
+    gint64          date;
+    gint            parent;
+    gint            first_child;
+    gint            next_sibling;
+    guint           depth;
+} CommentNode;
+
+typedef enum {
+    FIELD_NONE,
+    FIELD_ID,
+    FIELD_AUTHOR,
+    FIELD_DATE,
+    FIELD_SUBJECT,
+    FIELD_MESSAGE,
+    FIELD_STATUS,
+    FIELD_STATUS_MESSAGE
+} FIELD;
+
+/*
+    Used while parsing, for each <comment> still open
+*/
+typedef struct {
+    gint            index;
+    int             depth;
+    gint            last_child;
+} OpenComment;
+
+struct _OGDCommentTree {
+    OGDProvider     *provider;
+    guint           target_type;
+    gchar           *target_id;
+
+    guint           page_size;
+    guint           next_page;
+    gboolean        more;
+
+    GArray          *nodes;
+    OGDArena        *arena;
+    gint            last_root;
+};
+
+/*
+    Params:
+        target_type:    type of the commented item, as used by the OCS API (1 for contents, 8 for
+                        events)
+*/
+OGDCommentTree* ogd_comment_tree_new (OGDProvider *provider, guint target_type, const gchar *target_id)
+{
+    OGDCommentTree *tree;
+
+    tree = g_new0 (OGDCommentTree, 1);
+    tree->provider = provider;
+    tree->target_type = target_type;
+    tree->target_id = g_strdup (target_id);
+    tree->page_size = DEFAULT_PAGE_SIZE;
+    tree->more = TRUE;
+    tree->nodes = g_array_new (FALSE, FALSE, sizeof (CommentNode));
+    tree->arena = ogd_arena_new ();
+    tree->last_root = -1;
+    return tree;
+}
+
+/**
+ * ogd_comment_tree_free:
+ * @tree:           the #OGDCommentTree to free
+ *
+ * Frees a #OGDCommentTree and all strings read from it
+ */
+void ogd_comment_tree_free (OGDCommentTree *tree)
+{
+    g_free (tree->target_id);
+    g_array_free (tree->nodes, TRUE);
+    ogd_arena_unref (tree->arena);
+    g_free (tree);
+}
+
+/**
+ * ogd_comment_tree_set_page_size:
+ * @tree:           the #OGDCommentTree to configure
+ * @size:           number of threads to request with each page
+ *
+ * To set how many threads (comments which are not replies, along with all their replies) are
+ * loaded by each call to ogd_comment_tree_fetch_next_page(). Default is 20
+ */
+void ogd_comment_tree_set_page_size (OGDCommentTree *tree, guint size)
+{
+    tree->page_size = MAX (size, 1);
+}
+
+static CommentNode* node_at (OGDCommentTree *tree, gint index)
+{
+    return &g_array_index (tree->nodes, CommentNode, index);
+}
+
+static gint append_node (OGDCommentTree *tree, GArray *open)
+{
+    gint index;
+    CommentNode node;
+    OpenComment *parent;
+
+    memset (&node, 0, sizeof (CommentNode));
+    node.parent = -1;
+    node.first_child = -1;
+    node.next_sibling = -1;
+    node.depth = open->len;
+
+    index = tree->nodes->len;
+
+    if (open->len != 0) {
+        parent = &g_array_index (open, OpenComment, open->len - 1);
+        node.parent = parent->index;
+
+        if (parent->last_child == -1)
+            node_at (tree, parent->index)->first_child = index;
+        else
+            node_at (tree, parent->last_child)->next_sibling = index;
+
+        parent->last_child = index;
+    }
+    else {
+        if (tree->last_root != -1)
+            node_at (tree, tree->last_root)->next_sibling = index;
+
+        tree->last_root = index;
+    }
+
+    g_array_append_val (tree->nodes, node);
+    return index;
+}
+
+static FIELD name_to_field (const gchar *name)
+{
+    if (strcmp (name, "id") == 0)
+        return FIELD_ID;
+    else if (strcmp (name, "user") == 0)
+        return FIELD_AUTHOR;
+    else if (strcmp (name, "date") == 0)
+        return FIELD_DATE;
+    else if (strcmp (name, "subject") == 0)
+        return FIELD_SUBJECT;
+    else if (strcmp (name, "text") == 0)
+        return FIELD_MESSAGE;
+    else
+        return FIELD_NONE;
+}
+
+static void set_field (OGDCommentTree *tree, gint index, FIELD field, const gchar *value)
+{
+    GTimeVal timeval;
+    CommentNode *node;
+
+    node = node_at (tree, index);
+
+    switch (field) {
+        case FIELD_ID:
+            node->id = ogd_arena_strndup (tree->arena, value, strlen (value));
+            break;
+
+        case FIELD_AUTHOR:
+            node->authorid = ogd_arena_strndup (tree->arena, value, strlen (value));
+            break;
+
+        case FIELD_DATE:
+            if (g_time_val_from_iso8601 (value, &timeval))
+                node->date = timeval.tv_sec;
+            break;
+
+        case FIELD_SUBJECT:
+            node->subject = ogd_arena_strndup (tree->arena, value, strlen (value));
+            break;
+
+        case FIELD_MESSAGE:
+            node->message = ogd_arena_strndup (tree->arena, value, strlen (value));
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void set_status_error (GError **error, const gchar *message)
+{
+    if (message != NULL)
+        g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                     "Failed to retrieve informations on server: %s", message);
+    else
+        g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                     "Failed to retrieve informations on server");
+}
+
+/*
+    Reads a page of comments as a stream. Each <comment> is appended to the tree when it is
+    opened, so that its replies (found into <childs>) follow it; values are read from elements
+    which are direct children of the innermost <comment> still open. When the response is not
+    valid the tree is left as it was.
+    Returns the number of threads found, used to know if another page exists
+*/
+static gulong parse_comments_page (OGDCommentTree *tree, const gchar *buffer, gsize length, GError **error)
+{
+    int ret;
+    int type;
+    int depth;
+    guint start;
+    gint previous_root;
+    gulong threads;
+    gboolean status_ok;
+    gboolean failed;
+    gchar *message;
+    const gchar *name;
+    const gchar *value;
+    FIELD field;
+    GArray *open;
+    OpenComment *current;
+    OpenComment comment;
+    xmlTextReaderPtr reader;
+
+    reader = xmlReaderForMemory (buffer, length, NULL, NULL, XML_PARSE_NOBLANKS);
+    if (reader == NULL) {
+        g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                     "Unable to parse response from server.");
+        return 0;
+    }
+
+    ret = 0;
+    start = tree->nodes->len;
+    previous_root = tree->last_root;
+    threads = 0;
+    status_ok = FALSE;
+    failed = FALSE;
+    message = NULL;
+    field = FIELD_NONE;
+    open = g_array_new (FALSE, FALSE, sizeof (OpenComment));
+
+    while (failed == FALSE && (ret = xmlTextReaderRead (reader)) == 1) {
+        type = xmlTextReaderNodeType (reader);
+        depth = xmlTextReaderDepth (reader);
+        current = (open->len != 0) ? &g_array_index (open, OpenComment, open->len - 1) : NULL;
+
+        switch (type) {
+            case XML_READER_TYPE_ELEMENT:
+                name = (const gchar*) xmlTextReaderConstLocalName (reader);
+
+                if (depth == 0 && strcmp (name, "ocs") != 0) {
+                    g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR, "Unidentified root XML block");
+                    failed = TRUE;
+                }
+                else if ((depth == 1 || depth == 2) && current == NULL && strcmp (name, "status") == 0) {
+                    field = FIELD_STATUS;
+                }
+                else if ((depth == 1 || depth == 2) && current == NULL && strcmp (name, "message") == 0) {
+                    field = FIELD_STATUS_MESSAGE;
+                }
+                else if (depth >= 2 && strcmp (name, "comment") == 0) {
+                    if (status_ok == FALSE) {
+                        set_status_error (error, message);
+                        failed = TRUE;
+                        break;
+                    }
+
+                    if (current == NULL)
+                        threads++;
+
+                    comment.index = append_node (tree, open);
+                    comment.depth = depth;
+                    comment.last_child = -1;
+
+                    if (xmlTextReaderIsEmptyElement (reader) == 0)
+                        g_array_append_val (open, comment);
+                }
+                else if (current != NULL && depth == current->depth + 1) {
+                    field = name_to_field (name);
+                }
+
+                if (xmlTextReaderIsEmptyElement (reader) == 1)
+                    field = FIELD_NONE;
+
+                break;
+
+            case XML_READER_TYPE_TEXT:
+            case XML_READER_TYPE_CDATA:
+                value = (const gchar*) xmlTextReaderConstValue (reader);
+
+                if (field == FIELD_STATUS)
+                    status_ok = (strcmp (value, "ok") == 0);
+                else if (field == FIELD_STATUS_MESSAGE && message == NULL)
+                    message = g_strdup (value);
+                else if (field != FIELD_NONE && current != NULL)
+                    set_field (tree, current->index, field, value);
+
+                break;
+
+            case XML_READER_TYPE_END_ELEMENT:
+                field = FIELD_NONE;
+
+                if (current != NULL && depth == current->depth)
+                    g_array_set_size (open, open->len - 1);
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (failed == FALSE) {
+        if (ret == -1) {
+            g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                         "Unable to parse response from server.");
+            failed = TRUE;
+        }
+        else if (status_ok == FALSE) {
+            set_status_error (error, message);
+            failed = TRUE;
+        }
+    }
+
+    /*
+        Strings already copied in the arena are lost until the tree is freed
+    */
+    if (failed == TRUE) {
+        g_array_set_size (tree->nodes, start);
+        tree->last_root = previous_root;
+
+        if (previous_root != -1)
+            node_at (tree, previous_root)->next_sibling = -1;
+
+        threads = 0;
+    }
+
+    g_array_free (open, TRUE);
+    g_free (message);
+    xmlFreeTextReader (reader);
+    return threads;
+}
+
+/**
+ * ogd_comment_tree_fetch_next_page:
+ * @tree:           the #OGDCommentTree to fill
+ * @error:          a #GError filled if the request fails
+ *
+ * Requests to the server the next page of threads and appends them to @tree
+ *
+ * Return value:    the number of comments added, replies included. 0 if no more comments exist
+ *                  or an error occurred
+ */
+gulong ogd_comment_tree_fetch_next_page (OGDCommentTree *tree, GError **error)
+{
+    guint start;
+    gulong threads;
+    gchar *query;
+    GError *page_error;
+
+    if (tree->more == FALSE)
+        return 0;
+
+    start = tree->nodes->len;
+    page_error = NULL;
+
+    query = g_strdup_printf ("comments/data/%u/%s/0?page=%u&pagesize=%u", tree->target_type, tree->target_id,
+                             tree->next_page, tree->page_size);
+    threads = ogd_provider_get_stream (tree->provider, query, "comments", (OGDProviderStreamParser) parse_comments_page,
+                                       tree, &page_error);
+    g_free (query);
+
+    if (page_error != NULL) {
+        g_propagate_error (error, page_error);
+        return 0;
+    }
+
+    tree->next_page++;
+    tree->more = (threads >= tree->page_size);
+    return tree->nodes->len - start;
+}
+
+/**
+ * ogd_comment_tree_has_more:
+ * @tree:           the #OGDCommentTree to query
+ *
+ * To know if other pages of threads may be requested with ogd_comment_tree_fetch_next_page()
+ *
+ * Return value:    %FALSE if the last page has already been loaded, %TRUE otherwise
+ */
+gboolean ogd_comment_tree_has_more (OGDCommentTree *tree)
+{
+    return tree->more;
+}
+
+/**
+ * ogd_comment_tree_get_length:
+ * @tree:           the #OGDCommentTree to query
+ *
+ * To know how many comments have been loaded, replies included
+ *
+ * Return value:    number of comments in @tree
+ */
+guint ogd_comment_tree_get_length (OGDCommentTree *tree)
+{
+    return tree->nodes->len;
+}
+
+/**
+ * ogd_comment_tree_get_parent:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve the comment to which the comment at @index replies
+ *
+ * Return value:    index of the parent comment, or -1 if @index is the first of a thread
+ */
+gint ogd_comment_tree_get_parent (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->parent;
+}
+
+/**
+ * ogd_comment_tree_get_first_child:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve the first reply to a comment. It is always @index + 1, if any
+ *
+ * Return value:    index of the first reply, or -1 if the comment has no replies
+ */
+gint ogd_comment_tree_get_first_child (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->first_child;
+}
+
+/**
+ * ogd_comment_tree_get_next_sibling:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve the next comment replying to the same parent, or the next thread if @index is the
+ * first comment of a thread
+ *
+ * Return value:    index of the next sibling, or -1 if none has been loaded
+ */
+gint ogd_comment_tree_get_next_sibling (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->next_sibling;
+}
+
+/**
+ * ogd_comment_tree_get_depth:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve the level of a comment in its thread
+ *
+ * Return value:    0 for the first comment of a thread, 1 for replies to it, and so on
+ */
+guint ogd_comment_tree_get_depth (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->depth;
+}
+
+/**
+ * ogd_comment_tree_get_id:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve the ID of a comment
+ *
+ * Return value:    ID of the comment, owned by @tree
+ */
+const gchar* ogd_comment_tree_get_id (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->id;
+}
+
+/**
+ * ogd_comment_tree_get_authorid:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve the author of a comment
+ *
+ * Return value:    ID of the #OGDPerson who wrote the comment, owned by @tree
+ */
+const gchar* ogd_comment_tree_get_authorid (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->authorid;
+}
+
+/**
+ * ogd_comment_tree_get_date:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve when a comment has been written
+ *
+ * Return value:    seconds since the Epoch, or 0 if unknown
+ */
+gint64 ogd_comment_tree_get_date (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->date;
+}
+
+/**
+ * ogd_comment_tree_get_subject:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve the subject of a comment
+ *
+ * Return value:    subject of the comment, owned by @tree
+ */
+const gchar* ogd_comment_tree_get_subject (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->subject;
+}
+
+/**
+ * ogd_comment_tree_get_message:
+ * @tree:           the #OGDCommentTree to query
+ * @index:          index of a comment
+ *
+ * To retrieve the text of a comment
+ *
+ * Return value:    text of the comment, owned by @tree
+ */
+const gchar* ogd_comment_tree_get_message (OGDCommentTree *tree, guint index)
+{
+    return node_at (tree, index)->message;
+}
@@ -0,0 +1,45 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_COMMENT_TREE_H
+#define OGD_COMMENT_TREE_H
+
+G_BEGIN_DECLS
+
+typedef struct _OGDCommentTree OGDCommentTree;
+
+void            ogd_comment_tree_free               (OGDCommentTree *tree);
+
+void            ogd_comment_tree_set_page_size      (OGDCommentTree *tree, guint size);
+gulong          ogd_comment_tree_fetch_next_page    (OGDCommentTree *tree, GError **error);
+gboolean        ogd_comment_tree_has_more           (OGDCommentTree *tree);
+
+guint           ogd_comment_tree_get_length         (OGDCommentTree *tree);
+gint            ogd_comment_tree_get_parent         (OGDCommentTree *tree, guint index);
+gint            ogd_comment_tree_get_first_child    (OGDCommentTree *tree, guint index);
+gint            ogd_comment_tree_get_next_sibling   (OGDCommentTree *tree, guint index);
+guint           ogd_comment_tree_get_depth          (OGDCommentTree *tree, guint index);
+
+const gchar*    ogd_comment_tree_get_id             (OGDCommentTree *tree, guint index);
+const gchar*    ogd_comment_tree_get_authorid       (OGDCommentTree *tree, guint index);
+gint64          ogd_comment_tree_get_date           (OGDCommentTree *tree, guint index);
+const gchar*    ogd_comment_tree_get_subject        (OGDCommentTree *tree, guint index);
+const gchar*    ogd_comment_tree_get_message        (OGDCommentTree *tree, guint index);
+
+G_END_DECLS
+
+#endif /* OGD_COMMENT_TREE_H */
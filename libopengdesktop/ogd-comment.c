@@ -49,12 +49,14 @@ static void ogd_comment_finalize (GObject *obj)
 
     msg = OGD_COMMENT (obj);
 
-    PTR_CHECK_FREE_NULLIFY (msg->priv->id);
-    PTR_CHECK_FREE_NULLIFY (msg->priv->authorid);
+    ARENA_CHECK_FREE_NULLIFY (msg->priv->id);
+    ARENA_CHECK_FREE_NULLIFY (msg->priv->authorid);
     DATE_CHECK_FREE_NULLIFY (msg->priv->date);
-    PTR_CHECK_FREE_NULLIFY (msg->priv->subject);
-    PTR_CHECK_FREE_NULLIFY (msg->priv->message);
+    ARENA_CHECK_FREE_NULLIFY (msg->priv->subject);
+    ARENA_CHECK_FREE_NULLIFY (msg->priv->message);
     FREE_LIST_OF_OBJECTS (msg->priv->children);
+
+    ogd_object_release_arena (OGD_OBJECT (obj));
 }
 
 static gboolean ogd_comment_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
@@ -97,7 +99,7 @@ static gboolean ogd_comment_fill_by_xml (OGDObject *obj, const xmlNode *xml, GEr
                 child = g_object_new (OGD_COMMENT_TYPE, NULL);
                 msg->priv->children = g_list_prepend (msg->priv->children, child);
 
-                if (ogd_comment_fill_by_xml (OGD_OBJECT (child), children, error) == FALSE)
+                if (ogd_object_fill_by_xml (OGD_OBJECT (child), children, error) == FALSE)
                     return FALSE;
 
                 ogd_object_set_provider (OGD_OBJECT (child), provider);
@@ -111,6 +113,11 @@ static gboolean ogd_comment_fill_by_xml (OGDObject *obj, const xmlNode *xml, GEr
     return TRUE;
 }
 
+static const gchar* ogd_comment_get_object_id (OGDObject *obj)
+{
+    return (const gchar*) OGD_COMMENT (obj)->priv->id;
+}
+
 static void ogd_comment_class_init (OGDCommentClass *klass)
 {
     GObjectClass *gobject_class;
@@ -123,6 +130,7 @@ static void ogd_comment_class_init (OGDCommentClass *klass)
 
     ogd_object_class = OGD_OBJECT_CLASS (klass);
     ogd_object_class->fill_by_xml = ogd_comment_fill_by_xml;
+    ogd_object_class_set_id_func (ogd_object_class, ogd_comment_get_object_id);
 }
 
 static void ogd_comment_init (OGDComment *item)
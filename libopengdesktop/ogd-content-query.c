@@ -0,0 +1,332 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-content-query.h"
+#include "ogd-private-utils.h"
+
+/**
+ * SECTION: ogd-content-query
+ * @short_description:  local ranking and aggregation of contents
+ *
+ * The server sorts contents only in the ways listed by #OGD_CATEGORY_SORTING, and one category at
+ * a time. Those functions answer other questions over contents already fetched into an
+ * #OGDContentColumns, without any further request: the best contents by any value, also merging
+ * many categories, and totals for each author or category.
+ * Values are read from contiguous arrays with simple loops, and ranking keeps only the best
+ * elements in a heap, so large sets of contents are handled without sorting them all
+ */
+
+/*
+    Copies the values used as ranking key into a single array, so the following passes do not
+    care about the column and its type
+*/
+static gint64* extract_key (const OGDContentColumns *columns, OGD_CONTENT_QUERY_KEY key)
+{
+    gulong i;
+    gint64 *ret;
+
+    ret = g_new (gint64, columns->rows);
+
+    switch (key) {
+        case OGD_CONTENT_QUERY_DOWNLOADS:
+            for (i = 0; i < columns->rows; i++)
+                ret [i] = columns->downloads [i];
+            break;
+
+        case OGD_CONTENT_QUERY_SCORE:
+            for (i = 0; i < columns->rows; i++)
+                ret [i] = columns->scores [i];
+            break;
+
+        case OGD_CONTENT_QUERY_CHANGED:
+            memcpy (ret, columns->changed, columns->rows * sizeof (gint64));
+            break;
+
+        case OGD_CONTENT_QUERY_CREATED:
+            memcpy (ret, columns->created, columns->rows * sizeof (gint64));
+            break;
+    }
+
+    return ret;
+}
+
+/*
+    Returns an array of flags telling which rows belong to one of the given categories, or NULL if
+    all rows are accepted
+*/
+static guint8* filter_categories (const OGDContentColumns *columns, const guint *typeids, guint n_typeids)
+{
+    guint j;
+    gulong i;
+    guint8 *ret;
+
+    if (typeids == NULL || n_typeids == 0)
+        return NULL;
+
+    ret = g_new0 (guint8, columns->rows);
+
+    for (j = 0; j < n_typeids; j++)
+        for (i = 0; i < columns->rows; i++)
+            ret [i] |= (columns->typeids [i] == typeids [j]);
+
+    return ret;
+}
+
+/*
+    Rows are compared by value, and with equal values the first row wins, so the result does not
+    depend on the order in which the heap is filled
+*/
+static inline gboolean row_is_worse (const gint64 *values, gulong a, gulong b)
+{
+    if (values [a] != values [b])
+        return values [a] < values [b];
+    else
+        return a > b;
+}
+
+static void heap_sift_down (gulong *heap, guint size, guint index, const gint64 *values)
+{
+    guint child;
+    gulong tmp;
+
+    while ((child = (index * 2) + 1) < size) {
+        if (child + 1 < size && row_is_worse (values, heap [child + 1], heap [child]))
+            child++;
+
+        if (row_is_worse (values, heap [child], heap [index]) == FALSE)
+            break;
+
+        tmp = heap [index];
+        heap [index] = heap [child];
+        heap [child] = tmp;
+        index = child;
+    }
+}
+
+static void heap_sift_up (gulong *heap, guint index, const gint64 *values)
+{
+    guint parent;
+    gulong tmp;
+
+    while (index > 0) {
+        parent = (index - 1) / 2;
+
+        if (row_is_worse (values, heap [index], heap [parent]) == FALSE)
+            break;
+
+        tmp = heap [index];
+        heap [index] = heap [parent];
+        heap [parent] = tmp;
+        index = parent;
+    }
+}
+
+/**
+ * ogd_content_query_top_k:
+ * @columns:        the contents to rank
+ * @key:            value by which contents are ranked
+ * @k:              maximum number of contents to return
+ * @typeids:        array of IDs of categories, to consider only contents from those, or %NULL to
+ *                  consider all contents
+ * @n_typeids:      number of elements in @typeids
+ *
+ * To find the @k best contents by the given value. With many @typeids the ranking is a single
+ * one, merging all the given categories. Contents with equal values are ordered as they appear
+ * in @columns
+ *
+ * Return value:    a #GArray of gulong, the indexes of the rows of @columns found, best first.
+ *                  Has to be freed with g_array_free()
+ */
+GArray* ogd_content_query_top_k (const OGDContentColumns *columns, OGD_CONTENT_QUERY_KEY key, guint k,
+                                 const guint *typeids, guint n_typeids)
+{
+    guint size;
+    gulong i;
+    gint64 *values;
+    guint8 *accepted;
+    gulong *heap;
+    GArray *ret;
+
+    ret = g_array_new (FALSE, FALSE, sizeof (gulong));
+    if (k == 0 || columns->rows == 0)
+        return ret;
+
+    values = extract_key (columns, key);
+    accepted = filter_categories (columns, typeids, n_typeids);
+
+    /*
+        The heap keeps the worst of the best rows found so far on top: each further row has just
+        to be compared with that one, and most of them are discarded without touching the heap
+    */
+    heap = g_new (gulong, MIN (k, columns->rows));
+    size = 0;
+
+    for (i = 0; i < columns->rows; i++) {
+        if (accepted != NULL && accepted [i] == 0)
+            continue;
+
+        if (size < k) {
+            heap [size] = i;
+            heap_sift_up (heap, size, values);
+            size++;
+        }
+        else if (row_is_worse (values, heap [0], i)) {
+            heap [0] = i;
+            heap_sift_down (heap, size, 0, values);
+        }
+    }
+
+    g_array_set_size (ret, size);
+
+    while (size > 0) {
+        size--;
+        g_array_index (ret, gulong, size) = heap [0];
+        heap [0] = heap [size];
+        heap_sift_down (heap, size, 0, values);
+    }
+
+    g_free (heap);
+    g_free (accepted);
+    g_free (values);
+    return ret;
+}
+
+static gint compare_rollups (gconstpointer a, gconstpointer b)
+{
+    const OGDContentRollup *first;
+    const OGDContentRollup *second;
+
+    first = a;
+    second = b;
+
+    if (first->downloads != second->downloads)
+        return (first->downloads < second->downloads) ? 1 : -1;
+    else if (first->contents != second->contents)
+        return (first->contents < second->contents) ? 1 : -1;
+    else
+        return 0;
+}
+
+/*
+    Rows are assigned to groups in a first pass, and each column is then summed in its own loop
+*/
+static void accumulate_groups (const OGDContentColumns *columns, const guint8 *accepted,
+                               const guint *groups, OGDContentRollup *rollups, guint64 *scores)
+{
+    gulong i;
+
+    for (i = 0; i < columns->rows; i++)
+        if (accepted == NULL || accepted [i] != 0)
+            rollups [groups [i]].contents++;
+
+    for (i = 0; i < columns->rows; i++)
+        if (accepted == NULL || accepted [i] != 0)
+            rollups [groups [i]].downloads += columns->downloads [i];
+
+    for (i = 0; i < columns->rows; i++)
+        if (accepted == NULL || accepted [i] != 0)
+            scores [groups [i]] += columns->scores [i];
+
+    for (i = 0; i < columns->rows; i++)
+        if ((accepted == NULL || accepted [i] != 0) && columns->changed [i] > rollups [groups [i]].changed)
+            rollups [groups [i]].changed = columns->changed [i];
+}
+
+/**
+ * ogd_content_query_rollup:
+ * @columns:        the contents to aggregate
+ * @grouping:       how contents are grouped
+ * @typeids:        array of IDs of categories, to consider only contents from those, or %NULL to
+ *                  consider all contents
+ * @n_typeids:      number of elements in @typeids
+ *
+ * To compute totals of contents for each author or category
+ *
+ * Return value:    a #GArray of #OGDContentRollup, one for each group with at least one content,
+ *                  ordered by total downloads. Strings in the elements belong to @columns. Has to
+ *                  be freed with g_array_free()
+ */
+GArray* ogd_content_query_rollup (const OGDContentColumns *columns, OGD_CONTENT_QUERY_GROUPING grouping,
+                                  const guint *typeids, guint n_typeids)
+{
+    guint i;
+    guint n_groups;
+    gulong row;
+    gpointer key;
+    gpointer index;
+    guint *groups;
+    guint8 *accepted;
+    guint64 *scores;
+    GHashTable *found;
+    GArray *ret;
+    OGDContentRollup *rollup;
+
+    ret = g_array_new (FALSE, TRUE, sizeof (OGDContentRollup));
+    if (columns->rows == 0)
+        return ret;
+
+    accepted = filter_categories (columns, typeids, n_typeids);
+    groups = g_new (guint, columns->rows);
+    found = g_hash_table_new (g_direct_hash, g_direct_equal);
+    n_groups = 0;
+
+    /*
+        Authors are interned strings and may be compared by pointer, as categories by value
+    */
+    for (row = 0; row < columns->rows; row++) {
+        if (accepted != NULL && accepted [row] == 0)
+            continue;
+
+        if (grouping == OGD_CONTENT_QUERY_BY_AUTHOR)
+            key = (gpointer) columns->personids [row];
+        else
+            key = GUINT_TO_POINTER (columns->typeids [row]);
+
+        if (g_hash_table_lookup_extended (found, key, NULL, &index) == FALSE) {
+            index = GUINT_TO_POINTER (n_groups);
+            g_hash_table_insert (found, key, index);
+            g_array_set_size (ret, n_groups + 1);
+
+            rollup = &g_array_index (ret, OGDContentRollup, n_groups);
+            if (grouping == OGD_CONTENT_QUERY_BY_AUTHOR)
+                rollup->personid = columns->personids [row];
+            else
+                rollup->typeid = columns->typeids [row];
+
+            n_groups++;
+        }
+
+        groups [row] = GPOINTER_TO_UINT (index);
+    }
+
+    scores = g_new0 (guint64, n_groups);
+    accumulate_groups (columns, accepted, groups, (OGDContentRollup*) ret->data, scores);
+
+    for (i = 0; i < n_groups; i++) {
+        rollup = &g_array_index (ret, OGDContentRollup, i);
+        rollup->score = (gdouble) scores [i] / rollup->contents;
+    }
+
+    g_array_sort (ret, compare_rollups);
+
+    g_free (scores);
+    g_hash_table_destroy (found);
+    g_free (groups);
+    g_free (accepted);
+    return ret;
+}
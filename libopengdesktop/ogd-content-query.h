@@ -0,0 +1,81 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_CONTENT_QUERY_H
+#define OGD_CONTENT_QUERY_H
+
+G_BEGIN_DECLS
+
+#include "ogd-columns.h"
+
+/**
+ * OGD_CONTENT_QUERY_KEY:
+ * @OGD_CONTENT_QUERY_DOWNLOADS:        contents with most downloads come before
+ * @OGD_CONTENT_QUERY_SCORE:            contents with higher scores come before
+ * @OGD_CONTENT_QUERY_CHANGED:          contents changed more recently come before
+ * @OGD_CONTENT_QUERY_CREATED:          newer contents come before
+ *
+ * Values by which contents are ranked by ogd_content_query_top_k()
+ */
+typedef enum {
+    OGD_CONTENT_QUERY_DOWNLOADS,
+    OGD_CONTENT_QUERY_SCORE,
+    OGD_CONTENT_QUERY_CHANGED,
+    OGD_CONTENT_QUERY_CREATED
+} OGD_CONTENT_QUERY_KEY;
+
+/**
+ * OGD_CONTENT_QUERY_GROUPING:
+ * @OGD_CONTENT_QUERY_BY_AUTHOR:        a group for each author
+ * @OGD_CONTENT_QUERY_BY_CATEGORY:      a group for each category
+ *
+ * How contents are grouped by ogd_content_query_rollup()
+ */
+typedef enum {
+    OGD_CONTENT_QUERY_BY_AUTHOR,
+    OGD_CONTENT_QUERY_BY_CATEGORY
+} OGD_CONTENT_QUERY_GROUPING;
+
+/**
+ * OGDContentRollup:
+ * @personid:       the author of the contents in the group, when grouped by author, or %NULL
+ * @typeid:         the category of the contents in the group, when grouped by category, or 0
+ * @contents:       number of contents in the group
+ * @downloads:      total downloads of the contents in the group
+ * @score:          average score of the contents in the group
+ * @changed:        time of the most recent change in the group, in seconds since the Epoch, or
+ *                  0 if unknown
+ *
+ * Aggregated values of a group of contents, as computed by ogd_content_query_rollup()
+ */
+typedef struct {
+    const gchar     *personid;
+    guint           typeid;
+    gulong          contents;
+    guint64         downloads;
+    gdouble         score;
+    gint64          changed;
+} OGDContentRollup;
+
+GArray*         ogd_content_query_top_k             (const OGDContentColumns *columns, OGD_CONTENT_QUERY_KEY key, guint k,
+                                                     const guint *typeids, guint n_typeids);
+GArray*         ogd_content_query_rollup            (const OGDContentColumns *columns, OGD_CONTENT_QUERY_GROUPING grouping,
+                                                     const guint *typeids, guint n_typeids);
+
+G_END_DECLS
+
+#endif /* OGD_CONTENT_QUERY_H */
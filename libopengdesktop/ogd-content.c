@@ -19,19 +19,39 @@
 #include "ogd-category.h"
 #include "ogd-provider-private.h"
 #include "ogd-private-utils.h"
+#include "ogd-snapshot-private.h"
 
 #define OGD_CONTENT_GET_PRIVATE(obj)       (G_TYPE_INSTANCE_GET_PRIVATE ((obj),    \
                                              OGD_CONTENT_TYPE, OGDContentPrivate))
 
-#define CHECK_AND_SET_STRING(__content, __field, __value) { \
-    if (check_ownership (__content) == FALSE) {             \
-        g_warning ("No permissions to edit the content.");  \
-        return;                                             \
-    }                                                       \
-                                                            \
-    SET_STRING (__content, __field, __value);               \
+#define CHECK_AND_SET_STRING(__content, __field, __value, __flag) {   \
+    if (check_ownership (__content) == FALSE) {                         \
+        g_warning ("No permissions to edit the content.");              \
+        return;                                                         \
+    }                                                                   \
+                                                                        \
+    if (g_strcmp0 (__content->priv->__field, __value) != 0) {           \
+        SET_STRING (__content, __field, __value);                       \
+        __content->priv->dirty |= __flag;                               \
+    }                                                                   \
 }
 
+/*
+    Fields changed with setters since the content has been fetched or saved the last time: only
+    those are sent when editing an existing content
+*/
+typedef enum {
+    CONTENT_DIRTY_CATEGORY      = 1 << 0,
+    CONTENT_DIRTY_NAME          = 1 << 1,
+    CONTENT_DIRTY_VERSION       = 1 << 2,
+    CONTENT_DIRTY_LANGUAGE      = 1 << 3,
+    CONTENT_DIRTY_DESCRIPTION   = 1 << 4,
+    CONTENT_DIRTY_CHANGELOG     = 1 << 5,
+    CONTENT_DIRTY_HOMEPAGE      = 1 << 6,
+    CONTENT_DIRTY_DOWNLOADS     = 1 << 7,
+    CONTENT_DIRTY_ALL           = (1 << 8) - 1
+} CONTENT_DIRTY_FIELDS;
+
 /**
  * SECTION: ogd-content
  * @short_description:  description of a specific content took from the provider
@@ -50,6 +70,7 @@ struct _OGDContentPrivate {
     gchar       *authorid;
     GDate       *creationdate;
     GDate       *changedate;
+    gint64      changetime;
     gulong      numdownloads;
     guint       score;
     gchar       *description;
@@ -59,6 +80,7 @@ struct _OGDContentPrivate {
     gulong      numfans;
     GList       *previews;
     GList       *downloads;
+    guint       dirty;
 };
 
 G_DEFINE_TYPE (OGDContent, ogd_content, OGD_OBJECT_TYPE);
@@ -69,25 +91,102 @@ static void ogd_content_finalize (GObject *obj)
 
     content = OGD_CONTENT (obj);
 
-    PTR_CHECK_FREE_NULLIFY (content->priv->id);
+    ARENA_CHECK_FREE_NULLIFY (content->priv->id);
     OBJ_CHECK_UNREF_NULLIFY (content->priv->category);
-    PTR_CHECK_FREE_NULLIFY (content->priv->name);
-    PTR_CHECK_FREE_NULLIFY (content->priv->version);
-    PTR_CHECK_FREE_NULLIFY (content->priv->language);
-    PTR_CHECK_FREE_NULLIFY (content->priv->authorid);
+    ARENA_CHECK_FREE_NULLIFY (content->priv->name);
+    ARENA_CHECK_FREE_NULLIFY (content->priv->version);
+    ARENA_CHECK_FREE_NULLIFY (content->priv->language);
+    ARENA_CHECK_FREE_NULLIFY (content->priv->authorid);
     DATE_CHECK_FREE_NULLIFY (content->priv->creationdate);
     DATE_CHECK_FREE_NULLIFY (content->priv->changedate);
-    PTR_CHECK_FREE_NULLIFY (content->priv->description);
-    PTR_CHECK_FREE_NULLIFY (content->priv->changelog);
-    PTR_CHECK_FREE_NULLIFY (content->priv->homepage);
-    STRLIST_CHECK_FREE_NULLIFY (content->priv->previews);
-    STRLIST_CHECK_FREE_NULLIFY (content->priv->downloads);
+    content->priv->changetime = 0;
+    ARENA_CHECK_FREE_NULLIFY (content->priv->description);
+    ARENA_CHECK_FREE_NULLIFY (content->priv->changelog);
+    ARENA_CHECK_FREE_NULLIFY (content->priv->homepage);
+    ARENA_STRLIST_CHECK_FREE_NULLIFY (content->priv->previews);
+    ARENA_STRLIST_CHECK_FREE_NULLIFY (content->priv->downloads);
+    content->priv->dirty = 0;
+
+    ogd_object_release_arena (OGD_OBJECT (obj));
+}
+
+/*
+    Values of the fields changed with setters and not saved yet, detached from the content while
+    it is filled again
+*/
+typedef struct {
+    guint       dirty;
+    OGDCategory *category;
+    gchar       *name;
+    gchar       *version;
+    gchar       *language;
+    gchar       *description;
+    gchar       *changelog;
+    gchar       *homepage;
+    GList       *downloads;
+} DirtyFields;
+
+#define TAKE_DIRTY_FIELD(__content, __saved, __field, __flag) {     \
+    if (((__saved)->dirty & (__flag)) != 0) {                       \
+        (__saved)->__field = __content->priv->__field;              \
+        __content->priv->__field = NULL;                            \
+    }                                                               \
 }
 
+#define RESTORE_DIRTY_STRING(__content, __saved, __field, __flag) { \
+    if (((__saved)->dirty & (__flag)) != 0) {                       \
+        ARENA_CHECK_FREE_NULLIFY (__content->priv->__field);        \
+        __content->priv->__field = (__saved)->__field;              \
+    }                                                               \
+}
+
+static void take_dirty_fields (OGDContent *content, DirtyFields *saved)
+{
+    memset (saved, 0, sizeof (DirtyFields));
+    saved->dirty = content->priv->dirty;
+
+    TAKE_DIRTY_FIELD (content, saved, category, CONTENT_DIRTY_CATEGORY);
+    TAKE_DIRTY_FIELD (content, saved, name, CONTENT_DIRTY_NAME);
+    TAKE_DIRTY_FIELD (content, saved, version, CONTENT_DIRTY_VERSION);
+    TAKE_DIRTY_FIELD (content, saved, language, CONTENT_DIRTY_LANGUAGE);
+    TAKE_DIRTY_FIELD (content, saved, description, CONTENT_DIRTY_DESCRIPTION);
+    TAKE_DIRTY_FIELD (content, saved, changelog, CONTENT_DIRTY_CHANGELOG);
+    TAKE_DIRTY_FIELD (content, saved, homepage, CONTENT_DIRTY_HOMEPAGE);
+    TAKE_DIRTY_FIELD (content, saved, downloads, CONTENT_DIRTY_DOWNLOADS);
+}
+
+static void restore_dirty_fields (OGDContent *content, DirtyFields *saved)
+{
+    if ((saved->dirty & CONTENT_DIRTY_CATEGORY) != 0) {
+        OBJ_CHECK_UNREF_NULLIFY (content->priv->category);
+        content->priv->category = saved->category;
+    }
+
+    RESTORE_DIRTY_STRING (content, saved, name, CONTENT_DIRTY_NAME);
+    RESTORE_DIRTY_STRING (content, saved, version, CONTENT_DIRTY_VERSION);
+    RESTORE_DIRTY_STRING (content, saved, language, CONTENT_DIRTY_LANGUAGE);
+    RESTORE_DIRTY_STRING (content, saved, description, CONTENT_DIRTY_DESCRIPTION);
+    RESTORE_DIRTY_STRING (content, saved, changelog, CONTENT_DIRTY_CHANGELOG);
+    RESTORE_DIRTY_STRING (content, saved, homepage, CONTENT_DIRTY_HOMEPAGE);
+
+    if ((saved->dirty & CONTENT_DIRTY_DOWNLOADS) != 0) {
+        ARENA_STRLIST_CHECK_FREE_NULLIFY (content->priv->downloads);
+        content->priv->downloads = saved->downloads;
+    }
+
+    content->priv->dirty = saved->dirty;
+}
+
+/*
+    Fields changed with setters and not saved yet survive when the content is filled again, e.g.
+    when the identity map updates the live instance with data just received: the local value wins
+    over the received one, and is still sent by the next save
+*/
 static gboolean ogd_content_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
 {
     xmlNode *cursor;
     OGDContent *content;
+    DirtyFields saved;
 
     content = OGD_CONTENT (obj);
 
@@ -99,6 +198,7 @@ static gboolean ogd_content_fill_by_xml (OGDObject *obj, const xmlNode *xml, GEr
         return FALSE;
     }
 
+    take_dirty_fields (content, &saved);
     ogd_content_finalize (G_OBJECT (obj));
 
     for (cursor = xml->children; cursor; cursor = cursor->next) {
@@ -116,8 +216,10 @@ static gboolean ogd_content_fill_by_xml (OGDObject *obj, const xmlNode *xml, GEr
             content->priv->authorid = MYGETCONTENT (cursor);
         else if (MYSTRCMP (cursor->name, "created") == 0)
             content->priv->creationdate = node_to_date (cursor);
-        else if (MYSTRCMP (cursor->name, "changed") == 0)
+        else if (MYSTRCMP (cursor->name, "changed") == 0) {
             content->priv->changedate = node_to_date (cursor);
+            content->priv->changetime = node_to_time (cursor);
+        }
         else if (MYSTRCMP (cursor->name, "downloads") == 0)
             content->priv->numdownloads = (guint) node_to_num (cursor);
         else if (MYSTRCMP (cursor->name, "score") == 0)
@@ -138,6 +240,7 @@ static gboolean ogd_content_fill_by_xml (OGDObject *obj, const xmlNode *xml, GEr
             content->priv->downloads = g_list_prepend (content->priv->downloads, MYGETCONTENT (cursor));
     }
 
+    restore_dirty_fields (content, &saved);
     return TRUE;
 }
 
@@ -146,6 +249,11 @@ static gchar* ogd_content_target_query (const gchar *id)
     return g_strdup_printf ("content/data/%s", id);
 }
 
+static const gchar* ogd_content_get_object_id (OGDObject *obj)
+{
+    return ogd_content_get_id (OGD_CONTENT (obj));
+}
+
 static void ogd_content_class_init (OGDContentClass *klass)
 {
     GObjectClass *gobject_class;
@@ -158,6 +266,7 @@ static void ogd_content_class_init (OGDContentClass *klass)
 
     ogd_object_class = OGD_OBJECT_CLASS (klass);
     ogd_object_class->fill_by_xml = ogd_content_fill_by_xml;
+    ogd_object_class_set_id_func (ogd_object_class, ogd_content_get_object_id);
     ogd_object_class->target_query = ogd_content_target_query;
 }
 
@@ -167,27 +276,129 @@ static void ogd_content_init (OGDContent *item)
     memset (item->priv, 0, sizeof (OGDContentPrivate));
 }
 
+/*
+    The category is saved along with the content, so that it does not have to be requested to the
+    server when the content is loaded
+*/
+static const OGD_SNAPSHOT_KIND ContentSnapshotKinds [] = {
+    OGD_SNAPSHOT_STRING,        /* id */
+    OGD_SNAPSHOT_STRING,        /* category id */
+    OGD_SNAPSHOT_STRING,        /* category name */
+    OGD_SNAPSHOT_STRING,        /* name */
+    OGD_SNAPSHOT_STRING,        /* version */
+    OGD_SNAPSHOT_STRING,        /* language */
+    OGD_SNAPSHOT_STRING,        /* authorid */
+    OGD_SNAPSHOT_INTEGER,       /* creationdate */
+    OGD_SNAPSHOT_INTEGER,       /* changedate */
+    OGD_SNAPSHOT_INTEGER,       /* changetime */
+    OGD_SNAPSHOT_INTEGER,       /* numdownloads */
+    OGD_SNAPSHOT_INTEGER,       /* score */
+    OGD_SNAPSHOT_STRING,        /* description */
+    OGD_SNAPSHOT_STRING,        /* changelog */
+    OGD_SNAPSHOT_STRING,        /* homepage */
+    OGD_SNAPSHOT_INTEGER,       /* numcomments */
+    OGD_SNAPSHOT_INTEGER,       /* numfans */
+    OGD_SNAPSHOT_STRING_LIST,   /* previews */
+    OGD_SNAPSHOT_STRING_LIST,   /* downloads */
+};
+
+static void ogd_content_to_snapshot (OGDObject *obj, OGDSnapshotValue *values)
+{
+    OGDContent *content;
+
+    content = OGD_CONTENT (obj);
+
+    values [0].string = content->priv->id;
+
+    if (content->priv->category != NULL) {
+        values [1].string = ogd_category_get_id (content->priv->category);
+        values [2].string = ogd_category_get_name (content->priv->category);
+    }
+
+    values [3].string = content->priv->name;
+    values [4].string = content->priv->version;
+    values [5].string = content->priv->language;
+    values [6].string = content->priv->authorid;
+    values [7].integer = ogd_snapshot_pack_date (content->priv->creationdate);
+    values [8].integer = ogd_snapshot_pack_date (content->priv->changedate);
+    values [9].integer = content->priv->changetime;
+    values [10].integer = content->priv->numdownloads;
+    values [11].integer = content->priv->score;
+    values [12].string = content->priv->description;
+    values [13].string = content->priv->changelog;
+    values [14].string = content->priv->homepage;
+    values [15].integer = content->priv->numcomments;
+    values [16].integer = content->priv->numfans;
+    values [17].list = content->priv->previews;
+    values [18].list = content->priv->downloads;
+}
+
+static void ogd_content_fill_by_snapshot (OGDObject *obj, const OGDSnapshotValue *values)
+{
+    OGDContent *content;
+
+    content = OGD_CONTENT (obj);
+    ogd_content_finalize (G_OBJECT (obj));
+
+    content->priv->id = (gchar*) values [0].string;
+
+    if (values [1].string != NULL) {
+        content->priv->category = g_object_new (OGD_CATEGORY_TYPE, NULL);
+        ogd_object_set_provider (OGD_OBJECT (content->priv->category), ogd_object_get_provider (obj));
+        ogd_snapshot_fill_object (OGD_OBJECT (content->priv->category), values + 1);
+    }
+
+    content->priv->name = (gchar*) values [3].string;
+    content->priv->version = (gchar*) values [4].string;
+    content->priv->language = (gchar*) values [5].string;
+    content->priv->authorid = (gchar*) values [6].string;
+    content->priv->creationdate = ogd_snapshot_unpack_date (values [7].integer);
+    content->priv->changedate = ogd_snapshot_unpack_date (values [8].integer);
+    content->priv->changetime = values [9].integer;
+    content->priv->numdownloads = (gulong) values [10].integer;
+    content->priv->score = (guint) values [11].integer;
+    content->priv->description = (gchar*) values [12].string;
+    content->priv->changelog = (gchar*) values [13].string;
+    content->priv->homepage = (gchar*) values [14].string;
+    content->priv->numcomments = (gulong) values [15].integer;
+    content->priv->numfans = (gulong) values [16].integer;
+    content->priv->previews = ogd_snapshot_unpack_list (values [17].string);
+    content->priv->downloads = ogd_snapshot_unpack_list (values [18].string);
+}
+
+const OGDSnapshotSchema* ogd_content_get_snapshot_schema ()
+{
+    static const OGDSnapshotSchema schema = {
+        G_N_ELEMENTS (ContentSnapshotKinds),
+        ContentSnapshotKinds,
+        ogd_content_to_snapshot,
+        ogd_content_fill_by_snapshot
+    };
+
+    return &schema;
+}
+
 static gboolean check_ownership (OGDContent *content)
 {
     const gchar *owner;
-    static const gchar *myself = NULL;
+    const gchar *myself;
 
     if (ogd_content_get_id (content) == NULL)
         return TRUE;
 
     owner = ogd_content_get_authorid (content);
+    myself = ogd_person_get_myself_id (ogd_object_get_provider (OGD_OBJECT (content)));
 
-    if (myself == NULL)
-        myself = ogd_person_get_id (ogd_person_get_myself (ogd_object_get_provider (OGD_OBJECT (content))));
-
-    return (strcmp (owner, myself) == 0);
+    return (owner != NULL && myself != NULL && strcmp (owner, myself) == 0);
 }
 
 /**
  * ogd_content_new:
  * @provider:       reference provider for the new event
  *
- * Creates an empty content suitable to be filled and saved with ogd_content_save()
+ * Creates an empty content suitable to be filled and saved with ogd_content_save(). The author is
+ * the current user: if its ID has not been retrieved yet from the server, it is resolved when the
+ * content is saved, and until then ogd_content_get_authorid() returns %NULL
  *
  * Return value:    a new #OGDContent
  */
@@ -197,7 +408,7 @@ OGDContent* ogd_content_new (OGDProvider *provider)
 
     ret = g_object_new (OGD_CONTENT_TYPE, NULL);
     ogd_object_set_provider (OGD_OBJECT (ret), provider);
-    ret->priv->authorid = g_strdup (ogd_person_get_id (ogd_person_get_myself (provider)));
+    ret->priv->authorid = g_strdup (ogd_provider_get_myself_id (provider));
     return ret;
 }
 
@@ -288,7 +499,10 @@ void ogd_content_set_category (OGDContent *content, OGDCategory *category)
         return;
     }
 
-    SET_OBJECT (content, category, category);
+    if (content->priv->category != category) {
+        SET_OBJECT (content, category, category);
+        content->priv->dirty |= CONTENT_DIRTY_CATEGORY;
+    }
 }
 
 /**
@@ -314,7 +528,7 @@ const gchar* ogd_content_get_name (OGDContent *content)
  */
 void ogd_content_set_name (OGDContent *content, gchar *name)
 {
-    CHECK_AND_SET_STRING (content, name, name);
+    CHECK_AND_SET_STRING (content, name, name, CONTENT_DIRTY_NAME);
 }
 
 /**
@@ -341,7 +555,7 @@ const gchar* ogd_content_get_version (OGDContent *content)
  */
 void ogd_content_set_version (OGDContent *content, gchar *version)
 {
-    CHECK_AND_SET_STRING (content, version, version);
+    CHECK_AND_SET_STRING (content, version, version, CONTENT_DIRTY_VERSION);
 }
 
 /**
@@ -368,7 +582,7 @@ const gchar* ogd_content_get_language (OGDContent *content)
  */
 void ogd_content_set_language (OGDContent *content, gchar *language)
 {
-    CHECK_AND_SET_STRING (content, language, language);
+    CHECK_AND_SET_STRING (content, language, language, CONTENT_DIRTY_LANGUAGE);
 }
 
 /**
@@ -411,6 +625,20 @@ const GDate* ogd_content_get_change_date (OGDContent *content)
     return content->priv->changedate;
 }
 
+/**
+ * ogd_content_get_change_time:
+ * @content:        the #OGDContent to query
+ *
+ * As ogd_content_get_change_date(), but with the time of the change
+ *
+ * Return value:    the time of latest change of the target @content, in seconds since the Epoch,
+ *                  or 0 if unknown
+ */
+gint64 ogd_content_get_change_time (OGDContent *content)
+{
+    return content->priv->changetime;
+}
+
 /**
  * ogd_content_get_num_downloads:
  * @content:        the #OGDContent to query
@@ -461,7 +689,7 @@ const gchar* ogd_content_get_description (OGDContent *content)
  */
 void ogd_content_set_description (OGDContent *content, gchar *description)
 {
-    CHECK_AND_SET_STRING (content, description, description);
+    CHECK_AND_SET_STRING (content, description, description, CONTENT_DIRTY_DESCRIPTION);
 }
 
 /**
@@ -487,7 +715,7 @@ const gchar* ogd_content_get_changelog (OGDContent *content)
  */
 void ogd_content_set_changelog (OGDContent *content, gchar *changelog)
 {
-    CHECK_AND_SET_STRING (content, changelog, changelog);
+    CHECK_AND_SET_STRING (content, changelog, changelog, CONTENT_DIRTY_CHANGELOG);
 }
 
 /**
@@ -513,7 +741,7 @@ const gchar* ogd_content_get_homepage (OGDContent *content)
  */
 void ogd_content_set_homepage (OGDContent *content, gchar *homepage)
 {
-    CHECK_AND_SET_STRING (content, homepage, homepage);
+    CHECK_AND_SET_STRING (content, homepage, homepage, CONTENT_DIRTY_HOMEPAGE);
 }
 
 /**
@@ -553,13 +781,31 @@ void ogd_content_get_comments_async (OGDContent *content, OGDAsyncListCallback c
     g_free (query);
 }
 
+/**
+ * ogd_content_get_comment_tree:
+ * @content:        the #OGDContent to query
+ *
+ * Prepares to load the comments published for the given #OGDContent page by page, without
+ * building an #OGDComment for each of them. Preferable to ogd_content_get_comments() for
+ * contents with many comments
+ *
+ * Return value:    an empty #OGDCommentTree, to be filled with ogd_comment_tree_fetch_next_page()
+ *                  and freed with ogd_comment_tree_free()
+ */
+OGDCommentTree* ogd_content_get_comment_tree (OGDContent *content)
+{
+    return ogd_comment_tree_new (ogd_object_get_provider (OGD_OBJECT (content)), 1, ogd_content_get_id (content));
+}
+
 /**
  * ogd_content_get_fans:
  * @content:        the #OGDContent to query
  *
  * Retrieves list of current fans for the given @content
  *
- * Return value:    a list of #OGDPerson to be freed when no longer in use, or NULL
+ * Return value:    a list of #OGDPerson to be freed when no longer in use, or NULL. If some of
+ *                  the fans cannot be retrieved NULL is returned, and the reason is available
+ *                  with ogd_provider_get_last_error()
  */
 GList* ogd_content_get_fans (OGDContent *content)
 {
@@ -567,7 +813,7 @@ GList* ogd_content_get_fans (OGDContent *content)
     GList *ret;
 
     query = g_strdup_printf ("fan/data/%s", ogd_content_get_id (content));
-    ret = list_of_people (OGD_OBJECT (content), query);
+    ret = list_of_people (OGD_OBJECT (content), query, NULL);
     g_free (query);
     return ret;
 }
@@ -575,8 +821,9 @@ GList* ogd_content_get_fans (OGDContent *content)
 /**
  * ogd_content_get_fans_async:
  * @content:        the #OGDContent to query
- * @callback:       callback to call when fans collection is ended. If no fans exist, it is
- *                  invoked with NULL
+ * @callback:       callback to call when fans collection is ended. If no fans exist, or some of
+ *                  them cannot be retrieved, it is invoked with NULL: the reason of a failure is
+ *                  available with ogd_provider_get_last_error()
  * @userdata:       the user data for the callback
  *
  * Async version of ogd_content_get_fans()
@@ -631,18 +878,14 @@ void ogd_content_set_download_refs (OGDContent *content, const GList *downloads)
         return;
     }
 
-    STRLIST_CHECK_FREE_NULLIFY (content->priv->downloads);
+    ARENA_STRLIST_CHECK_FREE_NULLIFY (content->priv->downloads);
     content->priv->downloads = (GList*) downloads;
+    content->priv->dirty |= CONTENT_DIRTY_DOWNLOADS;
 }
 
-static void effective_vote (OGDContent *content, OGD_CONTENT_VOTE vote, gboolean async,
-                            OGDPutAsyncCallback callback, gpointer userdata)
+static gchar* vote_query (OGDContent *content, OGD_CONTENT_VOTE vote)
 {
-    gchar *query;
     gchar *vote_str;
-    OGDProvider *provider;
-
-    provider = ogd_object_get_provider (OGD_OBJECT (content));
 
     switch (vote) {
         case OGD_CONTENT_GOOD:
@@ -655,18 +898,16 @@ static void effective_vote (OGDContent *content, OGD_CONTENT_VOTE vote, gboolean
 
         default:
             g_warning ("Invalid vote");
-            return;
+            return NULL;
             break;
     }
 
-    query = g_strdup_printf ("content/vote/%s?vote=%s", ogd_content_get_id (content), vote_str);
-
-    if (async == FALSE)
-        ogd_provider_put (provider, query, NULL);
-    else
-        ogd_provider_put_async (provider, query, NULL, callback, userdata);
+    return g_strdup_printf ("content/vote/%s?vote=%s", ogd_content_get_id (content), vote_str);
+}
 
-    g_free (query);
+static gchar* queue_key (const gchar *operation, OGDContent *content)
+{
+    return g_strdup_printf ("%s/%s", operation, ogd_content_get_id (content));
 }
 
 #ifndef OGD_DISABLE_DEPRECATED
@@ -714,7 +955,14 @@ gulong ogd_content_get_num_fans (OGDContent *content)
  */
 void ogd_content_vote (OGDContent *content, OGD_CONTENT_VOTE vote)
 {
-    effective_vote (content, vote, FALSE, NULL, NULL);
+    gchar *query;
+
+    query = vote_query (content, vote);
+    if (query == NULL)
+        return;
+
+    ogd_provider_put (ogd_object_get_provider (OGD_OBJECT (content)), query, NULL);
+    g_free (query);
 }
 
 /**
@@ -728,7 +976,41 @@ void ogd_content_vote (OGDContent *content, OGD_CONTENT_VOTE vote)
  */
 void ogd_content_vote_async (OGDContent *content, OGD_CONTENT_VOTE vote, OGDPutAsyncCallback callback, gpointer userdata)
 {
-    effective_vote (content, vote, TRUE, callback, userdata);
+    gchar *query;
+
+    query = vote_query (content, vote);
+    if (query == NULL)
+        return;
+
+    ogd_provider_put_async (ogd_object_get_provider (OGD_OBJECT (content)), query, NULL, callback, userdata);
+    g_free (query);
+}
+
+/**
+ * ogd_content_vote_queued:
+ * @content:        the #OGDContent to vote
+ * @vote:           rating for the @content
+ * @callback:       async callback to which result of the operation is passed, or %NULL
+ * @userdata:       the user data for the callback
+ *
+ * As ogd_content_vote_async(), but the vote is kept in the write queue of the provider: if the
+ * same content is voted again before the request is sent only the last vote is sent, and the
+ * result of that request is passed to the callbacks of both. Use ogd_provider_flush_writes() to
+ * wait for all enqueued operations
+ */
+void ogd_content_vote_queued (OGDContent *content, OGD_CONTENT_VOTE vote, OGDPutAsyncCallback callback, gpointer userdata)
+{
+    gchar *key;
+    gchar *query;
+
+    query = vote_query (content, vote);
+    if (query == NULL)
+        return;
+
+    key = queue_key ("vote", content);
+    ogd_provider_queue_put (ogd_object_get_provider (OGD_OBJECT (content)), key, query, NULL, callback, userdata);
+    g_free (key);
+    g_free (query);
 }
 
 static gchar* fan_query (OGDContent *content, gboolean fan)
@@ -779,6 +1061,31 @@ void ogd_content_set_fan_async (OGDContent *content, gboolean fan, OGDPutAsyncCa
     g_free (query);
 }
 
+/**
+ * ogd_content_set_fan_queued:
+ * @content:        the #OGDContent for which change the fan status
+ * @fan:            %TRUE to become fan of the @content, %FALSE to be removed from the list of
+ *                  fans
+ * @callback:       async callback to which result of the operation is passed, or %NULL
+ * @userdata:       the user data for the callback
+ *
+ * As ogd_content_set_fan_async(), but the change is kept in the write queue of the provider: if
+ * the fan status of the same content is changed again before the request is sent only the last
+ * status is sent, and the result of that request is passed to the callbacks of both. Use
+ * ogd_provider_flush_writes() to wait for all enqueued operations
+ */
+void ogd_content_set_fan_queued (OGDContent *content, gboolean fan, OGDPutAsyncCallback callback, gpointer userdata)
+{
+    gchar *key;
+    gchar *query;
+
+    query = fan_query (content, fan);
+    key = queue_key ("fan", content);
+    ogd_provider_queue_put (ogd_object_get_provider (OGD_OBJECT (content)), key, query, NULL, callback, userdata);
+    g_free (key);
+    g_free (query);
+}
+
 static GHashTable* add_comment_params (OGDContent *content, gchar *subject, gchar *message)
 {
     GHashTable *params;
@@ -827,105 +1134,254 @@ void ogd_content_add_comment_async (OGDContent *content, gchar *subject, gchar *
     g_hash_table_unref (params);
 }
 
+/**
+ * ogd_content_add_comment_queued:
+ * @content:        the #OGDContent to comment
+ * @subject:        subject of the new comment
+ * @message:        text of the new comment
+ * @callback:       async callback to which result of the operation is passed, or %NULL
+ * @userdata:       the user data for the callback
+ *
+ * As ogd_content_add_comment_async(), but the comment is kept in the write queue of the
+ * provider. Comments are never merged, each one is sent with its own request. Use
+ * ogd_provider_flush_writes() to wait for all enqueued operations
+ */
+void ogd_content_add_comment_queued (OGDContent *content, gchar *subject, gchar *message, OGDPutAsyncCallback callback, gpointer userdata)
+{
+    GHashTable *params;
+
+    params = add_comment_params (content, subject, message);
+    ogd_provider_queue_put (ogd_object_get_provider (OGD_OBJECT (content)), NULL, "comments/add", params, callback, userdata);
+    g_hash_table_unref (params);
+}
+
+static void insert_param (OGDContent *content, GHashTable *data, guint fields, guint flag, gchar *key, const gchar *value)
+{
+    if ((fields & flag) == 0)
+        return;
+
+    /*
+        A field emptied on an existing content is sent anyway, so that it is emptied also on the
+        server
+    */
+    if (value != NULL)
+        g_hash_table_insert (data, g_strdup (key), (gchar*) value);
+    else if (ogd_content_get_id (content) != NULL)
+        g_hash_table_insert (data, g_strdup (key), "");
+}
+
+/*
+    Parameters describing @content for "content/add" and "content/edit", limited to the @fields
+    mask. Values are borrowed from the content, so the table must not outlive it. NULL if
+    mandatory fields are missing
+*/
+static GHashTable* save_params (OGDContent *content, guint fields, GError **error)
+{
+    int i;
+    const GList *list;
+    GHashTable *data;
+    OGDCategory *category;
+
+    if (ogd_content_get_name (content) == NULL) {
+        g_set_error (error, OGD_EDIT_ERROR_DOMAIN, OGD_EDIT_ERROR, "A name for the content is mandatory.");
+        return NULL;
+    }
+
+    category = (OGDCategory*) ogd_content_get_category (content);
+    if (category == NULL) {
+        g_set_error (error, OGD_EDIT_ERROR_DOMAIN, OGD_EDIT_ERROR, "A category for the content is mandatory.");
+        return NULL;
+    }
+
+    data = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    insert_param (content, data, fields, CONTENT_DIRTY_NAME, "name", ogd_content_get_name (content));
+    insert_param (content, data, fields, CONTENT_DIRTY_CATEGORY, "type", ogd_category_get_id (category));
+    insert_param (content, data, fields, CONTENT_DIRTY_VERSION, "version", ogd_content_get_version (content));
+    insert_param (content, data, fields, CONTENT_DIRTY_LANGUAGE, "language", ogd_content_get_language (content));
+    insert_param (content, data, fields, CONTENT_DIRTY_DESCRIPTION, "description", ogd_content_get_description (content));
+    insert_param (content, data, fields, CONTENT_DIRTY_CHANGELOG, "changelog", ogd_content_get_changelog (content));
+    insert_param (content, data, fields, CONTENT_DIRTY_HOMEPAGE, "homepage", ogd_content_get_homepage (content));
+
+    if ((fields & CONTENT_DIRTY_DOWNLOADS) != 0) {
+        for (i = 1, list = ogd_content_get_download_refs (content); list != NULL; i++, list = g_list_next (list)) {
+            g_hash_table_insert (data, g_strdup_printf ("downloadtype%d", i), "1");
+            g_hash_table_insert (data, g_strdup_printf ("downloadlink%d", i), (gchar*) list->data);
+        }
+    }
+
+    return data;
+}
+
 /**
  * ogd_content_save:
  * @content:        a new #OGDContent to be saved on the provider, or an existing event to edit
  *
  * To save a new or edited content. The function fails if trying to edit a content not owned by the
- * current user
+ * current user. When editing an existing content only the fields changed since it has been
+ * fetched or saved the last time are sent, and nothing is done if none has been changed
  */
 void ogd_content_save (OGDContent *content)
 {
-    int i;
+    guint fields;
     const gchar *id;
     gchar *query;
-    gchar *tmp;
-    const gchar *str;
-    const GList *list;
     GHashTable *data;
+    GError *error;
     xmlNode *response;
-    xmlNode *inner_response;
-    OGDCategory *category;
 
-    if (check_ownership (content) == FALSE) {
-        g_warning ("No permissions to edit the event.");
+    id = ogd_content_get_id (content);
+    if (id != NULL && content->priv->dirty == 0)
         return;
-    }
 
-    str = ogd_content_get_name (content);
-    if (str == NULL) {
-        g_warning ("A name for the content is mandatory.");
+    if (check_ownership (content) == FALSE) {
+        g_warning ("No permissions to edit the content.");
         return;
     }
 
-    category = ogd_content_get_category (content);
-    if (category == NULL) {
-        g_warning ("A category for the content is mandatory.");
+    if (id == NULL && content->priv->authorid == NULL)
+        content->priv->authorid = g_strdup (ogd_person_get_myself_id (ogd_object_get_provider (OGD_OBJECT (content))));
+
+    fields = (id == NULL) ? CONTENT_DIRTY_ALL : content->priv->dirty;
+
+    error = NULL;
+    data = save_params (content, fields, &error);
+    if (data == NULL) {
+        g_warning ("%s", error->message);
+        g_error_free (error);
         return;
     }
 
-    data = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    if (id == NULL) {
+        response = ogd_provider_put_raw (ogd_object_get_provider (OGD_OBJECT (content)), "content/add", data);
+        if (response != NULL) {
+            content->priv->id = id_from_add_response (response, "content");
+            if (content->priv->id != NULL)
+                content->priv->dirty = 0;
+            else
+                g_warning ("An error occurred while retriving ID for newly created content.");
 
-    g_hash_table_insert (data, g_strdup ("name"), (gchar*) str);
-    g_hash_table_insert (data, g_strdup ("type"), ogd_category_get_id (category));
+            xmlFreeDoc (response->doc);
+        }
+    }
+    else {
+        query = g_strdup_printf ("content/edit/%s", id);
+        if (ogd_provider_put (ogd_object_get_provider (OGD_OBJECT (content)), query, data) == TRUE)
+            content->priv->dirty &= ~fields;
+        g_free (query);
+    }
 
-    str = ogd_content_get_version (content);
-    if (str != NULL)
-        g_hash_table_insert (data, g_strdup ("version"), (gchar*) str);
+    g_hash_table_unref (data);
+}
 
-    str = ogd_content_get_language (content);
-    if (str != NULL)
-        g_hash_table_insert (data, g_strdup ("language"), (gchar*) str);
+static void content_edited (OGDObject *obj, guint fields, gchar *id)
+{
+    OGDContent *content;
 
-    str = ogd_content_get_description (content);
-    if (str != NULL)
-        g_hash_table_insert (data, g_strdup ("description"), (gchar*) str);
+    content = OGD_CONTENT (obj);
 
-    str = ogd_content_get_changelog (content);
-    if (str != NULL)
-        g_hash_table_insert (data, g_strdup ("changelog"), (gchar*) str);
+    if (id != NULL) {
+        ARENA_CHECK_FREE_NULLIFY (content->priv->id);
+        content->priv->id = id;
+    }
 
-    str = ogd_content_get_homepage (content);
-    if (str != NULL)
-        g_hash_table_insert (data, g_strdup ("homepage"), (gchar*) str);
+    /*
+        Fields changed again while the request was running are still to be sent
+    */
+    content->priv->dirty &= ~fields;
+}
 
-    for (i = 1, list = ogd_content_get_download_refs (content); list != NULL; i++, list = g_list_next (list)) {
-        str = g_strdup_printf ("downloadtype%d", i);
-        g_hash_table_insert (data, str, "1");
-        str = g_strdup_printf ("downloadlink%d", i);
-        g_hash_table_insert (data, str, (gchar*) list->data);
-    }
+static void save_content_async (OGDContent *content, OGDSaveAsyncCallback callback, gpointer userdata)
+{
+    guint fields;
+    const gchar *id;
+    gchar *query;
+    GHashTable *data;
+    GError *error;
 
     id = ogd_content_get_id (content);
+    if (id != NULL && content->priv->dirty == 0) {
+        callback (OGD_OBJECT (content), NULL, userdata);
+        return;
+    }
 
-    if (id == NULL) {
-        response = ogd_provider_put_raw (ogd_object_get_provider (OGD_OBJECT (content)), "content/add", data);
-        if (response != NULL) {
-            if (MYSTRCMP (response->name, "data") == 0 && response->children != NULL &&
-                    MYSTRCMP (response->children->name, "content") == 0 && response->children->children != NULL &&
-                    MYSTRCMP (response->children->children->name, "id") == 0) {
-
-                inner_response = response->children->children;
-                tmp = (gchar*) MYGETCONTENT (inner_response);
-                content->priv->id = g_strdup (tmp);
-                xmlFree (tmp);
-            }
-            else {
-                g_warning ("An error occurred while retriving ID for newly created event.");
-            }
+    fields = (id == NULL) ? CONTENT_DIRTY_ALL : content->priv->dirty;
 
-            xmlFreeDoc (response->doc);
-        }
+    error = NULL;
+    data = save_params (content, fields, &error);
+    if (data == NULL) {
+        callback (OGD_OBJECT (content), error, userdata);
+        g_error_free (error);
+        return;
+    }
+
+    if (id == NULL) {
+        edit_object_async (OGD_OBJECT (content), NULL, "content/add", data, "content", fields, content_edited,
+                           callback, userdata);
     }
     else {
         query = g_strdup_printf ("content/edit/%s", id);
-        ogd_provider_put (ogd_object_get_provider (OGD_OBJECT (content)), query, data);
+        edit_object_async (OGD_OBJECT (content), ogd_content_get_authorid (content), query, data, NULL, fields,
+                           content_edited, callback, userdata);
         g_free (query);
     }
 
     g_hash_table_unref (data);
 }
 
+typedef struct {
+    OGDContent              *content;
+    OGDSaveAsyncCallback    callback;
+    gpointer                userdata;
+} NewContentRequest;
+
+/*
+    The author of a new content is not sent to the server, so the content is saved also if the
+    current user cannot be retrieved
+*/
+static void author_resolved (const gchar *id, const GError *error, gpointer userdata)
+{
+    NewContentRequest *req;
+
+    req = (NewContentRequest*) userdata;
+
+    if (id != NULL && req->content->priv->authorid == NULL)
+        req->content->priv->authorid = g_strdup (id);
+
+    save_content_async (req->content, req->callback, req->userdata);
+    g_object_unref (req->content);
+    g_free (req);
+}
+
+/**
+ * ogd_content_save_async:
+ * @content:        a new #OGDContent to be saved on the provider, or an existing content to edit
+ * @callback:       async callback to which result of the operation is passed
+ * @userdata:       the user data for the callback
+ *
+ * Async version of ogd_content_save(). When editing an existing content the ownership is checked
+ * without blocking. When saving a new one its author, if not known yet, is resolved without
+ * blocking as well, and the ID assigned by the server is available through ogd_content_get_id()
+ * at the time @callback is invoked. If the content cannot be saved the
+ * reason is passed to @callback, which may be invoked before this function returns when mandatory
+ * fields are missing or nothing has been changed
+ */
+void ogd_content_save_async (OGDContent *content, OGDSaveAsyncCallback callback, gpointer userdata)
+{
+    NewContentRequest *req;
+
+    if (ogd_content_get_id (content) != NULL || content->priv->authorid != NULL) {
+        save_content_async (content, callback, userdata);
+        return;
+    }
+
+    req = g_new0 (NewContentRequest, 1);
+    req->content = g_object_ref (content);
+    req->callback = callback;
+    req->userdata = userdata;
+    ogd_person_get_myself_id_async (ogd_object_get_provider (OGD_OBJECT (content)), author_resolved, req);
+}
+
 /**
  * ogd_content_remove:
  * @content:        the #OGDContent to remove
@@ -939,7 +1395,7 @@ void ogd_content_remove (OGDContent *content)
     gchar *query;
 
     if (check_ownership (content) == FALSE) {
-        g_warning ("No permissions to edit the event.");
+        g_warning ("No permissions to edit the content.");
         return;
     }
 
@@ -952,3 +1408,32 @@ void ogd_content_remove (OGDContent *content)
     }
 }
 
+/**
+ * ogd_content_remove_async:
+ * @content:        the #OGDContent to remove
+ * @callback:       async callback to which result of the operation is passed
+ * @userdata:       the user data for the callback
+ *
+ * Async version of ogd_content_remove(). Ownership of the content is checked without blocking,
+ * and if the content cannot be removed the reason is passed to @callback
+ */
+void ogd_content_remove_async (OGDContent *content, OGDSaveAsyncCallback callback, gpointer userdata)
+{
+    const gchar *id;
+    gchar *query;
+    GError *error;
+
+    id = ogd_content_get_id (content);
+
+    if (id == NULL) {
+        error = g_error_new (OGD_EDIT_ERROR_DOMAIN, OGD_EDIT_ERROR, "The content has never been saved.");
+        callback (OGD_OBJECT (content), error, userdata);
+        g_error_free (error);
+        return;
+    }
+
+    query = g_strdup_printf ("content/delete/%s", id);
+    edit_object_async (OGD_OBJECT (content), ogd_content_get_authorid (content), query, NULL, NULL, 0, NULL,
+                       callback, userdata);
+    g_free (query);
+}
@@ -21,6 +21,7 @@
 G_BEGIN_DECLS
 
 #include "ogd-person.h"
+#include "ogd-comment-tree.h"
 
 #define OGD_CONTENT_TYPE             (ogd_content_get_type ())
 #define OGD_CONTENT(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
@@ -79,6 +80,7 @@ void                    ogd_content_set_language            (OGDContent *content
 const gchar*            ogd_content_get_authorid            (OGDContent *content);
 const GDate*            ogd_content_get_creation_date       (OGDContent *content);
 const GDate*            ogd_content_get_change_date         (OGDContent *content);
+gint64                  ogd_content_get_change_time         (OGDContent *content);
 gulong                  ogd_content_get_num_downloads       (OGDContent *content);
 guint                   ogd_content_get_score               (OGDContent *content);
 const gchar*            ogd_content_get_description         (OGDContent *content);
@@ -89,6 +91,7 @@ const gchar*            ogd_content_get_homepage            (OGDContent *content
 void                    ogd_content_set_homepage            (OGDContent *content, gchar *homepage);
 GList*                  ogd_content_get_comments            (OGDContent *content);
 void                    ogd_content_get_comments_async      (OGDContent *content, OGDAsyncListCallback callback, gpointer userdata);
+OGDCommentTree*         ogd_content_get_comment_tree        (OGDContent *content);
 GList*                  ogd_content_get_fans                (OGDContent *content);
 void                    ogd_content_get_fans_async          (OGDContent *content, OGDAsyncListCallback callback, gpointer userdata);
 const GList*            ogd_content_get_previews            (OGDContent *content);
@@ -102,13 +105,18 @@ gulong                  ogd_content_get_num_fans            (OGDContent *content
 
 void                    ogd_content_vote                    (OGDContent *content, OGD_CONTENT_VOTE vote);
 void                    ogd_content_vote_async              (OGDContent *content, OGD_CONTENT_VOTE vote, OGDPutAsyncCallback callback, gpointer userdata);
+void                    ogd_content_vote_queued             (OGDContent *content, OGD_CONTENT_VOTE vote, OGDPutAsyncCallback callback, gpointer userdata);
 void                    ogd_content_set_fan                 (OGDContent *content, gboolean fan);
 void                    ogd_content_set_fan_async           (OGDContent *content, gboolean fan, OGDPutAsyncCallback callback, gpointer userdata);
+void                    ogd_content_set_fan_queued          (OGDContent *content, gboolean fan, OGDPutAsyncCallback callback, gpointer userdata);
 void                    ogd_content_add_comment             (OGDContent *content, gchar *subject, gchar *message);
 void                    ogd_content_add_comment_async       (OGDContent *content, gchar *subject, gchar *message, OGDPutAsyncCallback callback, gpointer userdata);
+void                    ogd_content_add_comment_queued      (OGDContent *content, gchar *subject, gchar *message, OGDPutAsyncCallback callback, gpointer userdata);
 
 void                    ogd_content_save                    (OGDContent *content);
+void                    ogd_content_save_async              (OGDContent *content, OGDSaveAsyncCallback callback, gpointer userdata);
 void                    ogd_content_remove                  (OGDContent *content);
+void                    ogd_content_remove_async            (OGDContent *content, OGDSaveAsyncCallback callback, gpointer userdata);
 
 G_END_DECLS
 
@@ -22,12 +22,16 @@
 #define OGD_HIERARCHY_ERROR_DOMAIN  g_quark_from_string("HierarchyError")
 #define OGD_TYPE_ERROR_DOMAIN       g_quark_from_string("TypeError")
 #define OGD_NETWORK_ERROR_DOMAIN    g_quark_from_string("NetworkError")
+#define OGD_EDIT_ERROR_DOMAIN       g_quark_from_string("EditError")
+#define OGD_JOURNAL_ERROR_DOMAIN    g_quark_from_string("JournalError")
 
 typedef enum {
     OGD_XML_ERROR,
     OGD_HIERARCHY_ERROR,
     OGD_TYPE_ERROR,
     OGD_NETWORK_ERROR,
+    OGD_EDIT_ERROR,
+    OGD_JOURNAL_ERROR,
     OGD_END_ERRORS
 } OGD_ERRORS;
 
@@ -0,0 +1,663 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "ogd.h"
+#include "ogd-event-index.h"
+#include "ogd-provider-private.h"
+#include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
+
+/**
+ * SECTION: ogd-event-index
+ * @short_description:  in-memory index of events by dates and place
+ *
+ * An #OGDEventIndex keeps a local copy of the events of a provider, and finds those taking place
+ * in a range of dates, optionally in a given country or city, without scanning all of them: the
+ * cost of a query depends on the logarithm of the number of events in the country or city and
+ * on the number of events found. Countries and cities are compared ignoring case.
+ * The index is filled with ogd_event_index_refresh(), which only fetches the events changed since
+ * the previous refresh. For this it keeps a watermark, the most recent time of change seen, and
+ * requests events from the newest change stopping as soon as an older one is found. Events
+ * removed from the server are not noticed, and have to be removed with ogd_event_index_remove()
+ */
+
+/*
+    All events, the events of each country and the events of each city are kept in facets. Each
+    facet is an interval tree over the days of the events, stored in a sorted array: events are
+    sorted by start day, and the middle of each range of the array is the root of the tree over
+    that range, annotated with the maximum end day found in the range. So branches ending before
+    the beginning of the query, and those starting after its end, are never visited.
+    Facets are sorted again only when queried after a change
+*/
+
+#define REFRESH_QUERY           "event/data?sortmode=new"
+#define REFRESH_PAGE_SIZE       100
+
+typedef struct {
+    guint32         start;
+    guint32         end;
+    guint32         maxend;
+    OGDEvent        *event;
+    const gchar     *country;
+} EventSpan;
+
+typedef struct {
+    gchar           *name;
+    GHashTable      *members;
+    EventSpan       *spans;
+    glong           size;
+    gboolean        dirty;
+} EventFacet;
+
+typedef struct {
+    OGDEvent        *event;
+    gchar           *country;
+    gchar           *city;
+} EventRecord;
+
+struct _OGDEventIndex {
+    OGDProvider     *provider;
+    GHashTable      *records;
+    EventFacet      *all;
+    GHashTable      *countries;
+    GHashTable      *cities;
+    gint64          watermark;
+};
+
+typedef struct {
+    OGDEventIndex                   *index;
+    OGDEventIndexRefreshCallback    callback;
+    gpointer                        userdata;
+} RefreshRun;
+
+static gboolean event_change_time (OGDObject *obj, gint64 *time);
+static void insert_event (OGDObject *obj, gpointer userdata);
+static void finish_run (gpointer userdata, gint64 newest, gulong changed, const GError *error);
+
+static const OGDChangesFeed EventsFeed = {
+    REFRESH_PAGE_SIZE, event_change_time, insert_event, finish_run
+};
+
+static EventFacet* new_facet (const gchar *name)
+{
+    EventFacet *facet;
+
+    facet = g_new0 (EventFacet, 1);
+    facet->name = g_strdup (name);
+    facet->members = g_hash_table_new (g_direct_hash, g_direct_equal);
+    return facet;
+}
+
+static void free_facet (EventFacet *facet)
+{
+    g_hash_table_destroy (facet->members);
+    g_free (facet->spans);
+    g_free (facet->name);
+    g_free (facet);
+}
+
+static void free_record (EventRecord *record)
+{
+    g_object_unref (record->event);
+    g_free (record->country);
+    g_free (record->city);
+    g_free (record);
+}
+
+/**
+ * ogd_event_index_new:
+ * @provider:       the #OGDProvider from which events are fetched
+ *
+ * To create a new empty #OGDEventIndex
+ *
+ * Return value:    a newly allocated #OGDEventIndex, to be freed with ogd_event_index_free()
+ */
+OGDEventIndex* ogd_event_index_new (OGDProvider *provider)
+{
+    OGDEventIndex *index;
+
+    index = g_new0 (OGDEventIndex, 1);
+    index->provider = provider;
+    index->records = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) free_record);
+    index->all = new_facet (NULL);
+    index->countries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) free_facet);
+    index->cities = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) free_facet);
+    return index;
+}
+
+/**
+ * ogd_event_index_free:
+ * @index:          the #OGDEventIndex to free
+ *
+ * Frees an #OGDEventIndex, releasing the references to the events it contains. Must not be
+ * called while a refresh started with ogd_event_index_refresh_async() is still running
+ */
+void ogd_event_index_free (OGDEventIndex *index)
+{
+    g_hash_table_destroy (index->countries);
+    g_hash_table_destroy (index->cities);
+    free_facet (index->all);
+    g_hash_table_destroy (index->records);
+    g_free (index);
+}
+
+static gchar* facet_key (const gchar *name)
+{
+    if (name == NULL || *name == '\0')
+        return NULL;
+
+    return g_utf8_casefold (name, -1);
+}
+
+static void facet_add (GHashTable *facets, const gchar *key, const gchar *name, EventRecord *record)
+{
+    EventFacet *facet;
+
+    if (key == NULL)
+        return;
+
+    facet = g_hash_table_lookup (facets, key);
+
+    if (facet == NULL) {
+        facet = new_facet (name);
+        g_hash_table_insert (facets, g_strdup (key), facet);
+    }
+
+    g_hash_table_insert (facet->members, record, record);
+    facet->dirty = TRUE;
+}
+
+static void facet_remove (GHashTable *facets, const gchar *key, EventRecord *record)
+{
+    EventFacet *facet;
+
+    if (key == NULL)
+        return;
+
+    facet = g_hash_table_lookup (facets, key);
+    if (facet == NULL)
+        return;
+
+    g_hash_table_remove (facet->members, record);
+    facet->dirty = TRUE;
+
+    if (g_hash_table_size (facet->members) == 0)
+        g_hash_table_remove (facets, key);
+}
+
+/**
+ * ogd_event_index_remove:
+ * @index:          the #OGDEventIndex from which remove the event
+ * @id:             ID of the #OGDEvent to remove
+ *
+ * Removes an event from the index, e.g. when it has been removed from the server. Nothing is
+ * done if no event with the given @id is in the index
+ */
+void ogd_event_index_remove (OGDEventIndex *index, const gchar *id)
+{
+    EventRecord *record;
+
+    record = g_hash_table_lookup (index->records, id);
+    if (record == NULL)
+        return;
+
+    g_hash_table_remove (index->all->members, record);
+    index->all->dirty = TRUE;
+    facet_remove (index->countries, record->country, record);
+    facet_remove (index->cities, record->city, record);
+
+    g_hash_table_remove (index->records, id);
+}
+
+/**
+ * ogd_event_index_insert:
+ * @index:          the #OGDEventIndex in which insert the event
+ * @event:          the #OGDEvent to insert. The index takes a reference to it
+ *
+ * Inserts an event in the index, replacing the one with the same ID if any. If @event is
+ * modified after the insertion, it has to be inserted again to update the index. Events without
+ * ID are ignored, and those without dates are never returned by ogd_event_index_query()
+ */
+void ogd_event_index_insert (OGDEventIndex *index, OGDEvent *event)
+{
+    const gchar *id;
+    EventRecord *record;
+
+    id = ogd_event_get_id (event);
+    if (id == NULL)
+        return;
+
+    /*
+        The event may be the same already in the index, so it is kept alive while removed
+    */
+    g_object_ref (event);
+    ogd_event_index_remove (index, id);
+
+    record = g_new0 (EventRecord, 1);
+    record->event = event;
+    record->country = facet_key (ogd_event_get_country (event));
+    record->city = facet_key (ogd_event_get_city (event));
+    g_hash_table_insert (index->records, g_strdup (id), record);
+
+    g_hash_table_insert (index->all->members, record, record);
+    index->all->dirty = TRUE;
+    facet_add (index->countries, record->country, ogd_event_get_country (event), record);
+    facet_add (index->cities, record->city, ogd_event_get_city (event), record);
+}
+
+/**
+ * ogd_event_index_lookup:
+ * @index:          the #OGDEventIndex to query
+ * @id:             ID of the #OGDEvent
+ *
+ * To retrieve an event from the index
+ *
+ * Return value:    the #OGDEvent with the given @id, still owned by @index, or %NULL if not found
+ */
+OGDEvent* ogd_event_index_lookup (OGDEventIndex *index, const gchar *id)
+{
+    EventRecord *record;
+
+    record = g_hash_table_lookup (index->records, id);
+    return record != NULL ? record->event : NULL;
+}
+
+/**
+ * ogd_event_index_get_size:
+ * @index:          the #OGDEventIndex to query
+ *
+ * To know how many events are in the index
+ *
+ * Return value:    the number of events in @index
+ */
+guint ogd_event_index_get_size (OGDEventIndex *index)
+{
+    return g_hash_table_size (index->records);
+}
+
+static guint32 date_to_day (const GDate *date)
+{
+    if (date == NULL || g_date_valid (date) == FALSE)
+        return 0;
+
+    return g_date_get_julian (date);
+}
+
+/*
+    An event with only one of the dates is assumed to last a single day
+*/
+static gboolean event_span (OGDEvent *event, guint32 *start, guint32 *end)
+{
+    *start = date_to_day (ogd_event_get_start_date (event));
+    *end = date_to_day (ogd_event_get_end_date (event));
+
+    if (*start == 0 && *end == 0)
+        return FALSE;
+
+    if (*start == 0)
+        *start = *end;
+    if (*end < *start)
+        *end = *start;
+
+    return TRUE;
+}
+
+static int compare_spans (const void *a, const void *b)
+{
+    const EventSpan *first;
+    const EventSpan *second;
+
+    first = (const EventSpan*) a;
+    second = (const EventSpan*) b;
+
+    if (first->start != second->start)
+        return first->start < second->start ? -1 : 1;
+    if (first->end != second->end)
+        return first->end < second->end ? -1 : 1;
+    return 0;
+}
+
+static guint32 annotate_spans (EventSpan *spans, glong lo, glong hi)
+{
+    glong mid;
+    guint32 ret;
+
+    if (lo >= hi)
+        return 0;
+
+    mid = lo + (hi - lo) / 2;
+    ret = spans [mid].end;
+    ret = MAX (ret, annotate_spans (spans, lo, mid));
+    ret = MAX (ret, annotate_spans (spans, mid + 1, hi));
+    spans [mid].maxend = ret;
+    return ret;
+}
+
+static void rebuild_facet (EventFacet *facet)
+{
+    GHashTableIter iter;
+    EventRecord *record;
+    EventSpan *span;
+
+    if (facet->dirty == FALSE)
+        return;
+
+    g_free (facet->spans);
+    facet->spans = g_new (EventSpan, g_hash_table_size (facet->members));
+    facet->size = 0;
+
+    g_hash_table_iter_init (&iter, facet->members);
+
+    while (g_hash_table_iter_next (&iter, (gpointer*) &record, NULL)) {
+        span = &(facet->spans [facet->size]);
+
+        if (event_span (record->event, &span->start, &span->end) == TRUE) {
+            span->event = record->event;
+            span->country = record->country;
+            facet->size++;
+        }
+    }
+
+    qsort (facet->spans, facet->size, sizeof (EventSpan), compare_spans);
+    annotate_spans (facet->spans, 0, facet->size);
+    facet->dirty = FALSE;
+}
+
+/*
+    Found events are prepended in reverse order of start day, so that the final list is sorted
+*/
+static void query_spans (EventSpan *spans, glong lo, glong hi, guint32 from, guint32 to,
+                         const gchar *country, GList **found)
+{
+    glong mid;
+    EventSpan *span;
+
+    if (lo >= hi)
+        return;
+
+    mid = lo + (hi - lo) / 2;
+    span = &(spans [mid]);
+
+    if (span->maxend < from)
+        return;
+
+    if (span->start <= to) {
+        query_spans (spans, mid + 1, hi, from, to, country, found);
+
+        if (span->end >= from && (country == NULL || g_strcmp0 (span->country, country) == 0))
+            *found = g_list_prepend (*found, span->event);
+    }
+
+    query_spans (spans, lo, mid, from, to, country, found);
+}
+
+/**
+ * ogd_event_index_query:
+ * @index:          the #OGDEventIndex to query
+ * @from:           first day of the range, or %NULL for no lower limit
+ * @to:             last day of the range, or %NULL for no upper limit
+ * @country:        country in which the events take place, or %NULL for any country
+ * @city:           city in which the events take place, or %NULL for any city
+ *
+ * To retrieve the events taking place, even partially, in a range of days
+ *
+ * Return value:    a #GList of #OGDEvent s sorted by start date. Events are still owned by
+ *                  @index, only the list has to be freed
+ */
+GList* ogd_event_index_query (OGDEventIndex *index, const GDate *from, const GDate *to,
+                              const gchar *country, const gchar *city)
+{
+    guint32 first;
+    guint32 last;
+    gchar *country_key;
+    gchar *city_key;
+    GList *ret;
+    EventFacet *facet;
+
+    first = date_to_day (from);
+    last = date_to_day (to);
+    if (last == 0)
+        last = G_MAXUINT32;
+
+    country_key = facet_key (country);
+    city_key = facet_key (city);
+
+    /*
+        Cities with the same name in different countries share a facet, and are told apart
+        checking the country of the events found
+    */
+    if (city_key != NULL)
+        facet = g_hash_table_lookup (index->cities, city_key);
+    else if (country_key != NULL)
+        facet = g_hash_table_lookup (index->countries, country_key);
+    else
+        facet = index->all;
+
+    ret = NULL;
+
+    if (facet != NULL) {
+        rebuild_facet (facet);
+        query_spans (facet->spans, 0, facet->size, first, last, city_key != NULL ? country_key : NULL, &ret);
+    }
+
+    g_free (country_key);
+    g_free (city_key);
+    return ret;
+}
+
+/**
+ * ogd_event_index_get_countries:
+ * @index:          the #OGDEventIndex to query
+ *
+ * To retrieve the countries in which the events of the index take place
+ *
+ * Return value:    a #GList of strings, with the name of each country as found in the first
+ *                  event inserted for it. Strings are owned by @index, only the list has to be
+ *                  freed
+ */
+GList* ogd_event_index_get_countries (OGDEventIndex *index)
+{
+    GList *ret;
+    GHashTableIter iter;
+    EventFacet *facet;
+
+    ret = NULL;
+    g_hash_table_iter_init (&iter, index->countries);
+
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer*) &facet))
+        ret = g_list_prepend (ret, facet->name);
+
+    return ret;
+}
+
+/**
+ * ogd_event_index_get_cities:
+ * @index:          the #OGDEventIndex to query
+ * @country:        country of the cities, or %NULL for all countries
+ *
+ * To retrieve the cities in which the events of the index take place
+ *
+ * Return value:    a #GList of strings, with the name of each city. Strings are owned by @index,
+ *                  only the list has to be freed
+ */
+GList* ogd_event_index_get_cities (OGDEventIndex *index, const gchar *country)
+{
+    gchar *key;
+    GList *ret;
+    GHashTable *seen;
+    GHashTableIter iter;
+    EventFacet *facet;
+    EventRecord *record;
+
+    ret = NULL;
+
+    if (country == NULL) {
+        g_hash_table_iter_init (&iter, index->cities);
+
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer*) &facet))
+            ret = g_list_prepend (ret, facet->name);
+
+        return ret;
+    }
+
+    key = facet_key (country);
+    facet = key != NULL ? g_hash_table_lookup (index->countries, key) : NULL;
+    g_free (key);
+
+    if (facet == NULL)
+        return NULL;
+
+    seen = g_hash_table_new (g_str_hash, g_str_equal);
+    g_hash_table_iter_init (&iter, facet->members);
+
+    while (g_hash_table_iter_next (&iter, (gpointer*) &record, NULL)) {
+        if (record->city != NULL && g_hash_table_lookup (seen, record->city) == NULL) {
+            g_hash_table_insert (seen, record->city, record);
+            ret = g_list_prepend (ret, (gpointer) ogd_event_get_city (record->event));
+        }
+    }
+
+    g_hash_table_destroy (seen);
+    return ret;
+}
+
+/**
+ * ogd_event_index_get_watermark:
+ * @index:          the #OGDEventIndex to query
+ *
+ * To know up to when events have been fetched
+ *
+ * Return value:    the most recent time of change seen for events in @index, in seconds since the
+ *                  Epoch, or 0 if the index has never been refreshed
+ */
+gint64 ogd_event_index_get_watermark (OGDEventIndex *index)
+{
+    return index->watermark;
+}
+
+/**
+ * ogd_event_index_set_watermark:
+ * @index:          the #OGDEventIndex to modify
+ * @watermark:      new watermark, in seconds since the Epoch
+ *
+ * To explicitely set from when events have to be fetched by the next refresh, for example to 0
+ * to fetch all of them again
+ */
+void ogd_event_index_set_watermark (OGDEventIndex *index, gint64 watermark)
+{
+    index->watermark = watermark;
+}
+
+static RefreshRun* new_run (OGDEventIndex *index, OGDEventIndexRefreshCallback callback, gpointer userdata)
+{
+    RefreshRun *run;
+
+    run = g_new0 (RefreshRun, 1);
+    run->index = index;
+    run->callback = callback;
+    run->userdata = userdata;
+    return run;
+}
+
+static gboolean event_change_time (OGDObject *obj, gint64 *time)
+{
+    if (IS_OGD_EVENT (obj) == FALSE)
+        return FALSE;
+
+    *time = ogd_event_get_change_time (OGD_EVENT (obj));
+    return TRUE;
+}
+
+static void insert_event (OGDObject *obj, gpointer userdata)
+{
+    RefreshRun *run;
+
+    run = (RefreshRun*) userdata;
+    ogd_event_index_insert (run->index, OGD_EVENT (obj));
+}
+
+static void finish_run (gpointer userdata, gint64 newest, gulong changed, const GError *error)
+{
+    RefreshRun *run;
+
+    run = (RefreshRun*) userdata;
+
+    if (error == NULL)
+        run->index->watermark = newest;
+
+    if (run->callback != NULL) {
+        TRACED_CALLBACK ("callback", run->callback (run->index, changed, error, run->userdata));
+    }
+
+    g_free (run);
+}
+
+/**
+ * ogd_event_index_refresh:
+ * @index:          the #OGDEventIndex to refresh
+ * @changed:        if not %NULL, filled with the number of events inserted or updated
+ * @error:          a #GError filled if the function returns %FALSE
+ *
+ * Fetches the events changed since the previous refresh and inserts them in the index, or all
+ * the events of the provider at the first refresh. If one of the requests fails the watermark
+ * is not changed, but events already received are kept in the index
+ *
+ * Return value:    %TRUE if the refresh completed, %FALSE otherwise
+ */
+gboolean ogd_event_index_refresh (OGDEventIndex *index, gulong *changed, GError **error)
+{
+    gint64 newest;
+    gulong count;
+    GError *page_error;
+    RefreshRun *run;
+
+    run = new_run (index, NULL, NULL);
+    page_error = NULL;
+    fetch_changes (index->provider, REFRESH_QUERY, &EventsFeed, index->watermark, run,
+                   &newest, &count, &page_error);
+
+    if (changed != NULL)
+        *changed = count;
+
+    finish_run (run, newest, count, page_error);
+
+    if (page_error != NULL) {
+        g_propagate_error (error, page_error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * ogd_event_index_refresh_async:
+ * @index:          the #OGDEventIndex to refresh
+ * @callback:       callback invoked at the end of the refresh, or %NULL
+ * @userdata:       the user data for the callback
+ *
+ * Async version of ogd_event_index_refresh(). Pages are requested one after the other, with
+ * %OGD_PROVIDER_PRIORITY_BULK priority
+ */
+void ogd_event_index_refresh_async (OGDEventIndex *index, OGDEventIndexRefreshCallback callback, gpointer userdata)
+{
+    RefreshRun *run;
+
+    run = new_run (index, callback, userdata);
+    fetch_changes_async (index->provider, REFRESH_QUERY, &EventsFeed, index->watermark, run);
+}
@@ -0,0 +1,59 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_EVENT_INDEX_H
+#define OGD_EVENT_INDEX_H
+
+G_BEGIN_DECLS
+
+#include "ogd-event.h"
+
+typedef struct _OGDEventIndex OGDEventIndex;
+
+/**
+ * OGDEventIndexRefreshCallback:
+ * @index:          the #OGDEventIndex which has been refreshed
+ * @changed:        number of events inserted or updated
+ * @error:          the reason of the failure, or %NULL if the refresh succeeded
+ * @userdata:       the user data passed with the callback
+ *
+ * Invoked by ogd_event_index_refresh_async() at the end of the refresh
+ */
+typedef void (*OGDEventIndexRefreshCallback) (OGDEventIndex *index, gulong changed, const GError *error, gpointer userdata);
+
+OGDEventIndex*      ogd_event_index_new                 (OGDProvider *provider);
+void                ogd_event_index_free                (OGDEventIndex *index);
+
+void                ogd_event_index_insert              (OGDEventIndex *index, OGDEvent *event);
+void                ogd_event_index_remove              (OGDEventIndex *index, const gchar *id);
+OGDEvent*           ogd_event_index_lookup              (OGDEventIndex *index, const gchar *id);
+guint               ogd_event_index_get_size            (OGDEventIndex *index);
+
+GList*              ogd_event_index_query               (OGDEventIndex *index, const GDate *from, const GDate *to,
+                                                         const gchar *country, const gchar *city);
+GList*              ogd_event_index_get_countries       (OGDEventIndex *index);
+GList*              ogd_event_index_get_cities          (OGDEventIndex *index, const gchar *country);
+
+gint64              ogd_event_index_get_watermark       (OGDEventIndex *index);
+void                ogd_event_index_set_watermark       (OGDEventIndex *index, gint64 watermark);
+gboolean            ogd_event_index_refresh             (OGDEventIndex *index, gulong *changed, GError **error);
+void                ogd_event_index_refresh_async       (OGDEventIndex *index, OGDEventIndexRefreshCallback callback,
+                                                         gpointer userdata);
+
+G_END_DECLS
+
+#endif /* OGD_EVENT_INDEX_H */
@@ -23,15 +23,53 @@
 #define OGD_EVENT_GET_PRIVATE(obj)       (G_TYPE_INSTANCE_GET_PRIVATE ((obj),    \
                                              OGD_EVENT_TYPE, OGDEventPrivate))
 
-#define CHECK_AND_SET_STRING(__event, __field, __value) {   \
-    if (check_ownership (__event) == FALSE) {               \
-        g_warning ("No permissions to edit the event.");    \
-        return;                                             \
-    }                                                       \
-                                                            \
-    SET_STRING (__event, __field, __value);                 \
+#define CHECK_AND_SET_STRING(__event, __field, __value, __flag) { \
+    if (check_ownership (__event) == FALSE) {                       \
+        g_warning ("No permissions to edit the event.");            \
+        return;                                                     \
+    }                                                               \
+                                                                    \
+    if (g_strcmp0 (__event->priv->__field, __value) != 0) {         \
+        SET_STRING (__event, __field, __value);                     \
+        __event->priv->dirty |= __flag;                             \
+    }                                                               \
 }
 
+#define CHECK_AND_SET_VALUE(__event, __field, __value, __flag) {  \
+    if (check_ownership (__event) == FALSE) {                       \
+        g_warning ("No permissions to edit the event.");            \
+        return;                                                     \
+    }                                                               \
+                                                                    \
+    if (__event->priv->__field != __value) {                        \
+        __event->priv->__field = __value;                           \
+        __event->priv->dirty |= __flag;                             \
+    }                                                               \
+}
+
+/*
+    Fields changed with setters since the event has been fetched or saved the last time: only
+    those are sent when editing an existing event
+*/
+typedef enum {
+    EVENT_DIRTY_NAME            = 1 << 0,
+    EVENT_DIRTY_DESCRIPTION     = 1 << 1,
+    EVENT_DIRTY_CATEGORY        = 1 << 2,
+    EVENT_DIRTY_STARTDATE       = 1 << 3,
+    EVENT_DIRTY_ENDDATE         = 1 << 4,
+    EVENT_DIRTY_ORGANIZER       = 1 << 5,
+    EVENT_DIRTY_LOCATION        = 1 << 6,
+    EVENT_DIRTY_CITY            = 1 << 7,
+    EVENT_DIRTY_COUNTRY         = 1 << 8,
+    EVENT_DIRTY_LATITUDE        = 1 << 9,
+    EVENT_DIRTY_LONGITUDE       = 1 << 10,
+    EVENT_DIRTY_HOMEPAGE        = 1 << 11,
+    EVENT_DIRTY_TELEPHONE       = 1 << 12,
+    EVENT_DIRTY_FAX             = 1 << 13,
+    EVENT_DIRTY_MAIL            = 1 << 14,
+    EVENT_DIRTY_ALL             = (1 << 15) - 1
+} EVENT_DIRTY_FIELDS;
+
 /**
  * SECTION: ogd-event
  * @short_description:  a registered event
@@ -64,9 +102,11 @@ struct _OGDEventPrivate {
     gchar               *fax;
     gchar               *mail;
     GDate               *changed;
+    gint64              changetime;
     gulong              numcomments;
     gulong              numpartecipants;
     gchar               *image;
+    guint               dirty;
 };
 
 G_DEFINE_TYPE (OGDEvent, ogd_event, OGD_OBJECT_TYPE);
@@ -77,22 +117,26 @@ static void ogd_event_finalize (GObject *obj)
 
     event = OGD_EVENT (obj);
 
-    PTR_CHECK_FREE_NULLIFY (event->priv->id);
-    PTR_CHECK_FREE_NULLIFY (event->priv->name);
-    PTR_CHECK_FREE_NULLIFY (event->priv->description);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->id);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->name);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->description);
     DATE_CHECK_FREE_NULLIFY (event->priv->startdate);
     DATE_CHECK_FREE_NULLIFY (event->priv->enddate);
-    PTR_CHECK_FREE_NULLIFY (event->priv->authorid);
-    PTR_CHECK_FREE_NULLIFY (event->priv->organizer);
-    PTR_CHECK_FREE_NULLIFY (event->priv->location);
-    PTR_CHECK_FREE_NULLIFY (event->priv->city);
-    PTR_CHECK_FREE_NULLIFY (event->priv->country);
-    PTR_CHECK_FREE_NULLIFY (event->priv->homepage);
-    PTR_CHECK_FREE_NULLIFY (event->priv->telephone);
-    PTR_CHECK_FREE_NULLIFY (event->priv->fax);
-    PTR_CHECK_FREE_NULLIFY (event->priv->mail);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->authorid);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->organizer);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->location);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->city);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->country);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->homepage);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->telephone);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->fax);
+    ARENA_CHECK_FREE_NULLIFY (event->priv->mail);
     DATE_CHECK_FREE_NULLIFY (event->priv->changed);
-    PTR_CHECK_FREE_NULLIFY (event->priv->image);
+    event->priv->changetime = 0;
+    ARENA_CHECK_FREE_NULLIFY (event->priv->image);
+    event->priv->dirty = 0;
+
+    ogd_object_release_arena (OGD_OBJECT (obj));
 }
 
 static gboolean ogd_event_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
@@ -162,8 +206,10 @@ static gboolean ogd_event_fill_by_xml (OGDObject *obj, const xmlNode *xml, GErro
             event->priv->fax = MYGETCONTENT (cursor);
         else if (MYSTRCMP (cursor->name, "email") == 0)
             event->priv->mail = MYGETCONTENT (cursor);
-        else if (MYSTRCMP (cursor->name, "changed") == 0)
+        else if (MYSTRCMP (cursor->name, "changed") == 0) {
             event->priv->changed = node_to_date (cursor);
+            event->priv->changetime = node_to_time (cursor);
+        }
         else if (MYSTRCMP (cursor->name, "comments") == 0)
             event->priv->numcomments = (guint) node_to_num (cursor);
         else if (MYSTRCMP (cursor->name, "partecipants") == 0)
@@ -180,6 +226,11 @@ static gchar* ogd_event_target_query (const gchar *id)
     return g_strdup_printf ("event/data/%s", id);
 }
 
+static const gchar* ogd_event_get_object_id (OGDObject *obj)
+{
+    return ogd_event_get_id (OGD_EVENT (obj));
+}
+
 static void ogd_event_class_init (OGDEventClass *klass)
 {
     GObjectClass *gobject_class;
@@ -192,6 +243,7 @@ static void ogd_event_class_init (OGDEventClass *klass)
 
     ogd_object_class = OGD_OBJECT_CLASS (klass);
     ogd_object_class->fill_by_xml = ogd_event_fill_by_xml;
+    ogd_object_class_set_id_func (ogd_object_class, ogd_event_get_object_id);
     ogd_object_class->target_query = ogd_event_target_query;
 }
 
@@ -204,17 +256,15 @@ static void ogd_event_init (OGDEvent *item)
 static gboolean check_ownership (OGDEvent *event)
 {
     const gchar *owner;
-    static const gchar *myself = NULL;
+    const gchar *myself;
 
     if (ogd_event_get_id (event) == NULL)
         return TRUE;
 
     owner = ogd_event_get_authorid (event);
+    myself = ogd_person_get_myself_id (ogd_object_get_provider (OGD_OBJECT (event)));
 
-    if (myself == NULL)
-        myself = ogd_person_get_id (ogd_person_get_myself (ogd_object_get_provider (OGD_OBJECT (event))));
-
-    return (strcmp (owner, myself) == 0);
+    return (owner != NULL && myself != NULL && strcmp (owner, myself) == 0);
 }
 
 /**
@@ -298,7 +348,7 @@ const gchar* ogd_event_get_name (OGDEvent *event)
  */
 void ogd_event_set_name (OGDEvent *event, gchar *title)
 {
-    CHECK_AND_SET_STRING (event, name, title);
+    CHECK_AND_SET_STRING (event, name, title, EVENT_DIRTY_NAME);
 }
 
 /**
@@ -324,7 +374,7 @@ const gchar* ogd_event_get_description (OGDEvent *event)
  */
 void ogd_event_set_description (OGDEvent *event, gchar *description)
 {
-    CHECK_AND_SET_STRING (event, description, description);
+    CHECK_AND_SET_STRING (event, description, description, EVENT_DIRTY_DESCRIPTION);
 }
 
 /**
@@ -350,12 +400,7 @@ OGD_EVENT_CATEGORY ogd_event_get_category (OGDEvent *event)
  */
 void ogd_event_set_category (OGDEvent *event, OGD_EVENT_CATEGORY cat)
 {
-    if (check_ownership (event) == FALSE) {
-        g_warning ("No permissions to edit the event.");
-        return;
-    }
-
-    event->priv->category = cat;
+    CHECK_AND_SET_VALUE (event, category, cat, EVENT_DIRTY_CATEGORY);
 }
 
 /**
@@ -388,6 +433,7 @@ void ogd_event_set_start_date (OGDEvent *event, GDate *date)
 
     DATE_CHECK_FREE_NULLIFY (event->priv->startdate);
     event->priv->startdate = date;
+    event->priv->dirty |= EVENT_DIRTY_STARTDATE;
 }
 
 /**
@@ -420,6 +466,7 @@ void ogd_event_set_end_date (OGDEvent *event, GDate *date)
 
     DATE_CHECK_FREE_NULLIFY (event->priv->enddate);
     event->priv->enddate = date;
+    event->priv->dirty |= EVENT_DIRTY_ENDDATE;
 }
 
 /**
@@ -446,7 +493,7 @@ const gchar* ogd_event_get_organizer (OGDEvent *event)
  */
 void ogd_event_set_organizer (OGDEvent *event, gchar *organizer)
 {
-    CHECK_AND_SET_STRING (event, organizer, organizer);
+    CHECK_AND_SET_STRING (event, organizer, organizer, EVENT_DIRTY_ORGANIZER);
 }
 
 /**
@@ -473,7 +520,7 @@ const gchar* ogd_event_get_location (OGDEvent *event)
  */
 void ogd_event_set_location (OGDEvent *event, gchar *location)
 {
-    CHECK_AND_SET_STRING (event, location, location);
+    CHECK_AND_SET_STRING (event, location, location, EVENT_DIRTY_LOCATION);
 }
 
 /**
@@ -500,7 +547,7 @@ const gchar* ogd_event_get_city (OGDEvent *event)
  */
 void ogd_event_set_city (OGDEvent *event, gchar *city)
 {
-    CHECK_AND_SET_STRING (event, city, city);
+    CHECK_AND_SET_STRING (event, city, city, EVENT_DIRTY_CITY);
 }
 
 /**
@@ -527,7 +574,7 @@ const gchar* ogd_event_get_country (OGDEvent *event)
  */
 void ogd_event_set_country (OGDEvent *event, gchar *country)
 {
-    CHECK_AND_SET_STRING (event, country, country);
+    CHECK_AND_SET_STRING (event, country, country, EVENT_DIRTY_COUNTRY);
 }
 
 /**
@@ -553,12 +600,7 @@ gdouble ogd_event_get_longitude (OGDEvent *event)
  */
 void ogd_event_set_longitude (OGDEvent *event, gdouble longitude)
 {
-    if (check_ownership (event) == FALSE) {
-        g_warning ("No permissions to edit the event.");
-        return;
-    }
-
-    event->priv->longitude = longitude;
+    CHECK_AND_SET_VALUE (event, longitude, longitude, EVENT_DIRTY_LONGITUDE);
 }
 
 /**
@@ -584,12 +626,7 @@ gdouble ogd_event_get_latitude (OGDEvent *event)
  */
 void ogd_event_set_latitude (OGDEvent *event, gdouble latitude)
 {
-    if (check_ownership (event) == FALSE) {
-        g_warning ("No permissions to edit the event.");
-        return;
-    }
-
-    event->priv->latitude = latitude;
+    CHECK_AND_SET_VALUE (event, latitude, latitude, EVENT_DIRTY_LATITUDE);
 }
 
 /**
@@ -615,7 +652,7 @@ const gchar* ogd_event_get_homepage (OGDEvent *event)
  */
 void ogd_event_set_homepage (OGDEvent *event, gchar *homepage)
 {
-    CHECK_AND_SET_STRING (event, homepage, homepage);
+    CHECK_AND_SET_STRING (event, homepage, homepage, EVENT_DIRTY_HOMEPAGE);
 }
 
 /**
@@ -643,7 +680,7 @@ const gchar* ogd_event_get_telephone (OGDEvent *event)
  */
 void ogd_event_set_telephone (OGDEvent *event, gchar *telephone)
 {
-    CHECK_AND_SET_STRING (event, telephone, telephone);
+    CHECK_AND_SET_STRING (event, telephone, telephone, EVENT_DIRTY_TELEPHONE);
 }
 
 /**
@@ -670,7 +707,7 @@ const gchar* ogd_event_get_fax (OGDEvent *event)
  */
 void ogd_event_set_fax (OGDEvent *event, gchar *fax)
 {
-    CHECK_AND_SET_STRING (event, fax, fax);
+    CHECK_AND_SET_STRING (event, fax, fax, EVENT_DIRTY_FAX);
 }
 
 /**
@@ -698,7 +735,7 @@ const gchar* ogd_event_get_email (OGDEvent *event)
  */
 void ogd_event_set_email (OGDEvent *event, gchar *mail)
 {
-    CHECK_AND_SET_STRING (event, mail, mail);
+    CHECK_AND_SET_STRING (event, mail, mail, EVENT_DIRTY_MAIL);
 }
 
 /**
@@ -714,6 +751,20 @@ const GDate* ogd_event_get_changed (OGDEvent *event)
     return event->priv->changed;
 }
 
+/**
+ * ogd_event_get_change_time:
+ * @event:          the #OGDEvent to query
+ *
+ * As ogd_event_get_changed(), but with the time of the change
+ *
+ * Return value:    the time of latest change of the target @event, in seconds since the Epoch, or
+ *                  0 if unknown
+ */
+gint64 ogd_event_get_change_time (OGDEvent *event)
+{
+    return event->priv->changetime;
+}
+
 /**
  * ogd_event_get_comments:
  * @event:          the #OGDEvent to query
@@ -732,6 +783,21 @@ GList* ogd_event_get_comments (OGDEvent *event)
     return ret;
 }
 
+/**
+ * ogd_event_get_comment_tree:
+ * @event:          the #OGDEvent to query
+ *
+ * Prepares to load the comments published for the given #OGDEvent page by page, without
+ * building an #OGDComment for each of them
+ *
+ * Return value:    an empty #OGDCommentTree, to be filled with ogd_comment_tree_fetch_next_page()
+ *                  and freed with ogd_comment_tree_free()
+ */
+OGDCommentTree* ogd_event_get_comment_tree (OGDEvent *event)
+{
+    return ogd_comment_tree_new (ogd_object_get_provider (OGD_OBJECT (event)), 8, ogd_event_get_id (event));
+}
+
 /**
  * ogd_event_get_num_partecipants:
  * @event:          the #OGDEvent to query
@@ -796,133 +862,192 @@ static int category_to_identifier (OGD_EVENT_CATEGORY category)
     }
 }
 
+static void insert_param (OGDEvent *event, GHashTable *data, guint fields, guint flag, gchar *key, gchar *value)
+{
+    if ((fields & flag) == 0) {
+        g_free (value);
+        return;
+    }
+
+    /*
+        A field emptied on an existing event is sent anyway, so that it is emptied also on the
+        server
+    */
+    if (value != NULL)
+        g_hash_table_insert (data, key, value);
+    else if (ogd_event_get_id (event) != NULL)
+        g_hash_table_insert (data, key, g_strdup (""));
+}
+
+static gchar* format_event_date (const GDate *date)
+{
+    gchar *ret;
+    struct tm tm;
+
+    if (date == NULL)
+        return NULL;
+
+    g_date_to_struct_tm (date, &tm);
+    ret = g_new0 (gchar, 100);
+    strftime (ret, 100, "%Y-%m-%dT%H:%M:%S", &tm);
+    return ret;
+}
+
+/*
+    Parameters describing @event for "event/add" and "event/edit", limited to the @fields mask.
+    Values are copied, so the table is independent from the event. NULL if mandatory fields are
+    missing
+*/
+static GHashTable* save_params (OGDEvent *event, guint fields, GError **error)
+{
+    GHashTable *data;
+
+    if (ogd_event_get_name (event) == NULL) {
+        g_set_error (error, OGD_EDIT_ERROR_DOMAIN, OGD_EDIT_ERROR, "A name for the event is mandatory.");
+        return NULL;
+    }
+
+    data = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+
+    insert_param (event, data, fields, EVENT_DIRTY_NAME, "name", g_strdup (ogd_event_get_name (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_DESCRIPTION, "description", g_strdup (ogd_event_get_description (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_CATEGORY, "category",
+                  g_strdup_printf ("%d", category_to_identifier (ogd_event_get_category (event))));
+    insert_param (event, data, fields, EVENT_DIRTY_STARTDATE, "startdate", format_event_date (ogd_event_get_start_date (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_ENDDATE, "enddate", format_event_date (ogd_event_get_end_date (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_ORGANIZER, "organizer", g_strdup (ogd_event_get_organizer (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_LOCATION, "location", g_strdup (ogd_event_get_location (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_CITY, "city", g_strdup (ogd_event_get_city (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_COUNTRY, "country", g_strdup (ogd_event_get_country (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_LONGITUDE, "longitude", g_strdup_printf ("%.03f", ogd_event_get_longitude (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_LATITUDE, "latitude", g_strdup_printf ("%.03f", ogd_event_get_latitude (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_HOMEPAGE, "homepage", g_strdup (ogd_event_get_homepage (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_TELEPHONE, "tel", g_strdup (ogd_event_get_telephone (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_FAX, "fax", g_strdup (ogd_event_get_fax (event)));
+    insert_param (event, data, fields, EVENT_DIRTY_MAIL, "email", g_strdup (ogd_event_get_email (event)));
+
+    return data;
+}
+
 /**
  * ogd_event_save:
  * @event:          a new #OGDEvent to be saved on the provider, or an existing event to edit
  *
  * To save a new or edited event. The function fails if trying to edit an event not owned by the
- * current user
+ * current user. When editing an existing event only the fields changed since it has been fetched
+ * or saved the last time are sent, and nothing is done if none has been changed
  */
 void ogd_event_save (OGDEvent *event)
 {
+    guint fields;
     const gchar *id;
     gchar *query;
-    gchar *tmp;
-    const gchar *str;
-    gdouble coord;
-    struct tm tm;
-    OGD_EVENT_CATEGORY cat;
-    const GDate *date;
     GHashTable *data;
+    GError *error;
     xmlNode *response;
-    xmlNode *inner_response;
+
+    id = ogd_event_get_id (event);
+    if (id != NULL && event->priv->dirty == 0)
+        return;
 
     if (check_ownership (event) == FALSE) {
         g_warning ("No permissions to edit the event.");
         return;
     }
 
-    str = ogd_event_get_name (event);
-    if (str == NULL) {
-        g_warning ("A name for the event is mandatory.");
+    fields = (id == NULL) ? EVENT_DIRTY_ALL : event->priv->dirty;
+
+    error = NULL;
+    data = save_params (event, fields, &error);
+    if (data == NULL) {
+        g_warning ("%s", error->message);
+        g_error_free (error);
         return;
     }
 
-    data = g_hash_table_new (g_str_hash, g_str_equal);
-
-    g_hash_table_insert (data, "name", (gchar*) str);
-
-    str = ogd_event_get_description (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "description", (gchar*) str);
-
-    cat = ogd_event_get_category (event);
-    tmp = (gchar*) alloca (100);
-    snprintf (tmp, 100, "%d", category_to_identifier (cat));
-    g_hash_table_insert (data, "category", tmp);
+    if (id == NULL) {
+        response = ogd_provider_put_raw (ogd_object_get_provider (OGD_OBJECT (event)), "event/add", data);
+        if (response != NULL) {
+            event->priv->id = id_from_add_response (response, "event");
+            if (event->priv->id != NULL)
+                event->priv->dirty = 0;
+            else
+                g_warning ("An error occurred while retriving ID for newly created event.");
 
-    date = ogd_event_get_start_date (event);
-    if (date != NULL) {
-        g_date_to_struct_tm (date, &tm);
-        tmp = (gchar*) alloca (100);
-        strftime (tmp, 100, "%Y-%m-%dT%H:%M:%S", &tm);
-        g_hash_table_insert (data, "startdate", tmp);
+            xmlFreeDoc (response->doc);
+        }
     }
-
-    date = ogd_event_get_end_date (event);
-    if (date != NULL) {
-        g_date_to_struct_tm (date, &tm);
-        tmp = (gchar*) alloca (100);
-        strftime (tmp, 100, "%Y-%m-%dT%H:%M:%S", &tm);
-        g_hash_table_insert (data, "enddate", tmp);
+    else {
+        query = g_strdup_printf ("event/edit/%s", id);
+        if (ogd_provider_put (ogd_object_get_provider (OGD_OBJECT (event)), query, data) == TRUE)
+            event->priv->dirty &= ~fields;
+        g_free (query);
     }
 
-    str = ogd_event_get_organizer (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "organizer", (gchar*) str);
-
-    str = ogd_event_get_location (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "location", (gchar*) str);
-
-    str = ogd_event_get_city (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "city", (gchar*) str);
+    g_hash_table_unref (data);
+}
 
-    str = ogd_event_get_country (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "country", (gchar*) str);
+static void event_edited (OGDObject *obj, guint fields, gchar *id)
+{
+    OGDEvent *event;
 
-    coord = ogd_event_get_longitude (event);
-    tmp = (gchar*) alloca (100);
-    snprintf (tmp, 100, "%.03f", coord);
-    g_hash_table_insert (data, "longitude", tmp);
+    event = OGD_EVENT (obj);
 
-    coord = ogd_event_get_latitude (event);
-    tmp = (gchar*) alloca (100);
-    snprintf (tmp, 100, "%.03f", coord);
-    g_hash_table_insert (data, "latitude", tmp);
+    if (id != NULL) {
+        ARENA_CHECK_FREE_NULLIFY (event->priv->id);
+        event->priv->id = id;
+    }
 
-    str = ogd_event_get_homepage (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "homepage", (gchar*) str);
+    /*
+        Fields changed again while the request was running are still to be sent
+    */
+    event->priv->dirty &= ~fields;
+}
 
-    str = ogd_event_get_telephone (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "tel", (gchar*) str);
+/**
+ * ogd_event_save_async:
+ * @event:          a new #OGDEvent to be saved on the provider, or an existing event to edit
+ * @callback:       async callback to which result of the operation is passed
+ * @userdata:       the user data for the callback
+ *
+ * Async version of ogd_event_save(). When editing an existing event the ownership is checked
+ * without blocking, and when saving a new one the ID assigned by the server is available through
+ * ogd_event_get_id() at the time @callback is invoked. If the event cannot be saved the reason is
+ * passed to @callback, which may be invoked before this function returns when mandatory fields
+ * are missing or nothing has been changed
+ */
+void ogd_event_save_async (OGDEvent *event, OGDSaveAsyncCallback callback, gpointer userdata)
+{
+    guint fields;
+    const gchar *id;
+    gchar *query;
+    GHashTable *data;
+    GError *error;
 
-    str = ogd_event_get_fax (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "fax", (gchar*) str);
+    id = ogd_event_get_id (event);
+    if (id != NULL && event->priv->dirty == 0) {
+        callback (OGD_OBJECT (event), NULL, userdata);
+        return;
+    }
 
-    str = ogd_event_get_email (event);
-    if (str != NULL)
-        g_hash_table_insert (data, "email", (gchar*) str);
+    fields = (id == NULL) ? EVENT_DIRTY_ALL : event->priv->dirty;
 
-    id = ogd_event_get_id (event);
+    error = NULL;
+    data = save_params (event, fields, &error);
+    if (data == NULL) {
+        callback (OGD_OBJECT (event), error, userdata);
+        g_error_free (error);
+        return;
+    }
 
     if (id == NULL) {
-        response = ogd_provider_put_raw (ogd_object_get_provider (OGD_OBJECT (event)), "event/add", data);
-        if (response != NULL) {
-            if (MYSTRCMP (response->name, "data") == 0 && response->children != NULL &&
-                    MYSTRCMP (response->children->name, "event") == 0 && response->children->children != NULL &&
-                    MYSTRCMP (response->children->children->name, "id") == 0) {
-
-                inner_response = response->children->children;
-                tmp = (gchar*) MYGETCONTENT (inner_response);
-                event->priv->id = g_strdup (tmp);
-                xmlFree (tmp);
-            }
-            else {
-                g_warning ("An error occurred while retriving ID for newly created event.");
-            }
-
-            xmlFreeDoc (response->doc);
-        }
+        edit_object_async (OGD_OBJECT (event), NULL, "event/add", data, "event", fields, event_edited,
+                           callback, userdata);
     }
     else {
         query = g_strdup_printf ("event/edit/%s", id);
-        ogd_provider_put (ogd_object_get_provider (OGD_OBJECT (event)), query, data);
+        edit_object_async (OGD_OBJECT (event), ogd_event_get_authorid (event), query, data, NULL, fields,
+                           event_edited, callback, userdata);
         g_free (query);
     }
 
@@ -955,6 +1080,36 @@ void ogd_event_remove (OGDEvent *event)
     }
 }
 
+/**
+ * ogd_event_remove_async:
+ * @event:          the #OGDEvent to remove
+ * @callback:       async callback to which result of the operation is passed
+ * @userdata:       the user data for the callback
+ *
+ * Async version of ogd_event_remove(). Ownership of the event is checked without blocking, and if
+ * the event cannot be removed the reason is passed to @callback
+ */
+void ogd_event_remove_async (OGDEvent *event, OGDSaveAsyncCallback callback, gpointer userdata)
+{
+    const gchar *id;
+    gchar *query;
+    GError *error;
+
+    id = ogd_event_get_id (event);
+
+    if (id == NULL) {
+        error = g_error_new (OGD_EDIT_ERROR_DOMAIN, OGD_EDIT_ERROR, "The event has never been saved.");
+        callback (OGD_OBJECT (event), error, userdata);
+        g_error_free (error);
+        return;
+    }
+
+    query = g_strdup_printf ("event/delete/%s", id);
+    edit_object_async (OGD_OBJECT (event), ogd_event_get_authorid (event), query, NULL, NULL, 0, NULL,
+                       callback, userdata);
+    g_free (query);
+}
+
 static GHashTable* add_comment_params (OGDEvent *event, gchar *subject, gchar *message)
 {
     GHashTable *params;
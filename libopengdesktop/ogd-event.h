@@ -20,6 +20,8 @@
 
 G_BEGIN_DECLS
 
+#include "ogd-comment-tree.h"
+
 #define OGD_EVENT_TYPE             (ogd_event_get_type ())
 #define OGD_EVENT(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
                                          OGD_EVENT_TYPE, OGDEvent))
@@ -107,7 +109,9 @@ void                    ogd_event_set_fax               (OGDEvent *event, gchar
 const gchar*            ogd_event_get_email             (OGDEvent *event);
 void                    ogd_event_set_email             (OGDEvent *event, gchar *mail);
 const GDate*            ogd_event_get_changed           (OGDEvent *event);
+gint64                  ogd_event_get_change_time       (OGDEvent *event);
 GList*                  ogd_event_get_comments          (OGDEvent *event);
+OGDCommentTree*         ogd_event_get_comment_tree      (OGDEvent *event);
 gulong                  ogd_event_get_num_partecipants  (OGDEvent *event);
 const gchar*            ogd_event_get_image             (OGDEvent *event);
 
@@ -116,7 +120,9 @@ gulong                  ogd_event_get_num_comments      (OGDEvent *event);
 #endif
 
 void                    ogd_event_save                  (OGDEvent *event);
+void                    ogd_event_save_async            (OGDEvent *event, OGDSaveAsyncCallback callback, gpointer userdata);
 void                    ogd_event_remove                (OGDEvent *event);
+void                    ogd_event_remove_async          (OGDEvent *event, OGDSaveAsyncCallback callback, gpointer userdata);
 void                    ogd_event_add_comment           (OGDEvent *event, gchar *subject, gchar *message);
 void                    ogd_event_add_comment_async     (OGDEvent *event, gchar *subject, gchar *message, OGDPutAsyncCallback callback, gpointer userdata);
 
@@ -17,6 +17,7 @@
 
 #include "ogd.h"
 #include "ogd-category.h"
+#include "ogd-provider-private.h"
 #include "ogd-private-utils.h"
 
 #define OGD_FOLDER_GET_PRIVATE(obj)         (G_TYPE_INSTANCE_GET_PRIVATE ((obj),    \
@@ -45,8 +46,10 @@ static void ogd_folder_finalize (GObject *obj)
 
     folder = OGD_FOLDER (obj);
 
-    PTR_CHECK_FREE_NULLIFY (folder->priv->id);
-    PTR_CHECK_FREE_NULLIFY (folder->priv->name);
+    ARENA_CHECK_FREE_NULLIFY (folder->priv->id);
+    ARENA_CHECK_FREE_NULLIFY (folder->priv->name);
+
+    ogd_object_release_arena (OGD_OBJECT (obj));
 }
 
 static gboolean ogd_folder_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
@@ -88,6 +91,11 @@ static gboolean ogd_folder_fill_by_xml (OGDObject *obj, const xmlNode *xml, GErr
     return TRUE;
 }
 
+static const gchar* ogd_folder_get_object_id (OGDObject *obj)
+{
+    return ogd_folder_get_id (OGD_FOLDER (obj));
+}
+
 static void ogd_folder_class_init (OGDFolderClass *klass)
 {
     GObjectClass *gobject_class;
@@ -100,6 +108,7 @@ static void ogd_folder_class_init (OGDFolderClass *klass)
 
     ogd_object_class = OGD_OBJECT_CLASS (klass);
     ogd_object_class->fill_by_xml = ogd_folder_fill_by_xml;
+    ogd_object_class_set_id_func (ogd_object_class, ogd_folder_get_object_id);
 }
 
 static void ogd_folder_init (OGDFolder *item)
@@ -204,3 +213,192 @@ OGDIterator* ogd_folder_get_contents (OGDFolder *folder)
     g_free (query);
     return iterator;
 }
+
+/*
+    The IDs of the folders of the current user rarely change, so they are kept along with the
+    provider once fetched, to not ask them again each time a message is sent
+*/
+struct _OGDFolderDirectory {
+    gchar                   *ids [OGD_FOLDER_TRASH + 1];
+    gboolean                fetched;
+    gboolean                fetching;
+    guint                   account;
+    GList                   *waiters;
+};
+
+typedef struct {
+    OGD_FOLDER_CATEGORY     category;
+    OGDFolderIdCallback     callback;
+    gpointer                userdata;
+} FolderDirectoryWaiter;
+
+static void free_directory_ids (OGDFolderDirectory *directory)
+{
+    int i;
+
+    for (i = 0; i <= OGD_FOLDER_TRASH; i++)
+        PTR_CHECK_FREE_NULLIFY (directory->ids [i]);
+
+    directory->fetched = FALSE;
+}
+
+OGDFolderDirectory* ogd_folder_directory_new ()
+{
+    return g_new0 (OGDFolderDirectory, 1);
+}
+
+/*
+    To be called when the user of the provider changes. A fetch already running is not stopped,
+    but its response is discarded and the folders are asked again for the new user
+*/
+void ogd_folder_directory_reset (OGDFolderDirectory *directory)
+{
+    free_directory_ids (directory);
+}
+
+void ogd_folder_directory_free (OGDFolderDirectory *directory)
+{
+    free_directory_ids (directory);
+    g_list_foreach (directory->waiters, (GFunc) g_free, NULL);
+    g_list_free (directory->waiters);
+    g_free (directory);
+}
+
+/*
+    Consumes the list of folders
+*/
+static void fill_directory (OGDFolderDirectory *directory, GList *folders)
+{
+    GList *iter;
+    OGDFolder *folder;
+
+    free_directory_ids (directory);
+
+    for (iter = folders; iter; iter = g_list_next (iter)) {
+        folder = (OGDFolder*) iter->data;
+
+        if (folder->priv->category <= OGD_FOLDER_TRASH && directory->ids [folder->priv->category] == NULL)
+            directory->ids [folder->priv->category] = g_strdup (folder->priv->id);
+
+        g_object_unref (folder);
+    }
+
+    g_list_free (folders);
+    directory->fetched = TRUE;
+}
+
+/**
+ * ogd_folder_refresh_directory:
+ * @provider:       a #OGDProvider
+ *
+ * The IDs of the folders of the current user, used to send messages with ogd_message_send(), are
+ * retrieved from the server only the first time and then kept along with @provider. This
+ * function fetches them again, e.g. after the folders have been changed on the server
+ *
+ * Return value:    %TRUE if the folders have been retrieved, %FALSE otherwise
+ */
+gboolean ogd_folder_refresh_directory (OGDProvider *provider)
+{
+    GList *folders;
+    OGDFolderDirectory *directory;
+
+    directory = ogd_provider_get_folder_directory (provider);
+    folders = ogd_folder_fetch_all (provider);
+
+    if (folders == NULL) {
+        free_directory_ids (directory);
+        return FALSE;
+    }
+
+    fill_directory (directory, folders);
+    return TRUE;
+}
+
+/*
+    ID of the folder of the given @category, asked to the server only the first time. NULL if not
+    found
+*/
+const gchar* ogd_folder_get_id_by_category (OGDProvider *provider, OGD_FOLDER_CATEGORY category)
+{
+    OGDFolderDirectory *directory;
+
+    directory = ogd_provider_get_folder_directory (provider);
+
+    if (directory->fetched == FALSE && ogd_folder_refresh_directory (provider) == FALSE)
+        return NULL;
+
+    return directory->ids [category];
+}
+
+static void directory_received (GList *list, const GError *error, gpointer userdata)
+{
+    GList *waiters;
+    GList *iter;
+    OGDProvider *provider;
+    OGDFolderDirectory *directory;
+    FolderDirectoryWaiter *waiter;
+
+    provider = (OGDProvider*) userdata;
+    directory = ogd_provider_get_folder_directory (provider);
+
+    /*
+        The user changed while the folders were being fetched
+    */
+    if (directory->account != ogd_provider_get_account (provider)) {
+        FREE_LIST_OF_OBJECTS (list);
+        directory->account = ogd_provider_get_account (provider);
+        ogd_provider_get_list_async_full (provider, "message", OGD_PROVIDER_PRIORITY_INTERACTIVE, directory,
+                                          directory_received, provider);
+        return;
+    }
+
+    if (list != NULL)
+        fill_directory (directory, list);
+
+    /*
+        Callbacks may request other folders, they are so detached before being invoked
+    */
+    waiters = directory->waiters;
+    directory->waiters = NULL;
+    directory->fetching = FALSE;
+
+    for (iter = waiters; iter; iter = g_list_next (iter)) {
+        waiter = (FolderDirectoryWaiter*) iter->data;
+        waiter->callback (directory->ids [waiter->category], waiter->userdata);
+        g_free (waiter);
+    }
+
+    g_list_free (waiters);
+}
+
+/*
+    Async version of ogd_folder_get_id_by_category(). When the folders are already known
+    @callback is invoked before this function returns, otherwise requests issued while the folders
+    are being fetched wait for the same response
+*/
+void ogd_folder_get_id_by_category_async (OGDProvider *provider, OGD_FOLDER_CATEGORY category,
+                                          OGDFolderIdCallback callback, gpointer userdata)
+{
+    OGDFolderDirectory *directory;
+    FolderDirectoryWaiter *waiter;
+
+    directory = ogd_provider_get_folder_directory (provider);
+
+    if (directory->fetched == TRUE) {
+        callback (directory->ids [category], userdata);
+        return;
+    }
+
+    waiter = g_new0 (FolderDirectoryWaiter, 1);
+    waiter->category = category;
+    waiter->callback = callback;
+    waiter->userdata = userdata;
+    directory->waiters = g_list_append (directory->waiters, waiter);
+
+    if (directory->fetching == FALSE) {
+        directory->fetching = TRUE;
+        directory->account = ogd_provider_get_account (provider);
+        ogd_provider_get_list_async_full (provider, "message", OGD_PROVIDER_PRIORITY_INTERACTIVE, directory,
+                                          directory_received, provider);
+    }
+}
@@ -69,6 +69,7 @@ GType                   ogd_folder_get_type             ();
 
 GList*                  ogd_folder_fetch_all            (OGDProvider *provider);
 void                    ogd_folder_fetch_all_async      (OGDProvider *provider, OGDAsyncCallback callback, gpointer userdata);
+gboolean                ogd_folder_refresh_directory    (OGDProvider *provider);
 
 const gchar*            ogd_folder_get_id               (OGDFolder *folder);
 const gchar*            ogd_folder_get_name             (OGDFolder *folder);
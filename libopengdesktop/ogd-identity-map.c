@@ -0,0 +1,176 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-identity-map.h"
+#include "ogd-private-utils.h"
+
+/*
+    Keeps track of the OGDObjects alive for a provider, so that the same remote item is never
+    materialized twice: objects are indexed by type and ID, and held with weak references, so the
+    map never prolongs their life. When a response contains an item already alive the existing
+    instance is updated with the new data and used in place of the new one
+*/
+
+struct _OGDIdentityMap {
+    GHashTable      *types;
+};
+
+typedef struct {
+    GHashTable      *table;
+    gchar           *id;
+    OGDObject       *obj;
+} MappedObject;
+
+static void free_mapped_object (MappedObject *entry)
+{
+    g_free (entry->id);
+    g_free (entry);
+}
+
+OGDIdentityMap* ogd_identity_map_new ()
+{
+    OGDIdentityMap *map;
+
+    map = g_new0 (OGDIdentityMap, 1);
+    map->types = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_hash_table_destroy);
+    return map;
+}
+
+static void object_finalized (gpointer userdata, GObject *obj)
+{
+    MappedObject *entry;
+
+    entry = (MappedObject*) userdata;
+    g_hash_table_remove (entry->table, entry->id);
+}
+
+static void forget_object (MappedObject *entry)
+{
+    g_object_weak_unref (G_OBJECT (entry->obj), object_finalized, entry);
+    g_hash_table_remove (entry->table, entry->id);
+}
+
+/*
+    Objects still alive lose their weak reference, but are not touched otherwise
+*/
+void ogd_identity_map_free (OGDIdentityMap *map)
+{
+    GList *tables;
+    GList *entries;
+    GList *iter;
+    GList *sub_iter;
+    MappedObject *entry;
+
+    tables = g_hash_table_get_values (map->types);
+
+    for (iter = tables; iter; iter = g_list_next (iter)) {
+        entries = g_hash_table_get_values ((GHashTable*) iter->data);
+
+        for (sub_iter = entries; sub_iter; sub_iter = g_list_next (sub_iter)) {
+            entry = (MappedObject*) sub_iter->data;
+            g_object_weak_unref (G_OBJECT (entry->obj), object_finalized, entry);
+        }
+
+        g_list_free (entries);
+    }
+
+    g_list_free (tables);
+    g_hash_table_destroy (map->types);
+    g_free (map);
+}
+
+/*
+    Returns the live instance of the given type with the given ID, or NULL. The map holds no
+    reference: the caller has to add its own to keep the object
+*/
+OGDObject* ogd_identity_map_lookup (OGDIdentityMap *map, GType type, const gchar *id)
+{
+    const gchar *current;
+    GHashTable *table;
+    MappedObject *entry;
+
+    table = g_hash_table_lookup (map->types, GSIZE_TO_POINTER (type));
+    if (table == NULL)
+        return NULL;
+
+    entry = g_hash_table_lookup (table, id);
+    if (entry == NULL)
+        return NULL;
+
+    /*
+        The object may have been filled again with another item since it has been indexed
+    */
+    current = ogd_object_get_id (entry->obj);
+
+    if (current == NULL || strcmp (current, id) != 0) {
+        forget_object (entry);
+        return NULL;
+    }
+
+    return entry->obj;
+}
+
+/*
+    Params:
+        obj:        an object just filled with @xml
+        xml:        the data used to fill @obj, used to update the existing instance (if any)
+
+    Returns the instance to be used in place of @obj: @obj itself if it has no ID or if it is
+    the first instance of that item, otherwise the one already alive, updated with @xml. Fields of
+    the live instance changed locally and not saved yet are kept by the refill, with their dirty
+    flags (see ogd_content_fill_by_xml()). No reference is added to the returned object
+*/
+OGDObject* ogd_identity_map_intern (OGDIdentityMap *map, OGDObject *obj, const xmlNode *xml)
+{
+    const gchar *id;
+    GType type;
+    GHashTable *table;
+    MappedObject *entry;
+    OGDObject *existing;
+
+    id = ogd_object_get_id (obj);
+    if (id == NULL)
+        return obj;
+
+    type = G_OBJECT_TYPE (obj);
+    existing = ogd_identity_map_lookup (map, type, id);
+
+    if (existing == obj) {
+        return obj;
+    }
+    else if (existing != NULL) {
+        ogd_object_fill_by_xml (existing, xml, NULL);
+        return existing;
+    }
+
+    table = g_hash_table_lookup (map->types, GSIZE_TO_POINTER (type));
+
+    if (table == NULL) {
+        table = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) free_mapped_object);
+        g_hash_table_insert (map->types, GSIZE_TO_POINTER (type), table);
+    }
+
+    entry = g_new0 (MappedObject, 1);
+    entry->table = table;
+    entry->id = g_strdup (id);
+    entry->obj = obj;
+    g_hash_table_insert (table, entry->id, entry);
+    g_object_weak_ref (G_OBJECT (obj), object_finalized, entry);
+
+    return obj;
+}
@@ -0,0 +1,31 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_IDENTITY_MAP_H
+#define OGD_IDENTITY_MAP_H
+
+#include "ogd-provider-private.h"
+
+typedef struct _OGDIdentityMap OGDIdentityMap;
+
+OGDIdentityMap* ogd_identity_map_new                ();
+void            ogd_identity_map_free               (OGDIdentityMap *map);
+
+OGDObject*      ogd_identity_map_lookup             (OGDIdentityMap *map, GType type, const gchar *id);
+OGDObject*      ogd_identity_map_intern             (OGDIdentityMap *map, OGDObject *obj, const xmlNode *xml);
+
+#endif /* OGD_IDENTITY_MAP_H */
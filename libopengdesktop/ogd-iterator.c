@@ -20,6 +20,7 @@
 #include "ogd-provider.h"
 #include "ogd-provider-private.h"
 #include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
 
 #define OGD_ITERATOR_DEFAULT_STEP       10
 
@@ -41,6 +42,8 @@ struct _OGDIteratorPrivate {
     gulong              total;
     gulong              step;
     gulong              position;
+
+    OGD_PROVIDER_PRIORITY   priority;
 };
 
 G_DEFINE_TYPE (OGDIterator, ogd_iterator, G_TYPE_OBJECT);
@@ -68,12 +71,12 @@ static void ogd_iterator_init (OGDIterator *iter)
     iter->priv = OGD_ITERATOR_GET_PRIVATE (iter);
     memset (iter->priv, 0, sizeof (OGDIteratorPrivate));
     iter->priv->step = OGD_ITERATOR_DEFAULT_STEP;
+    iter->priv->priority = OGD_PROVIDER_PRIORITY_BULK;
 }
 
 static void prefetch_total_count (OGDIterator *iterator)
 {
     gchar *query;
-    xmlNode *node;
 
     /*
         Here we provide a simple dry-run of the query, just to obtain information about total
@@ -82,11 +85,8 @@ static void prefetch_total_count (OGDIterator *iterator)
     */
 
     query = g_strdup_printf ("%s&page=0&pagesize=1", iterator->priv->query);
-    node = ogd_provider_get_raw (iterator->priv->provider, query, NULL);
+    iterator->priv->total = ogd_provider_get_total (iterator->priv->provider, query);
     g_free (query);
-
-    iterator->priv->total = total_items_for_query (node);
-    xmlFreeDoc (node->doc);
 }
 
 /**
@@ -166,6 +166,80 @@ GList* ogd_iterator_fetch_next_slice (OGDIterator *iter)
     return ogd_iterator_fetch_slice (iter, iter->priv->position, iter->priv->step);
 }
 
+/**
+ * ogd_iterator_fetch_next_columns:
+ * @iter:           #OGDIterator to advance, over a query returning contents
+ * @columns:        #OGDContentColumns to which append the contents fetched
+ * @error:          a #GError filled if the request fails
+ *
+ * As ogd_iterator_fetch_next_slice(), but instead of building an #OGDContent for each element
+ * only the scalar values are appended to @columns, reading the response of the server as a
+ * stream. The internal index is moved to the beginning of the next page, but not when the
+ * request fails
+ *
+ * Return value:    the number of rows appended to @columns, 0 when the iterator is already at
+ *                  the end or the request fails
+ */
+gulong ogd_iterator_fetch_next_columns (OGDIterator *iter, OGDContentColumns *columns, GError **error)
+{
+    gulong page;
+    gulong ret;
+    gchar *query;
+
+    if (iter->priv->position >= iter->priv->total)
+        return 0;
+
+    page = iter->priv->position / iter->priv->step;
+    query = g_strdup_printf ("%s&page=%lu&pagesize=%lu", iter->priv->query, page, iter->priv->step);
+    ret = ogd_provider_get_columns (iter->priv->provider, query, columns, error);
+    g_free (query);
+
+    /*
+        The index is moved to the next page even if this one is shorter than expected, so that
+        the same page is never requested again appending the same rows twice
+    */
+    if (ret != 0)
+        iter->priv->position = (page + 1) * iter->priv->step;
+
+    return ret;
+}
+
+/**
+ * ogd_iterator_fetch_all_columns:
+ * @iter:           #OGDIterator to advance, over a query returning contents
+ * @columns:        #OGDContentColumns to which append the contents fetched
+ * @error:          a #GError filled if one of the requests fails
+ *
+ * Calls ogd_iterator_fetch_next_columns() until all contents from the current index are
+ * appended to @columns. Each request fetches as many elements as specified with
+ * ogd_iterator_set_step(), so a large step is suggested
+ *
+ * Return value:    the number of rows appended to @columns. If a request fails the rows already
+ *                  appended are kept, @error is filled, and the iterator is left at the position
+ *                  of the failed page
+ */
+gulong ogd_iterator_fetch_all_columns (OGDIterator *iter, OGDContentColumns *columns, GError **error)
+{
+    gulong rows;
+    gulong ret;
+    GError *page_error;
+
+    ret = 0;
+
+    do {
+        page_error = NULL;
+        rows = ogd_iterator_fetch_next_columns (iter, columns, &page_error);
+        ret += rows;
+
+        if (page_error != NULL) {
+            g_propagate_error (error, page_error);
+            break;
+        }
+    } while (rows != 0);
+
+    return ret;
+}
+
 static void retrieve_async_contents (OGDObject *obj, gpointer request)
 {
     AsyncRequestDesc *req;
@@ -173,16 +247,15 @@ static void retrieve_async_contents (OGDObject *obj, gpointer request)
     req = (AsyncRequestDesc*) request;
 
     if (obj == NULL) {
+        req->counter += 1;
+
         if (req->total <= req->counter) {
-            req->callback (NULL, req->userdata);
+            TRACED_CALLBACK ("callback", req->callback (NULL, req->userdata));
             g_free (req);
         }
-        else
-            return;
     }
     else {
-        req->callback (obj, req->userdata);
-        req->counter += 1;
+        TRACED_CALLBACK ("callback", req->callback (obj, req->userdata));
     }
 }
 
@@ -193,7 +266,10 @@ static void retrieve_async_contents (OGDObject *obj, gpointer request)
  * @userdata:       the user data for the callback
  *
  * Retrieve all contents involved by the iterator and return them one by one through an async
- * callback
+ * callback. Requests are scheduled with the priority specified with ogd_iterator_set_priority().
+ * The callback is invoked with %NULL when all pages have been fetched, including when some of them
+ * failed even after the retries permitted by ogd_provider_set_retry_policy(): in that case the
+ * reason is available from ogd_provider_get_last_error()
  */
 void ogd_iterator_fetch_async (OGDIterator *iter, OGDAsyncCallback callback, gpointer userdata)
 {
@@ -206,20 +282,28 @@ void ogd_iterator_fetch_async (OGDIterator *iter, OGDAsyncCallback callback, gpo
     req->callback = callback;
     req->userdata = userdata;
     req->counter = 0;
-    req->total = iter->priv->total;
+    req->total = (iter->priv->total + 99) / 100;
+
+    if (req->total == 0) {
+        callback (NULL, userdata);
+        g_free (req);
+        return;
+    }
 
     /*
         Problem: the OCS provider often forces a limit for the number of items fetchable on a
         single request, it is not possible to retrieve all on a single step. So many
-        ogd_provider_get_async() invocations are required, but each at the end will call the
-        callback with a NULL obj. So an internal counter is maintained (in
-        iter->priv->async_counter): if the incoming obj is NULL but this counter is not
-        iter->priv->total it means it ends a single cycle of interrogation, otherwise the whole
-        operation is ended and NULL is also passed to the toplevel application to notify it
+        ogd_provider_get_async() invocations are required, but each at the end (or on failure)
+        will call the callback with a NULL obj. So the completed pages are counted in
+        req->counter: if the incoming obj is NULL but not all pages are completed it means it ends
+        a single cycle of interrogation, otherwise the whole operation is ended and NULL is also
+        passed to the toplevel application to notify it. Counting pages instead of objects also
+        avoids waiting forever when the server returns less items than announced
     */
     for (page = 0, tot = 0; tot < iter->priv->total; page++, tot += 100) {
         query = g_strdup_printf ("%s&page=%lu&pagesize=%d", iter->priv->query, page, 100);
-        ogd_provider_get_async (iter->priv->provider, query, retrieve_async_contents, req);
+        ogd_provider_get_async_full (iter->priv->provider, query, iter->priv->priority, req,
+                                     retrieve_async_contents, req);
         g_free (query);
     }
 }
@@ -236,3 +320,17 @@ void ogd_iterator_set_step (OGDIterator *iter, gulong step)
 {
     iter->priv->step = step;
 }
+
+/**
+ * ogd_iterator_set_priority:
+ * @iter:           #OGDIterator for which change priority
+ * @priority:       class in which requests issued by ogd_iterator_fetch_async() are scheduled
+ *
+ * Since an iterator may involve many requests to the server, by default those are scheduled
+ * with %OGD_PROVIDER_PRIORITY_BULK priority and do not delay other operations. Use this to
+ * change the priority, e.g. when the contents are immediately displayed to the user
+ */
+void ogd_iterator_set_priority (OGDIterator *iter, OGD_PROVIDER_PRIORITY priority)
+{
+    iter->priv->priority = priority;
+}
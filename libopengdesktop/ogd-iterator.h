@@ -21,6 +21,7 @@
 G_BEGIN_DECLS
 
 #include "ogd-provider.h"
+#include "ogd-columns.h"
 
 #define OGD_ITERATOR_TYPE             (ogd_iterator_get_type ())
 #define OGD_ITERATOR(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
@@ -56,7 +57,10 @@ OGDIterator*    ogd_iterator_new                    (const OGDProvider *provider
 GList*          ogd_iterator_fetch_slice            (OGDIterator *iter, gulong start, gulong quantity);
 GList*          ogd_iterator_fetch_next_slice       (OGDIterator *iter);
 void            ogd_iterator_fetch_async            (OGDIterator *iter, OGDAsyncCallback callback, gpointer userdata);
+gulong          ogd_iterator_fetch_next_columns     (OGDIterator *iter, OGDContentColumns *columns, GError **error);
+gulong          ogd_iterator_fetch_all_columns      (OGDIterator *iter, OGDContentColumns *columns, GError **error);
 void            ogd_iterator_set_step               (OGDIterator *iter, gulong step);
+void            ogd_iterator_set_priority           (OGDIterator *iter, OGD_PROVIDER_PRIORITY priority);
 
 G_END_DECLS
 
@@ -0,0 +1,359 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "ogd.h"
+#include "ogd-journal.h"
+#include "ogd-private-utils.h"
+
+/*
+    A journal keeps on disk the write requests which have not been accepted by the server because
+    it was not reachable, so they may be sent again in the same order later, also in a later run
+    of the application. Each request is identified by an idempotency key, generated when it was
+    sent the first time and sent again along with it, so the server may recognize a request
+    which was already applied before the connection was lost.
+    The file is an append-only log, flushed to disk after each record: a request is added with a
+    P record, and marked as completed with a D record. When no request is pending the file is
+    truncated.
+
+    The file starts with a line identifying the format, followed by records:
+
+        P <key> <queued> <query> <body length>
+        <form encoded body>
+
+        D <key>
+
+    where the query is escaped as in URIs (so it never contains spaces) and times are in seconds
+    since the Epoch
+*/
+
+#define JOURNAL_SIGNATURE       "OGD-JOURNAL 1\n"
+
+struct _OGDJournal {
+    gchar           *path;
+    FILE            *file;
+    GQueue          *entries;
+};
+
+static void free_entry (OGDJournalEntry *entry)
+{
+    g_free (entry->key);
+    g_free (entry->query);
+    g_free (entry->body);
+    g_free (entry);
+}
+
+static gchar* next_line (gchar **cursor, gchar *end)
+{
+    gchar *ret;
+    gchar *newline;
+
+    if (*cursor >= end)
+        return NULL;
+
+    newline = memchr (*cursor, '\n', end - *cursor);
+    if (newline == NULL)
+        return NULL;
+
+    *newline = '\0';
+    ret = *cursor;
+    *cursor = newline + 1;
+    return ret;
+}
+
+static gboolean load_entry (OGDJournal *journal, gchar **tokens, gchar **cursor, gchar *end)
+{
+    OGDJournalEntry *entry;
+
+    if (g_strv_length (tokens) != 5)
+        return FALSE;
+
+    entry = g_new0 (OGDJournalEntry, 1);
+    entry->key = g_strdup (tokens [1]);
+    entry->queued = g_ascii_strtoll (tokens [2], NULL, 10);
+    entry->query = g_uri_unescape_string (tokens [3], NULL);
+    entry->length = (gsize) g_ascii_strtoull (tokens [4], NULL, 10);
+
+    if (entry->query == NULL || *cursor + entry->length + 1 > end) {
+        free_entry (entry);
+        return FALSE;
+    }
+
+    entry->body = g_strndup (*cursor, entry->length);
+    *cursor += entry->length + 1;
+    g_queue_push_tail (journal->entries, entry);
+    return TRUE;
+}
+
+static gboolean unload_entry (OGDJournal *journal, gchar **tokens)
+{
+    GList *iter;
+    OGDJournalEntry *entry;
+
+    if (g_strv_length (tokens) != 2)
+        return FALSE;
+
+    for (iter = journal->entries->head; iter; iter = g_list_next (iter)) {
+        entry = (OGDJournalEntry*) iter->data;
+
+        if (strcmp (entry->key, tokens [1]) == 0) {
+            g_queue_delete_link (journal->entries, iter);
+            free_entry (entry);
+            break;
+        }
+    }
+
+    return TRUE;
+}
+
+/*
+    As in the store, a truncated record at the end of the file is ignored
+*/
+static gboolean load_journal (OGDJournal *journal, GError **error)
+{
+    gsize length;
+    gboolean valid;
+    gchar *contents;
+    gchar *cursor;
+    gchar *end;
+    gchar *line;
+    gchar **tokens;
+
+    if (g_file_get_contents (journal->path, &contents, &length, error) == FALSE)
+        return FALSE;
+
+    if (length < strlen (JOURNAL_SIGNATURE) || strncmp (contents, JOURNAL_SIGNATURE, strlen (JOURNAL_SIGNATURE)) != 0) {
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s is not a valid journal", journal->path);
+        g_free (contents);
+        return FALSE;
+    }
+
+    cursor = contents + strlen (JOURNAL_SIGNATURE);
+    end = contents + length;
+
+    while ((line = next_line (&cursor, end)) != NULL) {
+        tokens = g_strsplit (line, " ", 0);
+
+        if (tokens [0] != NULL && strcmp (tokens [0], "P") == 0)
+            valid = load_entry (journal, tokens, &cursor, end);
+        else if (tokens [0] != NULL && strcmp (tokens [0], "D") == 0)
+            valid = unload_entry (journal, tokens);
+        else
+            valid = FALSE;
+
+        g_strfreev (tokens);
+
+        if (valid == FALSE) {
+            g_warning ("Invalid record in journal %s, ignoring the rest of the file", journal->path);
+            break;
+        }
+    }
+
+    g_free (contents);
+    return TRUE;
+}
+
+static gboolean sync_journal (OGDJournal *journal)
+{
+    if (fflush (journal->file) != 0 || fsync (fileno (journal->file)) != 0) {
+        g_warning ("Unable to write journal %s: %s", journal->path, g_strerror (errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean write_entry (FILE *file, OGDJournalEntry *entry)
+{
+    gchar *query;
+
+    query = g_uri_escape_string (entry->query, NULL, FALSE);
+    fprintf (file, "P %s %" G_GINT64_FORMAT " %s %" G_GSIZE_FORMAT "\n", entry->key, entry->queued, query, entry->length);
+    g_free (query);
+
+    fwrite (entry->body, 1, entry->length, file);
+    return (fputc ('\n', file) != EOF);
+}
+
+/*
+    Rewrites the file with only the pending entries, if any: applied once loaded, and when the
+    last pending entry is removed
+*/
+static gboolean rewrite_journal (OGDJournal *journal, GError **error)
+{
+    gchar *temp_path;
+    GList *iter;
+    FILE *output;
+
+    temp_path = g_strdup_printf ("%s.rewrite", journal->path);
+    output = fopen (temp_path, "wb");
+
+    if (output == NULL) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to rewrite journal %s: %s", journal->path, g_strerror (errno));
+        g_free (temp_path);
+        return FALSE;
+    }
+
+    fputs (JOURNAL_SIGNATURE, output);
+
+    for (iter = journal->entries->head; iter; iter = g_list_next (iter))
+        write_entry (output, iter->data);
+
+    if (fflush (output) != 0 || fsync (fileno (output)) != 0 || fclose (output) != 0 ||
+            g_rename (temp_path, journal->path) != 0) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to rewrite journal %s: %s", journal->path, g_strerror (errno));
+        g_unlink (temp_path);
+        g_free (temp_path);
+        return FALSE;
+    }
+
+    g_free (temp_path);
+
+    if (journal->file != NULL)
+        fclose (journal->file);
+
+    journal->file = fopen (journal->path, "ab");
+    if (journal->file == NULL) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to open journal %s: %s", journal->path, g_strerror (errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+    Opens the journal saved in @path, or creates it if the file does not exist. Requests still
+    pending from a previous run are available with ogd_journal_peek()
+*/
+OGDJournal* ogd_journal_open (const gchar *path, GError **error)
+{
+    OGDJournal *journal;
+
+    journal = g_new0 (OGDJournal, 1);
+    journal->path = g_strdup (path);
+    journal->entries = g_queue_new ();
+
+    if (g_file_test (path, G_FILE_TEST_EXISTS) == TRUE && load_journal (journal, error) == FALSE) {
+        ogd_journal_free (journal);
+        return NULL;
+    }
+
+    if (rewrite_journal (journal, error) == FALSE) {
+        ogd_journal_free (journal);
+        return NULL;
+    }
+
+    return journal;
+}
+
+void ogd_journal_free (OGDJournal *journal)
+{
+    OGDJournalEntry *entry;
+
+    if (journal->file != NULL)
+        fclose (journal->file);
+
+    while ((entry = g_queue_pop_head (journal->entries)) != NULL)
+        free_entry (entry);
+
+    g_queue_free (journal->entries);
+    g_free (journal->path);
+    g_free (journal);
+}
+
+/*
+    Builds a new idempotency key, to be attached to a write request when sent the first time
+*/
+gchar* ogd_journal_new_key ()
+{
+    return g_strdup_printf ("%" G_GINT64_MODIFIER "x-%08x%08x", wall_clock_usec (), g_random_int (), g_random_int ());
+}
+
+/*
+    Adds a request at the end of the journal: @query is relative to the URL of the provider, and
+    @body is the form encoded data of the request. Returns FALSE if the request cannot be saved
+    on disk
+*/
+gboolean ogd_journal_append (OGDJournal *journal, const gchar *key, const gchar *query, const gchar *body, gsize length)
+{
+    OGDJournalEntry *entry;
+
+    entry = g_new0 (OGDJournalEntry, 1);
+    entry->key = (key != NULL) ? g_strdup (key) : ogd_journal_new_key ();
+    entry->queued = wall_clock_usec () / G_USEC_PER_SEC;
+    entry->query = g_strdup (query);
+    entry->body = g_strndup (body != NULL ? body : "", length);
+    entry->length = length;
+
+    g_queue_push_tail (journal->entries, entry);
+
+    if (journal->file == NULL || write_entry (journal->file, entry) == FALSE) {
+        g_warning ("Unable to write journal %s", journal->path);
+        return FALSE;
+    }
+
+    return sync_journal (journal);
+}
+
+/*
+    The oldest pending request, or NULL if the journal is empty. Owned by the journal
+*/
+const OGDJournalEntry* ogd_journal_peek (OGDJournal *journal)
+{
+    return g_queue_peek_head (journal->entries);
+}
+
+/*
+    Marks the oldest pending request as completed, whether it has been accepted or refused by the
+    server
+*/
+void ogd_journal_remove_head (OGDJournal *journal)
+{
+    GError *error;
+    OGDJournalEntry *entry;
+
+    entry = g_queue_pop_head (journal->entries);
+    if (entry == NULL)
+        return;
+
+    if (g_queue_is_empty (journal->entries) == TRUE) {
+        error = NULL;
+
+        if (rewrite_journal (journal, &error) == FALSE) {
+            g_warning ("%s", error->message);
+            g_error_free (error);
+        }
+    }
+    else if (journal->file != NULL) {
+        fprintf (journal->file, "D %s\n", entry->key);
+        sync_journal (journal);
+    }
+
+    free_entry (entry);
+}
+
+guint ogd_journal_get_length (OGDJournal *journal)
+{
+    return g_queue_get_length (journal->entries);
+}
@@ -0,0 +1,43 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_JOURNAL_H
+#define OGD_JOURNAL_H
+
+#include "ogd-provider-private.h"
+
+typedef struct _OGDJournal OGDJournal;
+
+typedef struct {
+    gchar           *key;
+    gint64          queued;
+    gchar           *query;
+    gchar           *body;
+    gsize           length;
+} OGDJournalEntry;
+
+OGDJournal*     ogd_journal_open                    (const gchar *path, GError **error);
+void            ogd_journal_free                    (OGDJournal *journal);
+
+gchar*          ogd_journal_new_key                 ();
+gboolean        ogd_journal_append                  (OGDJournal *journal, const gchar *key, const gchar *query,
+                                                     const gchar *body, gsize length);
+const OGDJournalEntry* ogd_journal_peek             (OGDJournal *journal);
+void            ogd_journal_remove_head             (OGDJournal *journal);
+guint           ogd_journal_get_length              (OGDJournal *journal);
+
+#endif /* OGD_JOURNAL_H */
@@ -0,0 +1,547 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-mailbox.h"
+#include "ogd-provider-private.h"
+#include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
+
+/**
+ * SECTION: ogd-mailbox
+ * @short_description:  polling of the folders of the current user for new messages
+ *
+ * An #OGDMailbox periodically checks the #OGDFolder s of the user inited with
+ * ogd_provider_auth_user_and_pwd() and passes to a callback only the messages arrived since the
+ * previous check. For each folder it remembers the number of messages and the newest message
+ * seen: the list of folders is requested at each poll, but messages are fetched only from the
+ * folders whose count changed, and pages stop being requested as soon as the newest known
+ * message, or an older one, is found. The first poll only takes note of the current state of
+ * the folders, and reports no message.
+ * This relies on the server listing messages from the newest. Since dates of messages have no
+ * time, the IDs of the messages sent in the newest day are kept to not report them twice.
+ * When started with ogd_mailbox_start() the interval between polls adapts to the activity:
+ * after a poll reporting new messages the next one is performed after the minimum interval,
+ * otherwise the interval is doubled up to the maximum one
+ */
+
+#define MAILBOX_PAGE_SIZE           20
+#define MAILBOX_MIN_INTERVAL        30
+#define MAILBOX_MAX_INTERVAL        600
+
+typedef struct {
+    gboolean                    known;
+    guint                       count;
+    gchar                       *newest_id;
+    guint32                     newest_day;
+    GHashTable                  *newest_ids;
+} FolderState;
+
+struct _OGDMailbox {
+    OGDProvider                 *provider;
+    GHashTable                  *folders;
+
+    OGDMailboxMessageCallback   callback;
+    gpointer                    userdata;
+
+    OGDPollTimer                timer;
+};
+
+typedef struct {
+    OGDMailbox                  *mailbox;
+    gulong                      received;
+    guint                       pending;
+} MailboxPoll;
+
+typedef struct {
+    MailboxPoll                 *poll;
+    gchar                       *folder;
+    guint                       count;
+    guint                       page;
+    guint                       pagesize;
+
+    gchar                       *newest_id;
+    guint32                     newest_day;
+    GList                       *fresh;
+} FolderPoll;
+
+static void free_folder_state (FolderState *state)
+{
+    g_free (state->newest_id);
+    g_hash_table_destroy (state->newest_ids);
+    g_free (state);
+}
+
+static void poll_async (gpointer userdata);
+
+/**
+ * ogd_mailbox_new:
+ * @provider:       the #OGDProvider from which messages are fetched
+ * @callback:       callback invoked for each new message
+ * @userdata:       the user data for @callback
+ *
+ * To create a new #OGDMailbox. Use ogd_mailbox_poll() to check for new messages once, or
+ * ogd_mailbox_start() to check them periodically
+ *
+ * Return value:    a newly allocated #OGDMailbox, to be freed with ogd_mailbox_free()
+ */
+OGDMailbox* ogd_mailbox_new (OGDProvider *provider, OGDMailboxMessageCallback callback, gpointer userdata)
+{
+    OGDMailbox *mailbox;
+
+    mailbox = g_new0 (OGDMailbox, 1);
+    mailbox->provider = provider;
+    mailbox->folders = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) free_folder_state);
+    mailbox->callback = callback;
+    mailbox->userdata = userdata;
+    poll_timer_init (&(mailbox->timer), MAILBOX_MIN_INTERVAL, MAILBOX_MAX_INTERVAL, poll_async, mailbox);
+    return mailbox;
+}
+
+static void destroy_mailbox (OGDMailbox *mailbox)
+{
+    g_hash_table_destroy (mailbox->folders);
+    g_free (mailbox);
+}
+
+/**
+ * ogd_mailbox_free:
+ * @mailbox:        the #OGDMailbox to free
+ *
+ * Stops and frees an #OGDMailbox. If a poll is running the #OGDMailbox is released when it
+ * completes, but no more messages are passed to the callback
+ */
+void ogd_mailbox_free (OGDMailbox *mailbox)
+{
+    if (poll_timer_dispose (&(mailbox->timer)) == TRUE)
+        destroy_mailbox (mailbox);
+}
+
+/**
+ * ogd_mailbox_set_intervals:
+ * @mailbox:        the #OGDMailbox to configure
+ * @min_seconds:    interval between polls while new messages are arriving. Must be at least 1
+ * @max_seconds:    maximum interval between polls, reached when no message arrives for a while
+ *
+ * To set the range in which the interval between polls performed after ogd_mailbox_start()
+ * adapts. Defaults are 30 and 600 seconds
+ */
+void ogd_mailbox_set_intervals (OGDMailbox *mailbox, guint min_seconds, guint max_seconds)
+{
+    poll_timer_set_intervals (&(mailbox->timer), min_seconds, max_seconds);
+}
+
+/**
+ * ogd_mailbox_get_interval:
+ * @mailbox:        the #OGDMailbox to query
+ *
+ * To know after how long the next poll will be performed, accordly the activity observed so far
+ *
+ * Return value:    the current interval between polls, in seconds
+ */
+guint ogd_mailbox_get_interval (OGDMailbox *mailbox)
+{
+    return mailbox->timer.interval;
+}
+
+/**
+ * ogd_mailbox_get_folder_count:
+ * @mailbox:        the #OGDMailbox to query
+ * @folder:         ID of an #OGDFolder
+ *
+ * To retrieve the number of messages in a folder, as reported by the server at the last
+ * successful poll
+ *
+ * Return value:    the number of messages in @folder, or 0 if it has never been polled
+ */
+guint ogd_mailbox_get_folder_count (OGDMailbox *mailbox, const gchar *folder)
+{
+    FolderState *state;
+
+    state = g_hash_table_lookup (mailbox->folders, folder);
+    if (state == NULL || state->known == FALSE)
+        return 0;
+
+    return state->count;
+}
+
+static guint32 message_day (OGDMessage *message)
+{
+    const GDate *date;
+
+    date = ogd_message_get_date (message);
+    if (date == NULL || g_date_valid (date) == FALSE)
+        return 0;
+
+    return g_date_get_julian (date);
+}
+
+static FolderState* folder_state (OGDMailbox *mailbox, const gchar *folder)
+{
+    FolderState *state;
+
+    state = g_hash_table_lookup (mailbox->folders, folder);
+
+    if (state == NULL) {
+        state = g_new0 (FolderState, 1);
+        state->newest_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        g_hash_table_insert (mailbox->folders, g_strdup (folder), state);
+    }
+
+    return state;
+}
+
+static MailboxPoll* new_poll (OGDMailbox *mailbox)
+{
+    MailboxPoll *poll;
+
+    poll = g_new0 (MailboxPoll, 1);
+    poll->mailbox = mailbox;
+    return poll;
+}
+
+/*
+    Returns NULL if the messages of @folder have not to be fetched, since their number is the same
+    of the previous poll
+*/
+static FolderPoll* new_folder_poll (MailboxPoll *poll, OGDFolder *folder)
+{
+    guint count;
+    const gchar *id;
+    FolderState *state;
+    FolderPoll *fpoll;
+
+    id = ogd_folder_get_id (folder);
+    if (id == NULL)
+        return NULL;
+
+    count = ogd_folder_get_count (folder);
+    state = folder_state (poll->mailbox, id);
+
+    if (state->known == TRUE && state->count == count)
+        return NULL;
+
+    fpoll = g_new0 (FolderPoll, 1);
+    fpoll->poll = poll;
+    fpoll->folder = g_strdup (id);
+    fpoll->count = count;
+
+    /*
+        When only some messages arrived a page just larger than them usually includes also the
+        newest known one, and nothing else has to be requested
+    */
+    if (state->known == TRUE && count > state->count)
+        fpoll->pagesize = CLAMP (count - state->count + 1, 2, MAILBOX_PAGE_SIZE);
+    else
+        fpoll->pagesize = MAILBOX_PAGE_SIZE;
+
+    return fpoll;
+}
+
+static gchar* folder_poll_query (gpointer userdata)
+{
+    FolderPoll *fpoll;
+
+    fpoll = (FolderPoll*) userdata;
+    return g_strdup_printf ("message/%s?page=%u&pagesize=%u", fpoll->folder, fpoll->page, fpoll->pagesize);
+}
+
+/*
+    New messages are collected in fpoll->fresh from the oldest, to be reported only if all the
+    required pages are received. The first poll of a folder collects messages sent in the same day
+    of the newest one, just to take note of their IDs
+*/
+static gboolean process_page (GList *messages, gpointer userdata)
+{
+    guint count;
+    guint32 day;
+    guint32 limit;
+    gboolean stop;
+    const gchar *id;
+    GList *iter;
+    OGDMessage *message;
+    FolderState *state;
+    FolderPoll *fpoll;
+
+    fpoll = (FolderPoll*) userdata;
+    count = 0;
+    stop = FALSE;
+    state = folder_state (fpoll->poll->mailbox, fpoll->folder);
+
+    for (iter = messages; iter; iter = g_list_next (iter)) {
+        count++;
+
+        if (IS_OGD_MESSAGE (iter->data) == FALSE) {
+            g_object_unref (iter->data);
+            continue;
+        }
+
+        message = OGD_MESSAGE (iter->data);
+        id = ogd_object_get_id (OGD_OBJECT (message));
+        day = message_day (message);
+
+        if (fpoll->page == 0 && count == 1) {
+            fpoll->newest_id = g_strdup (id);
+            fpoll->newest_day = day;
+        }
+
+        limit = state->known ? state->newest_day : fpoll->newest_day;
+
+        if (stop == TRUE || (state->known == TRUE && id != NULL && g_strcmp0 (id, state->newest_id) == 0) ||
+                (day != 0 && day < limit)) {
+            stop = TRUE;
+            g_object_unref (message);
+        }
+        else if (id != NULL && g_hash_table_lookup (state->newest_ids, id) != NULL) {
+            g_object_unref (message);
+        }
+        else {
+            fpoll->fresh = g_list_prepend (fpoll->fresh, message);
+        }
+    }
+
+    g_list_free (messages);
+    fpoll->page++;
+
+    return (stop == FALSE && count == fpoll->pagesize);
+}
+
+static void finish_folder_poll (FolderPoll *fpoll, const GError *error)
+{
+    const gchar *id;
+    GList *iter;
+    OGDMailbox *mailbox;
+    OGDMessage *message;
+    FolderState *state;
+
+    mailbox = fpoll->poll->mailbox;
+    state = folder_state (mailbox, fpoll->folder);
+
+    if (error == NULL) {
+        for (iter = fpoll->fresh; iter; iter = g_list_next (iter)) {
+            message = (OGDMessage*) iter->data;
+
+            if (state->known == TRUE && mailbox->timer.disposed == FALSE) {
+                TRACED_CALLBACK ("callback", mailbox->callback (mailbox, fpoll->folder, message, mailbox->userdata));
+                fpoll->poll->received++;
+            }
+        }
+
+        if (fpoll->newest_id != NULL) {
+            if (state->known == FALSE || fpoll->newest_day > state->newest_day) {
+                g_hash_table_remove_all (state->newest_ids);
+                state->newest_day = fpoll->newest_day;
+            }
+
+            g_free (state->newest_id);
+            state->newest_id = fpoll->newest_id;
+            fpoll->newest_id = NULL;
+        }
+
+        for (iter = fpoll->fresh; iter; iter = g_list_next (iter)) {
+            message = (OGDMessage*) iter->data;
+            id = ogd_object_get_id (OGD_OBJECT (message));
+
+            if (id != NULL && message_day (message) == state->newest_day)
+                g_hash_table_insert (state->newest_ids, g_strdup (id), GINT_TO_POINTER (1));
+        }
+
+        state->count = fpoll->count;
+        state->known = TRUE;
+    }
+
+    g_list_foreach (fpoll->fresh, (GFunc) g_object_unref, NULL);
+    g_list_free (fpoll->fresh);
+    g_free (fpoll->newest_id);
+    g_free (fpoll->folder);
+    g_free (fpoll);
+}
+
+/**
+ * ogd_mailbox_poll:
+ * @mailbox:        the #OGDMailbox used to poll
+ * @received:       if not %NULL, filled with the number of messages passed to the callback
+ * @error:          a #GError filled if the function returns %FALSE
+ *
+ * Checks once for new messages, passing them to the callback of @mailbox. If the messages of a
+ * folder cannot be fetched the other folders are checked anyway, and the failed one is checked
+ * again by the next poll
+ *
+ * Return value:    %TRUE if all folders have been checked, %FALSE otherwise
+ */
+gboolean ogd_mailbox_poll (OGDMailbox *mailbox, gulong *received, GError **error)
+{
+    GList *folders;
+    GList *iter;
+    GError *poll_error;
+    GError *page_error;
+    MailboxPoll *poll;
+    FolderPoll *fpoll;
+
+    poll_error = NULL;
+    folders = ogd_provider_get_full (mailbox->provider, "message", &poll_error);
+
+    if (poll_error != NULL) {
+        poll_timer_adapt (&(mailbox->timer), 0);
+        g_propagate_error (error, poll_error);
+        return FALSE;
+    }
+
+    poll = new_poll (mailbox);
+
+    for (iter = folders; iter; iter = g_list_next (iter)) {
+        fpoll = NULL;
+
+        if (IS_OGD_FOLDER (iter->data))
+            fpoll = new_folder_poll (poll, OGD_FOLDER (iter->data));
+
+        g_object_unref (iter->data);
+
+        if (fpoll == NULL)
+            continue;
+
+        page_error = NULL;
+        fetch_pages (mailbox->provider, folder_poll_query, process_page, fpoll, &page_error);
+        finish_folder_poll (fpoll, page_error);
+
+        if (page_error != NULL) {
+            if (poll_error == NULL)
+                poll_error = page_error;
+            else
+                g_error_free (page_error);
+        }
+    }
+
+    g_list_free (folders);
+
+    if (received != NULL)
+        *received = poll->received;
+
+    poll_timer_adapt (&(mailbox->timer), poll->received);
+    g_free (poll);
+
+    if (poll_error != NULL) {
+        g_propagate_error (error, poll_error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void finish_poll (MailboxPoll *poll)
+{
+    OGDMailbox *mailbox;
+
+    mailbox = poll->mailbox;
+
+    if (poll_timer_done (&(mailbox->timer), poll->received) == TRUE)
+        destroy_mailbox (mailbox);
+
+    g_free (poll);
+}
+
+static void folder_poll_done (MailboxPoll *poll)
+{
+    poll->pending--;
+    if (poll->pending == 0)
+        finish_poll (poll);
+}
+
+static void folder_fetched (gpointer userdata, const GError *error)
+{
+    FolderPoll *fpoll;
+    MailboxPoll *poll;
+
+    fpoll = (FolderPoll*) userdata;
+    poll = fpoll->poll;
+    finish_folder_poll (fpoll, error);
+    folder_poll_done (poll);
+}
+
+static void folders_received (GList *folders, const GError *error, gpointer userdata)
+{
+    GList *iter;
+    MailboxPoll *poll;
+    FolderPoll *fpoll;
+
+    poll = (MailboxPoll*) userdata;
+
+    if (error != NULL) {
+        finish_poll (poll);
+        return;
+    }
+
+    /*
+        The counter is kept above 0 until all folders have been considered, otherwise a folder
+        completed immediately would end the whole poll
+    */
+    poll->pending = 1;
+
+    for (iter = folders; iter; iter = g_list_next (iter)) {
+        fpoll = NULL;
+
+        if (IS_OGD_FOLDER (iter->data))
+            fpoll = new_folder_poll (poll, OGD_FOLDER (iter->data));
+
+        g_object_unref (iter->data);
+
+        if (fpoll != NULL) {
+            poll->pending++;
+            fetch_pages_async (poll->mailbox->provider, poll, folder_poll_query, process_page, folder_fetched, fpoll);
+        }
+    }
+
+    g_list_free (folders);
+
+    folder_poll_done (poll);
+}
+
+static void poll_async (gpointer userdata)
+{
+    OGDMailbox *mailbox;
+    MailboxPoll *poll;
+
+    mailbox = (OGDMailbox*) userdata;
+    poll = new_poll (mailbox);
+    ogd_provider_get_list_async_full (mailbox->provider, "message", OGD_PROVIDER_PRIORITY_BULK, poll,
+                                      folders_received, poll);
+}
+
+/**
+ * ogd_mailbox_start:
+ * @mailbox:        the #OGDMailbox to start
+ *
+ * Starts to poll periodically for new messages, with the first poll performed immediately.
+ * Requests are scheduled with %OGD_PROVIDER_PRIORITY_BULK priority. If a poll fails it is
+ * repeated later, and the reason is available from ogd_provider_get_last_error()
+ */
+void ogd_mailbox_start (OGDMailbox *mailbox)
+{
+    poll_timer_start (&(mailbox->timer));
+}
+
+/**
+ * ogd_mailbox_stop:
+ * @mailbox:        the #OGDMailbox to stop
+ *
+ * Stops polling for new messages. A poll already running is completed anyway, and new messages
+ * it finds are still passed to the callback
+ */
+void ogd_mailbox_stop (OGDMailbox *mailbox)
+{
+    poll_timer_stop (&(mailbox->timer));
+}
@@ -0,0 +1,53 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_MAILBOX_H
+#define OGD_MAILBOX_H
+
+G_BEGIN_DECLS
+
+#include "ogd-message.h"
+
+typedef struct _OGDMailbox OGDMailbox;
+
+/**
+ * OGDMailboxMessageCallback:
+ * @mailbox:        the #OGDMailbox which found the message
+ * @folder:         ID of the #OGDFolder containing the message
+ * @message:        an #OGDMessage arrived since the previous poll
+ * @userdata:       the user data passed with the callback
+ *
+ * Invoked by an #OGDMailbox for each new message. Messages of the same folder are passed from
+ * the oldest to the newest. @message is unref'd after the callback, which has to take its own
+ * reference to keep it
+ */
+typedef void (*OGDMailboxMessageCallback) (OGDMailbox *mailbox, const gchar *folder, OGDMessage *message, gpointer userdata);
+
+OGDMailbox*     ogd_mailbox_new                     (OGDProvider *provider, OGDMailboxMessageCallback callback, gpointer userdata);
+void            ogd_mailbox_free                    (OGDMailbox *mailbox);
+
+void            ogd_mailbox_set_intervals           (OGDMailbox *mailbox, guint min_seconds, guint max_seconds);
+guint           ogd_mailbox_get_interval            (OGDMailbox *mailbox);
+guint           ogd_mailbox_get_folder_count        (OGDMailbox *mailbox, const gchar *folder);
+
+gboolean        ogd_mailbox_poll                    (OGDMailbox *mailbox, gulong *received, GError **error);
+void            ogd_mailbox_start                   (OGDMailbox *mailbox);
+void            ogd_mailbox_stop                    (OGDMailbox *mailbox);
+
+G_END_DECLS
+
+#endif /* OGD_MAILBOX_H */
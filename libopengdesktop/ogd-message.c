@@ -18,6 +18,7 @@
 #include "ogd.h"
 #include "ogd-message.h"
 #include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
 
 #define OGD_MESSAGE_GET_PRIVATE(obj)        (G_TYPE_INSTANCE_GET_PRIVATE ((obj),    \
                                              OGD_MESSAGE_TYPE, OGDMessagePrivate))
@@ -47,11 +48,13 @@ static void ogd_message_finalize (GObject *obj)
 
     msg = OGD_MESSAGE (obj);
 
-    PTR_CHECK_FREE_NULLIFY (msg->priv->id);
-    PTR_CHECK_FREE_NULLIFY (msg->priv->authorid);
+    ARENA_CHECK_FREE_NULLIFY (msg->priv->id);
+    ARENA_CHECK_FREE_NULLIFY (msg->priv->authorid);
     DATE_CHECK_FREE_NULLIFY (msg->priv->date);
-    PTR_CHECK_FREE_NULLIFY (msg->priv->subject);
-    PTR_CHECK_FREE_NULLIFY (msg->priv->body);
+    ARENA_CHECK_FREE_NULLIFY (msg->priv->subject);
+    ARENA_CHECK_FREE_NULLIFY (msg->priv->body);
+
+    ogd_object_release_arena (OGD_OBJECT (obj));
 }
 
 static gboolean ogd_message_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
@@ -86,6 +89,11 @@ static gboolean ogd_message_fill_by_xml (OGDObject *obj, const xmlNode *xml, GEr
     return TRUE;
 }
 
+static const gchar* ogd_message_get_object_id (OGDObject *obj)
+{
+    return (const gchar*) OGD_MESSAGE (obj)->priv->id;
+}
+
 static void ogd_message_class_init (OGDMessageClass *klass)
 {
     GObjectClass *gobject_class;
@@ -98,6 +106,7 @@ static void ogd_message_class_init (OGDMessageClass *klass)
 
     ogd_object_class = OGD_OBJECT_CLASS (klass);
     ogd_object_class->fill_by_xml = ogd_message_fill_by_xml;
+    ogd_object_class_set_id_func (ogd_object_class, ogd_message_get_object_id);
 }
 
 static void ogd_message_init (OGDMessage *item)
@@ -172,27 +181,15 @@ const gchar* ogd_message_get_body (OGDMessage *msg)
     return (const gchar*) msg->priv->body;
 }
 
-static const gchar* retrieve_messages_folder (OGDProvider *provider, OGD_FOLDER_CATEGORY category)
+static GHashTable* message_params (OGDPerson *to, const gchar *subject, const gchar *body)
 {
-    const gchar *ret;
-    GList *folders;
-    GList *iter;
-    OGDFolder *fold;
-
-    ret = NULL;
-    folders = ogd_folder_fetch_all (provider);
-
-    for (iter = g_list_first (folders); iter; iter = g_list_next (iter)) {
-        fold = (OGDFolder*) iter->data;
-
-        if (ogd_folder_get_category (fold) == category) {
-            ret = ogd_folder_get_id (fold);
-            break;
-        }
-    }
+    GHashTable *params;
 
-    g_list_free (folders);
-    return ret;
+    params = g_hash_table_new (g_str_hash, g_str_equal);
+    g_hash_table_insert (params, "to", (gpointer) ogd_person_get_id (to));
+    g_hash_table_insert (params, "subject", (gpointer) subject);
+    g_hash_table_insert (params, "message", (gpointer) body);
+    return params;
 }
 
 /**
@@ -212,19 +209,161 @@ void ogd_message_send (OGDPerson *to, const gchar *subject, const gchar *body)
 
     provider = ogd_object_get_provider (OGD_OBJECT (to));
 
-    id_of_send_folder = retrieve_messages_folder (provider, OGD_FOLDER_SEND);
+    id_of_send_folder = ogd_folder_get_id_by_category (provider, OGD_FOLDER_SEND);
     if (id_of_send_folder == NULL)
         return;
 
     query = g_strdup_printf ("message/%s", id_of_send_folder);
-
-    params = g_hash_table_new (g_str_hash, g_str_equal);
-    g_hash_table_insert (params, "to", (gpointer) ogd_person_get_id (to));
-    g_hash_table_insert (params, "subject", (gpointer) subject);
-    g_hash_table_insert (params, "message", (gpointer) body);
+    params = message_params (to, subject, body);
 
     ogd_provider_put (provider, query, params);
 
     g_hash_table_unref (params);
     g_free (query);
 }
+
+typedef struct {
+    OGDPerson               *to;
+    gchar                   *subject;
+    gchar                   *body;
+    OGDPutAsyncCallback     callback;
+    gpointer                userdata;
+} SendRequestDesc;
+
+static void send_folder_found (const gchar *id, gpointer userdata)
+{
+    gchar *query;
+    GHashTable *params;
+    SendRequestDesc *req;
+
+    req = (SendRequestDesc*) userdata;
+
+    if (id == NULL) {
+        if (req->callback != NULL) {
+            TRACED_CALLBACK ("callback", req->callback (FALSE, req->userdata));
+        }
+    }
+    else {
+        /*
+            Messages are never coalesced in the write queue, so no key is used
+        */
+        query = g_strdup_printf ("message/%s", id);
+        params = message_params (req->to, req->subject, req->body);
+        ogd_provider_queue_put (ogd_object_get_provider (OGD_OBJECT (req->to)), NULL, query, params,
+                                req->callback, req->userdata);
+        g_hash_table_unref (params);
+        g_free (query);
+    }
+
+    g_object_unref (req->to);
+    g_free (req->subject);
+    g_free (req->body);
+    g_free (req);
+}
+
+/**
+ * ogd_message_send_async:
+ * @to:             recipent for the message
+ * @subject:        text of the subject for the new message
+ * @body:           content of the message
+ * @callback:       async callback to which the result of the operation is passed, or %NULL
+ * @userdata:       the user data for the callback
+ *
+ * Async version of ogd_message_send(). The message is enqueued in the write queue of the
+ * #OGDProvider of @to, so many messages sent in a row are pipelined to the server: see
+ * ogd_provider_set_write_limit()
+ */
+void ogd_message_send_async (OGDPerson *to, const gchar *subject, const gchar *body,
+                             OGDPutAsyncCallback callback, gpointer userdata)
+{
+    SendRequestDesc *req;
+
+    req = g_new0 (SendRequestDesc, 1);
+    req->to = g_object_ref (to);
+    req->subject = g_strdup (subject);
+    req->body = g_strdup (body);
+    req->callback = callback;
+    req->userdata = userdata;
+
+    ogd_folder_get_id_by_category_async (ogd_object_get_provider (OGD_OBJECT (to)), OGD_FOLDER_SEND,
+                                         send_folder_found, req);
+}
+
+typedef struct {
+    guint   sent;
+    guint   failed;
+} BulkSendDesc;
+
+static void bulk_message_sent (gboolean successfull, gpointer userdata)
+{
+    BulkSendDesc *bulk;
+
+    bulk = (BulkSendDesc*) userdata;
+
+    if (successfull == TRUE)
+        bulk->sent++;
+    else
+        bulk->failed++;
+}
+
+/**
+ * ogd_message_send_bulk:
+ * @recipients:     a #GList of #OGDPerson to which send the message, all from the same
+ *                  #OGDProvider
+ * @subject:        text of the subject for the new messages
+ * @body:           content of the messages
+ * @error:          a #GError filled if not all messages have been sent
+ *
+ * Sends the same message to many persons. The folder in which sent messages are saved is looked
+ * up only once, and the messages are pipelined to the server through the write queue of the
+ * #OGDProvider. This function returns when all of them have been sent. Only the messages of this
+ * call are accounted in the result, not other operations completed meanwhile in the write queue
+ *
+ * Return value:    %TRUE if all messages have been sent, %FALSE otherwise
+ */
+gboolean ogd_message_send_bulk (GList *recipients, const gchar *subject, const gchar *body, GError **error)
+{
+    gchar *query;
+    const gchar *id_of_send_folder;
+    GList *iter;
+    GHashTable *params;
+    OGDProvider *provider;
+    BulkSendDesc bulk;
+
+    if (recipients == NULL)
+        return TRUE;
+
+    provider = ogd_object_get_provider (OGD_OBJECT (recipients->data));
+
+    id_of_send_folder = ogd_folder_get_id_by_category (provider, OGD_FOLDER_SEND);
+    if (id_of_send_folder == NULL) {
+        g_set_error (error, OGD_EDIT_ERROR_DOMAIN, OGD_EDIT_ERROR, "Unable to find the folder of sent messages");
+        return FALSE;
+    }
+
+    query = g_strdup_printf ("message/%s", id_of_send_folder);
+    bulk.sent = 0;
+    bulk.failed = 0;
+
+    for (iter = recipients; iter; iter = g_list_next (iter)) {
+        params = message_params ((OGDPerson*) iter->data, subject, body);
+        ogd_provider_queue_put (provider, NULL, query, params, bulk_message_sent, &bulk);
+        g_hash_table_unref (params);
+    }
+
+    g_free (query);
+
+    /*
+        The summary of the flush covers all operations of the queue, the ones of this call are
+        counted by their own callbacks
+    */
+    ogd_provider_flush_writes (provider, NULL);
+
+    if (bulk.failed != 0) {
+        g_set_error (error, OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR, "%u of %u messages have not been sent",
+                     bulk.failed, bulk.sent + bulk.failed);
+        return FALSE;
+    }
+
+    return TRUE;
+}
@@ -70,6 +70,10 @@ const gchar*            ogd_message_get_subject                 (OGDMessage *msg
 const gchar*            ogd_message_get_body                    (OGDMessage *msg);
 
 void                    ogd_message_send                        (OGDPerson *to, const gchar *subject, const gchar *body);
+void                    ogd_message_send_async                  (OGDPerson *to, const gchar *subject, const gchar *body,
+                                                                 OGDPutAsyncCallback callback, gpointer userdata);
+gboolean                ogd_message_send_bulk                   (GList *recipients, const gchar *subject, const gchar *body,
+                                                                 GError **error);
 
 G_END_DECLS
 
@@ -20,6 +20,7 @@
 #include "ogd-provider.h"
 #include "ogd-provider-private.h"
 #include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
 
 #define OGD_OBJECT_GET_PRIVATE(obj)       (G_TYPE_INSTANCE_GET_PRIVATE ((obj),    \
                                              OGD_OBJECT_TYPE, OGDObjectPrivate))
@@ -35,8 +36,15 @@
 
 struct _OGDObjectPrivate {
     OGDProvider     *provider;
+    OGDArena        *arena;
 };
 
+/*
+    Functions retrieving the ID of each type of object, registered by subclasses with
+    ogd_object_class_set_id_func(). They are kept out of OGDObjectClass to not change its layout
+*/
+static GHashTable       *IdFuncs            = NULL;
+
 G_DEFINE_ABSTRACT_TYPE (OGDObject, ogd_object, G_TYPE_OBJECT);
 
 static void ogd_object_finalize (GObject *obj)
@@ -58,7 +66,47 @@ static void ogd_object_finalize (GObject *obj)
  */
 gboolean ogd_object_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
 {
-    return OGD_OBJECT_GET_CLASS (obj)->fill_by_xml (obj, xml, error);
+    gboolean ret;
+    OGDArena *arena;
+
+    ogd_tracing_begin ("fill_by_xml", G_OBJECT_TYPE_NAME (obj));
+    ret = OGD_OBJECT_GET_CLASS (obj)->fill_by_xml (obj, xml, error);
+    ogd_tracing_end ("fill_by_xml", G_OBJECT_TYPE_NAME (obj));
+
+    /*
+        Fields may have been allocated from the arena of the response, which is so kept alive
+        until the object is finalized or filled again
+    */
+    arena = ogd_arena_get_current ();
+    if (arena != NULL)
+        ogd_object_attach_arena (obj, arena);
+
+    return ret;
+}
+
+/*
+    The object keeps a reference to @arena, from which some of its fields have been allocated,
+    replacing the one previously held (if any)
+*/
+void ogd_object_attach_arena (OGDObject *obj, OGDArena *arena)
+{
+    if (obj->priv->arena != arena) {
+        ogd_object_release_arena (obj);
+        obj->priv->arena = ogd_arena_ref (arena);
+    }
+}
+
+/*
+    To be called by finalize callbacks of extending classes after all fields have been freed:
+    those callbacks are used also to reset the object before filling it again, so the arena is not
+    released when the GObject is finalized but when fields allocated from it are no longer used
+*/
+void ogd_object_release_arena (OGDObject *obj)
+{
+    if (obj->priv->arena != NULL) {
+        ogd_arena_unref (obj->priv->arena);
+        obj->priv->arena = NULL;
+    }
 }
 
 static inline gchar* has_valid_target_callback (OGDObject *obj, const gchar *id)
@@ -102,15 +150,28 @@ gboolean ogd_object_fill_by_id (OGDObject *obj, const gchar *id, GError **error)
         return FALSE;
     }
 
+    if (ogd_provider_fill_from_store (obj->priv->provider, obj, id, FALSE) == TRUE) {
+        g_free (query);
+        return TRUE;
+    }
+
     data = ogd_provider_get_raw (ogd_object_get_provider (obj), query, error);
     g_free (query);
 
     if (data != NULL) {
         ret = ogd_object_fill_by_xml (obj, data, error);
+        if (ret == TRUE)
+            ogd_provider_intern_object (obj->priv->provider, obj, data);
+
         xmlFreeDoc (data->doc);
     }
     else {
-        ret = FALSE;
+        /*
+            When the server cannot be reached an outdated copy is better than nothing
+        */
+        ret = ogd_provider_fill_from_store (obj->priv->provider, obj, id, TRUE);
+        if (ret == TRUE && error != NULL && *error != NULL)
+            g_clear_error (error);
     }
 
     return ret;
@@ -120,29 +181,40 @@ static void parse_xml_from_async (xmlNode *node, gpointer userdata)
 {
     AsyncRequestDesc *req;
 
+    req = (AsyncRequestDesc*) userdata;
+
     if (node != NULL) {
-        req = (AsyncRequestDesc*) userdata;
-        ogd_object_fill_by_xml (req->reference, node, NULL);
-        req->callback (req->reference, req->userdata);
+        if (ogd_object_fill_by_xml (req->reference, node, NULL) == TRUE)
+            ogd_provider_intern_object (ogd_object_get_provider (req->reference), req->reference, node);
+
+        TRACED_CALLBACK ("callback", req->callback (req->reference, req->userdata));
         xmlFreeDoc (node->doc);
-        g_free (req);
     }
+    else {
+        TRACED_CALLBACK ("callback", req->callback (NULL, req->userdata));
+    }
+
+    g_free (req);
 }
 
-/**
- * ogd_object_fill_by_id_async:
- * @obj:            #OGDObject to fill with values from the provided XML
- * @id:             ID of the object to read
- * @callback:       async callback to which the filled #OGDObject is passed
- * @userdata:       the user data for the callback
- *
- * Async version of ogd_object_fill_by_id()
- */
-void ogd_object_fill_by_id_async (OGDObject *obj, const gchar *id, OGDAsyncCallback callback, gpointer userdata)
+/*
+    Used internally when filling many objects as part of the same operation (e.g. the list of
+    friends of a person), so that all the requests share priority and fairness lane
+*/
+void fill_by_id_async_full (OGDObject *obj, const gchar *id, OGD_PROVIDER_PRIORITY priority, gpointer caller,
+                            OGDAsyncCallback callback, gpointer userdata)
 {
     gchar *query;
     AsyncRequestDesc *req;
 
+    /*
+        Objects in the store are delivered immediately, before this function returns
+    */
+    if (ogd_provider_fill_from_store (ogd_object_get_provider (obj), obj, id, FALSE) == TRUE) {
+        TRACED_CALLBACK ("callback", callback (obj, userdata));
+        return;
+    }
+
     query = has_valid_target_callback (obj, id);
     if (query == NULL)
         return;
@@ -152,10 +224,27 @@ void ogd_object_fill_by_id_async (OGDObject *obj, const gchar *id, OGDAsyncCallb
     req->userdata = userdata;
     req->reference = obj;
 
-    ogd_provider_get_raw_async (ogd_object_get_provider (obj), query, FALSE, parse_xml_from_async, req);
+    ogd_provider_get_raw_async_full (ogd_object_get_provider (obj), query, FALSE, priority, caller,
+                                     parse_xml_from_async, req);
     g_free (query);
 }
 
+/**
+ * ogd_object_fill_by_id_async:
+ * @obj:            #OGDObject to fill with values from the provided XML
+ * @id:             ID of the object to read
+ * @callback:       async callback to which the filled #OGDObject is passed
+ * @userdata:       the user data for the callback
+ *
+ * Async version of ogd_object_fill_by_id(). The request is scheduled with
+ * %OGD_PROVIDER_PRIORITY_INTERACTIVE priority. If the object cannot be retrieved the @callback is
+ * invoked with %NULL
+ */
+void ogd_object_fill_by_id_async (OGDObject *obj, const gchar *id, OGDAsyncCallback callback, gpointer userdata)
+{
+    fill_by_id_async_full (obj, id, OGD_PROVIDER_PRIORITY_INTERACTIVE, userdata, callback, userdata);
+}
+
 static void ogd_object_class_init (OGDObjectClass *klass)
 {
     GObjectClass *gobject_class;
@@ -200,3 +289,44 @@ void ogd_object_set_provider (OGDObject *obj, OGDProvider *provider)
 {
     obj->priv->provider = (OGDProvider*) provider;
 }
+
+/**
+ * ogd_object_get_id:
+ * @obj:            the #OGDObject to query
+ *
+ * To retrieve the identifier of an object on the server, whatever its type
+ *
+ * Return value:    the ID of @obj, or %NULL if not yet assigned or if the type of object has no
+ *                  identifier
+ */
+const gchar* ogd_object_get_id (OGDObject *obj)
+{
+    GType type;
+    OGDObjectIdFunc func;
+
+    if (IdFuncs == NULL)
+        return NULL;
+
+    /*
+        Subclasses defined outside the library inherit the function of their parent
+    */
+    for (type = G_OBJECT_TYPE (obj); type != 0 && type != OGD_OBJECT_TYPE; type = g_type_parent (type)) {
+        func = (OGDObjectIdFunc) g_hash_table_lookup (IdFuncs, GSIZE_TO_POINTER (type));
+        if (func != NULL)
+            return func (obj);
+    }
+
+    return NULL;
+}
+
+/*
+    To be called in class_init of each subclass having an identifier, to make it available to
+    ogd_object_get_id()
+*/
+void ogd_object_class_set_id_func (OGDObjectClass *klass, OGDObjectIdFunc func)
+{
+    if (IdFuncs == NULL)
+        IdFuncs = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    g_hash_table_insert (IdFuncs, GSIZE_TO_POINTER (G_OBJECT_CLASS_TYPE (klass)), func);
+}
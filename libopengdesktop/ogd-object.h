@@ -41,6 +41,7 @@ typedef struct _OGDObjectPrivate OGDObjectPrivate;
 typedef void (*OGDAsyncCallback)        (OGDObject *obj, gpointer userdata);
 typedef void (*OGDAsyncListCallback)    (GList *list, gpointer userdata);
 typedef void (*OGDPutAsyncCallback)     (gboolean successfull, gpointer userdata);
+typedef void (*OGDSaveAsyncCallback)    (OGDObject *obj, const GError *error, gpointer userdata);
 
 struct _OGDObject {
     GObject                 parent;
@@ -59,6 +60,7 @@ GType               ogd_object_get_type                 ();
 
 OGDProvider*        ogd_object_get_provider             (OGDObject *obj);
 void                ogd_object_set_provider             (OGDObject *obj, OGDProvider *provider);
+const gchar*        ogd_object_get_id                   (OGDObject *obj);
 
 gboolean            ogd_object_fill_by_xml              (OGDObject *obj, const xmlNode *xml, GError **error);
 gboolean            ogd_object_fill_by_id               (OGDObject *obj, const gchar *id, GError **error);
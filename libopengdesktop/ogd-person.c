@@ -19,6 +19,8 @@
 #include "ogd-person.h"
 #include "ogd-provider-private.h"
 #include "ogd-private-utils.h"
+#include "ogd-snapshot-private.h"
+#include "ogd-tracing-private.h"
 
 #define OGD_PERSON_GET_PRIVATE(obj)       (G_TYPE_INSTANCE_GET_PRIVATE ((obj),    \
                                              OGD_PERSON_TYPE, OGDPersonPrivate))
@@ -77,28 +79,30 @@ static void ogd_person_finalize (GObject *obj)
 
     person = OGD_PERSON (obj);
 
-    PTR_CHECK_FREE_NULLIFY (person->priv->id);
-    PTR_CHECK_FREE_NULLIFY (person->priv->firstname);
-    PTR_CHECK_FREE_NULLIFY (person->priv->lastname);
-    PTR_CHECK_FREE_NULLIFY (person->priv->homepage);
-    PTR_CHECK_FREE_NULLIFY (person->priv->company);
-    PTR_CHECK_FREE_NULLIFY (person->priv->avatar);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->id);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->firstname);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->lastname);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->homepage);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->company);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->avatar);
     DATE_CHECK_FREE_NULLIFY (person->priv->birthday);
-    PTR_CHECK_FREE_NULLIFY (person->priv->city);
-    PTR_CHECK_FREE_NULLIFY (person->priv->country);
-    PTR_CHECK_FREE_NULLIFY (person->priv->likes);
-    PTR_CHECK_FREE_NULLIFY (person->priv->dontlikes);
-    PTR_CHECK_FREE_NULLIFY (person->priv->interests);
-    PTR_CHECK_FREE_NULLIFY (person->priv->languages);
-    PTR_CHECK_FREE_NULLIFY (person->priv->programminglangs);
-    PTR_CHECK_FREE_NULLIFY (person->priv->favouritequote);
-    PTR_CHECK_FREE_NULLIFY (person->priv->favouritemusic);
-    PTR_CHECK_FREE_NULLIFY (person->priv->favouritetv);
-    PTR_CHECK_FREE_NULLIFY (person->priv->favouritemovies);
-    PTR_CHECK_FREE_NULLIFY (person->priv->favouritebooks);
-    PTR_CHECK_FREE_NULLIFY (person->priv->favouritegames);
-    PTR_CHECK_FREE_NULLIFY (person->priv->description);
-    PTR_CHECK_FREE_NULLIFY (person->priv->profilepage);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->city);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->country);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->likes);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->dontlikes);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->interests);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->languages);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->programminglangs);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->favouritequote);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->favouritemusic);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->favouritetv);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->favouritemovies);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->favouritebooks);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->favouritegames);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->description);
+    ARENA_CHECK_FREE_NULLIFY (person->priv->profilepage);
+
+    ogd_object_release_arena (OGD_OBJECT (obj));
 }
 
 static gboolean ogd_person_fill_by_xml (OGDObject *obj, const xmlNode *xml, GError **error)
@@ -221,6 +225,11 @@ static gchar* ogd_person_target_query (const gchar *id)
     return g_strdup_printf ("person/data/%s", id);
 }
 
+static const gchar* ogd_person_get_object_id (OGDObject *obj)
+{
+    return ogd_person_get_id (OGD_PERSON (obj));
+}
+
 static void ogd_person_class_init (OGDPersonClass *klass)
 {
     GObjectClass *gobject_class;
@@ -233,6 +242,7 @@ static void ogd_person_class_init (OGDPersonClass *klass)
 
     ogd_object_class = OGD_OBJECT_CLASS (klass);
     ogd_object_class->fill_by_xml = ogd_person_fill_by_xml;
+    ogd_object_class_set_id_func (ogd_object_class, ogd_person_get_object_id);
     ogd_object_class->target_query = ogd_person_target_query;
 }
 
@@ -242,6 +252,122 @@ static void ogd_person_init (OGDPerson *item)
     memset (item->priv, 0, sizeof (OGDPersonPrivate));
 }
 
+static const OGD_SNAPSHOT_KIND PersonSnapshotKinds [] = {
+    OGD_SNAPSHOT_STRING,        /* id */
+    OGD_SNAPSHOT_INTEGER,       /* privacy */
+    OGD_SNAPSHOT_STRING,        /* firstname */
+    OGD_SNAPSHOT_STRING,        /* lastname */
+    OGD_SNAPSHOT_INTEGER,       /* gender */
+    OGD_SNAPSHOT_INTEGER,       /* role */
+    OGD_SNAPSHOT_STRING,        /* homepage */
+    OGD_SNAPSHOT_STRING,        /* company */
+    OGD_SNAPSHOT_STRING,        /* avatar */
+    OGD_SNAPSHOT_INTEGER,       /* birthday */
+    OGD_SNAPSHOT_INTEGER,       /* jobstatus */
+    OGD_SNAPSHOT_STRING,        /* city */
+    OGD_SNAPSHOT_STRING,        /* country */
+    OGD_SNAPSHOT_DOUBLE,        /* latitude */
+    OGD_SNAPSHOT_DOUBLE,        /* longitude */
+    OGD_SNAPSHOT_STRING,        /* likes */
+    OGD_SNAPSHOT_STRING,        /* dontlikes */
+    OGD_SNAPSHOT_STRING,        /* interests */
+    OGD_SNAPSHOT_STRING,        /* languages */
+    OGD_SNAPSHOT_STRING,        /* programminglangs */
+    OGD_SNAPSHOT_STRING,        /* favouritequote */
+    OGD_SNAPSHOT_STRING,        /* favouritemusic */
+    OGD_SNAPSHOT_STRING,        /* favouritetv */
+    OGD_SNAPSHOT_STRING,        /* favouritemovies */
+    OGD_SNAPSHOT_STRING,        /* favouritebooks */
+    OGD_SNAPSHOT_STRING,        /* favouritegames */
+    OGD_SNAPSHOT_STRING,        /* description */
+    OGD_SNAPSHOT_STRING,        /* profilepage */
+};
+
+static void ogd_person_to_snapshot (OGDObject *obj, OGDSnapshotValue *values)
+{
+    OGDPerson *person;
+
+    person = OGD_PERSON (obj);
+
+    values [0].string = person->priv->id;
+    values [1].integer = person->priv->privacy;
+    values [2].string = person->priv->firstname;
+    values [3].string = person->priv->lastname;
+    values [4].integer = person->priv->gender;
+    values [5].integer = person->priv->role;
+    values [6].string = person->priv->homepage;
+    values [7].string = person->priv->company;
+    values [8].string = person->priv->avatar;
+    values [9].integer = ogd_snapshot_pack_date (person->priv->birthday);
+    values [10].integer = person->priv->jobstatus;
+    values [11].string = person->priv->city;
+    values [12].string = person->priv->country;
+    values [13].real = person->priv->latitude;
+    values [14].real = person->priv->longitude;
+    values [15].string = person->priv->likes;
+    values [16].string = person->priv->dontlikes;
+    values [17].string = person->priv->interests;
+    values [18].string = person->priv->languages;
+    values [19].string = person->priv->programminglangs;
+    values [20].string = person->priv->favouritequote;
+    values [21].string = person->priv->favouritemusic;
+    values [22].string = person->priv->favouritetv;
+    values [23].string = person->priv->favouritemovies;
+    values [24].string = person->priv->favouritebooks;
+    values [25].string = person->priv->favouritegames;
+    values [26].string = person->priv->description;
+    values [27].string = person->priv->profilepage;
+}
+
+static void ogd_person_fill_by_snapshot (OGDObject *obj, const OGDSnapshotValue *values)
+{
+    OGDPerson *person;
+
+    person = OGD_PERSON (obj);
+    ogd_person_finalize (G_OBJECT (obj));
+
+    person->priv->id = (gchar*) values [0].string;
+    person->priv->privacy = (guint) values [1].integer;
+    person->priv->firstname = (gchar*) values [2].string;
+    person->priv->lastname = (gchar*) values [3].string;
+    person->priv->gender = (OGD_PERSON_GENDER) values [4].integer;
+    person->priv->role = (OGD_PERSON_ROLE) values [5].integer;
+    person->priv->homepage = (gchar*) values [6].string;
+    person->priv->company = (gchar*) values [7].string;
+    person->priv->avatar = (gchar*) values [8].string;
+    person->priv->birthday = ogd_snapshot_unpack_date (values [9].integer);
+    person->priv->jobstatus = (OGD_PERSON_JOB) values [10].integer;
+    person->priv->city = (gchar*) values [11].string;
+    person->priv->country = (gchar*) values [12].string;
+    person->priv->latitude = values [13].real;
+    person->priv->longitude = values [14].real;
+    person->priv->likes = (gchar*) values [15].string;
+    person->priv->dontlikes = (gchar*) values [16].string;
+    person->priv->interests = (gchar*) values [17].string;
+    person->priv->languages = (gchar*) values [18].string;
+    person->priv->programminglangs = (gchar*) values [19].string;
+    person->priv->favouritequote = (gchar*) values [20].string;
+    person->priv->favouritemusic = (gchar*) values [21].string;
+    person->priv->favouritetv = (gchar*) values [22].string;
+    person->priv->favouritemovies = (gchar*) values [23].string;
+    person->priv->favouritebooks = (gchar*) values [24].string;
+    person->priv->favouritegames = (gchar*) values [25].string;
+    person->priv->description = (gchar*) values [26].string;
+    person->priv->profilepage = (gchar*) values [27].string;
+}
+
+const OGDSnapshotSchema* ogd_person_get_snapshot_schema ()
+{
+    static const OGDSnapshotSchema schema = {
+        G_N_ELEMENTS (PersonSnapshotKinds),
+        PersonSnapshotKinds,
+        ogd_person_to_snapshot,
+        ogd_person_fill_by_snapshot
+    };
+
+    return &schema;
+}
+
 /**
  * ogd_person_get_id:
  * @person:         the #OGDPerson to query
@@ -640,7 +766,9 @@ const gchar* ogd_person_get_profile_page (OGDPerson *person)
  * Retrieve list of friends registered for the specified @person. Please note that this call
  * requires some syncronous communication with the server, so may return after some time
  *
- * Return value:    list of #OGDPerson, one for each friend of the target @person
+ * Return value:    list of #OGDPerson, one for each friend of the target @person, or NULL if some
+ *                  of them cannot be retrieved. The reason is available with
+ *                  ogd_provider_get_last_error()
  */
 const GList* ogd_person_get_friends (OGDPerson *person)
 {
@@ -648,17 +776,40 @@ const GList* ogd_person_get_friends (OGDPerson *person)
     GList *ret;
 
     query = g_strdup_printf ("friend/data/%s", ogd_person_get_id (person));
-    ret = list_of_people (OGD_OBJECT (person), query);
+    ret = list_of_people (OGD_OBJECT (person), query, NULL);
     g_free (query);
     return ret;
 }
 
+/*
+    req->total is the number of pending operations: one for each page of the listing, plus one for
+    each friend to fill. The final NULL is passed when all of them are completed, successfully or
+    not, and persons still in req->list at that time are the ones failed to be retrieved
+*/
+static void friends_request_done (AsyncRequestDesc *req)
+{
+    req->counter += 1;
+
+    if (req->counter < req->total)
+        return;
+
+    FREE_LIST_OF_OBJECTS (req->list);
+    TRACED_CALLBACK ("callback", req->callback (NULL, req->userdata));
+    g_free (req);
+}
+
 static void pass_friend_up (OGDObject *obj, gpointer userdata)
 {
     AsyncRequestDesc *req;
 
     req = (AsyncRequestDesc*) userdata;
-    req->callback (obj, req->userdata);
+
+    if (obj != NULL) {
+        req->list = g_list_remove (req->list, obj);
+        TRACED_CALLBACK ("callback", req->callback (obj, req->userdata));
+    }
+
+    friends_request_done (req);
 }
 
 static void retrieve_friends_slice (xmlNode *node, gpointer userdata)
@@ -670,48 +821,62 @@ static void retrieve_friends_slice (xmlNode *node, gpointer userdata)
     req = (AsyncRequestDesc*) userdata;
 
     if (node == NULL) {
-        if (req->total <= req->counter) {
-            req->callback (NULL, req->userdata);
-            g_free (req);
-        }
-        else
-            return;
+        friends_request_done (req);
     }
     else {
         friend_id = xmlNodeGetContent (node);
 
         if (friend_id != NULL) {
-            obj = g_object_new (OGD_PERSON_TYPE, NULL);
-            ogd_object_set_provider (OGD_OBJECT (obj), req->provider);
-            ogd_object_fill_by_id_async (OGD_OBJECT (obj), (char*) friend_id, pass_friend_up, req);
+            obj = (OGDPerson*) ogd_provider_lookup_object (req->provider, OGD_PERSON_TYPE, (char*) friend_id);
+            req->total += 1;
+
+            if (obj != NULL) {
+                req->list = g_list_prepend (req->list, obj);
+                pass_friend_up (OGD_OBJECT (obj), req);
+            }
+            else {
+                obj = g_object_new (OGD_PERSON_TYPE, NULL);
+                ogd_object_set_provider (OGD_OBJECT (obj), req->provider);
+                req->list = g_list_prepend (req->list, obj);
+                fill_by_id_async_full (OGD_OBJECT (obj), (char*) friend_id, OGD_PROVIDER_PRIORITY_NORMAL, req,
+                                       pass_friend_up, req);
+            }
+
             xmlFree (friend_id);
-            req->counter += 1;
         }
     }
 }
 
 static void init_friends_async_rebuild (xmlNode *node, gpointer userdata)
 {
-    int tot;
     int page;
+    gulong tot;
+    gulong friends;
     gchar *query;
     AsyncRequestDesc *req;
 
     req = (AsyncRequestDesc*) userdata;
+    friends = 0;
 
-    if (node == NULL) {
-        req->callback (NULL, req->userdata);
+    if (node != NULL) {
+        friends = total_items_for_query (node);
+        xmlFreeDoc (node->doc);
+    }
+
+    if (friends == 0) {
+        TRACED_CALLBACK ("callback", req->callback (NULL, req->userdata));
         g_free (req);
+        return;
     }
-    else {
-        req->total = total_items_for_query (node);
-        req->counter = 0;
 
-        for (page = 0, tot = 0; tot < req->total; page++, tot += 100) {
-            query = g_strdup_printf ("friend/data/%s?pagesize=%d&page=%d", ogd_person_get_id (OGD_PERSON (req->reference)), 100, page);
-            ogd_provider_get_raw_async (req->provider, query, TRUE, retrieve_friends_slice, req);
-            g_free (query);
-        }
+    req->total = (friends + 99) / 100;
+    req->counter = 0;
+
+    for (page = 0, tot = 0; tot < friends; page++, tot += 100) {
+        query = g_strdup_printf ("friend/data/%s?pagesize=%d&page=%d", ogd_person_get_id (OGD_PERSON (req->reference)), 100, page);
+        ogd_provider_get_raw_async_full (req->provider, query, TRUE, OGD_PROVIDER_PRIORITY_NORMAL, req,
+                                         retrieve_friends_slice, req);
+        g_free (query);
     }
 }
 
@@ -738,7 +903,8 @@ void ogd_person_get_friends_async (OGDPerson *person, OGDAsyncCallback callback,
     req->reference = OGD_OBJECT (person);
 
     query = g_strdup_printf ("friend/data/%s?pagesize=%d&page=%d", ogd_person_get_id (person), 1, 0);
-    ogd_provider_get_raw_async (provider, query, FALSE, init_friends_async_rebuild, req);
+    ogd_provider_get_raw_async_full (provider, query, FALSE, OGD_PROVIDER_PRIORITY_NORMAL, req,
+                                     init_friends_async_rebuild, req);
     g_free (query);
 }
 
@@ -781,6 +947,102 @@ void ogd_person_get_myself_async (OGDProvider *provider, OGDAsyncCallback callba
     ogd_provider_get_single_async (provider, "person/self", callback, userdata);
 }
 
+typedef struct {
+    OGDProvider         *provider;
+    guint               account;
+    OGDMyselfIdCallback callback;
+    gpointer            userdata;
+} MyselfIdRequest;
+
+/*
+    If the user changed since @account the ID is not kept, and the one of @myself is returned
+*/
+static const gchar* remember_myself_id (OGDProvider *provider, guint account, OGDPerson *myself)
+{
+    const gchar *ret;
+
+    ret = ogd_provider_set_myself_id (provider, account, ogd_person_get_id (myself));
+    if (ret == NULL)
+        ret = ogd_person_get_id (myself);
+
+    return ret;
+}
+
+/*
+    ID of the current user on @provider, requested to the server only the first time and then kept
+    along with the provider until its credentials change. NULL if it cannot be retrieved
+*/
+const gchar* ogd_person_get_myself_id (OGDProvider *provider)
+{
+    const gchar *ret;
+    OGDPerson *myself;
+
+    ret = ogd_provider_get_myself_id (provider);
+    if (ret != NULL)
+        return ret;
+
+    myself = ogd_person_get_myself (provider);
+    if (myself == NULL)
+        return NULL;
+
+    ret = remember_myself_id (provider, ogd_provider_get_account (provider), myself);
+    g_object_unref (myself);
+    return ret;
+}
+
+static void myself_id_received (GList *list, const GError *error, gpointer userdata)
+{
+    const gchar *id;
+    GError *missing;
+    MyselfIdRequest *req;
+
+    req = (MyselfIdRequest*) userdata;
+    id = NULL;
+    missing = NULL;
+
+    if (list != NULL)
+        id = remember_myself_id (req->provider, req->account, OGD_PERSON (list->data));
+    else if (error == NULL)
+        error = missing = g_error_new (OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                                       "Unable to retrieve current user on the server");
+
+    req->callback (id, error, req->userdata);
+
+    g_list_foreach (list, (GFunc) g_object_unref, NULL);
+    g_list_free (list);
+
+    if (missing != NULL)
+        g_error_free (missing);
+
+    g_free (req);
+}
+
+/*
+    Async version of ogd_person_get_myself_id(). When the ID is already known @callback is invoked
+    before this function returns
+*/
+void ogd_person_get_myself_id_async (OGDProvider *provider, OGDMyselfIdCallback callback, gpointer userdata)
+{
+    const gchar *id;
+    MyselfIdRequest *req;
+
+    id = ogd_provider_get_myself_id (provider);
+
+    if (id != NULL) {
+        callback (id, NULL, userdata);
+        return;
+    }
+
+    req = g_new0 (MyselfIdRequest, 1);
+    req->provider = provider;
+    req->account = ogd_provider_get_account (provider);
+    req->callback = callback;
+    req->userdata = userdata;
+
+    ogd_provider_get_list_async_full (provider, "person/self", OGD_PROVIDER_PRIORITY_INTERACTIVE, req,
+                                      myself_id_received, req);
+}
+
 static void effective_set_coordinates (OGDPerson *myself, gdouble latitude, gdouble longitude,
                                        gboolean async, OGDPutAsyncCallback callback, gpointer userdata)
 {
@@ -887,11 +1149,13 @@ void ogd_person_myself_invite_friend_async (OGDPerson *person, gchar *message, O
  *
  * Retrieves list of current pending requests for friendship
  *
- * Return value:    a list of #OGDPerson, or NULL
+ * Return value:    a list of #OGDPerson, or NULL. NULL is also returned if some of the persons
+ *                  cannot be retrieved, and the reason is available with
+ *                  ogd_provider_get_last_error()
  */
 GList* ogd_person_myself_pending_friends (OGDPerson *person)
 {
-    return list_of_people (OGD_OBJECT (person), "friend/receivedinvitations");
+    return list_of_people (OGD_OBJECT (person), "friend/receivedinvitations", NULL);
 }
 
 /**
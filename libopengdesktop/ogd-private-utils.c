@@ -15,9 +15,12 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <time.h>
+
 #include "ogd.h"
 #include "ogd-provider-private.h"
 #include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
 
 static GHashTable       *TypesMap           = NULL;
 
@@ -43,13 +46,108 @@ gdouble node_to_double (xmlNode *node)
     return ret;
 }
 
+/*
+    Monotonic time, to measure intervals: it never jumps back or forth when the system clock is
+    changed, but has no meaning outside the running process
+*/
+gint64 current_usec ()
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return ((gint64) now.tv_sec * G_USEC_PER_SEC) + (now.tv_nsec / 1000);
+}
+
+/*
+    Time since the Epoch, for the timestamps saved on disk and compared across runs
+*/
+gint64 wall_clock_usec ()
+{
+    GTimeVal now;
+
+    g_get_current_time (&now);
+    return ((gint64) now.tv_sec * G_USEC_PER_SEC) + now.tv_usec;
+}
+
+/*
+    The path of a message is something like /v1/content/data/1234, where the first part may
+    change if the provider is hosted in a subdirectory: all is skipped up to the version of the
+    API, and the remaining query (with parameters) is returned as it would be passed to
+    ogd_provider_get()
+*/
+gchar* message_to_query (SoupMessage *msg)
+{
+    const gchar *path;
+    const gchar *cursor;
+    SoupURI *uri;
+
+    uri = soup_message_get_uri (msg);
+    path = uri->path;
+
+    for (cursor = uri->path; *cursor != '\0'; cursor++) {
+        if (cursor [0] == '/' && cursor [1] == 'v' && g_ascii_isdigit (cursor [2])) {
+            for (cursor += 2; g_ascii_isdigit (*cursor); cursor++);
+
+            if (*cursor == '/') {
+                path = cursor + 1;
+                break;
+            }
+        }
+    }
+
+    while (*path == '/')
+        path++;
+
+    if (uri->query != NULL)
+        return g_strdup_printf ("%s?%s", path, uri->query);
+    else
+        return g_strdup (path);
+}
+
+/*
+    Content of the node is copied into the current arena, if any, avoiding to allocate it with
+    xmlNodeGetContent() when it is made of a single text node, as for most fields. Returned string
+    has always to be freed with ARENA_CHECK_FREE_NULLIFY() or ogd_arena_release()
+*/
+gchar* node_to_string (xmlNode *node)
+{
+    gchar *ret;
+    xmlChar *tmp;
+    OGDArena *arena;
+
+    arena = ogd_arena_get_current ();
+    if (arena == NULL)
+        return (gchar*) xmlNodeGetContent (node);
+
+    if (node->children == NULL)
+        return ogd_arena_strndup (arena, "", 0);
+
+    if (node->children->next == NULL && node->children->type == XML_TEXT_NODE && node->children->content != NULL)
+        return ogd_arena_strndup (arena, (gchar*) node->children->content, strlen ((char*) node->children->content));
+
+    tmp = xmlNodeGetContent (node);
+    ret = ogd_arena_strndup (arena, (gchar*) tmp, strlen ((char*) tmp));
+    xmlFree (tmp);
+    return ret;
+}
+
 GDate* node_to_date (xmlNode *node)
 {
     GTimeVal timeval;
     GDate *ret;
     xmlChar *tmp;
+    OGDArena *arena;
+
+    arena = ogd_arena_get_current ();
+
+    if (arena != NULL) {
+        ret = ogd_arena_alloc (arena, sizeof (GDate));
+        g_date_clear (ret, 1);
+    }
+    else {
+        ret = g_date_new ();
+    }
 
-    ret = g_date_new ();
     tmp = xmlNodeGetContent (node);
 
     if (g_time_val_from_iso8601 ((char*) tmp, &timeval))
@@ -59,6 +157,46 @@ GDate* node_to_date (xmlNode *node)
     return ret;
 }
 
+/*
+    Seconds since the Epoch, or 0 if the node does not contain a valid ISO 8601 date
+*/
+gint64 node_to_time (xmlNode *node)
+{
+    gint64 ret;
+    GTimeVal timeval;
+    xmlChar *tmp;
+
+    tmp = xmlNodeGetContent (node);
+
+    if (g_time_val_from_iso8601 ((char*) tmp, &timeval))
+        ret = timeval.tv_sec;
+    else
+        ret = 0;
+
+    xmlFree (tmp);
+    return ret;
+}
+
+/*
+    Reads the ID assigned by the server to a new item from the response to "content/add" or
+    "event/add", in which @element is "content" or "event". Returns NULL if not found
+*/
+gchar* id_from_add_response (xmlNode *response, const gchar *element)
+{
+    gchar *ret;
+    xmlChar *tmp;
+
+    if (response == NULL || MYSTRCMP (response->name, "data") != 0 || response->children == NULL ||
+            MYSTRCMP (response->children->name, element) != 0 || response->children->children == NULL ||
+            MYSTRCMP (response->children->children->name, "id") != 0)
+        return NULL;
+
+    tmp = xmlNodeGetContent (response->children->children);
+    ret = g_strdup ((gchar*) tmp);
+    xmlFree (tmp);
+    return ret;
+}
+
 gulong total_items_for_query (xmlNode *package)
 {
     gulong ret;
@@ -85,13 +223,20 @@ gulong total_items_for_query (xmlNode *package)
     return ret;
 }
 
-GList* list_of_people (OGDObject *reference, gchar *query)
+/*
+    A single person which cannot be retrieved makes the whole list fail, as a page which cannot
+    be fetched: a shorter list would not be distinguishable from the complete one. The error is
+    also kept as the last error of the provider
+*/
+GList* list_of_people (OGDObject *reference, gchar *query, GError **error)
 {
     gulong collected;
     gulong totalitems;
+    gulong found;
     gint page;
     gchar *complete_query;
     GList *ret;
+    GError *failure;
     xmlChar *friend_id;
     xmlNode *data;
     xmlNode *cursor;
@@ -99,6 +244,7 @@ GList* list_of_people (OGDObject *reference, gchar *query)
     OGDProvider *provider;
 
     ret = NULL;
+    failure = NULL;
     collected = 0;
     totalitems = 0;
     page = 0;
@@ -106,36 +252,65 @@ GList* list_of_people (OGDObject *reference, gchar *query)
 
     do {
         complete_query = g_strdup_printf ("%s?pagesize=100&page=%d", query, page);
-        data = ogd_provider_get_raw (provider, complete_query, NULL);
+        data = ogd_provider_get_raw (provider, complete_query, &failure);
         g_free (complete_query);
 
-        if (data != NULL) {
-            totalitems = total_items_for_query (data);
+        if (data == NULL) {
+            if (failure == NULL)
+                failure = g_error_new (OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                                       "Unable to retrieve page %d of %s", page, query);
+            break;
+        }
+
+        found = 0;
+        totalitems = total_items_for_query (data);
 
-            for (cursor = data->children; cursor; cursor = cursor->next) {
-                friend_id = xmlNodeGetContent (cursor->children);
+        for (cursor = data->children; cursor && failure == NULL; cursor = cursor->next) {
+            friend_id = xmlNodeGetContent (cursor->children);
+            if (friend_id == NULL)
+                continue;
 
-                if (friend_id != NULL) {
-                    obj = g_object_new (OGD_PERSON_TYPE, NULL);
-                    ogd_object_set_provider (OGD_OBJECT (obj), provider);
+            /*
+                Persons already alive are reused as they are, when the identity map is enabled in
+                the provider
+            */
+            obj = (OGDPerson*) ogd_provider_lookup_object (provider, OGD_PERSON_TYPE, (char*) friend_id);
 
-                    if (ogd_object_fill_by_id (OGD_OBJECT (obj), (char*) friend_id, NULL) == TRUE) {
-                        ret = g_list_prepend (ret, obj);
-                    }
-                    else {
-                        g_warning ("Unable to retrieve person with ID %s.", (char*) friend_id);
-                    }
+            if (obj == NULL) {
+                obj = g_object_new (OGD_PERSON_TYPE, NULL);
+                ogd_object_set_provider (OGD_OBJECT (obj), provider);
 
-                    xmlFree (friend_id);
-                    collected++;
+                if (ogd_object_fill_by_id (OGD_OBJECT (obj), (char*) friend_id, &failure) == FALSE) {
+                    if (failure == NULL)
+                        failure = g_error_new (OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                                               "Unable to retrieve person with ID %s", (char*) friend_id);
+
+                    OBJ_CHECK_UNREF_NULLIFY (obj);
                 }
             }
 
-            xmlFreeDoc (data->doc);
-            page++;
+            if (obj != NULL)
+                ret = g_list_prepend (ret, obj);
+
+            xmlFree (friend_id);
+            found++;
         }
 
-    } while (collected < totalitems);
+        xmlFreeDoc (data->doc);
+        collected += found;
+        page++;
+
+        /*
+            An empty page before the expected total would be requested again forever
+        */
+    } while (failure == NULL && found != 0 && collected < totalitems);
+
+    if (failure != NULL) {
+        FREE_LIST_OF_OBJECTS (ret);
+        ogd_provider_set_last_error (provider, failure);
+        g_propagate_error (error, failure);
+        return NULL;
+    }
 
     if (ret != NULL)
         ret = g_list_reverse (ret);
@@ -143,20 +318,47 @@ GList* list_of_people (OGDObject *reference, gchar *query)
     return ret;
 }
 
+/*
+    request->total is the number of pending operations: the listing itself, plus one for each
+    person to fill. The list is delivered when all of them are completed: if any failed, the whole
+    operation fails and NULL is delivered, with the reason available from
+    ogd_provider_get_last_error()
+*/
+static void people_request_done (AsyncRequestDesc *request)
+{
+    request->counter += 1;
+
+    if (request->counter < request->total)
+        return;
+
+    if (request->failure != NULL) {
+        FREE_LIST_OF_OBJECTS (request->list);
+        request->list = NULL;
+        ogd_provider_set_last_error (request->provider, request->failure);
+        g_error_free (request->failure);
+    }
+
+    TRACED_CALLBACK ("callback", request->lcallback (g_list_reverse (request->list), request->userdata));
+    g_free (request);
+}
+
 void put_person_in_list (OGDObject *obj, gpointer userdata)
 {
     AsyncRequestDesc *request;
 
     request = (AsyncRequestDesc*) userdata;
-    request->list = g_list_prepend (request->list, obj);
 
-    if (g_list_length (request->list) == request->total) {
-        request->lcallback (request->list, request->userdata);
-        g_free (request);
-    }
+    /*
+        The person itself is already in the list, and is released with it
+    */
+    if (obj == NULL && request->failure == NULL)
+        request->failure = g_error_new (OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                                        "Unable to retrieve a person of the list");
+
+    people_request_done (request);
 }
 
-void fill_people_in_list (xmlNode *node, gpointer userdata)
+void fill_people_in_list (xmlNode *node, const GError *error, gpointer userdata)
 {
     xmlChar *friend_id;
     AsyncRequestDesc *request;
@@ -168,18 +370,27 @@ void fill_people_in_list (xmlNode *node, gpointer userdata)
         request->total += 1;
 
         friend_id = xmlNodeGetContent (node);
+        obj = (OGDPerson*) ogd_provider_lookup_object (request->provider, OGD_PERSON_TYPE, (char*) friend_id);
 
-        obj = g_object_new (OGD_PERSON_TYPE, NULL);
-        ogd_object_set_provider (OGD_OBJECT (obj), request->provider);
-        ogd_object_fill_by_id_async (OGD_OBJECT (obj), (char*) friend_id, put_person_in_list, request);
+        if (obj != NULL) {
+            request->list = g_list_prepend (request->list, obj);
+            put_person_in_list (OGD_OBJECT (obj), request);
+        }
+        else {
+            obj = g_object_new (OGD_PERSON_TYPE, NULL);
+            ogd_object_set_provider (OGD_OBJECT (obj), request->provider);
+            request->list = g_list_prepend (request->list, obj);
+            fill_by_id_async_full (OGD_OBJECT (obj), (char*) friend_id, OGD_PROVIDER_PRIORITY_NORMAL, request,
+                                   put_person_in_list, request);
+        }
 
         xmlFree (friend_id);
     }
     else {
-        if (request->total == 0) {
-            request->lcallback (NULL, request->userdata);
-            g_free (request);
-        }
+        if (error != NULL && request->failure == NULL)
+            request->failure = g_error_copy (error);
+
+        people_request_done (request);
     }
 }
 
@@ -197,12 +408,430 @@ void list_of_people_async (OGDObject *reference, gchar *query, OGDAsyncListCallb
     request->provider = ogd_object_get_provider (reference);
     request->lcallback = callback;
     request->userdata = userdata;
+    request->total = 1;
 
     complete_query = g_strdup_printf ("%s?pagesize=100&page=%d", query, page);
-    ogd_provider_get_raw_async (provider, complete_query, TRUE, fill_people_in_list, request);
+    ogd_provider_get_raw_list_async_full (provider, complete_query, OGD_PROVIDER_PRIORITY_NORMAL, request,
+                                          fill_people_in_list, request);
     g_free (complete_query);
 }
 
+typedef struct {
+    OGDObject               *obj;
+    gchar                   *owner;
+    gchar                   *query;
+    GHashTable              *params;
+    const gchar             *element;
+    guint                   fields;
+    OGDEditedCallback       edited;
+    OGDSaveAsyncCallback    callback;
+    gpointer                userdata;
+} EditRequestDesc;
+
+static void edit_request_done (EditRequestDesc *req, const GError *error)
+{
+    TRACED_CALLBACK ("callback", req->callback (req->obj, error, req->userdata));
+
+    g_object_unref (req->obj);
+    g_free (req->owner);
+    g_free (req->query);
+    if (req->params != NULL)
+        g_hash_table_unref (req->params);
+    g_free (req);
+}
+
+static void edit_response_received (xmlNode *response, const GError *error, gpointer userdata)
+{
+    gchar *id;
+    GError *missing;
+    EditRequestDesc *req;
+
+    req = (EditRequestDesc*) userdata;
+    id = NULL;
+    missing = NULL;
+
+    if (error == NULL && req->element != NULL) {
+        id = id_from_add_response (response, req->element);
+
+        if (id == NULL)
+            error = missing = g_error_new (OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
+                                           "Unable to retrieve ID for newly created %s", req->element);
+    }
+
+    if (error == NULL && req->edited != NULL)
+        req->edited (req->obj, req->fields, id);
+
+    edit_request_done (req, error);
+
+    if (missing != NULL)
+        g_error_free (missing);
+}
+
+static void send_edit_request (EditRequestDesc *req)
+{
+    ogd_provider_put_raw_async (ogd_object_get_provider (req->obj), req->query, req->params,
+                                edit_response_received, req);
+}
+
+static void edit_owner_checked (const gchar *myself, const GError *error, gpointer userdata)
+{
+    GError *denied;
+    EditRequestDesc *req;
+
+    req = (EditRequestDesc*) userdata;
+
+    if (error != NULL) {
+        edit_request_done (req, error);
+    }
+    else if (req->owner == NULL || strcmp (req->owner, myself) != 0) {
+        denied = g_error_new (OGD_EDIT_ERROR_DOMAIN, OGD_EDIT_ERROR, "No permissions to edit the %s",
+                              G_OBJECT_TYPE_NAME (req->obj));
+        edit_request_done (req, denied);
+        g_error_free (denied);
+    }
+    else {
+        send_edit_request (req);
+    }
+}
+
+/*
+    Sends @query with @params on behalf of @obj without blocking. If @obj already has an ID it is
+    first verified that @owner is the current user, asking it to the server only the first time.
+    When @element is not NULL the response is expected to contain the ID of the new item.
+    If the request succeeds @edited receives @fields, the mask of fields sent with @params, and the
+    ID of the new item, if any, before @callback is invoked.
+    @obj is referenced until @callback is invoked, and so are @params, whose values may so be
+    borrowed from @obj
+*/
+void edit_object_async (OGDObject *obj, const gchar *owner, gchar *query, GHashTable *params, const gchar *element,
+                        guint fields, OGDEditedCallback edited, OGDSaveAsyncCallback callback, gpointer userdata)
+{
+    EditRequestDesc *req;
+
+    req = g_new0 (EditRequestDesc, 1);
+    req->obj = g_object_ref (obj);
+    req->owner = g_strdup (owner);
+    req->query = g_strdup (query);
+    req->params = (params != NULL) ? g_hash_table_ref (params) : NULL;
+    req->element = element;
+    req->fields = fields;
+    req->edited = edited;
+    req->callback = callback;
+    req->userdata = userdata;
+
+    if (ogd_object_get_id (obj) == NULL)
+        send_edit_request (req);
+    else
+        ogd_person_get_myself_id_async (ogd_object_get_provider (obj), edit_owner_checked, req);
+}
+
+typedef struct {
+    OGDProvider             *provider;
+    gpointer                caller;
+    OGDPageQueryFunc        query;
+    OGDPageFunc             process;
+    OGDPagesDoneFunc        done;
+    gpointer                run;
+} PagedFetchDesc;
+
+/*
+    Requests the pages of @run one after the other, until @process finds nothing more to fetch
+    or a request fails. @run is never touched here: it is up to @process to advance to the next
+    page, and up to the caller to commit the state collected in @run, only if this returns TRUE
+    so that after a failure the next run fetches again the same items and nothing is lost
+*/
+gboolean fetch_pages (OGDProvider *provider, OGDPageQueryFunc query, OGDPageFunc process, gpointer run,
+                      GError **error)
+{
+    gboolean more;
+    gchar *complete_query;
+    GList *list;
+    GError *page_error;
+
+    page_error = NULL;
+
+    do {
+        complete_query = query (run);
+        list = ogd_provider_get_full (provider, complete_query, &page_error);
+        g_free (complete_query);
+
+        if (page_error != NULL) {
+            g_propagate_error (error, page_error);
+            return FALSE;
+        }
+
+        more = process (list, run);
+    } while (more == TRUE);
+
+    return TRUE;
+}
+
+static void send_page_request (PagedFetchDesc *fetch);
+
+static void page_received (GList *list, const GError *error, gpointer userdata)
+{
+    PagedFetchDesc *fetch;
+
+    fetch = (PagedFetchDesc*) userdata;
+
+    if (error == NULL && fetch->process (list, fetch->run) == TRUE) {
+        send_page_request (fetch);
+        return;
+    }
+
+    fetch->done (fetch->run, error);
+    g_free (fetch);
+}
+
+static void send_page_request (PagedFetchDesc *fetch)
+{
+    gchar *complete_query;
+
+    complete_query = fetch->query (fetch->run);
+    ogd_provider_get_list_async_full (fetch->provider, complete_query, OGD_PROVIDER_PRIORITY_BULK, fetch->caller,
+                                      page_received, fetch);
+    g_free (complete_query);
+}
+
+/*
+    Async version of fetch_pages(): pages are requested with OGD_PROVIDER_PRIORITY_BULK priority
+    on behalf of @caller, and @done is invoked at the end with the error of the failed request, if
+    any, to commit or discard the state collected in @run
+*/
+void fetch_pages_async (OGDProvider *provider, gpointer caller, OGDPageQueryFunc query, OGDPageFunc process,
+                        OGDPagesDoneFunc done, gpointer run)
+{
+    PagedFetchDesc *fetch;
+
+    fetch = g_new0 (PagedFetchDesc, 1);
+    fetch->provider = provider;
+    fetch->caller = caller;
+    fetch->query = query;
+    fetch->process = process;
+    fetch->done = done;
+    fetch->run = run;
+    send_page_request (fetch);
+}
+
+typedef struct {
+    const OGDChangesFeed    *feed;
+    gchar                   *query;
+    gint64                  watermark;
+    gint64                  newest;
+    guint                   page;
+    gulong                  changed;
+    gpointer                run;
+} ChangesFetchDesc;
+
+static ChangesFetchDesc* new_changes_fetch (const OGDChangesFeed *feed, const gchar *query, gint64 watermark,
+                                            gpointer run)
+{
+    ChangesFetchDesc *fetch;
+
+    fetch = g_new0 (ChangesFetchDesc, 1);
+    fetch->feed = feed;
+    fetch->query = g_strdup (query);
+    fetch->watermark = watermark;
+    fetch->newest = watermark;
+    fetch->run = run;
+    return fetch;
+}
+
+static void free_changes_fetch (ChangesFetchDesc *fetch)
+{
+    g_free (fetch->query);
+    g_free (fetch);
+}
+
+static gchar* changes_query (gpointer userdata)
+{
+    ChangesFetchDesc *fetch;
+
+    fetch = (ChangesFetchDesc*) userdata;
+    return g_strdup_printf ("%s&page=%u&pagesize=%u", fetch->query, fetch->page, fetch->feed->pagesize);
+}
+
+/*
+    Items changed exactly at the time of the watermark are passed again, since others may have
+    changed in the same second after the previous fetch
+*/
+static gboolean process_changes (GList *list, gpointer userdata)
+{
+    guint count;
+    gint64 time;
+    gboolean older;
+    GList *iter;
+    ChangesFetchDesc *fetch;
+
+    fetch = (ChangesFetchDesc*) userdata;
+    count = 0;
+    older = FALSE;
+
+    for (iter = list; iter; iter = g_list_next (iter)) {
+        count++;
+
+        if (fetch->feed->time (iter->data, &time) == TRUE) {
+            if (time != 0 && time < fetch->watermark) {
+                older = TRUE;
+            }
+            else {
+                fetch->feed->change (iter->data, fetch->run);
+                fetch->changed++;
+                fetch->newest = MAX (fetch->newest, time);
+            }
+        }
+
+        g_object_unref (iter->data);
+    }
+
+    g_list_free (list);
+    fetch->page++;
+
+    return (older == FALSE && count == fetch->feed->pagesize);
+}
+
+/*
+    Fetches the items of @query, which has to sort them from the most recently changed, until one
+    older than @watermark is found. Each changed item is passed to the change function of @feed,
+    together with @run. @newest is filled with the most recent time of change seen, never older
+    than @watermark, to be used as the next watermark only if this returns TRUE
+*/
+gboolean fetch_changes (OGDProvider *provider, const gchar *query, const OGDChangesFeed *feed, gint64 watermark,
+                        gpointer run, gint64 *newest, gulong *changed, GError **error)
+{
+    gboolean ret;
+    ChangesFetchDesc *fetch;
+
+    fetch = new_changes_fetch (feed, query, watermark, run);
+    ret = fetch_pages (provider, changes_query, process_changes, fetch, error);
+    *newest = fetch->newest;
+    *changed = fetch->changed;
+    free_changes_fetch (fetch);
+    return ret;
+}
+
+static void changes_fetched (gpointer userdata, const GError *error)
+{
+    ChangesFetchDesc *fetch;
+
+    fetch = (ChangesFetchDesc*) userdata;
+    fetch->feed->done (fetch->run, fetch->newest, fetch->changed, error);
+    free_changes_fetch (fetch);
+}
+
+/*
+    Async version of fetch_changes(): the outcome is passed to the done function of @feed
+*/
+void fetch_changes_async (OGDProvider *provider, const gchar *query, const OGDChangesFeed *feed, gint64 watermark,
+                          gpointer run)
+{
+    ChangesFetchDesc *fetch;
+
+    fetch = new_changes_fetch (feed, query, watermark, run);
+    fetch_pages_async (provider, run, changes_query, process_changes, changes_fetched, fetch);
+}
+
+void poll_timer_init (OGDPollTimer *timer, guint min_interval, guint max_interval, OGDPollFunc poll, gpointer owner)
+{
+    memset (timer, 0, sizeof (OGDPollTimer));
+    timer->min_interval = min_interval;
+    timer->max_interval = max_interval;
+    timer->interval = min_interval;
+    timer->poll = poll;
+    timer->owner = owner;
+}
+
+void poll_timer_set_intervals (OGDPollTimer *timer, guint min_interval, guint max_interval)
+{
+    timer->min_interval = MAX (min_interval, 1);
+    timer->max_interval = MAX (max_interval, timer->min_interval);
+    timer->interval = CLAMP (timer->interval, timer->min_interval, timer->max_interval);
+}
+
+/*
+    Failed polls also make the interval longer, to not insist with an unreachable server
+*/
+void poll_timer_adapt (OGDPollTimer *timer, gulong received)
+{
+    if (received != 0)
+        timer->interval = timer->min_interval;
+    else
+        timer->interval = MIN (timer->interval * 2, timer->max_interval);
+}
+
+static void run_poll (OGDPollTimer *timer)
+{
+    timer->polling = TRUE;
+    timer->poll (timer->owner);
+}
+
+static gboolean poll_timeout (gpointer userdata)
+{
+    OGDPollTimer *timer;
+
+    timer = (OGDPollTimer*) userdata;
+    timer->source = 0;
+    run_poll (timer);
+    return FALSE;
+}
+
+void poll_timer_start (OGDPollTimer *timer)
+{
+    if (timer->started == TRUE)
+        return;
+
+    timer->started = TRUE;
+
+    if (timer->polling == FALSE)
+        run_poll (timer);
+}
+
+void poll_timer_stop (OGDPollTimer *timer)
+{
+    timer->started = FALSE;
+
+    if (timer->source != 0) {
+        g_source_remove (timer->source);
+        timer->source = 0;
+    }
+}
+
+/*
+    Stops @timer, and returns TRUE if its owner can be destroyed immediately. Otherwise a poll is
+    running, and the owner has to be destroyed when poll_timer_done() says so
+*/
+gboolean poll_timer_dispose (OGDPollTimer *timer)
+{
+    poll_timer_stop (timer);
+
+    if (timer->polling == TRUE) {
+        timer->disposed = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+    To be called at the end of each poll started by @timer, with the number of items it reported.
+    Schedules the next poll, or returns TRUE if the owner has been disposed meanwhile and has now
+    to be destroyed
+*/
+gboolean poll_timer_done (OGDPollTimer *timer, gulong received)
+{
+    timer->polling = FALSE;
+
+    if (timer->disposed == TRUE)
+        return TRUE;
+
+    poll_timer_adapt (timer, received);
+
+    if (timer->started == TRUE && timer->source == 0)
+        timer->source = g_timeout_add_seconds (timer->interval, poll_timeout, timer);
+
+    return FALSE;
+}
+
 void init_types_management ()
 {
     GType type;
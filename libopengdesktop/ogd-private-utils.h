@@ -19,6 +19,7 @@
 #define OGD_PRIVATE_UTILS_H
 
 #include "ogd-provider-private.h"
+#include "ogd-arena.h"
 
 #define PTR_CHECK_FREE_NULLIFY(__ptr) {     \
     if (__ptr != NULL) {                    \
@@ -27,6 +28,16 @@
     }                                       \
 }
 
+/*
+    For fields of objects, which may have been filled from an arena
+*/
+#define ARENA_CHECK_FREE_NULLIFY(__ptr) {   \
+    if (__ptr != NULL) {                    \
+        ogd_arena_release (__ptr);          \
+        __ptr = NULL;                       \
+    }                                       \
+}
+
 #define OBJ_CHECK_UNREF_NULLIFY(__ptr) {    \
     if (__ptr != NULL) {                    \
         g_object_unref (__ptr);             \
@@ -34,11 +45,12 @@
     }                                       \
 }
 
-#define DATE_CHECK_FREE_NULLIFY(__date) {   \
-    if (__date != NULL) {                   \
-        g_date_free (__date);               \
-        __date = NULL;                      \
-    }                                       \
+#define DATE_CHECK_FREE_NULLIFY(__date) {       \
+    if (__date != NULL) {                       \
+        if (ogd_arena_owns (__date) == FALSE)   \
+            g_date_free (__date);               \
+        __date = NULL;                          \
+    }                                           \
 }
 
 #define STRLIST_CHECK_FREE_NULLIFY(__ptr) {                                         \
@@ -51,6 +63,16 @@
     }                                                                               \
 }
 
+#define ARENA_STRLIST_CHECK_FREE_NULLIFY(__ptr) {                                   \
+    if (__ptr != NULL) {                                                            \
+        GList *__iter;                                                              \
+        for (__iter = g_list_first (__ptr); __iter; __iter = g_list_next (__iter))  \
+            ogd_arena_release (__iter->data);                                       \
+        g_list_free (__ptr);                                                        \
+        __ptr = NULL;                                                               \
+    }                                                                               \
+}
+
 #define FREE_LIST_OF_OBJECTS(__list) {                                  \
     GList *__iter;                                                      \
                                                                         \
@@ -72,7 +94,7 @@
 })
 
 #define SET_STRING(__obj, __field, __value) {             \
-    PTR_CHECK_FREE_NULLIFY (__obj->priv->__field);        \
+    ARENA_CHECK_FREE_NULLIFY (__obj->priv->__field);      \
     __obj->priv->__field = g_strdup (__value);            \
 }
 
@@ -82,7 +104,57 @@
 }
 
 #define MYSTRCMP(__a,__b)       strcmp ((char*) __a, (char*) __b)
-#define MYGETCONTENT(__a)       (char*) xmlNodeGetContent(__a)
+#define MYGETCONTENT(__a)       node_to_string (__a)
+
+typedef void (*OGDMyselfIdCallback) (const gchar *id, const GError *error, gpointer userdata);
+typedef void (*OGDEditedCallback) (OGDObject *obj, guint fields, gchar *id);
+typedef void (*OGDFolderIdCallback) (const gchar *id, gpointer userdata);
+typedef const gchar* (*OGDObjectIdFunc) (OGDObject *obj);
+
+/*
+    Functions driving fetch_pages(): OGDPageQueryFunc builds the query for the current page of the
+    run, OGDPageFunc consumes the list received for it and returns TRUE if the following page has
+    to be requested
+*/
+typedef gchar* (*OGDPageQueryFunc) (gpointer run);
+typedef gboolean (*OGDPageFunc) (GList *list, gpointer run);
+typedef void (*OGDPagesDoneFunc) (gpointer run, const GError *error);
+
+/*
+    Describes a kind of items fetched with fetch_changes(): OGDChangeTimeFunc fills the time of
+    change of an item and returns FALSE if the item is not of the expected type, OGDChangeFunc
+    receives each changed item and OGDChangesDoneFunc the outcome of fetch_changes_async()
+*/
+typedef gboolean (*OGDChangeTimeFunc) (OGDObject *obj, gint64 *time);
+typedef void (*OGDChangeFunc) (OGDObject *obj, gpointer run);
+typedef void (*OGDChangesDoneFunc) (gpointer run, gint64 newest, gulong changed, const GError *error);
+
+typedef struct {
+    guint                       pagesize;
+    OGDChangeTimeFunc           time;
+    OGDChangeFunc               change;
+    OGDChangesDoneFunc          done;
+} OGDChangesFeed;
+
+typedef void (*OGDPollFunc) (gpointer owner);
+
+/*
+    Embedded in the objects polling periodically: it schedules the polls of the owner while
+    started, and tells when the owner freed during a poll can be destroyed
+*/
+typedef struct {
+    guint                       min_interval;
+    guint                       max_interval;
+    guint                       interval;
+    guint                       source;
+
+    gboolean                    started;
+    gboolean                    polling;
+    gboolean                    disposed;
+
+    OGDPollFunc                 poll;
+    gpointer                    owner;
+} OGDPollTimer;
 
 typedef struct {
     OGDProvider                 *provider;
@@ -96,19 +168,69 @@ typedef struct {
     OGDProviderRawAsyncCallback rcallback;
     OGDPutAsyncCallback         pcallback;
     OGDAsyncListCallback        lcallback;
+    OGDProviderListAsyncCallback ecallback;
+    OGDProviderPutRawAsyncCallback prcallback;
 
     gulong                      total;
     gulong                      counter;
+    gchar                       *query;
+    gboolean                    journaled;
+    GError                      *failure;
 } AsyncRequestDesc;
 
+gchar*      node_to_string              (xmlNode *node);
 GDate*      node_to_date                (xmlNode *node);
+gint64      node_to_time                (xmlNode *node);
 guint64     node_to_num                 (xmlNode *node);
 gdouble     node_to_double              (xmlNode *node);
+gint64      current_usec                ();
+gint64      wall_clock_usec             ();
+gchar*      message_to_query            (SoupMessage *msg);
 
 gulong      total_items_for_query       (xmlNode *package);
-GList*      list_of_people              (OGDObject *reference, gchar *query);
+GList*      list_of_people              (OGDObject *reference, gchar *query, GError **error);
 void        list_of_people_async        (OGDObject *reference, gchar *query, OGDAsyncListCallback callback, gpointer userdata);
 
+void        fill_by_id_async_full       (OGDObject *obj, const gchar *id, OGD_PROVIDER_PRIORITY priority, gpointer caller,
+                                         OGDAsyncCallback callback, gpointer userdata);
+const gchar* ogd_person_get_myself_id  (OGDProvider *provider);
+void        ogd_person_get_myself_id_async (OGDProvider *provider, OGDMyselfIdCallback callback, gpointer userdata);
+gchar*      id_from_add_response        (xmlNode *response, const gchar *element);
+const gchar* ogd_folder_get_id_by_category (OGDProvider *provider, OGD_FOLDER_CATEGORY category);
+void        ogd_folder_get_id_by_category_async (OGDProvider *provider, OGD_FOLDER_CATEGORY category,
+                                         OGDFolderIdCallback callback, gpointer userdata);
+OGDFolderDirectory* ogd_folder_directory_new ();
+void        ogd_folder_directory_reset  (OGDFolderDirectory *directory);
+void        ogd_folder_directory_free   (OGDFolderDirectory *directory);
+void        edit_object_async           (OGDObject *obj, const gchar *owner, gchar *query, GHashTable *params,
+                                         const gchar *element, guint fields, OGDEditedCallback edited,
+                                         OGDSaveAsyncCallback callback, gpointer userdata);
+
+OGDCommentTree* ogd_comment_tree_new    (OGDProvider *provider, guint target_type, const gchar *target_id);
+
+void        ogd_object_class_set_id_func (OGDObjectClass *klass, OGDObjectIdFunc func);
+void        ogd_object_attach_arena     (OGDObject *obj, OGDArena *arena);
+void        ogd_object_release_arena    (OGDObject *obj);
+
+gboolean    fetch_pages                 (OGDProvider *provider, OGDPageQueryFunc query, OGDPageFunc process, gpointer run,
+                                         GError **error);
+void        fetch_pages_async           (OGDProvider *provider, gpointer caller, OGDPageQueryFunc query, OGDPageFunc process,
+                                         OGDPagesDoneFunc done, gpointer run);
+
+gboolean    fetch_changes               (OGDProvider *provider, const gchar *query, const OGDChangesFeed *feed, gint64 watermark,
+                                         gpointer run, gint64 *newest, gulong *changed, GError **error);
+void        fetch_changes_async         (OGDProvider *provider, const gchar *query, const OGDChangesFeed *feed, gint64 watermark,
+                                         gpointer run);
+
+void        poll_timer_init             (OGDPollTimer *timer, guint min_interval, guint max_interval, OGDPollFunc poll,
+                                         gpointer owner);
+void        poll_timer_set_intervals    (OGDPollTimer *timer, guint min_interval, guint max_interval);
+void        poll_timer_adapt            (OGDPollTimer *timer, gulong received);
+void        poll_timer_start            (OGDPollTimer *timer);
+void        poll_timer_stop             (OGDPollTimer *timer);
+gboolean    poll_timer_dispose          (OGDPollTimer *timer);
+gboolean    poll_timer_done             (OGDPollTimer *timer, gulong received);
+
 void        init_types_management       ();
 GType       retrieve_type               (const gchar *xml_name);
 void        finalize_types_management   ();
@@ -19,13 +19,51 @@
 #define OGD_PROVIDER_PRIVATE_H
 
 #include "ogd-provider.h"
+#include "ogd-columns.h"
+
+#define OGD_PROVIDER_PRIORITIES     (OGD_PROVIDER_PRIORITY_BULK + 1)
 
 typedef void (*OGDProviderRawAsyncCallback) (xmlNode *node, gpointer userdata);
+typedef void (*OGDProviderListAsyncCallback) (GList *list, const GError *error, gpointer userdata);
+typedef void (*OGDProviderPutRawAsyncCallback) (xmlNode *response, const GError *error, gpointer userdata);
+typedef gulong (*OGDProviderStreamParser) (gpointer target, const gchar *buffer, gsize length, GError **error);
+
+typedef struct _OGDFolderDirectory OGDFolderDirectory;
 
 xmlNode*        ogd_provider_get_raw                (OGDProvider *provider, gchar *query, GError **error);
 void            ogd_provider_get_raw_async          (OGDProvider *provider, gchar *query, gboolean many, OGDProviderRawAsyncCallback rcallback, gpointer userdata);
+void            ogd_provider_get_raw_async_full     (OGDProvider *provider, gchar *query, gboolean many, OGD_PROVIDER_PRIORITY priority,
+                                                     gpointer caller, OGDProviderRawAsyncCallback rcallback, gpointer userdata);
+void            ogd_provider_get_raw_list_async_full (OGDProvider *provider, gchar *query, OGD_PROVIDER_PRIORITY priority,
+                                                     gpointer caller, OGDProviderPutRawAsyncCallback callback, gpointer userdata);
+void            ogd_provider_set_last_error         (OGDProvider *provider, const GError *error);
 xmlNode*        ogd_provider_put_raw                (OGDProvider *provider, gchar *query, GHashTable *data);
+void            ogd_provider_put_raw_async          (OGDProvider *provider, gchar *query, GHashTable *data,
+                                                     OGDProviderPutRawAsyncCallback callback, gpointer userdata);
+void            ogd_provider_put_async_full         (OGDProvider *provider, gchar *query, GHashTable *data, OGD_PROVIDER_PRIORITY priority,
+                                                     gpointer caller, OGDPutAsyncCallback callback, gpointer userdata);
+void            ogd_provider_queue_put              (OGDProvider *provider, const gchar *key, gchar *query, GHashTable *data,
+                                                     OGDPutAsyncCallback callback, gpointer userdata);
+gboolean        ogd_provider_journal_put            (OGDProvider *provider, gchar *query, GHashTable *data);
+GList*          ogd_provider_get_full               (OGDProvider *provider, gchar *query, GError **error);
+gulong          ogd_provider_get_total              (OGDProvider *provider, gchar *query);
+void            ogd_provider_get_list_async_full    (OGDProvider *provider, gchar *query, OGD_PROVIDER_PRIORITY priority, gpointer caller,
+                                                     OGDProviderListAsyncCallback callback, gpointer userdata);
 GHashTable*     ogd_provider_header_from_raw        (xmlNode *response);
+GList*          ogd_provider_parse_objects          (OGDProvider *provider, const gchar *buffer, gsize length, GError **error);
+gulong          ogd_provider_get_stream             (OGDProvider *provider, gchar *query, const gchar *label,
+                                                     OGDProviderStreamParser parser, gpointer target, GError **error);
+gulong          ogd_provider_get_columns            (OGDProvider *provider, gchar *query, OGDContentColumns *columns, GError **error);
+gulong          ogd_content_columns_parse           (OGDContentColumns *columns, const gchar *buffer, gsize length, GError **error);
 void            ogd_provider_get_single_async       (OGDProvider *provider, gchar *query, OGDAsyncCallback callback, gpointer userdata);
+void            ogd_provider_get_async_full         (OGDProvider *provider, gchar *query, OGD_PROVIDER_PRIORITY priority, gpointer caller,
+                                                     OGDAsyncCallback callback, gpointer userdata);
+OGDObject*      ogd_provider_lookup_object          (OGDProvider *provider, GType type, const gchar *id);
+OGDObject*      ogd_provider_intern_object          (OGDProvider *provider, OGDObject *obj, const xmlNode *xml);
+gboolean        ogd_provider_fill_from_store        (OGDProvider *provider, OGDObject *obj, const gchar *id, gboolean any_age);
+guint           ogd_provider_get_account            (OGDProvider *provider);
+const gchar*    ogd_provider_get_myself_id          (OGDProvider *provider);
+const gchar*    ogd_provider_set_myself_id          (OGDProvider *provider, guint account, const gchar *id);
+OGDFolderDirectory* ogd_provider_get_folder_directory (OGDProvider *provider);
 
 #endif /* OGD_PROVIDER_PRIVATE_H */
@@ -19,6 +19,16 @@
 #include "ogd-provider.h"
 #include "ogd-provider-private.h"
 #include "ogd-private-utils.h"
+#include "ogd-scheduler.h"
+#include "ogd-rate-limiter.h"
+#include "ogd-retry-policy.h"
+#include "ogd-stats.h"
+#include "ogd-archive.h"
+#include "ogd-identity-map.h"
+#include "ogd-store.h"
+#include "ogd-write-queue.h"
+#include "ogd-journal.h"
+#include "ogd-tracing-private.h"
 
 #define OPEN_COLLABORATION_API_VERSION      1
 
@@ -38,9 +48,31 @@ struct _OGDProviderPrivate {
     gchar       *server_name;
     SoupSession *http_session;
     SoupSession *async_http_session;
+    OGDScheduler *scheduler;
+    OGDWriteQueue *write_queue;
+    OGDRateLimiter *limiter;
+    OGDRetryPolicy *retry_policy;
+    OGDStats    *stats;
+    OGDArchive  *recording;
+    OGDArchive  *replay;
+    OGDIdentityMap *identity_map;
+    gboolean    arena_allocation;
+    OGDStore    *store;
+    guint       store_max_age;
+    OGDJournal  *journal;
+    OGDJournalConflictCallback journal_conflict;
+    gpointer    journal_userdata;
+    GList       *journaled_writes;
+    guint       journal_idle;
+    gboolean    replaying;
+    GError      *last_error;
 
     gchar       *access_url;
 
+    guint       account;
+    gchar       *myself_id;
+    OGDFolderDirectory *folders;
+
     gchar       *username;
     gchar       *password;
 };
@@ -54,6 +86,8 @@ G_DEFINE_TYPE (OGDProvider, ogd_provider, G_TYPE_OBJECT);
 */
 static int  InstancesCounter        = 0;
 
+static void complete_journaled_writes (OGDProvider *provider);
+
 static void ogd_provider_finalize (GObject *obj)
 {
     OGDProvider *provider;
@@ -64,9 +98,103 @@ static void ogd_provider_finalize (GObject *obj)
     PTR_CHECK_FREE_NULLIFY (provider->priv->access_url);
     PTR_CHECK_FREE_NULLIFY (provider->priv->username);
     PTR_CHECK_FREE_NULLIFY (provider->priv->password);
+    PTR_CHECK_FREE_NULLIFY (provider->priv->myself_id);
     OBJ_CHECK_UNREF_NULLIFY (provider->priv->http_session);
+
+    /*
+        Closed before the scheduler is freed, since it aborts the requests of the queue
+    */
+    if (provider->priv->write_queue != NULL)
+        ogd_write_queue_close (provider->priv->write_queue);
+
+    if (provider->priv->scheduler != NULL) {
+        ogd_scheduler_free (provider->priv->scheduler);
+        provider->priv->scheduler = NULL;
+    }
+
+    /*
+        Writes still waiting in the queue are journaled after the ones aborted by the scheduler,
+        which have been issued before
+    */
+    if (provider->priv->write_queue != NULL) {
+        ogd_write_queue_free (provider->priv->write_queue);
+        provider->priv->write_queue = NULL;
+    }
+
+    /*
+        Async writes saved behind older ones are already in the journal, and are only completed.
+        Their callbacks may issue more of them
+    */
+    while (provider->priv->journaled_writes != NULL)
+        complete_journaled_writes (provider);
+
+    if (provider->priv->journal_idle != 0) {
+        g_source_remove (provider->priv->journal_idle);
+        provider->priv->journal_idle = 0;
+    }
+
     OBJ_CHECK_UNREF_NULLIFY (provider->priv->async_http_session);
 
+    /*
+        Freed after the scheduler, whose aborted requests may still look for it
+    */
+    if (provider->priv->folders != NULL) {
+        ogd_folder_directory_free (provider->priv->folders);
+        provider->priv->folders = NULL;
+    }
+
+    /*
+        Freed after the scheduler and the write queue, which abort pending writes: those are saved
+        in the journal
+    */
+    if (provider->priv->journal != NULL) {
+        ogd_journal_free (provider->priv->journal);
+        provider->priv->journal = NULL;
+    }
+
+    if (provider->priv->limiter != NULL) {
+        ogd_rate_limiter_free (provider->priv->limiter);
+        provider->priv->limiter = NULL;
+    }
+
+    if (provider->priv->retry_policy != NULL) {
+        ogd_retry_policy_free (provider->priv->retry_policy);
+        provider->priv->retry_policy = NULL;
+    }
+
+    if (provider->priv->last_error != NULL) {
+        g_error_free (provider->priv->last_error);
+        provider->priv->last_error = NULL;
+    }
+
+    /*
+        Destroyed after the sessions, which report messages still pending when aborted
+    */
+    if (provider->priv->identity_map != NULL) {
+        ogd_identity_map_free (provider->priv->identity_map);
+        provider->priv->identity_map = NULL;
+    }
+
+    if (provider->priv->store != NULL) {
+        ogd_store_free (provider->priv->store);
+        provider->priv->store = NULL;
+    }
+
+    if (provider->priv->recording != NULL) {
+        ogd_archive_free (provider->priv->recording);
+        provider->priv->recording = NULL;
+    }
+
+    if (provider->priv->replay != NULL) {
+        ogd_archive_free (provider->priv->replay);
+        provider->priv->replay = NULL;
+    }
+
+    if (provider->priv->stats != NULL) {
+        ogd_stats_free (provider->priv->stats);
+        provider->priv->stats = NULL;
+    }
+
     InstancesCounter--;
     if (InstancesCounter == 0)
         finalize_types_management ();
@@ -81,6 +209,7 @@ static void ogd_provider_class_init (OGDProviderClass *klass)
         finalized when the last OGDProvider is freed, in ogd_provider_finalize()
     */
     init_types_management ();
+    ogd_tracing_check_environment ();
 
     g_type_class_add_private (klass, sizeof (OGDProviderPrivate));
 
@@ -95,6 +224,25 @@ static void ogd_provider_init (OGDProvider *item)
     memset (item->priv, 0, sizeof (OGDProviderPrivate));
     item->priv->http_session = soup_session_sync_new ();
     item->priv->async_http_session = soup_session_async_new ();
+    item->priv->limiter = ogd_rate_limiter_new ();
+    item->priv->retry_policy = ogd_retry_policy_new ();
+    item->priv->stats = ogd_stats_new ();
+    ogd_stats_watch_session (item->priv->stats, item->priv->http_session);
+    ogd_stats_watch_session (item->priv->stats, item->priv->async_http_session);
+    item->priv->scheduler = ogd_scheduler_new (item->priv->async_http_session, item->priv->limiter,
+                                               item->priv->retry_policy);
+    item->priv->write_queue = ogd_write_queue_new (item);
+    item->priv->folders = ogd_folder_directory_new ();
+}
+
+/*
+    Drops what is known about the current user, when the credentials change
+*/
+static void forget_account (OGDProvider *provider)
+{
+    provider->priv->account++;
+    PTR_CHECK_FREE_NULLIFY (provider->priv->myself_id);
+    ogd_folder_directory_reset (provider->priv->folders);
 }
 
 void authenticate_call (SoupSession *session, SoupMessage *msg, SoupAuth *auth, gboolean retrying, OGDProvider *provider)
@@ -137,6 +285,8 @@ OGDProvider* ogd_provider_new (gchar *url)
  */
 void ogd_provider_auth_user_and_pwd (OGDProvider *provider, gchar *username, gchar *password)
 {
+    forget_account (provider);
+
     PTR_CHECK_FREE_NULLIFY (provider->priv->username);
     provider->priv->username = g_strdup (username);
     PTR_CHECK_FREE_NULLIFY (provider->priv->password);
@@ -162,6 +312,8 @@ void ogd_provider_auth_user_and_pwd (OGDProvider *provider, gchar *username, gch
  */
 void ogd_provider_auth_api_key (OGDProvider *provider, gchar *key)
 {
+    forget_account (provider);
+
     PTR_CHECK_FREE_NULLIFY (provider->priv->access_url);
     provider->priv->access_url = g_strdup_printf ("http://%s@%s/v%d/", key,
                                                   provider->priv->server_name,
@@ -246,7 +398,7 @@ static gboolean check_provider_response (xmlNode *root, xmlNode **data, GError *
     return TRUE;
 }
 
-static xmlNode* parse_provider_response (SoupMessageBody *response, GError **error)
+static xmlNode* parse_provider_buffer (const gchar *buffer, gsize length, GError **error)
 {
     xmlDocPtr doc;
     xmlNode *root;
@@ -254,7 +406,7 @@ static xmlNode* parse_provider_response (SoupMessageBody *response, GError **err
 
     data = NULL;
 
-    doc = xmlReadMemory (response->data, response->length, NULL, NULL, XML_PARSE_NOBLANKS);
+    doc = xmlReadMemory (buffer, length, NULL, NULL, XML_PARSE_NOBLANKS);
     if (doc == NULL) {
         g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR,
                      "Unable to parse response from server.");
@@ -272,6 +424,19 @@ static xmlNode* parse_provider_response (SoupMessageBody *response, GError **err
     }
 }
 
+static xmlNode* parse_provider_response (OGDProvider *provider, SoupMessage *msg, GError **error)
+{
+    gint64 start;
+    xmlNode *ret;
+
+    ogd_tracing_begin ("parse", "parse");
+    start = current_usec ();
+    ret = parse_provider_buffer (msg->response_body->data, msg->response_body->length, error);
+    ogd_tracing_end ("parse", "parse");
+    ogd_stats_record_message_parse (provider->priv->stats, msg, current_usec () - start, 0);
+    return ret;
+}
+
 static GList* parse_xml_node_to_list_of_objects (xmlNode *data, OGDProvider *provider)
 {
     xmlNode *cursor;
@@ -279,9 +444,28 @@ static GList* parse_xml_node_to_list_of_objects (xmlNode *data, OGDProvider *pro
     GType obj_type;
     GError *error;
     OGDObject *obj;
+    OGDObject *canonical;
+    OGDArena *arena;
+    OGDArena *previous_arena;
 
     ret = NULL;
 
+    if (data == NULL)
+        return NULL;
+
+    /*
+        Each object filled takes its own reference to the arena, which is freed when the last
+        of them is destroyed
+    */
+    if (provider->priv->arena_allocation == TRUE) {
+        arena = ogd_arena_new ();
+        previous_arena = ogd_arena_set_current (arena);
+    }
+    else {
+        arena = NULL;
+        previous_arena = NULL;
+    }
+
     for (cursor = data->children; cursor; cursor = cursor->next) {
         obj_type = retrieve_type ((const gchar*) cursor->name);
         obj = g_object_new (obj_type, NULL);
@@ -296,6 +480,13 @@ static GList* parse_xml_node_to_list_of_objects (xmlNode *data, OGDProvider *pro
         error = NULL;
 
         if (ogd_object_fill_by_xml (obj, cursor, &error) == TRUE) {
+            canonical = ogd_provider_intern_object (provider, obj, cursor);
+
+            if (canonical != obj) {
+                g_object_unref (obj);
+                obj = g_object_ref (canonical);
+            }
+
             ret = g_list_prepend (ret, obj);
         }
         else {
@@ -304,6 +495,11 @@ static GList* parse_xml_node_to_list_of_objects (xmlNode *data, OGDProvider *pro
         }
     }
 
+    if (arena != NULL) {
+        ogd_arena_set_current (previous_arena);
+        ogd_arena_unref (arena);
+    }
+
     if (ret)
         ret = g_list_reverse (ret);
 
@@ -311,71 +507,298 @@ static GList* parse_xml_node_to_list_of_objects (xmlNode *data, OGDProvider *pro
     return ret;
 }
 
+/*
+    Params:
+        total:      if not NULL, filled with the total number of items declared by the server
+*/
+static GList* fetch_and_parse (OGDProvider *provider, gchar *query, gulong *total, GError **error)
+{
+    gint64 start;
+    GList *ret;
+    xmlNode *data;
+
+    ret = NULL;
+
+    if (total != NULL)
+        *total = 0;
+
+    data = ogd_provider_get_raw (provider, query, error);
+    if (data != NULL) {
+        if (total != NULL)
+            *total = total_items_for_query (data);
+
+        start = current_usec ();
+        ret = parse_xml_node_to_list_of_objects (data, provider);
+        ogd_stats_record_parse (provider->priv->stats, query, current_usec () - start, g_list_length (ret));
+    }
+
+    return ret;
+}
+
+/*
+    Builds the object saved in the store with the given key, or returns the instance already
+    alive if the identity map is enabled
+*/
+static OGDObject* object_from_store (OGDProvider *provider, OGDStoreKey *key)
+{
+    xmlNode *node;
+    OGDObject *obj;
+
+    obj = ogd_provider_lookup_object (provider, key->type, key->id);
+    if (obj != NULL)
+        return obj;
+
+    node = ogd_store_get_object (provider->priv->store, key->type, key->id, G_MAXUINT);
+    if (node == NULL)
+        return NULL;
+
+    obj = g_object_new (key->type, NULL);
+    ogd_object_set_provider (obj, provider);
+
+    if (ogd_object_fill_by_xml (obj, node, NULL) == TRUE) {
+        if (provider->priv->identity_map != NULL)
+            ogd_identity_map_intern (provider->priv->identity_map, obj, node);
+    }
+    else {
+        g_object_unref (obj);
+        obj = NULL;
+    }
+
+    xmlFreeDoc (node->doc);
+    return obj;
+}
+
+/*
+    Returns FALSE if not all objects in @keys may be rebuilt from the store, so that a partial
+    list is never passed off as a complete one
+*/
+static gboolean objects_from_store (OGDProvider *provider, GList *keys, GList **objects)
+{
+    GList *iter;
+    OGDObject *obj;
+
+    *objects = NULL;
+
+    for (iter = keys; iter; iter = g_list_next (iter)) {
+        obj = object_from_store (provider, iter->data);
+
+        if (obj == NULL) {
+            g_list_foreach (*objects, (GFunc) g_object_unref, NULL);
+            g_list_free (*objects);
+            *objects = NULL;
+            return FALSE;
+        }
+
+        *objects = g_list_prepend (*objects, obj);
+    }
+
+    *objects = g_list_reverse (*objects);
+    return TRUE;
+}
+
+static gboolean query_from_store (OGDProvider *provider, gchar *query, guint max_age, gulong *total, GList **objects)
+{
+    gboolean ret;
+    GList *keys;
+
+    if (ogd_store_get_query (provider->priv->store, query, max_age, total, &keys) == FALSE)
+        return FALSE;
+
+    ret = objects_from_store (provider, keys, objects);
+    g_list_free (keys);
+    return ret;
+}
+
+/*
+    The result of @query is taken from the store if it is fresh enough, otherwise it is asked to
+    the server and saved. When the server cannot be reached the last result saved is used, whatever
+    its age
+*/
+static GList* get_through_store (OGDProvider *provider, gchar *query, gulong *total)
+{
+    gulong count;
+    GList *ret;
+    GError *error;
+
+    if (query_from_store (provider, query, provider->priv->store_max_age, &count, &ret) == FALSE) {
+        error = NULL;
+        ret = fetch_and_parse (provider, query, &count, &error);
+
+        if (error == NULL) {
+            ogd_store_put_query (provider->priv->store, query, count, ret);
+        }
+        else {
+            g_error_free (error);
+            if (query_from_store (provider, query, G_MAXUINT, &count, &ret) == FALSE)
+                count = 0;
+        }
+    }
+
+    if (total != NULL)
+        *total = count;
+
+    return ret;
+}
+
 static gboolean check_msg (SoupMessage *msg, GError **error)
 {
     if (msg->status_code != SOUP_STATUS_OK) {
         g_set_error (error, OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
                      "Unable to submit request to server: %s", msg->reason_phrase);
-        g_object_unref (msg);
         return FALSE;
     }
     else
         return TRUE;
 }
 
+static void set_last_error (OGDProvider *provider, GError *error)
+{
+    if (provider->priv->last_error != NULL)
+        g_error_free (provider->priv->last_error);
+
+    provider->priv->last_error = error;
+}
+
+/*
+    For operations built on many requests, which fail as a whole
+*/
+void ogd_provider_set_last_error (OGDProvider *provider, const GError *error)
+{
+    set_last_error (provider, g_error_copy (error));
+}
+
+/*
+    When a request definitively fails (retries included) the operation is terminated anyway,
+    passing NULL to the callback: it is the same notification used for the end of results, so
+    whoever is waiting for it is never left hanging. The reason is available to the callback with
+    ogd_provider_get_last_error()
+*/
+static void report_async_failure (AsyncRequestDesc *async, GError *error)
+{
+    g_warning ("%s", error->message);
+    set_last_error (async->provider, error);
+
+    if (async->objectize) {
+        if (async->ecallback != NULL) {
+            TRACED_CALLBACK ("response handler", async->ecallback (NULL, error, async->userdata));
+        }
+        else if (async->lcallback != NULL) {
+            TRACED_CALLBACK ("response handler", async->lcallback (NULL, async->userdata));
+        }
+        else {
+            TRACED_CALLBACK ("response handler", async->callback (NULL, async->userdata));
+        }
+    }
+    else if (async->prcallback != NULL) {
+        TRACED_CALLBACK ("response handler", async->prcallback (NULL, error, async->userdata));
+    }
+    else {
+        TRACED_CALLBACK ("response handler", async->rcallback (NULL, async->userdata));
+    }
+}
+
+/*
+    Raw nodes are passed to the error-aware callback if the request has one
+*/
+static void deliver_raw_node (AsyncRequestDesc *async, xmlNode *node)
+{
+    if (async->prcallback != NULL) {
+        TRACED_CALLBACK ("response handler", async->prcallback (node, NULL, async->userdata));
+    }
+    else {
+        TRACED_CALLBACK ("response handler", async->rcallback (node, async->userdata));
+    }
+}
+
 static void handle_async_get_response (SoupSession *session, SoupMessage *msg, gpointer userdata)
 {
     xmlNode *ret;
     GList *list;
     GList *iter;
+    gint64 start;
+    GError *error;
     xmlNode *cursor;
     AsyncRequestDesc *async;
 
-    if (check_msg (msg, NULL) == FALSE)
+    async = (AsyncRequestDesc*) userdata;
+    error = NULL;
+
+    if (check_msg (msg, &error) == FALSE) {
+        report_async_failure (async, error);
+        g_free (async);
         return;
+    }
 
-    async = (AsyncRequestDesc*) userdata;
-    ret = parse_provider_response (msg->response_body, NULL);
+    ret = parse_provider_response (async->provider, msg, &error);
+    if (ret == NULL && error != NULL) {
+        report_async_failure (async, error);
+        g_free (async);
+        return;
+    }
 
     if (async->objectize) {
+        start = current_usec ();
         list = parse_xml_node_to_list_of_objects (ret, async->provider);
+        ogd_stats_record_message_parse (async->provider->priv->stats, msg,
+                                        current_usec () - start, g_list_length (list));
 
-        if (async->lcallback != NULL) {
-            async->lcallback (list, async->userdata);
+        if (async->ecallback != NULL) {
+            TRACED_CALLBACK ("response handler", async->ecallback (list, NULL, async->userdata));
+        }
+        else if (async->lcallback != NULL) {
+            TRACED_CALLBACK ("response handler", async->lcallback (list, async->userdata));
         }
         else {
             for (iter = g_list_first (list); iter; iter = g_list_next (iter)) {
-                async->callback ((OGDObject*) iter->data, async->userdata);
+                TRACED_CALLBACK ("response handler", async->callback ((OGDObject*) iter->data, async->userdata));
                 g_object_unref (iter->data);
             }
 
-            if (async->one_shot == FALSE)
-                async->callback (NULL, async->userdata);
+            if (async->one_shot == FALSE || list == NULL) {
+                TRACED_CALLBACK ("response handler", async->callback (NULL, async->userdata));
+            }
 
             g_list_free (list);
         }
     }
+    else if (ret == NULL || ret->children == NULL) {
+        if (ret != NULL)
+            xmlFreeDoc (ret->doc);
+
+        deliver_raw_node (async, NULL);
+    }
+    else if (async->one_shot == TRUE) {
+        /*
+            The callback takes ownership of the document
+        */
+        deliver_raw_node (async, ret->children);
+    }
     else {
         for (cursor = ret->children; cursor; cursor = cursor->next)
-            async->rcallback ((xmlNode*) cursor, async->userdata);
+            deliver_raw_node (async, (xmlNode*) cursor);
 
-        if (async->one_shot == FALSE)
-            async->rcallback (NULL, async->userdata);
+        xmlFreeDoc (ret->doc);
+        deliver_raw_node (async, NULL);
     }
+
+    g_free (async);
 }
 
-static void send_async_msg_to_server (const gchar *complete_query, AsyncRequestDesc *async)
+static void send_async_msg_to_server (const gchar *complete_query, OGD_PROVIDER_PRIORITY priority,
+                                      gpointer caller, AsyncRequestDesc *async)
 {
     SoupMessage *msg;
 
     msg = soup_message_new ("GET", complete_query);
     if (msg == NULL) {
-        g_warning ("Unable to build request to server: %s\n", complete_query);
+        report_async_failure (async, g_error_new (OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                                                  "Unable to build request to server: %s", complete_query));
+        g_free (async);
         return;
     }
 
-    soup_session_queue_message (async->provider->priv->async_http_session, msg,
-                                handle_async_get_response, async);
+    ogd_scheduler_push (async->provider->priv->scheduler, msg, priority, caller,
+                        handle_async_get_response, async);
 }
 
 /*
@@ -387,10 +810,16 @@ static void send_async_msg_to_server (const gchar *complete_query, AsyncRequestD
         callback:   if objects == TRUE, callback to which pass built objects
         rcallback:  if objects == FALSE, callback to which pass raw XML
         lcallback:  if objects == TRUE and lcallback != NULL, callback to which pass GList of built objects
+        ecallback:  if objects == TRUE and ecallback != NULL, callback to which pass GList of built
+                    objects or the error occurred
+        priority:   class in which the request is scheduled
+        caller:     identifier of the operation issuing the request, requests with the same caller
+                    share the same fairness lane in the scheduler
         userdata:   the user data for callback or rcallback
 */
 static void get_async (OGDProvider *provider, gchar *query, gboolean single, gboolean objects,
                        OGDAsyncCallback callback, OGDProviderRawAsyncCallback rcallback, OGDAsyncListCallback lcallback,
+                       OGDProviderListAsyncCallback ecallback, OGD_PROVIDER_PRIORITY priority, gpointer caller,
                        gpointer userdata)
 {
     gchar *complete_query;
@@ -404,37 +833,70 @@ static void get_async (OGDProvider *provider, gchar *query, gboolean single, gbo
     async->callback = callback;
     async->rcallback = rcallback;
     async->lcallback = lcallback;
+    async->ecallback = ecallback;
     async->provider = provider;
     async->objectize = objects;
 
-    send_async_msg_to_server (complete_query, async);
+    send_async_msg_to_server (complete_query, priority, caller, async);
     g_free (complete_query);
 }
 
+/*
+    Sends a message through the sync session, or fills it from the archive when replaying
+*/
+static guint send_sync_message (OGDProvider *provider, SoupMessage *msg)
+{
+    gint64 delay;
+
+    if (provider->priv->replay == NULL)
+        return soup_session_send_message (provider->priv->http_session, msg);
+
+    delay = ogd_archive_replay (provider->priv->replay, msg);
+    if (delay > 0)
+        g_usleep (delay);
+
+    return msg->status_code;
+}
+
 static SoupMessage* send_msg_to_server (OGDProvider *provider, const gchar *complete_query, GError **error)
 {
-    guint sendret;
+    guint attempts;
+    gboolean throttled;
     SoupMessage *msg;
 
-    msg = soup_message_new ("GET", complete_query);
-    if (msg == NULL) {
-        g_set_error (error, OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
-                     "Unable to build request to server");
-        return NULL;
-    }
+    for (attempts = 1; ; attempts++) {
+        msg = soup_message_new ("GET", complete_query);
+        if (msg == NULL) {
+            g_set_error (error, OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                         "Unable to build request to server");
+            return NULL;
+        }
+
+        ogd_rate_limiter_wait (provider->priv->limiter);
+        ogd_tracing_request_begin (msg, FALSE, NULL);
+        send_sync_message (provider, msg);
+        ogd_tracing_request_end (msg, FALSE);
+        throttled = ogd_rate_limiter_check_response (provider->priv->limiter, msg);
+
+        if (ogd_retry_policy_should_retry (provider->priv->retry_policy, msg, attempts) == FALSE)
+            break;
+
+        /*
+            When throttled the wait is already imposed by the limiter
+        */
+        if (throttled == FALSE)
+            g_usleep (ogd_retry_policy_delay (provider->priv->retry_policy, attempts));
 
-    sendret = soup_session_send_message (provider->priv->http_session, msg);
-    if (sendret != 200) {
-        g_set_error (error, OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
-                     "Unable to send request to server, error %u", sendret);
         g_object_unref (msg);
-        return NULL;
     }
 
-    if (check_msg (msg, error) == FALSE)
+    if (check_msg (msg, error) == FALSE) {
+        g_object_unref (msg);
         return NULL;
-    else
+    }
+    else {
         return msg;
+    }
 }
 
 xmlNode* ogd_provider_get_raw (OGDProvider *provider, gchar *query, GError **error)
@@ -450,7 +912,7 @@ xmlNode* ogd_provider_get_raw (OGDProvider *provider, gchar *query, GError **err
     g_free (complete_query);
 
     if (msg != NULL) {
-        ret = parse_provider_response (msg->response_body, error);
+        ret = parse_provider_response (provider, msg, error);
         g_object_unref (msg);
     }
 
@@ -460,51 +922,166 @@ xmlNode* ogd_provider_get_raw (OGDProvider *provider, gchar *query, GError **err
 void ogd_provider_get_raw_async (OGDProvider *provider, gchar *query, gboolean many,
                                  OGDProviderRawAsyncCallback callback, gpointer userdata)
 {
-    get_async (provider, query, many == FALSE, FALSE, NULL, callback, NULL, userdata);
+    get_async (provider, query, many == FALSE, FALSE, NULL, callback, NULL, NULL,
+               OGD_PROVIDER_PRIORITY_NORMAL, userdata, userdata);
 }
 
-GHashTable* ogd_provider_header_from_raw (xmlNode *response)
+void ogd_provider_get_raw_async_full (OGDProvider *provider, gchar *query, gboolean many, OGD_PROVIDER_PRIORITY priority,
+                                      gpointer caller, OGDProviderRawAsyncCallback callback, gpointer userdata)
 {
-    GHashTable *header;
-    xmlNode *node;
-
-    node = xmlDocGetRootElement (response->doc);
-    node = node->children;
+    get_async (provider, query, many == FALSE, FALSE, NULL, callback, NULL, NULL, priority, caller, userdata);
+}
 
-    if (node == NULL || MYSTRCMP (node->name, "meta") != 0) {
-        g_warning ("No header in this response\n");
-        return NULL;
-    }
+/*
+    As ogd_provider_get_raw_async_full() with many == TRUE, but @callback is also invoked with NULL
+    and the error if the request fails, so that the end of the list can be told apart from a
+    failure
+*/
+void ogd_provider_get_raw_list_async_full (OGDProvider *provider, gchar *query, OGD_PROVIDER_PRIORITY priority,
+                                           gpointer caller, OGDProviderPutRawAsyncCallback callback, gpointer userdata)
+{
+    gchar *complete_query;
+    AsyncRequestDesc *async;
 
-    header = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                    (GDestroyNotify) xmlFree, (GDestroyNotify) xmlFree);
+    complete_query = g_strdup_printf ("%s%s", provider->priv->access_url, query);
 
-    for (node = node->children; node; node = node->next)
-        g_hash_table_insert (header, strdup ((char*) node->name), xmlNodeGetContent (node));
+    async = g_new0 (AsyncRequestDesc, 1);
+    async->userdata = userdata;
+    async->prcallback = callback;
+    async->provider = provider;
 
-    return header;
+    send_async_msg_to_server (complete_query, priority, caller, async);
+    g_free (complete_query);
 }
 
-/**
- * ogd_provider_get:
- * @provider:       the #OGDProvider from which retrieve data
- * @query:          query to ask contents
- *
- * To retrieve some content from the server
- *
- * Return value:    a list of GObject, or NULL if an error occours
- */
-GList* ogd_provider_get (OGDProvider *provider, gchar *query)
+/*
+    Params:
+        label:      name of the parser, used for tracing
+        parser:     reads the response as a stream, and returns the number of items found
+
+    Sends a GET request and passes the body of the response directly to @parser, without building
+    the XML tree. Returns the value returned by @parser, or 0 if the request failed
+*/
+gulong ogd_provider_get_stream (OGDProvider *provider, gchar *query, const gchar *label,
+                                OGDProviderStreamParser parser, gpointer target, GError **error)
+{
+    gulong ret;
+    gint64 start;
+    gchar *complete_query;
+    SoupMessage *msg;
+
+    complete_query = g_strdup_printf ("%s%s", provider->priv->access_url, query);
+    msg = send_msg_to_server (provider, complete_query, error);
+    g_free (complete_query);
+
+    if (msg == NULL)
+        return 0;
+
+    ogd_tracing_begin ("parse", label);
+    start = current_usec ();
+    ret = parser (target, msg->response_body->data, msg->response_body->length, error);
+    ogd_tracing_end ("parse", label);
+    ogd_stats_record_message_parse (provider->priv->stats, msg, current_usec () - start, (guint) ret);
+
+    g_object_unref (msg);
+    return ret;
+}
+
+/*
+    Fetches a page of contents and appends their scalar values to @columns, reading the response
+    as a stream without building the XML tree nor any object. Returns the number of rows added
+*/
+gulong ogd_provider_get_columns (OGDProvider *provider, gchar *query, OGDContentColumns *columns, GError **error)
+{
+    return ogd_provider_get_stream (provider, query, "columns", (OGDProviderStreamParser) ogd_content_columns_parse,
+                                    columns, error);
+}
+
+/*
+    Builds objects from a complete OCS response, exactly as done for responses received from the
+    server. Permits to measure the parsing layer alone, without any network involved
+*/
+GList* ogd_provider_parse_objects (OGDProvider *provider, const gchar *buffer, gsize length, GError **error)
 {
-    GList *ret;
     xmlNode *data;
 
-    ret = NULL;
+    data = parse_provider_buffer (buffer, length, error);
+    if (data == NULL)
+        return NULL;
 
-    data = ogd_provider_get_raw (provider, query, NULL);
-    if (data != NULL)
-        ret = parse_xml_node_to_list_of_objects (data, provider);
+    return parse_xml_node_to_list_of_objects (data, provider);
+}
+
+GHashTable* ogd_provider_header_from_raw (xmlNode *response)
+{
+    GHashTable *header;
+    xmlNode *node;
+
+    node = xmlDocGetRootElement (response->doc);
+    node = node->children;
+
+    if (node == NULL || MYSTRCMP (node->name, "meta") != 0) {
+        g_warning ("No header in this response\n");
+        return NULL;
+    }
+
+    header = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                    (GDestroyNotify) xmlFree, (GDestroyNotify) xmlFree);
+
+    for (node = node->children; node; node = node->next)
+        g_hash_table_insert (header, strdup ((char*) node->name), xmlNodeGetContent (node));
+
+    return header;
+}
+
+/**
+ * ogd_provider_get:
+ * @provider:       the #OGDProvider from which retrieve data
+ * @query:          query to ask contents
+ *
+ * To retrieve some content from the server
+ *
+ * Return value:    a list of GObject, or NULL if an error occours
+ */
+GList* ogd_provider_get (OGDProvider *provider, gchar *query)
+{
+    if (provider->priv->store != NULL)
+        return get_through_store (provider, query, NULL);
+    else
+        return ogd_provider_get_full (provider, query, NULL);
+}
+
+/*
+    As ogd_provider_get(), but a failed request is reported in @error and may be distinguished
+    from an empty list. The request is always sent to the server, also when a store is in use
+*/
+GList* ogd_provider_get_full (OGDProvider *provider, gchar *query, GError **error)
+{
+    return fetch_and_parse (provider, query, NULL, error);
+}
+
+/*
+    Returns the total number of items declared by the server for @query
+*/
+gulong ogd_provider_get_total (OGDProvider *provider, gchar *query)
+{
+    gulong ret;
+    GList *list;
+    xmlNode *node;
+
+    if (provider->priv->store != NULL) {
+        list = get_through_store (provider, query, &ret);
+        g_list_foreach (list, (GFunc) g_object_unref, NULL);
+        g_list_free (list);
+        return ret;
+    }
+
+    node = ogd_provider_get_raw (provider, query, NULL);
+    if (node == NULL)
+        return 0;
 
+    ret = total_items_for_query (node);
+    xmlFreeDoc (node->doc);
     return ret;
 }
 
@@ -515,12 +1092,20 @@ GList* ogd_provider_get (OGDProvider *provider, gchar *query)
  * @callback:       async callback to which incoming #OGDObject are passed
  * @userdata:       the user data for the callback
  *
- * Async version of ogd_provider_get()
+ * Async version of ogd_provider_get(). The request is scheduled with %OGD_PROVIDER_PRIORITY_NORMAL
+ * priority, and requests sharing the same @userdata are considered issued by the same caller
  */
 void ogd_provider_get_async (OGDProvider *provider, gchar *query,
                              OGDAsyncCallback callback, gpointer userdata)
 {
-    get_async (provider, query, FALSE, TRUE, callback, NULL, NULL, userdata);
+    get_async (provider, query, FALSE, TRUE, callback, NULL, NULL, NULL,
+               OGD_PROVIDER_PRIORITY_NORMAL, userdata, userdata);
+}
+
+void ogd_provider_get_async_full (OGDProvider *provider, gchar *query, OGD_PROVIDER_PRIORITY priority, gpointer caller,
+                                  OGDAsyncCallback callback, gpointer userdata)
+{
+    get_async (provider, query, FALSE, TRUE, callback, NULL, NULL, NULL, priority, caller, userdata);
 }
 
 /**
@@ -530,22 +1115,38 @@ void ogd_provider_get_async (OGDProvider *provider, gchar *query,
  * @callback:       async callback to which list of incoming #OGDObjects is passed
  * @userdata:       the user data for the callback
  *
- * Async version of ogd_provider_get()
+ * Async version of ogd_provider_get(). The request is scheduled with %OGD_PROVIDER_PRIORITY_NORMAL
+ * priority
  */
 void ogd_provider_get_list_async (OGDProvider *provider, gchar *query,
                                   OGDAsyncListCallback callback, gpointer userdata)
 {
-    get_async (provider, query, FALSE, TRUE, NULL, NULL, callback, userdata);
+    get_async (provider, query, FALSE, TRUE, NULL, NULL, callback, NULL,
+               OGD_PROVIDER_PRIORITY_NORMAL, userdata, userdata);
+}
+
+/*
+    As ogd_provider_get_list_async(), but the callback is able to distinguish a failed request
+    from an empty list
+*/
+void ogd_provider_get_list_async_full (OGDProvider *provider, gchar *query, OGD_PROVIDER_PRIORITY priority, gpointer caller,
+                                       OGDProviderListAsyncCallback callback, gpointer userdata)
+{
+    get_async (provider, query, FALSE, TRUE, NULL, NULL, NULL, callback, priority, caller, userdata);
 }
 
 void ogd_provider_get_single_async (OGDProvider *provider, gchar *query,
                                     OGDAsyncCallback callback, gpointer userdata)
 {
-    get_async (provider, query, TRUE, TRUE, callback, NULL, NULL, userdata);
+    get_async (provider, query, TRUE, TRUE, callback, NULL, NULL, NULL,
+               OGD_PROVIDER_PRIORITY_INTERACTIVE, userdata, userdata);
 }
 
+#define IDEMPOTENCY_KEY_HEADER      "Idempotency-Key"
+
 static SoupMessage* prepare_message_to_put (OGDProvider *provider, gchar *query, GHashTable *data)
 {
+    gchar *key;
     gchar *complete_query;
     SoupMessage *msg;
 
@@ -556,10 +1157,361 @@ static SoupMessage* prepare_message_to_put (OGDProvider *provider, gchar *query,
     else
         msg = soup_form_request_new ("POST", complete_query, NULL, NULL);
 
+    /*
+        The key is sent since the first attempt, so the server may recognize the request if sent
+        again from the journal after it was applied but the response was lost
+    */
+    if (provider->priv->journal != NULL) {
+        key = ogd_journal_new_key ();
+        soup_message_headers_append (msg->request_headers, IDEMPOTENCY_KEY_HEADER, key);
+        g_free (key);
+    }
+
+    g_free (complete_query);
+    return msg;
+}
+
+static gboolean server_unreachable (SoupMessage *msg)
+{
+    return (SOUP_STATUS_IS_TRANSPORT_ERROR (msg->status_code) || SOUP_STATUS_IS_SERVER_ERROR (msg->status_code) ||
+            msg->status_code == 429);
+}
+
+static gboolean journal_write (OGDProvider *provider, const gchar *query, SoupMessage *msg)
+{
+    gboolean ret;
+    SoupBuffer *body;
+
+    body = soup_message_body_flatten (msg->request_body);
+    ret = ogd_journal_append (provider->priv->journal,
+                              soup_message_headers_get_one (msg->request_headers, IDEMPOTENCY_KEY_HEADER),
+                              query, body->data, body->length);
+    soup_buffer_free (body);
+    return ret;
+}
+
+/*
+    With a journal, a write which has not reached the server is saved to be sent again later.
+    Returns TRUE if @msg has been saved
+*/
+static gboolean journal_failed_write (OGDProvider *provider, const gchar *query, SoupMessage *msg)
+{
+    if (provider->priv->journal == NULL || query == NULL || server_unreachable (msg) == FALSE)
+        return FALSE;
+
+    return journal_write (provider, query, msg);
+}
+
+/*
+    Builds the request sending again @entry, or NULL if its query is not valid
+*/
+static SoupMessage* prepare_replayed_write (OGDProvider *provider, const OGDJournalEntry *entry)
+{
+    gchar *complete_query;
+    SoupMessage *msg;
+
+    complete_query = g_strdup_printf ("%s%s", provider->priv->access_url, entry->query);
+    msg = soup_message_new ("POST", complete_query);
     g_free (complete_query);
+
+    if (msg != NULL) {
+        soup_message_set_request (msg, SOUP_FORM_MIME_TYPE_URLENCODED, SOUP_MEMORY_COPY, entry->body, entry->length);
+        soup_message_headers_append (msg->request_headers, IDEMPOTENCY_KEY_HEADER, entry->key);
+    }
+
     return msg;
 }
 
+typedef struct {
+    SoupMessage         *msg;
+    SoupSessionCallback callback;
+    AsyncRequestDesc    *async;
+} JournaledWrite;
+
+static void free_journaled_write (JournaledWrite *write)
+{
+    g_object_unref (write->msg);
+    g_free (write);
+}
+
+/*
+    Completes the async write saved in the journal with @key, if one is waiting: with @msg, the
+    request which has sent it again
+*/
+static void complete_journaled_write (OGDProvider *provider, const gchar *key, SoupMessage *msg)
+{
+    GList *iter;
+    JournaledWrite *write;
+
+    for (iter = provider->priv->journaled_writes; iter; iter = g_list_next (iter)) {
+        write = (JournaledWrite*) iter->data;
+
+        if (g_strcmp0 (soup_message_headers_get_one (write->msg->request_headers, IDEMPOTENCY_KEY_HEADER), key) == 0) {
+            provider->priv->journaled_writes = g_list_delete_link (provider->priv->journaled_writes, iter);
+            write->callback (provider->priv->async_http_session, msg, write->async);
+            free_journaled_write (write);
+            return;
+        }
+    }
+}
+
+/*
+    Completes all the async writes saved in the journal behind older ones, and not sent yet, as
+    still journaled
+*/
+static void complete_journaled_writes (OGDProvider *provider)
+{
+    GList *writes;
+    GList *iter;
+    JournaledWrite *write;
+
+    writes = provider->priv->journaled_writes;
+    provider->priv->journaled_writes = NULL;
+
+    for (iter = writes; iter; iter = g_list_next (iter)) {
+        write = (JournaledWrite*) iter->data;
+        write->callback (provider->priv->async_http_session, write->msg, write->async);
+        free_journaled_write (write);
+    }
+
+    g_list_free (writes);
+}
+
+/*
+    Ends the replay of the entry of the journal with @key, once @msg (NULL if it could not be
+    built) reached the server. Writes refused by the server are notified to the conflict callback.
+    The entry is dropped from the journal, unless another replay already did it meanwhile, and
+    then the async write waiting for it, if any, is completed
+*/
+static void journal_entry_sent (OGDProvider *provider, const gchar *key, const gchar *query, SoupMessage *msg)
+{
+    gchar *sent_key;
+    GError *conflict;
+    xmlNode *response;
+    const OGDJournalEntry *head;
+
+    conflict = NULL;
+
+    if (msg == NULL) {
+        conflict = g_error_new (OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR, "Unable to build request to server");
+    }
+    else if (msg->status_code == SOUP_STATUS_OK) {
+        response = parse_provider_response (provider, msg, &conflict);
+        if (response != NULL)
+            xmlFreeDoc (response->doc);
+    }
+    else {
+        conflict = g_error_new (OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                                "Request refused by server: %s", msg->reason_phrase);
+    }
+
+    if (conflict != NULL) {
+        if (provider->priv->journal_conflict != NULL) {
+            TRACED_CALLBACK ("conflict", provider->priv->journal_conflict (provider, query, key,
+                                                                          conflict, provider->priv->journal_userdata));
+        }
+
+        g_error_free (conflict);
+    }
+
+    /*
+        @key may belong to the entry itself, which is freed when dropped
+    */
+    sent_key = g_strdup (key);
+
+    if (provider->priv->journal != NULL) {
+        head = ogd_journal_peek (provider->priv->journal);
+        if (head != NULL && g_strcmp0 (head->key, sent_key) == 0)
+            ogd_journal_remove_head (provider->priv->journal);
+    }
+
+    if (msg != NULL)
+        complete_journaled_write (provider, sent_key, msg);
+
+    g_free (sent_key);
+}
+
+/*
+    Sends again the writes saved in the journal, in order, until the first one which does not
+    reach the server. Writes refused by the server are dropped and notified to the conflict
+    callback. Returns TRUE if the journal is empty at the end
+*/
+static gboolean replay_journal_entries (OGDProvider *provider, GError **error)
+{
+    SoupMessage *msg;
+    const OGDJournalEntry *entry;
+
+    if (provider->priv->journal == NULL)
+        return TRUE;
+
+    ogd_tracing_begin ("journal", "replay");
+
+    while (provider->priv->journal != NULL && (entry = ogd_journal_peek (provider->priv->journal)) != NULL) {
+        msg = prepare_replayed_write (provider, entry);
+
+        if (msg != NULL) {
+            ogd_rate_limiter_wait (provider->priv->limiter);
+            ogd_tracing_request_begin (msg, FALSE, NULL);
+            send_sync_message (provider, msg);
+            ogd_tracing_request_end (msg, FALSE);
+            ogd_rate_limiter_check_response (provider->priv->limiter, msg);
+
+            if (server_unreachable (msg) == TRUE) {
+                g_set_error (error, OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                             "Unable to replay journal: %s", msg->reason_phrase);
+                g_object_unref (msg);
+                break;
+            }
+        }
+
+        journal_entry_sent (provider, entry->key, entry->query, msg);
+
+        if (msg != NULL)
+            g_object_unref (msg);
+    }
+
+    ogd_tracing_end ("journal", "replay");
+    return (provider->priv->journal == NULL || ogd_journal_get_length (provider->priv->journal) == 0);
+}
+
+/*
+    Writes are applied in the order they are issued: while older ones are still in the journal,
+    they are sent first, and if this is not possible the new one is saved after them. While the
+    journal is being sent again from the main loop the new write is saved after it as well, and
+    sent by that replay
+*/
+static gboolean journal_is_empty (OGDProvider *provider)
+{
+    if (provider->priv->journal == NULL || ogd_journal_get_length (provider->priv->journal) == 0)
+        return TRUE;
+
+    if (provider->priv->replaying == TRUE)
+        return FALSE;
+
+    return replay_journal_entries (provider, NULL);
+}
+
+typedef struct {
+    OGDProvider     *provider;
+    gchar           *key;
+    gchar           *query;
+} ReplayedWrite;
+
+static void replay_journal_async (OGDProvider *provider);
+
+static void handle_replayed_write (SoupSession *session, SoupMessage *msg, gpointer userdata)
+{
+    OGDProvider *provider;
+    ReplayedWrite *replayed;
+
+    replayed = (ReplayedWrite*) userdata;
+    provider = replayed->provider;
+    provider->priv->replaying = FALSE;
+
+    /*
+        The remaining async writes are still in the journal, to be sent by the next replay
+    */
+    if (server_unreachable (msg) == TRUE) {
+        complete_journaled_writes (provider);
+    }
+    else {
+        journal_entry_sent (provider, replayed->key, replayed->query, msg);
+        replay_journal_async (provider);
+    }
+
+    g_free (replayed->key);
+    g_free (replayed->query);
+    g_free (replayed);
+}
+
+/*
+    Async counterpart of replay_journal_entries(): the writes in the journal are passed to the
+    scheduler one at a time, and the next one is sent when the previous has been completed, so the
+    main loop is never blocked. Async writes saved behind older ones are completed when their own
+    entry is sent, or as still journaled when the replay stops
+*/
+static void replay_journal_async (OGDProvider *provider)
+{
+    SoupMessage *msg;
+    ReplayedWrite *replayed;
+    const OGDJournalEntry *entry;
+
+    if (provider->priv->replaying == TRUE)
+        return;
+
+    while (provider->priv->journal != NULL && provider->priv->scheduler != NULL &&
+           (entry = ogd_journal_peek (provider->priv->journal)) != NULL) {
+        msg = prepare_replayed_write (provider, entry);
+
+        if (msg == NULL) {
+            journal_entry_sent (provider, entry->key, entry->query, NULL);
+            continue;
+        }
+
+        replayed = g_new0 (ReplayedWrite, 1);
+        replayed->provider = provider;
+        replayed->key = g_strdup (entry->key);
+        replayed->query = g_strdup (entry->query);
+
+        provider->priv->replaying = TRUE;
+        ogd_scheduler_push (provider->priv->scheduler, msg, OGD_PROVIDER_PRIORITY_INTERACTIVE, provider,
+                            handle_replayed_write, replayed);
+        return;
+    }
+
+    /*
+        Nothing left to send: writes still waiting belong to a journal which has been replaced
+    */
+    complete_journaled_writes (provider);
+}
+
+static gboolean journaled_writes_idle (gpointer userdata)
+{
+    OGDProvider *provider;
+
+    provider = (OGDProvider*) userdata;
+    provider->priv->journal_idle = 0;
+    replay_journal_async (provider);
+    return FALSE;
+}
+
+/*
+    Async counterpart of journal_is_empty(): while older writes are in the journal, @msg is saved
+    after them and a replay of the journal is started from the main loop. @callback is held until
+    the replay sends @msg, and receives its response, or until the replay stops before, and then
+    receives @msg completed as cancelled. Returns TRUE if @msg has been saved, FALSE if it has to
+    be sent as usual
+*/
+static gboolean journal_async_write (OGDProvider *provider, SoupMessage *msg, SoupSessionCallback callback,
+                                     AsyncRequestDesc *async)
+{
+    JournaledWrite *write;
+
+    if (provider->priv->journal == NULL || ogd_journal_get_length (provider->priv->journal) == 0)
+        return FALSE;
+
+    journal_write (provider, async->query, msg);
+    soup_message_set_status_full (msg, SOUP_STATUS_CANCELLED, "Saved in the journal, behind older writes");
+
+    /*
+        Already saved: the response handler must not save it again
+    */
+    g_free (async->query);
+    async->query = NULL;
+    async->journaled = TRUE;
+
+    write = g_new0 (JournaledWrite, 1);
+    write->msg = msg;
+    write->callback = callback;
+    write->async = async;
+    provider->priv->journaled_writes = g_list_append (provider->priv->journaled_writes, write);
+
+    if (provider->priv->journal_idle == 0 && provider->priv->replaying == FALSE)
+        provider->priv->journal_idle = g_idle_add (journaled_writes_idle, provider);
+
+    return TRUE;
+}
+
 xmlNode* ogd_provider_put_raw (OGDProvider *provider, gchar *query, GHashTable *data)
 {
     guint sendret;
@@ -569,13 +1521,25 @@ xmlNode* ogd_provider_put_raw (OGDProvider *provider, gchar *query, GHashTable *
     ret = NULL;
 
     msg = prepare_message_to_put (provider, query, data);
-    sendret = soup_session_send_message (provider->priv->http_session, msg);
 
-    if (sendret == 200 && msg->status_code == SOUP_STATUS_OK) {
-        ret = parse_provider_response (msg->response_body, NULL);
+    if (journal_is_empty (provider) == FALSE) {
+        journal_write (provider, query, msg);
         g_object_unref (msg);
+        return NULL;
     }
 
+    ogd_rate_limiter_wait (provider->priv->limiter);
+    ogd_tracing_request_begin (msg, FALSE, NULL);
+    sendret = send_sync_message (provider, msg);
+    ogd_tracing_request_end (msg, FALSE);
+    ogd_rate_limiter_check_response (provider->priv->limiter, msg);
+
+    if (sendret == 200 && msg->status_code == SOUP_STATUS_OK)
+        ret = parse_provider_response (provider, msg, NULL);
+    else
+        journal_failed_write (provider, query, msg);
+
+    g_object_unref (msg);
     return ret;
 }
 
@@ -596,24 +1560,63 @@ gboolean ogd_provider_put (OGDProvider *provider, gchar *query, GHashTable *data
     SoupMessage *msg;
 
     msg = prepare_message_to_put (provider, query, data);
-    sendret = soup_session_send_message (provider->priv->http_session, msg);
+
+    if (journal_is_empty (provider) == FALSE) {
+        journal_write (provider, query, msg);
+        g_object_unref (msg);
+        return FALSE;
+    }
+
+    ogd_rate_limiter_wait (provider->priv->limiter);
+    ogd_tracing_request_begin (msg, FALSE, NULL);
+    sendret = send_sync_message (provider, msg);
+    ogd_tracing_request_end (msg, FALSE);
+    ogd_rate_limiter_check_response (provider->priv->limiter, msg);
     ret = (sendret == 200 && msg->status_code == SOUP_STATUS_OK);
+
+    if (ret == FALSE)
+        journal_failed_write (provider, query, msg);
+
     g_object_unref (msg);
     return ret;
 }
 
+/*
+    As check_msg(), but an async write saved in the journal and completed before being sent again
+    fails with a journal error, so its caller knows the write is not lost and has not to issue it
+    again
+*/
+static gboolean check_put_msg (AsyncRequestDesc *async, SoupMessage *msg, GError **error)
+{
+    if (async->journaled == TRUE && msg->status_code == SOUP_STATUS_CANCELLED) {
+        g_set_error (error, OGD_JOURNAL_ERROR_DOMAIN, OGD_JOURNAL_ERROR,
+                     "Saved in the journal, to be sent again later");
+        return FALSE;
+    }
+
+    return check_msg (msg, error);
+}
+
 static void handle_async_put_response (SoupSession *session, SoupMessage *msg, gpointer userdata)
 {
+    GError *error;
     gboolean result;
     AsyncRequestDesc *async;
 
     async = (AsyncRequestDesc*) userdata;
+    error = NULL;
+    result = check_put_msg (async, msg, &error);
+
+    if (result == FALSE) {
+        set_last_error (async->provider, error);
+        journal_failed_write (async->provider, async->query, msg);
+    }
 
     if (async->pcallback != NULL) {
-        result = ( msg->status_code == SOUP_STATUS_OK );
-        async->pcallback (result, async->userdata);
+        TRACED_CALLBACK ("response handler", async->pcallback (result, async->userdata));
     }
 
+    g_free (async->query);
     g_free (async);
 }
 
@@ -625,10 +1628,24 @@ static void handle_async_put_response (SoupSession *session, SoupMessage *msg, g
  * @callback:       async callback to which result of the operation is passed
  * @userdata:       the user data for the callback
  *
- * Async version of ogd_provider_put()
+ * Async version of ogd_provider_put(). The request is scheduled with
+ * %OGD_PROVIDER_PRIORITY_INTERACTIVE priority. When a journal is in use, see
+ * ogd_provider_set_journal(), a failure may mean the request has been saved in the journal: in
+ * this case the error returned by ogd_provider_get_last_error() is in the
+ * %OGD_JOURNAL_ERROR_DOMAIN domain, and the request must not be issued again
  */
 void ogd_provider_put_async (OGDProvider *provider, gchar *query, GHashTable *data,
                              OGDPutAsyncCallback callback, gpointer userdata)
+{
+    ogd_provider_put_async_full (provider, query, data, OGD_PROVIDER_PRIORITY_INTERACTIVE, userdata,
+                                 callback, userdata);
+}
+
+/*
+    As ogd_provider_put_async(), but with explicit priority and caller, as used by the write queue
+*/
+void ogd_provider_put_async_full (OGDProvider *provider, gchar *query, GHashTable *data, OGD_PROVIDER_PRIORITY priority,
+                                  gpointer caller, OGDPutAsyncCallback callback, gpointer userdata)
 {
     SoupMessage *msg;
     AsyncRequestDesc *async;
@@ -636,11 +1653,718 @@ void ogd_provider_put_async (OGDProvider *provider, gchar *query, GHashTable *da
     msg = prepare_message_to_put (provider, query, data);
 
     async = g_new0 (AsyncRequestDesc, 1);
+    async->provider = provider;
     async->pcallback = callback;
+    async->query = g_strdup (query);
     async->userdata = userdata;
 
-    soup_session_queue_message (provider->priv->async_http_session, msg,
-                                handle_async_put_response, async);
+    if (journal_async_write (provider, msg, handle_async_put_response, async) == TRUE)
+        return;
+
+    ogd_scheduler_push (provider->priv->scheduler, msg, priority, caller, handle_async_put_response, async);
+}
 
+/*
+    Enqueues a POST in the write queue of @provider: see ogd_write_queue_push()
+*/
+void ogd_provider_queue_put (OGDProvider *provider, const gchar *key, gchar *query, GHashTable *data,
+                             OGDPutAsyncCallback callback, gpointer userdata)
+{
+    ogd_write_queue_push (provider->priv->write_queue, key, query, data, callback, userdata);
+}
+
+/*
+    Saves a POST of @query with @data in the journal, without sending it. Returns FALSE if no
+    journal is in use
+*/
+gboolean ogd_provider_journal_put (OGDProvider *provider, gchar *query, GHashTable *data)
+{
+    gboolean ret;
+    SoupMessage *msg;
+
+    if (provider->priv->journal == NULL)
+        return FALSE;
+
+    msg = prepare_message_to_put (provider, query, data);
+    ret = journal_write (provider, query, msg);
     g_object_unref (msg);
+    return ret;
+}
+
+/**
+ * ogd_provider_set_write_limit:
+ * @provider:       the #OGDProvider to configure
+ * @limit:          maximum number of enqueued editing operations concurrently sent to the
+ *                  server. Must be at least 1
+ *
+ * Editing operations issued with functions like ogd_content_vote_queued() are kept in a write
+ * queue, and only a limited number of them is passed at the same time to the scheduler, with
+ * %OGD_PROVIDER_PRIORITY_NORMAL priority. Operations which are still waiting in the queue may be
+ * replaced by newer ones affecting the same state, so a low limit saves more requests. Default
+ * is 4
+ */
+void ogd_provider_set_write_limit (OGDProvider *provider, guint limit)
+{
+    ogd_write_queue_set_limit (provider->priv->write_queue, limit);
+}
+
+/**
+ * ogd_provider_flush_writes:
+ * @provider:       the #OGDProvider for which wait the enqueued editing operations
+ * @error:          a #GError filled if the function returns %FALSE
+ *
+ * Waits for all editing operations enqueued with functions like ogd_content_vote_queued() to be
+ * completed, running the default main context meanwhile. The result of each operation is
+ * passed to its own callback; this function only summarizes them. Must not be called from one of
+ * those callbacks
+ *
+ * Return value:    %TRUE if all operations completed since the previous flush succeeded, %FALSE
+ *                  otherwise. The reason of the last failure is available with
+ *                  ogd_provider_get_last_error()
+ */
+gboolean ogd_provider_flush_writes (OGDProvider *provider, GError **error)
+{
+    return ogd_write_queue_flush (provider->priv->write_queue, error);
+}
+
+static void handle_async_put_raw_response (SoupSession *session, SoupMessage *msg, gpointer userdata)
+{
+    GError *error;
+    xmlNode *response;
+    AsyncRequestDesc *async;
+
+    async = (AsyncRequestDesc*) userdata;
+    error = NULL;
+    response = NULL;
+
+    if (check_put_msg (async, msg, &error) == TRUE)
+        response = parse_provider_response (async->provider, msg, &error);
+    else
+        journal_failed_write (async->provider, async->query, msg);
+
+    if (error != NULL)
+        set_last_error (async->provider, g_error_copy (error));
+
+    TRACED_CALLBACK ("response handler", async->prcallback (response, error, async->userdata));
+
+    if (response != NULL)
+        xmlFreeDoc (response->doc);
+    if (error != NULL)
+        g_error_free (error);
+
+    g_free (async->query);
+    g_free (async);
+}
+
+/*
+    Async version of ogd_provider_put_raw(), which also reports the reason of a failure. The
+    response passed to @callback is NULL if the server sent no data, and is freed after the
+    callback. The error is in OGD_JOURNAL_ERROR_DOMAIN if the write is saved in the journal, as
+    for ogd_provider_put_async()
+*/
+void ogd_provider_put_raw_async (OGDProvider *provider, gchar *query, GHashTable *data,
+                                 OGDProviderPutRawAsyncCallback callback, gpointer userdata)
+{
+    SoupMessage *msg;
+    AsyncRequestDesc *async;
+
+    msg = prepare_message_to_put (provider, query, data);
+
+    async = g_new0 (AsyncRequestDesc, 1);
+    async->provider = provider;
+    async->prcallback = callback;
+    async->query = g_strdup (query);
+    async->userdata = userdata;
+
+    if (journal_async_write (provider, msg, handle_async_put_raw_response, async) == TRUE)
+        return;
+
+    ogd_scheduler_push (provider->priv->scheduler, msg, OGD_PROVIDER_PRIORITY_INTERACTIVE, userdata,
+                        handle_async_put_raw_response, async);
+}
+
+/**
+ * ogd_provider_set_rate_limit:
+ * @provider:       the #OGDProvider to configure
+ * @rate:           maximum number of requests per second sent to the server, or 0 to disable the
+ *                  limit
+ * @burst:          maximum number of requests which may be sent at once after an idle period
+ *
+ * Many providers throttle clients sending too many requests: this permits to pace both sync and
+ * async requests to stay below their limits. Independently from this setting, when the server
+ * refuses a request with status 429 or 503 all further requests are suspended for the time
+ * suggested by the "Retry-After" header (or an increasing delay, if missing) and the rate is
+ * lowered for a while. Refused GET requests are sent again accordly to the policy defined with
+ * ogd_provider_set_retry_policy(). By default no limit is applied
+ */
+void ogd_provider_set_rate_limit (OGDProvider *provider, gdouble rate, guint burst)
+{
+    ogd_rate_limiter_set_rate (provider->priv->limiter, rate, burst);
+}
+
+/**
+ * ogd_provider_set_retry_policy:
+ * @provider:       the #OGDProvider to configure
+ * @max_attempts:   maximum number of times a GET request is sent to the server, including the
+ *                  first one. 1 disables retries
+ * @base_delay:     milliseconds to wait before the first retry
+ * @multiplier:     factor by which the delay grows at each further retry
+ * @max_delay:      maximum delay between two attempts, in milliseconds
+ * @classes:        combination of #OGD_PROVIDER_RETRY_CLASS, the failures for which a request is
+ *                  sent again
+ *
+ * GET requests, both sync and async, which fail for a transient reason are transparently sent
+ * again to the server, waiting an increasing (and partially randomized) delay between attempts.
+ * Requests saving data on the server are never retried, as they may have been applied even if the
+ * response has been lost. When all attempts fail the operation is terminated: sync functions
+ * return %NULL or %FALSE, async ones invoke their callback with %NULL (the same notification
+ * issued at the end of results) and the reason is available from
+ * ogd_provider_get_last_error(). By default 4 attempts are performed for transport errors,
+ * server errors and throttling, with delays starting from 500 milliseconds, doubling each time
+ * up to 30 seconds
+ */
+void ogd_provider_set_retry_policy (OGDProvider *provider, guint max_attempts, guint base_delay, gdouble multiplier,
+                                    guint max_delay, OGD_PROVIDER_RETRY_CLASS classes)
+{
+    ogd_retry_policy_set (provider->priv->retry_policy, max_attempts, base_delay, multiplier, max_delay, classes);
+}
+
+/**
+ * ogd_provider_get_last_error:
+ * @provider:       the #OGDProvider to query
+ *
+ * To know why the last failed async operation has been terminated. Mostly intended to be called
+ * from the callback of the operation itself, when it receives %NULL before the expected results
+ *
+ * Return value:    the last error occurred on async requests, or %NULL. It is owned by the
+ *                  #OGDProvider and is valid until the next failure
+ */
+const GError* ogd_provider_get_last_error (OGDProvider *provider)
+{
+    return provider->priv->last_error;
+}
+
+/**
+ * ogd_provider_set_concurrency:
+ * @provider:       the #OGDProvider to configure
+ * @priority:       the class of requests to configure
+ * @limit:          maximum number of requests of the given class concurrently sent to the
+ *                  server. Must be at least 1
+ *
+ * Async requests are not immediately sent to the server, but enqueued and dispatched accordly
+ * to their #OGD_PROVIDER_PRIORITY: this function permits to change the number of requests of a
+ * class which may be served at the same time. Defaults are 2 for each class
+ */
+void ogd_provider_set_concurrency (OGDProvider *provider, OGD_PROVIDER_PRIORITY priority, guint limit)
+{
+    ogd_scheduler_set_limit (provider->priv->scheduler, priority, limit);
+}
+
+/**
+ * ogd_provider_get_queue_depth:
+ * @provider:       the #OGDProvider to query
+ * @priority:       the class of requests to query
+ *
+ * To know how many async requests of a given class are waiting to be sent to the server
+ *
+ * Return value:    number of requests in queue
+ */
+guint ogd_provider_get_queue_depth (OGDProvider *provider, OGD_PROVIDER_PRIORITY priority)
+{
+    return ogd_scheduler_get_depth (provider->priv->scheduler, priority);
+}
+
+/**
+ * ogd_provider_get_queue_wait:
+ * @provider:       the #OGDProvider to query
+ * @priority:       the class of requests to query
+ *
+ * To know how much time async requests of a given class have spent in queue before being sent
+ * to the server
+ *
+ * Return value:    average waiting time, in milliseconds
+ */
+gdouble ogd_provider_get_queue_wait (OGDProvider *provider, OGD_PROVIDER_PRIORITY priority)
+{
+    return ogd_scheduler_get_wait (provider->priv->scheduler, priority);
+}
+
+/**
+ * ogd_provider_get_stats_endpoints:
+ * @provider:       the #OGDProvider to query
+ *
+ * To know the endpoints of the API for which statistics have been collected, to be passed to
+ * ogd_provider_get_stats(). Endpoints are identified by the first part of the query, as
+ * "content/data" or "friend/data"
+ *
+ * Return value:    a sorted list of strings, owned by the #OGDProvider. Only the list has to be
+ *                  freed with g_list_free()
+ */
+GList* ogd_provider_get_stats_endpoints (OGDProvider *provider)
+{
+    return ogd_stats_get_endpoints (provider->priv->stats);
+}
+
+/**
+ * ogd_provider_get_stats:
+ * @provider:       the #OGDProvider to query
+ * @endpoint:       the endpoint for which retrieve statistics
+ * @stats:          structure to fill with the statistics of @endpoint
+ *
+ * Each #OGDProvider records counters and latency histograms about all requests sent to the
+ * server, both sync and async, grouped by endpoint. Values are accumulated since the creation of
+ * the #OGDProvider or the last call to ogd_provider_reset_stats()
+ *
+ * Return value:    %TRUE if statistics are available for @endpoint, %FALSE otherwise (in which
+ *                  case @stats is zeroed)
+ */
+gboolean ogd_provider_get_stats (OGDProvider *provider, const gchar *endpoint, OGDEndpointStats *stats)
+{
+    return ogd_stats_get (provider->priv->stats, endpoint, stats);
+}
+
+/**
+ * ogd_provider_dump_stats:
+ * @provider:       the #OGDProvider to query
+ *
+ * Formats statistics of all endpoints as a human readable table, one endpoint per line.
+ * Percentiles are approximated with the bounds of histograms' buckets
+ *
+ * Return value:    a newly allocated string, to be freed with g_free()
+ */
+gchar* ogd_provider_dump_stats (OGDProvider *provider)
+{
+    return ogd_stats_dump (provider->priv->stats);
+}
+
+/**
+ * ogd_provider_reset_stats:
+ * @provider:       the #OGDProvider to reset
+ *
+ * Discards all statistics collected so far
+ */
+void ogd_provider_reset_stats (OGDProvider *provider)
+{
+    ogd_stats_reset (provider->priv->stats);
+}
+
+/**
+ * ogd_provider_set_stats_dump:
+ * @provider:       the #OGDProvider to configure
+ * @interval:       seconds between two dumps, or 0 to disable them
+ *
+ * Periodically writes in the log, with g_message(), the same table returned by
+ * ogd_provider_dump_stats(). Dumps are performed by the main loop, and skipped while no
+ * statistic has been collected. Disabled by default
+ */
+void ogd_provider_set_stats_dump (OGDProvider *provider, guint interval)
+{
+    ogd_stats_set_dump_interval (provider->priv->stats, interval);
+}
+
+/**
+ * ogd_provider_record_traffic:
+ * @provider:       the #OGDProvider to record
+ * @path:           file in which save the archive, or %NULL to stop recording
+ * @error:          a #GError filled if the function returns %FALSE
+ *
+ * Saves each request sent to the server from now on, with its response and the time it took,
+ * in a file which may be later passed to ogd_provider_replay_traffic(). Any previous recording is
+ * completed. Permits to capture the traffic of a real session and use it as a reproducible
+ * benchmark or regression test
+ *
+ * Return value:    %TRUE if recording started (or has been stopped), %FALSE if @path cannot be
+ *                  written
+ */
+gboolean ogd_provider_record_traffic (OGDProvider *provider, const gchar *path, GError **error)
+{
+    OGDArchive *archive;
+
+    archive = NULL;
+
+    if (path != NULL) {
+        archive = ogd_archive_new_recording (path, error);
+        if (archive == NULL)
+            return FALSE;
+    }
+
+    if (provider->priv->recording != NULL) {
+        ogd_archive_unwatch_session (provider->priv->recording, provider->priv->http_session);
+        ogd_archive_unwatch_session (provider->priv->recording, provider->priv->async_http_session);
+        ogd_archive_free (provider->priv->recording);
+    }
+
+    provider->priv->recording = archive;
+
+    if (archive != NULL) {
+        ogd_archive_watch_session (archive, provider->priv->http_session);
+        ogd_archive_watch_session (archive, provider->priv->async_http_session);
+    }
+
+    return TRUE;
+}
+
+/**
+ * ogd_provider_replay_traffic:
+ * @provider:       the #OGDProvider to configure
+ * @path:           archive produced by ogd_provider_record_traffic(), or %NULL to contact again
+ *                  the server
+ * @time_scale:     factor applied to the recorded duration of each request: 1 reproduces the
+ *                  original timings, 0.5 halves them, 0 completes all requests immediately
+ *
+ * From now on no request is sent to the server: responses, both for sync and async functions,
+ * are taken from the archive, matching requests by method and query. When the same request has
+ * been recorded many times its responses are served in the original order, the last one being
+ * repeated when all have been used; requests not found in the archive fail with status 404.
+ * Async requests still pass through the usual queues, so priorities, concurrency limits, rate
+ * limit and retries behave as when contacting the server
+ *
+ * Return value:    %TRUE if the archive has been loaded (or replay has been stopped), %FALSE
+ *                  otherwise
+ */
+gboolean ogd_provider_replay_traffic (OGDProvider *provider, const gchar *path, gdouble time_scale, GError **error)
+{
+    OGDArchive *archive;
+
+    archive = NULL;
+
+    if (path != NULL) {
+        archive = ogd_archive_new_replay (path, time_scale, error);
+        if (archive == NULL)
+            return FALSE;
+    }
+
+    if (provider->priv->replay != NULL)
+        ogd_archive_free (provider->priv->replay);
+
+    provider->priv->replay = archive;
+    ogd_scheduler_set_replay (provider->priv->scheduler, archive);
+    return TRUE;
+}
+
+/**
+ * ogd_provider_set_identity_map:
+ * @provider:       the #OGDProvider to configure
+ * @enabled:        %TRUE to keep a single instance for each remote item, %FALSE to always create
+ *                  new objects
+ *
+ * By default a new #OGDObject is built each time an item is received from the server, so the same
+ * person or content may be alive in many copies, for example when it appears in many lists. When
+ * the identity map is enabled the #OGDProvider keeps track (without holding references) of all
+ * objects alive with an ID: when the same item is received again the existing instance is
+ * updated and returned in place of a new one, ogd_object_fill_by_id() updates also the existing
+ * instance (if another one is alive), and lists of persons (such as friends and fans) reuse
+ * those already alive without requesting them again to the server. Disabled by default
+ */
+void ogd_provider_set_identity_map (OGDProvider *provider, gboolean enabled)
+{
+    if (enabled == TRUE && provider->priv->identity_map == NULL) {
+        provider->priv->identity_map = ogd_identity_map_new ();
+    }
+    else if (enabled == FALSE && provider->priv->identity_map != NULL) {
+        ogd_identity_map_free (provider->priv->identity_map);
+        provider->priv->identity_map = NULL;
+    }
+}
+
+/**
+ * ogd_provider_set_arena_allocation:
+ * @provider:       the #OGDProvider to configure
+ * @enabled:        %TRUE to allocate strings and dates of objects in the same response together,
+ *                  %FALSE to allocate each of them on its own
+ *
+ * Objects built from a response usually allocate each of their strings and dates individually.
+ * When arena allocation is enabled all those fields, for all objects received in the same list,
+ * are carved from a single block of memory shared among them, which is freed once the last of
+ * those objects is destroyed. This reduces the number of allocations and the fragmentation of
+ * memory in long running processes, but keeps the whole block alive while any of the objects is
+ * still referenced. Values assigned later with the setters of the objects are allocated as usual.
+ * Disabled by default
+ */
+void ogd_provider_set_arena_allocation (OGDProvider *provider, gboolean enabled)
+{
+    provider->priv->arena_allocation = enabled;
+}
+
+/**
+ * ogd_provider_set_store:
+ * @provider:       the #OGDProvider to configure
+ * @path:           path of the file in which objects are saved, or %NULL to stop using the store
+ * @max_age:        seconds for which a saved object or list is used in place of a new request to
+ *                  the server. 0 means the server is always asked (and the store used only when
+ *                  it cannot be reached), G_MAXUINT that saved data never expires
+ * @error:          a #GError filled if the function return %FALSE
+ *
+ * Saves in a local file all objects received from the server, and the lists returned for each
+ * query, so they may be used again without network access, also in later runs of the application.
+ * While a store is in use ogd_provider_get() (and so #OGDIterator) and ogd_object_fill_by_id()
+ * take from it results which are fresh enough, and fall back to older ones when the server cannot
+ * be reached. Saved objects may be searched with ogd_provider_query_store(). The file grows each
+ * time an object is received: use ogd_provider_compact_store() to discard outdated copies
+ *
+ * Return value:    %TRUE if the store has been opened, %FALSE otherwise
+ */
+gboolean ogd_provider_set_store (OGDProvider *provider, const gchar *path, guint max_age, GError **error)
+{
+    OGDStore *store;
+
+    store = NULL;
+
+    if (path != NULL) {
+        store = ogd_store_open (path, error);
+        if (store == NULL)
+            return FALSE;
+    }
+
+    if (provider->priv->store != NULL)
+        ogd_store_free (provider->priv->store);
+
+    provider->priv->store = store;
+    provider->priv->store_max_age = max_age;
+    return TRUE;
+}
+
+/**
+ * ogd_provider_query_store:
+ * @provider:       the #OGDProvider whose store is queried
+ * @type:           type of the objects to return (e.g. OGD_CONTENT_TYPE), or 0 for any type
+ * @category:       ID of the category of the objects, or %NULL for any category
+ * @author:         ID of the person who created the objects, or %NULL for any author
+ * @order:          order in which objects are returned
+ * @limit:          maximum number of objects to return, 0 for all
+ *
+ * Searches objects saved in the store set with ogd_provider_set_store(), without any request to
+ * the server and regardless of their age
+ *
+ * Return value:    a list of #OGDObject, to be freed and unref'd when no longer in use. NULL if no
+ *                  object matches or no store is in use
+ */
+GList* ogd_provider_query_store (OGDProvider *provider, GType type, const gchar *category, const gchar *author,
+                                 OGD_PROVIDER_STORE_ORDER order, guint limit)
+{
+    GList *keys;
+    GList *iter;
+    GList *ret;
+    OGDObject *obj;
+
+    if (provider->priv->store == NULL)
+        return NULL;
+
+    ret = NULL;
+    keys = ogd_store_find (provider->priv->store, type, category, author, order, limit);
+
+    for (iter = keys; iter; iter = g_list_next (iter)) {
+        obj = object_from_store (provider, iter->data);
+        if (obj != NULL)
+            ret = g_list_prepend (ret, obj);
+    }
+
+    g_list_free (keys);
+    return g_list_reverse (ret);
+}
+
+/**
+ * ogd_provider_compact_store:
+ * @provider:       the #OGDProvider whose store is compacted
+ * @error:          a #GError filled if the function return %FALSE
+ *
+ * Rewrites the file of the store set with ogd_provider_set_store() keeping only the last copy of
+ * each object and list. The store is left untouched if the operation fails
+ *
+ * Return value:    %TRUE if the store has been compacted or no store is in use, %FALSE otherwise
+ */
+gboolean ogd_provider_compact_store (OGDProvider *provider, GError **error)
+{
+    if (provider->priv->store == NULL)
+        return TRUE;
+
+    return ogd_store_compact (provider->priv->store, error);
+}
+
+/**
+ * ogd_provider_set_journal:
+ * @provider:       the #OGDProvider to configure
+ * @path:           path of the file in which pending writes are saved, or %NULL to stop using
+ *                  the journal
+ * @callback:       function notified about each saved write refused by the server when sent
+ *                  again, or %NULL
+ * @userdata:       the user data for the callback
+ * @error:          a #GError filled if the function return %FALSE
+ *
+ * Saves in a local file all the writes (e.g. ogd_content_save(), ogd_content_vote(),
+ * ogd_message_send()) which cannot reach the server, because of a network failure or of an error
+ * on the server side, so they are not lost. Saved writes are sent again in the same order with
+ * ogd_provider_replay_journal(), and before any new synchronous write: while the server is still
+ * unreachable new writes are saved after them, and the functions issuing them report a failure.
+ * Async writes (e.g. ogd_content_save_async() or the ones of the write queue) issued while the
+ * journal is not empty are saved after the older writes as well, and the journal is then sent
+ * again from the main loop, one write at a time through the scheduler. The callback of each of
+ * those writes is invoked when the write itself is sent, with its actual result; if the replay
+ * stops before, since the server is still unreachable, it reports a failure and
+ * ogd_provider_get_last_error() returns an error in the %OGD_JOURNAL_ERROR_DOMAIN domain: the
+ * write is still in the journal, and must not be issued again.
+ * Each write carries an idempotency key, in the "Idempotency-Key" header, which is the same when
+ * it is sent again.
+ * The journal survives the application: writes still pending when it is opened are the ones
+ * saved in previous runs. New items created when a saved write is sent again are not assigned
+ * to any object
+ *
+ * Return value:    %TRUE if the journal has been opened, %FALSE otherwise
+ */
+gboolean ogd_provider_set_journal (OGDProvider *provider, const gchar *path, OGDJournalConflictCallback callback,
+                                   gpointer userdata, GError **error)
+{
+    OGDJournal *journal;
+
+    journal = NULL;
+
+    if (path != NULL) {
+        journal = ogd_journal_open (path, error);
+        if (journal == NULL)
+            return FALSE;
+    }
+
+    if (provider->priv->journal != NULL)
+        ogd_journal_free (provider->priv->journal);
+
+    provider->priv->journal = journal;
+    provider->priv->journal_conflict = callback;
+    provider->priv->journal_userdata = userdata;
+    return TRUE;
+}
+
+/**
+ * ogd_provider_replay_journal:
+ * @provider:       the #OGDProvider whose journal is sent
+ * @error:          a #GError filled if the function return %FALSE
+ *
+ * Sends again the writes saved in the journal set with ogd_provider_set_journal(), oldest first,
+ * until all have been sent or the server is found unreachable. Writes refused by the server are
+ * conflicts: they are dropped from the journal and notified to the callback given to
+ * ogd_provider_set_journal(). The time spent is traced as the "journal" span, see
+ * ogd_tracing_start()
+ *
+ * Return value:    %TRUE if the journal is empty, %FALSE if some write is still pending
+ */
+gboolean ogd_provider_replay_journal (OGDProvider *provider, GError **error)
+{
+    return replay_journal_entries (provider, error);
+}
+
+/**
+ * ogd_provider_get_journal_length:
+ * @provider:       the #OGDProvider to query
+ *
+ * To know how many writes are saved in the journal, waiting to be sent again
+ *
+ * Return value:    number of pending writes, 0 if no journal is in use
+ */
+guint ogd_provider_get_journal_length (OGDProvider *provider)
+{
+    if (provider->priv->journal == NULL)
+        return 0;
+
+    return ogd_journal_get_length (provider->priv->journal);
+}
+
+/*
+    Returns a new reference to the live instance of the given item, or NULL if none or if the
+    identity map is disabled
+*/
+OGDObject* ogd_provider_lookup_object (OGDProvider *provider, GType type, const gchar *id)
+{
+    OGDObject *ret;
+
+    if (provider->priv->identity_map == NULL || id == NULL)
+        return NULL;
+
+    ret = ogd_identity_map_lookup (provider->priv->identity_map, type, id);
+    if (ret != NULL)
+        g_object_ref (ret);
+
+    return ret;
+}
+
+/*
+    To be called each time @obj has been filled with @xml: returns the instance to use in place of
+    @obj (@obj itself when the identity map is disabled), without adding references
+*/
+OGDObject* ogd_provider_intern_object (OGDProvider *provider, OGDObject *obj, const xmlNode *xml)
+{
+    if (provider == NULL)
+        return obj;
+
+    if (provider->priv->store != NULL)
+        ogd_store_put_object (provider->priv->store, obj, xml);
+
+    if (provider->priv->identity_map == NULL)
+        return obj;
+
+    return ogd_identity_map_intern (provider->priv->identity_map, obj, xml);
+}
+
+/*
+    Fills @obj with the copy of the item with ID @id saved in the store, if any and not older than
+    the age set with ogd_provider_set_store() (or of any age, if @any_age is TRUE). Returns FALSE
+    if the request has to be sent to the server
+*/
+gboolean ogd_provider_fill_from_store (OGDProvider *provider, OGDObject *obj, const gchar *id, gboolean any_age)
+{
+    gboolean ret;
+    xmlNode *node;
+
+    if (provider == NULL || provider->priv->store == NULL)
+        return FALSE;
+
+    node = ogd_store_get_object (provider->priv->store, G_OBJECT_TYPE (obj), id,
+                                 any_age == TRUE ? G_MAXUINT : provider->priv->store_max_age);
+    if (node == NULL)
+        return FALSE;
+
+    ret = ogd_object_fill_by_xml (obj, node, NULL);
+    if (ret == TRUE && provider->priv->identity_map != NULL)
+        ogd_identity_map_intern (provider->priv->identity_map, obj, node);
+
+    xmlFreeDoc (node->doc);
+    return ret;
+}
+
+/*
+    Serial number of the credentials in use, changed each time ogd_provider_auth_user_and_pwd() or
+    ogd_provider_auth_api_key() is called. Used to discard informations about the current user
+    received after it has been changed
+*/
+guint ogd_provider_get_account (OGDProvider *provider)
+{
+    return provider->priv->account;
+}
+
+/*
+    ID of the current user, if already retrieved with ogd_person_get_myself_id()
+*/
+const gchar* ogd_provider_get_myself_id (OGDProvider *provider)
+{
+    return provider->priv->myself_id;
+}
+
+/*
+    Keeps the ID of the current user, if @account is still the one in use. Returns the kept copy,
+    or NULL if the credentials changed in the meantime
+*/
+const gchar* ogd_provider_set_myself_id (OGDProvider *provider, guint account, const gchar *id)
+{
+    if (account != provider->priv->account)
+        return NULL;
+
+    PTR_CHECK_FREE_NULLIFY (provider->priv->myself_id);
+    provider->priv->myself_id = g_strdup (id);
+    return provider->priv->myself_id;
+}
+
+/*
+    IDs of the folders of the current user, managed by ogd-folder.c
+*/
+OGDFolderDirectory* ogd_provider_get_folder_directory (OGDProvider *provider)
+{
+    return provider->priv->folders;
 }
@@ -49,6 +49,104 @@ struct _OGDProviderClass {
     GObjectClass    parent_class;
 };
 
+/**
+ * OGD_PROVIDER_PRIORITY:
+ * @OGD_PROVIDER_PRIORITY_INTERACTIVE:      requests the user is actively waiting for, such as
+ *                                          ogd_person_get_myself_async() or a vote
+ * @OGD_PROVIDER_PRIORITY_NORMAL:           common requests, such as listings
+ * @OGD_PROVIDER_PRIORITY_BULK:             background operations, such as the complete crawl
+ *                                          performed by ogd_iterator_fetch_async()
+ *
+ * Classes in which async requests to the #OGDProvider are scheduled. Each class has an own limit
+ * of concurrent requests ( ogd_provider_set_concurrency() ), and a request is dispatched as soon
+ * as a slot of its class is free, regardless of the requests waiting in other classes: a busy
+ * class never stalls the others. Classes are only ordered when the rate limit is reached, since
+ * the available requests are then assigned to higher classes first
+ */
+typedef enum {
+    OGD_PROVIDER_PRIORITY_INTERACTIVE,
+    OGD_PROVIDER_PRIORITY_NORMAL,
+    OGD_PROVIDER_PRIORITY_BULK
+} OGD_PROVIDER_PRIORITY;
+
+/**
+ * OGD_PROVIDER_RETRY_CLASS:
+ * @OGD_RETRY_TRANSPORT_ERRORS:             the server has not been reached, or the connection has
+ *                                          been lost before a complete response was received
+ * @OGD_RETRY_SERVER_ERRORS:                the server answered with a 5xx status
+ * @OGD_RETRY_THROTTLING:                   the server refused the request with status 429 or 503
+ *
+ * Classes of failures for which a GET request is sent again to the #OGDProvider, to be combined
+ * and passed to ogd_provider_set_retry_policy()
+ */
+typedef enum {
+    OGD_RETRY_TRANSPORT_ERRORS  = 1 << 0,
+    OGD_RETRY_SERVER_ERRORS     = 1 << 1,
+    OGD_RETRY_THROTTLING        = 1 << 2
+} OGD_PROVIDER_RETRY_CLASS;
+
+/**
+ * OGD_PROVIDER_STORE_ORDER:
+ * @OGD_STORE_ORDER_NONE:                   objects are returned in no particular order
+ * @OGD_STORE_ORDER_CHANGED:                most recently changed objects first
+ * @OGD_STORE_ORDER_SCORE:                  objects with the highest score first
+ *
+ * Orders in which ogd_provider_query_store() may return objects saved in the local store
+ */
+typedef enum {
+    OGD_STORE_ORDER_NONE,
+    OGD_STORE_ORDER_CHANGED,
+    OGD_STORE_ORDER_SCORE
+} OGD_PROVIDER_STORE_ORDER;
+
+#define OGD_STATS_HISTOGRAM_BUCKETS     16
+
+/**
+ * OGDEndpointStats:
+ * @requests:       requests sent to the endpoint, each retry counted separately
+ * @failures:       requests which have not received a successful response
+ * @bytes_in:       bytes received, headers included
+ * @bytes_out:      bytes sent, headers included
+ * @objects:        objects built from the responses
+ * @parse_time:     total milliseconds spent parsing responses and building objects
+ * @total_time:     total milliseconds spent by requests, from when they are passed to the HTTP
+ *                  session to the end of the response
+ * @connect:        histogram of the time spent before a request is written on a connection, so
+ *                  name resolution, connection establishment and wait for a free connection
+ * @first_byte:     histogram of the time to the first byte of the response
+ * @total:          histogram of the complete time of requests
+ *
+ * Statistics collected by an #OGDProvider for a single endpoint of the API, as "content/data" or
+ * "person/data". Each histogram has %OGD_STATS_HISTOGRAM_BUCKETS buckets: the bucket at index i
+ * counts requests taking less than 2^i milliseconds (and at least the bound of the previous
+ * bucket), the last one all requests slower than that
+ */
+typedef struct {
+    guint64     requests;
+    guint64     failures;
+    guint64     bytes_in;
+    guint64     bytes_out;
+    guint64     objects;
+    gdouble     parse_time;
+    gdouble     total_time;
+    guint       connect [OGD_STATS_HISTOGRAM_BUCKETS];
+    guint       first_byte [OGD_STATS_HISTOGRAM_BUCKETS];
+    guint       total [OGD_STATS_HISTOGRAM_BUCKETS];
+} OGDEndpointStats;
+
+/**
+ * OGDJournalConflictCallback:
+ * @provider:       the #OGDProvider which sent the write again
+ * @query:          query of the write, relative to the URL of the provider
+ * @key:            idempotency key of the write
+ * @error:          reason for which the server refused the write
+ * @userdata:       the user data given to ogd_provider_set_journal()
+ *
+ * Notifies a write saved in the journal which has been refused by the server when sent again
+ */
+typedef void (*OGDJournalConflictCallback) (OGDProvider *provider, const gchar *query, const gchar *key,
+                                            const GError *error, gpointer userdata);
+
 #include "ogd-object.h"
 
 GType           ogd_provider_get_type               ();
@@ -64,6 +162,38 @@ void            ogd_provider_get_async              (OGDProvider *provider, gcha
 void            ogd_provider_get_list_async         (OGDProvider *provider, gchar *query, OGDAsyncListCallback callback, gpointer userdata);
 gboolean        ogd_provider_put                    (OGDProvider *provider, gchar *query, GHashTable *data);
 void            ogd_provider_put_async              (OGDProvider *provider, gchar *query, GHashTable *data, OGDPutAsyncCallback callback, gpointer userdata);
+void            ogd_provider_set_write_limit        (OGDProvider *provider, guint limit);
+gboolean        ogd_provider_flush_writes           (OGDProvider *provider, GError **error);
+
+void            ogd_provider_set_rate_limit         (OGDProvider *provider, gdouble rate, guint burst);
+void            ogd_provider_set_retry_policy       (OGDProvider *provider, guint max_attempts, guint base_delay, gdouble multiplier,
+                                                     guint max_delay, OGD_PROVIDER_RETRY_CLASS classes);
+const GError*   ogd_provider_get_last_error         (OGDProvider *provider);
+void            ogd_provider_set_concurrency        (OGDProvider *provider, OGD_PROVIDER_PRIORITY priority, guint limit);
+guint           ogd_provider_get_queue_depth        (OGDProvider *provider, OGD_PROVIDER_PRIORITY priority);
+gdouble         ogd_provider_get_queue_wait         (OGDProvider *provider, OGD_PROVIDER_PRIORITY priority);
+
+GList*          ogd_provider_get_stats_endpoints    (OGDProvider *provider);
+gboolean        ogd_provider_get_stats              (OGDProvider *provider, const gchar *endpoint, OGDEndpointStats *stats);
+gchar*          ogd_provider_dump_stats             (OGDProvider *provider);
+void            ogd_provider_reset_stats            (OGDProvider *provider);
+void            ogd_provider_set_stats_dump         (OGDProvider *provider, guint interval);
+
+gboolean        ogd_provider_record_traffic         (OGDProvider *provider, const gchar *path, GError **error);
+gboolean        ogd_provider_replay_traffic         (OGDProvider *provider, const gchar *path, gdouble time_scale, GError **error);
+
+void            ogd_provider_set_identity_map       (OGDProvider *provider, gboolean enabled);
+void            ogd_provider_set_arena_allocation   (OGDProvider *provider, gboolean enabled);
+
+gboolean        ogd_provider_set_store              (OGDProvider *provider, const gchar *path, guint max_age, GError **error);
+GList*          ogd_provider_query_store            (OGDProvider *provider, GType type, const gchar *category, const gchar *author,
+                                                     OGD_PROVIDER_STORE_ORDER order, guint limit);
+gboolean        ogd_provider_compact_store          (OGDProvider *provider, GError **error);
+
+gboolean        ogd_provider_set_journal            (OGDProvider *provider, const gchar *path, OGDJournalConflictCallback callback,
+                                                     gpointer userdata, GError **error);
+gboolean        ogd_provider_replay_journal         (OGDProvider *provider, GError **error);
+guint           ogd_provider_get_journal_length     (OGDProvider *provider);
 
 G_END_DECLS
 
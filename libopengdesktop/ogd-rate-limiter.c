@@ -0,0 +1,203 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-rate-limiter.h"
+#include "ogd-private-utils.h"
+
+/*
+    A token bucket, shared by sync and async requests of the same OGDProvider. When the server
+    refuses a request for throttling (429 or 503) every further request is held until the delay
+    suggested by Retry-After (or an exponential backoff, if the header is missing) is elapsed,
+    and the rate is halved; each successful response then restores it a bit, up to the configured
+    one
+*/
+
+#define BACKOFF_BASE_USEC           (1 * G_USEC_PER_SEC)
+#define BACKOFF_MAX_USEC            (60 * (gint64) G_USEC_PER_SEC)
+#define MIN_RATE_DIVIDER            16
+#define RATE_RECOVERY_DIVIDER       20
+
+struct _OGDRateLimiter {
+    gdouble         rate;
+    gdouble         current_rate;
+    guint           burst;
+    gdouble         tokens;
+    gint64          last_refill;
+
+    gint64          blocked_until;
+    guint           consecutive_throttles;
+};
+
+OGDRateLimiter* ogd_rate_limiter_new ()
+{
+    OGDRateLimiter *limiter;
+
+    limiter = g_new0 (OGDRateLimiter, 1);
+    limiter->last_refill = current_usec ();
+    return limiter;
+}
+
+void ogd_rate_limiter_free (OGDRateLimiter *limiter)
+{
+    g_free (limiter);
+}
+
+/*
+    Params:
+        rate:       maximum number of requests per second, 0 for no limit
+        burst:      maximum number of requests which may be sent at once after an idle period
+*/
+void ogd_rate_limiter_set_rate (OGDRateLimiter *limiter, gdouble rate, guint burst)
+{
+    limiter->rate = rate;
+    limiter->current_rate = rate;
+    limiter->burst = MAX (burst, 1);
+    limiter->tokens = limiter->burst;
+    limiter->last_refill = current_usec ();
+}
+
+static void refill (OGDRateLimiter *limiter, gint64 now)
+{
+    limiter->tokens += ((gdouble) (now - limiter->last_refill) / G_USEC_PER_SEC) * limiter->current_rate;
+    if (limiter->tokens > limiter->burst)
+        limiter->tokens = limiter->burst;
+
+    limiter->last_refill = now;
+}
+
+/*
+    Returns the number of microseconds to wait before a new request may be sent, 0 if it can be
+    sent immediately. To be followed by ogd_rate_limiter_consume() when the request is effectively
+    sent
+*/
+gint64 ogd_rate_limiter_delay (OGDRateLimiter *limiter)
+{
+    gint64 now;
+
+    now = current_usec ();
+
+    if (now < limiter->blocked_until)
+        return limiter->blocked_until - now;
+
+    if (limiter->rate <= 0)
+        return 0;
+
+    refill (limiter, now);
+
+    if (limiter->tokens >= 1)
+        return 0;
+    else
+        return (gint64) (((1 - limiter->tokens) / limiter->current_rate) * G_USEC_PER_SEC) + 1;
+}
+
+void ogd_rate_limiter_consume (OGDRateLimiter *limiter)
+{
+    if (limiter->rate > 0)
+        limiter->tokens -= 1;
+}
+
+/*
+    Blocking version of ogd_rate_limiter_delay() + ogd_rate_limiter_consume(), for sync requests
+*/
+void ogd_rate_limiter_wait (OGDRateLimiter *limiter)
+{
+    gint64 delay;
+
+    while ((delay = ogd_rate_limiter_delay (limiter)) > 0)
+        g_usleep (delay);
+
+    ogd_rate_limiter_consume (limiter);
+}
+
+static gint64 parse_retry_after (SoupMessage *msg)
+{
+    const char *header;
+    gchar *end;
+    gint64 seconds;
+    time_t when;
+    SoupDate *date;
+
+    header = soup_message_headers_get_one (msg->response_headers, "Retry-After");
+    if (header == NULL)
+        return -1;
+
+    seconds = g_ascii_strtoll (header, &end, 10);
+    if (end != header && *end == '\0')
+        return MAX (seconds, 0) * G_USEC_PER_SEC;
+
+    date = soup_date_new_from_string (header);
+    if (date == NULL)
+        return -1;
+
+    when = soup_date_to_time_t (date);
+    soup_date_free (date);
+    return MAX ((gint64) (when - time (NULL)), 0) * G_USEC_PER_SEC;
+}
+
+static gint64 backoff_with_jitter (OGDRateLimiter *limiter)
+{
+    gint64 backoff;
+
+    backoff = BACKOFF_BASE_USEC << MIN (limiter->consecutive_throttles - 1, 6);
+    if (backoff > BACKOFF_MAX_USEC)
+        backoff = BACKOFF_MAX_USEC;
+
+    /*
+        Half fixed and half random, so many clients throttled at the same time do not come back
+        all together
+    */
+    return (backoff / 2) + (gint64) g_random_double_range (0, backoff / 2);
+}
+
+/*
+    To be called with each completed message. Returns TRUE if the server refused the request for
+    throttling, in which case the limiter has already been slowed down
+*/
+gboolean ogd_rate_limiter_check_response (OGDRateLimiter *limiter, SoupMessage *msg)
+{
+    gint64 delay;
+
+    if (msg->status_code != 429 && msg->status_code != SOUP_STATUS_SERVICE_UNAVAILABLE) {
+        limiter->consecutive_throttles = 0;
+
+        if (limiter->current_rate < limiter->rate) {
+            limiter->current_rate += limiter->rate / RATE_RECOVERY_DIVIDER;
+            if (limiter->current_rate > limiter->rate)
+                limiter->current_rate = limiter->rate;
+        }
+
+        return FALSE;
+    }
+
+    limiter->consecutive_throttles++;
+
+    delay = parse_retry_after (msg);
+    if (delay < 0)
+        delay = backoff_with_jitter (limiter);
+    else
+        delay += (gint64) g_random_double_range (0, BACKOFF_BASE_USEC);
+
+    limiter->blocked_until = MAX (limiter->blocked_until, current_usec () + delay);
+
+    if (limiter->rate > 0) {
+        limiter->current_rate = MAX (limiter->current_rate / 2, limiter->rate / MIN_RATE_DIVIDER);
+        limiter->tokens = 0;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,34 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_RATE_LIMITER_H
+#define OGD_RATE_LIMITER_H
+
+#include "ogd-provider-private.h"
+
+typedef struct _OGDRateLimiter OGDRateLimiter;
+
+OGDRateLimiter* ogd_rate_limiter_new                ();
+void            ogd_rate_limiter_free               (OGDRateLimiter *limiter);
+
+void            ogd_rate_limiter_set_rate           (OGDRateLimiter *limiter, gdouble rate, guint burst);
+gint64          ogd_rate_limiter_delay              (OGDRateLimiter *limiter);
+void            ogd_rate_limiter_consume            (OGDRateLimiter *limiter);
+void            ogd_rate_limiter_wait               (OGDRateLimiter *limiter);
+gboolean        ogd_rate_limiter_check_response     (OGDRateLimiter *limiter, SoupMessage *msg);
+
+#endif /* OGD_RATE_LIMITER_H */
@@ -0,0 +1,115 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-retry-policy.h"
+#include "ogd-private-utils.h"
+
+/*
+    Decides if and when a failed GET has to be sent again. Only GETs are retried, being the only
+    idempotent requests issued by the library: a POST may have been applied by the server even if
+    the response has been lost
+*/
+
+#define DEFAULT_MAX_ATTEMPTS        4
+#define DEFAULT_BASE_DELAY          500
+#define DEFAULT_MULTIPLIER          2
+#define DEFAULT_MAX_DELAY           30000
+#define DEFAULT_CLASSES             (OGD_RETRY_TRANSPORT_ERRORS | OGD_RETRY_SERVER_ERRORS | OGD_RETRY_THROTTLING)
+
+struct _OGDRetryPolicy {
+    guint                       max_attempts;
+    guint                       base_delay;
+    gdouble                     multiplier;
+    guint                       max_delay;
+    OGD_PROVIDER_RETRY_CLASS    classes;
+};
+
+OGDRetryPolicy* ogd_retry_policy_new ()
+{
+    OGDRetryPolicy *policy;
+
+    policy = g_new0 (OGDRetryPolicy, 1);
+    ogd_retry_policy_set (policy, DEFAULT_MAX_ATTEMPTS, DEFAULT_BASE_DELAY, DEFAULT_MULTIPLIER,
+                          DEFAULT_MAX_DELAY, DEFAULT_CLASSES);
+    return policy;
+}
+
+void ogd_retry_policy_free (OGDRetryPolicy *policy)
+{
+    g_free (policy);
+}
+
+/*
+    See ogd_provider_set_retry_policy() for the meaning of the parameters
+*/
+void ogd_retry_policy_set (OGDRetryPolicy *policy, guint max_attempts, guint base_delay,
+                           gdouble multiplier, guint max_delay, OGD_PROVIDER_RETRY_CLASS classes)
+{
+    policy->max_attempts = MAX (max_attempts, 1);
+    policy->base_delay = base_delay;
+    policy->multiplier = MAX (multiplier, 1);
+    policy->max_delay = MAX (max_delay, base_delay);
+    policy->classes = classes;
+}
+
+static OGD_PROVIDER_RETRY_CLASS status_to_class (guint status)
+{
+    if (status == 429 || status == SOUP_STATUS_SERVICE_UNAVAILABLE)
+        return OGD_RETRY_THROTTLING;
+    else if (SOUP_STATUS_IS_TRANSPORT_ERROR (status) && status != SOUP_STATUS_CANCELLED)
+        return OGD_RETRY_TRANSPORT_ERRORS;
+    else if (SOUP_STATUS_IS_SERVER_ERROR (status))
+        return OGD_RETRY_SERVER_ERRORS;
+    else
+        return 0;
+}
+
+/*
+    Params:
+        msg:        the completed message
+        attempts:   number of times the request has been sent so far, including this one
+*/
+gboolean ogd_retry_policy_should_retry (OGDRetryPolicy *policy, SoupMessage *msg, guint attempts)
+{
+    if (attempts >= policy->max_attempts || strcmp (msg->method, "GET") != 0)
+        return FALSE;
+
+    return ((status_to_class (msg->status_code) & policy->classes) != 0);
+}
+
+/*
+    Returns the microseconds to wait before the next attempt, given the number of attempts already
+    performed. The delay grows exponentially, and half of it is randomized to avoid many failed
+    requests being sent again all together
+*/
+gint64 ogd_retry_policy_delay (OGDRetryPolicy *policy, guint attempts)
+{
+    guint i;
+    gdouble delay;
+
+    delay = policy->base_delay;
+
+    for (i = 1; i < attempts && delay < policy->max_delay; i++)
+        delay *= policy->multiplier;
+
+    if (delay > policy->max_delay)
+        delay = policy->max_delay;
+
+    delay = (delay / 2) + g_random_double_range (0, delay / 2);
+    return (gint64) (delay * 1000);
+}
@@ -0,0 +1,33 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_RETRY_POLICY_H
+#define OGD_RETRY_POLICY_H
+
+#include "ogd-provider-private.h"
+
+typedef struct _OGDRetryPolicy OGDRetryPolicy;
+
+OGDRetryPolicy* ogd_retry_policy_new                ();
+void            ogd_retry_policy_free               (OGDRetryPolicy *policy);
+
+void            ogd_retry_policy_set                (OGDRetryPolicy *policy, guint max_attempts, guint base_delay,
+                                                     gdouble multiplier, guint max_delay, OGD_PROVIDER_RETRY_CLASS classes);
+gboolean        ogd_retry_policy_should_retry       (OGDRetryPolicy *policy, SoupMessage *msg, guint attempts);
+gint64          ogd_retry_policy_delay              (OGDRetryPolicy *policy, guint attempts);
+
+#endif /* OGD_RETRY_POLICY_H */
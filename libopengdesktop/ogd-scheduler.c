@@ -0,0 +1,508 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-scheduler.h"
+#include "ogd-rate-limiter.h"
+#include "ogd-retry-policy.h"
+#include "ogd-archive.h"
+#include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
+
+/*
+    The scheduler sits between the OGDProvider and the async SoupSession: each async message is
+    parked here and passed to the session only when the concurrency limit of its priority class
+    permits. Classes are served in strict order (interactive, normal, bulk), so a long background
+    crawl never delays a request the user is waiting for; inside a single class the queued
+    requests are grouped by caller and callers are served round-robin, so two iterators crawling
+    at the same time progress at the same pace instead of the first monopolizing the class.
+    Before any dispatch the provider's rate limiter is consulted, and when it asks to wait the
+    whole queue is suspended until a timeout fires. Failed GETs are sent again as permitted by the
+    provider's retry policy: a throttled request goes back on top of its lane (the limiter already
+    holds the whole queue), any other is parked aside until its own backoff delay expires.
+    When the provider replays an archive, dispatched messages are filled from it instead of being
+    passed to the session, and completed after the recorded time
+*/
+
+#define DEFAULT_INTERACTIVE_LIMIT       2
+#define DEFAULT_NORMAL_LIMIT            2
+#define DEFAULT_BULK_LIMIT              2
+
+typedef struct {
+    OGDScheduler            *scheduler;
+    SoupMessage             *msg;
+    OGD_PROVIDER_PRIORITY   priority;
+    gpointer                caller;
+    SoupSessionCallback     callback;
+    gpointer                userdata;
+    gint64                  enqueued;
+    guint                   attempts;
+    guint                   timer;
+} ScheduledRequest;
+
+typedef struct {
+    gpointer                caller;
+    GQueue                  *requests;
+} CallerLane;
+
+typedef struct {
+    GQueue                  *lanes;
+    GHashTable              *lanes_by_caller;
+    guint                   depth;
+    guint                   running;
+    guint                   limit;
+
+    guint64                 dispatched;
+    gint64                  total_wait;
+} PriorityClass;
+
+struct _OGDScheduler {
+    SoupSession             *session;
+    OGDRateLimiter          *limiter;
+    OGDRetryPolicy          *policy;
+    OGDArchive              *replay;
+    GList                   *backing_off;
+    GList                   *replaying;
+    guint                   timer;
+    gboolean                closing;
+    PriorityClass           classes [OGD_PROVIDER_PRIORITIES];
+};
+
+static void update_session_limits (OGDScheduler *scheduler)
+{
+    int i;
+    guint total;
+
+    /*
+        SoupSession has its own FIFO queue when the number of connections to the same host is
+        exhausted: that would reorder requests we have already sorted, so the session is
+        permitted to open exactly as many connections as the sum of all classes' limits
+    */
+    for (i = 0, total = 0; i < OGD_PROVIDER_PRIORITIES; i++)
+        total += scheduler->classes [i].limit;
+
+    g_object_set (scheduler->session, SOUP_SESSION_MAX_CONNS_PER_HOST, total, NULL);
+}
+
+/*
+    Each OGDProvider owns one scheduler, bound to its async session, to its rate limiter and to its
+    retry policy. Free it with ogd_scheduler_free()
+*/
+OGDScheduler* ogd_scheduler_new (SoupSession *session, OGDRateLimiter *limiter, OGDRetryPolicy *policy)
+{
+    int i;
+    OGDScheduler *scheduler;
+
+    scheduler = g_new0 (OGDScheduler, 1);
+    scheduler->session = session;
+    scheduler->limiter = limiter;
+    scheduler->policy = policy;
+
+    for (i = 0; i < OGD_PROVIDER_PRIORITIES; i++) {
+        scheduler->classes [i].lanes = g_queue_new ();
+        scheduler->classes [i].lanes_by_caller = g_hash_table_new (g_direct_hash, g_direct_equal);
+    }
+
+    scheduler->classes [OGD_PROVIDER_PRIORITY_INTERACTIVE].limit = DEFAULT_INTERACTIVE_LIMIT;
+    scheduler->classes [OGD_PROVIDER_PRIORITY_NORMAL].limit = DEFAULT_NORMAL_LIMIT;
+    scheduler->classes [OGD_PROVIDER_PRIORITY_BULK].limit = DEFAULT_BULK_LIMIT;
+    update_session_limits (scheduler);
+
+    return scheduler;
+}
+
+static void request_completed (SoupSession *session, SoupMessage *msg, gpointer userdata);
+
+/*
+    Completes a request which has not been dispatched (or is waiting for a retry) as cancelled,
+    as the session does with the ones it aborts
+*/
+static void abort_request (OGDScheduler *scheduler, ScheduledRequest *req)
+{
+    gpointer operation;
+
+    soup_message_set_status (req->msg, SOUP_STATUS_CANCELLED);
+
+    if (req->callback != NULL) {
+        operation = ogd_tracing_set_operation (req->caller);
+        req->callback (scheduler->session, req->msg, req->userdata);
+        ogd_tracing_set_operation (operation);
+    }
+
+    g_object_unref (req->msg);
+    g_free (req);
+}
+
+/*
+    All requests are aborted: the ones still waiting in queue or for a retry are completed as
+    cancelled, the ones already dispatched are aborted by the session. Take care callbacks of all
+    requests are invoked before this function returns
+*/
+void ogd_scheduler_free (OGDScheduler *scheduler)
+{
+    int i;
+    SoupMessage *msg;
+    CallerLane *lane;
+    ScheduledRequest *req;
+    PriorityClass *class;
+
+    scheduler->closing = TRUE;
+
+    if (scheduler->timer != 0) {
+        g_source_remove (scheduler->timer);
+        scheduler->timer = 0;
+    }
+
+    while (scheduler->backing_off != NULL) {
+        req = (ScheduledRequest*) scheduler->backing_off->data;
+        scheduler->backing_off = g_list_delete_link (scheduler->backing_off, scheduler->backing_off);
+        g_source_remove (req->timer);
+        abort_request (scheduler, req);
+    }
+
+    /*
+        Replayed requests are aborted as the session does with its own
+    */
+    while (scheduler->replaying != NULL) {
+        req = (ScheduledRequest*) scheduler->replaying->data;
+        scheduler->replaying = g_list_delete_link (scheduler->replaying, scheduler->replaying);
+        g_source_remove (req->timer);
+
+        msg = req->msg;
+        soup_message_set_status (msg, SOUP_STATUS_CANCELLED);
+        request_completed (scheduler->session, msg, req);
+        g_object_unref (msg);
+    }
+
+    for (i = 0; i < OGD_PROVIDER_PRIORITIES; i++) {
+        class = &(scheduler->classes [i]);
+
+        while ((lane = g_queue_pop_head (class->lanes)) != NULL) {
+            while ((req = g_queue_pop_head (lane->requests)) != NULL) {
+                class->depth--;
+                abort_request (scheduler, req);
+            }
+
+            g_queue_free (lane->requests);
+            g_free (lane);
+        }
+
+        g_queue_free (class->lanes);
+        g_hash_table_destroy (class->lanes_by_caller);
+    }
+
+    soup_session_abort (scheduler->session);
+    g_free (scheduler);
+}
+
+static ScheduledRequest* pop_next_request (PriorityClass *class)
+{
+    CallerLane *lane;
+    ScheduledRequest *req;
+
+    lane = g_queue_pop_head (class->lanes);
+    if (lane == NULL)
+        return NULL;
+
+    req = g_queue_pop_head (lane->requests);
+    class->depth--;
+
+    /*
+        The lane just served goes to the end of the ring, so the next request of this class is
+        taken from another caller (if any)
+    */
+    if (g_queue_is_empty (lane->requests)) {
+        g_hash_table_remove (class->lanes_by_caller, lane->caller);
+        g_queue_free (lane->requests);
+        g_free (lane);
+    }
+    else {
+        g_queue_push_tail (class->lanes, lane);
+    }
+
+    return req;
+}
+
+static void enqueue_request (OGDScheduler *scheduler, ScheduledRequest *req, gboolean first)
+{
+    CallerLane *lane;
+    PriorityClass *class;
+
+    class = &(scheduler->classes [req->priority]);
+
+    lane = g_hash_table_lookup (class->lanes_by_caller, req->caller);
+    if (lane == NULL) {
+        lane = g_new0 (CallerLane, 1);
+        lane->caller = req->caller;
+        lane->requests = g_queue_new ();
+        g_hash_table_insert (class->lanes_by_caller, req->caller, lane);
+
+        if (first == TRUE)
+            g_queue_push_head (class->lanes, lane);
+        else
+            g_queue_push_tail (class->lanes, lane);
+    }
+
+    if (first == TRUE)
+        g_queue_push_head (lane->requests, req);
+    else
+        g_queue_push_tail (lane->requests, req);
+
+    class->depth++;
+}
+
+static void dispatch_requests (OGDScheduler *scheduler);
+
+static gboolean resume_request (gpointer userdata)
+{
+    ScheduledRequest *req;
+    OGDScheduler *scheduler;
+
+    req = (ScheduledRequest*) userdata;
+    scheduler = req->scheduler;
+
+    req->timer = 0;
+    req->enqueued = current_usec ();
+    scheduler->backing_off = g_list_remove (scheduler->backing_off, req);
+
+    enqueue_request (scheduler, req, TRUE);
+    dispatch_requests (scheduler);
+    return FALSE;
+}
+
+static gboolean retry_failed (OGDScheduler *scheduler, ScheduledRequest *req, SoupMessage *msg, gboolean throttled)
+{
+    gint64 delay;
+
+    if (scheduler->closing == TRUE || ogd_retry_policy_should_retry (scheduler->policy, msg, req->attempts) == FALSE)
+        return FALSE;
+
+    /*
+        The original message is owned (and freed) by the session once this callback returns, a
+        new one is built for the same URI
+    */
+    req->msg = soup_message_new_from_uri ("GET", soup_message_get_uri (msg));
+
+    if (throttled == TRUE) {
+        req->enqueued = current_usec ();
+        enqueue_request (scheduler, req, TRUE);
+    }
+    else {
+        delay = ogd_retry_policy_delay (scheduler->policy, req->attempts);
+        req->timer = g_timeout_add ((guint) ((delay + 999) / 1000), resume_request, req);
+        scheduler->backing_off = g_list_prepend (scheduler->backing_off, req);
+    }
+
+    return TRUE;
+}
+
+static void request_completed (SoupSession *session, SoupMessage *msg, gpointer userdata)
+{
+    gboolean throttled;
+    gpointer operation;
+    ScheduledRequest *req;
+    OGDScheduler *scheduler;
+
+    req = (ScheduledRequest*) userdata;
+    scheduler = req->scheduler;
+    scheduler->classes [req->priority].running--;
+    ogd_tracing_request_end (msg, TRUE);
+
+    throttled = ogd_rate_limiter_check_response (scheduler->limiter, msg);
+
+    if (retry_failed (scheduler, req, msg, throttled) == TRUE) {
+        dispatch_requests (scheduler);
+        return;
+    }
+
+    /*
+        All spans traced while handling the response are attributed to the operation which issued
+        the request
+    */
+    if (req->callback != NULL) {
+        operation = ogd_tracing_set_operation (req->caller);
+        req->callback (session, msg, req->userdata);
+        ogd_tracing_set_operation (operation);
+    }
+
+    g_free (req);
+
+    if (scheduler->closing == FALSE)
+        dispatch_requests (scheduler);
+}
+
+static gboolean delayed_dispatch (gpointer userdata)
+{
+    OGDScheduler *scheduler;
+
+    scheduler = (OGDScheduler*) userdata;
+    scheduler->timer = 0;
+    dispatch_requests (scheduler);
+    return FALSE;
+}
+
+static gboolean replay_completed (gpointer userdata)
+{
+    SoupMessage *msg;
+    ScheduledRequest *req;
+    OGDScheduler *scheduler;
+
+    req = (ScheduledRequest*) userdata;
+    scheduler = req->scheduler;
+
+    req->timer = 0;
+    scheduler->replaying = g_list_remove (scheduler->replaying, req);
+
+    /*
+        As the session does, the message is unref'd once the callback returns
+    */
+    msg = req->msg;
+    request_completed (scheduler->session, msg, req);
+    g_object_unref (msg);
+    return FALSE;
+}
+
+static void replay_request (OGDScheduler *scheduler, ScheduledRequest *req)
+{
+    gint64 delay;
+
+    delay = ogd_archive_replay (scheduler->replay, req->msg);
+    req->timer = g_timeout_add ((guint) ((delay + 999) / 1000), replay_completed, req);
+    scheduler->replaying = g_list_prepend (scheduler->replaying, req);
+}
+
+static void dispatch_requests (OGDScheduler *scheduler)
+{
+    int i;
+    gint64 delay;
+    ScheduledRequest *req;
+    PriorityClass *class;
+
+    for (i = 0; i < OGD_PROVIDER_PRIORITIES; i++) {
+        class = &(scheduler->classes [i]);
+
+        while (class->running < class->limit && class->depth != 0) {
+            delay = ogd_rate_limiter_delay (scheduler->limiter);
+
+            if (delay > 0) {
+                if (scheduler->timer == 0)
+                    scheduler->timer = g_timeout_add ((guint) ((delay + 999) / 1000), delayed_dispatch, scheduler);
+                return;
+            }
+
+            req = pop_next_request (class);
+            ogd_rate_limiter_consume (scheduler->limiter);
+
+            req->attempts++;
+            class->running++;
+            class->dispatched++;
+            class->total_wait += current_usec () - req->enqueued;
+
+            ogd_tracing_request_begin (req->msg, TRUE, req->caller);
+
+            if (scheduler->replay != NULL)
+                replay_request (scheduler, req);
+            else
+                soup_session_queue_message (scheduler->session, req->msg, request_completed, req);
+        }
+    }
+}
+
+/*
+    Params:
+        msg:        the SoupMessage to send. The scheduler takes ownership of the reference
+        priority:   class of the request
+        caller:     arbitrary pointer identifying the operation which issued the request, used to
+                    keep fairness among different operations with the same priority
+        callback:   invoked when the message is completed, as for soup_session_queue_message()
+        userdata:   the user data for the callback
+*/
+void ogd_scheduler_push (OGDScheduler *scheduler, SoupMessage *msg, OGD_PROVIDER_PRIORITY priority,
+                         gpointer caller, SoupSessionCallback callback, gpointer userdata)
+{
+    ScheduledRequest *req;
+
+    req = g_new0 (ScheduledRequest, 1);
+    req->scheduler = scheduler;
+    req->msg = msg;
+    req->priority = priority;
+    req->caller = caller;
+    req->callback = callback;
+    req->userdata = userdata;
+    req->enqueued = current_usec ();
+
+    /*
+        Requests issued by callbacks of aborted ones, while the scheduler is being freed
+    */
+    if (scheduler->closing == TRUE) {
+        abort_request (scheduler, req);
+        return;
+    }
+
+    enqueue_request (scheduler, req, FALSE);
+    dispatch_requests (scheduler);
+}
+
+/*
+    Params:
+        archive:    archive from which serve requests dispatched from now on, or NULL to send them
+                    again to the server. It is not owned by the scheduler
+*/
+void ogd_scheduler_set_replay (OGDScheduler *scheduler, OGDArchive *archive)
+{
+    scheduler->replay = archive;
+}
+
+/*
+    Changes the maximum number of requests of the given class concurrently sent to the server.
+    Cannot be 0
+*/
+void ogd_scheduler_set_limit (OGDScheduler *scheduler, OGD_PROVIDER_PRIORITY priority, guint limit)
+{
+    if (limit == 0) {
+        g_warning ("Concurrency limit must be at least 1");
+        return;
+    }
+
+    scheduler->classes [priority].limit = limit;
+    update_session_limits (scheduler);
+    dispatch_requests (scheduler);
+}
+
+/*
+    Number of requests of the given class still waiting to be dispatched
+*/
+guint ogd_scheduler_get_depth (OGDScheduler *scheduler, OGD_PROVIDER_PRIORITY priority)
+{
+    return scheduler->classes [priority].depth;
+}
+
+/*
+    Average time (in milliseconds) spent in queue by requests of the given class before being
+    dispatched
+*/
+gdouble ogd_scheduler_get_wait (OGDScheduler *scheduler, OGD_PROVIDER_PRIORITY priority)
+{
+    PriorityClass *class;
+
+    class = &(scheduler->classes [priority]);
+
+    if (class->dispatched == 0)
+        return 0;
+    else
+        return ((gdouble) class->total_wait / class->dispatched) / 1000;
+}
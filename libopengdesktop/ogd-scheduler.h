@@ -0,0 +1,39 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_SCHEDULER_H
+#define OGD_SCHEDULER_H
+
+#include "ogd-provider-private.h"
+#include "ogd-rate-limiter.h"
+#include "ogd-retry-policy.h"
+#include "ogd-archive.h"
+
+typedef struct _OGDScheduler OGDScheduler;
+
+OGDScheduler*   ogd_scheduler_new                   (SoupSession *session, OGDRateLimiter *limiter, OGDRetryPolicy *policy);
+void            ogd_scheduler_free                  (OGDScheduler *scheduler);
+
+void            ogd_scheduler_push                  (OGDScheduler *scheduler, SoupMessage *msg, OGD_PROVIDER_PRIORITY priority,
+                                                     gpointer caller, SoupSessionCallback callback, gpointer userdata);
+
+void            ogd_scheduler_set_replay            (OGDScheduler *scheduler, OGDArchive *archive);
+void            ogd_scheduler_set_limit             (OGDScheduler *scheduler, OGD_PROVIDER_PRIORITY priority, guint limit);
+guint           ogd_scheduler_get_depth             (OGDScheduler *scheduler, OGD_PROVIDER_PRIORITY priority);
+gdouble         ogd_scheduler_get_wait              (OGDScheduler *scheduler, OGD_PROVIDER_PRIORITY priority);
+
+#endif /* OGD_SCHEDULER_H */
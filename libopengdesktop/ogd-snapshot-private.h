@@ -0,0 +1,62 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_SNAPSHOT_PRIVATE_H
+#define OGD_SNAPSHOT_PRIVATE_H
+
+#include "ogd-snapshot.h"
+
+typedef enum {
+    OGD_SNAPSHOT_STRING,
+    OGD_SNAPSHOT_STRING_LIST,
+    OGD_SNAPSHOT_INTEGER,
+    OGD_SNAPSHOT_DOUBLE
+} OGD_SNAPSHOT_KIND;
+
+/*
+    Lists are passed to the writer as GList of strings, and to the reader as a block of
+    consecutive strings terminated by an empty one, to be unpacked with ogd_snapshot_unpack_list()
+*/
+typedef union {
+    const gchar     *string;
+    const GList     *list;
+    gint64          integer;
+    gdouble         real;
+} OGDSnapshotValue;
+
+/*
+    Describes how objects of a type are saved in a snapshot: the first field is always the ID.
+    Strings passed to fill_by_values() point into the snapshot, and have to be assigned to the
+    object without copying them (they are owned by the current arena)
+*/
+typedef struct {
+    guint                   n_fields;
+    const OGD_SNAPSHOT_KIND *kinds;
+    void                    (*to_values)        (OGDObject *obj, OGDSnapshotValue *values);
+    void                    (*fill_by_values)   (OGDObject *obj, const OGDSnapshotValue *values);
+} OGDSnapshotSchema;
+
+const OGDSnapshotSchema*    ogd_category_get_snapshot_schema    ();
+const OGDSnapshotSchema*    ogd_content_get_snapshot_schema     ();
+const OGDSnapshotSchema*    ogd_person_get_snapshot_schema      ();
+
+void                        ogd_snapshot_fill_object            (OGDObject *obj, const OGDSnapshotValue *values);
+GList*                      ogd_snapshot_unpack_list            (const gchar *block);
+gint64                      ogd_snapshot_pack_date              (const GDate *date);
+GDate*                      ogd_snapshot_unpack_date            (gint64 julian);
+
+#endif /* OGD_SNAPSHOT_PRIVATE_H */
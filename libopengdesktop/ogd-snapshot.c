@@ -0,0 +1,679 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+
+#include "ogd.h"
+#include "ogd-snapshot.h"
+#include "ogd-snapshot-private.h"
+#include "ogd-private-utils.h"
+
+/**
+ * SECTION: ogd-snapshot
+ * @short_description:  binary dump of objects, to be exchanged between processes
+ *
+ * A snapshot saves a set of #OGDCategory, #OGDContent and #OGDPerson in a compact binary file,
+ * so that another process may load them without requesting and parsing them again. The file is
+ * designed to be mapped in memory and used as is: opening a snapshot costs the same regardless of
+ * the number of objects inside, and each object is built only when requested with
+ * ogd_snapshot_get_object(), with its strings pointing directly into the mapped file
+ */
+
+/*
+    The file is made by:
+
+        header          magic string, version, number of sections, position and size of the
+                        string table
+        sections        for each type of object: name of the type, number of objects, number of
+                        fields, position of the columns
+        columns         for each section and for each field, one 64 bits value per object:
+                        integers, doubles, or offsets in the string table
+        strings         all strings, NUL terminated. Offset 0 stands for NULL, offset 1 for the
+                        empty string. Lists are consecutive strings terminated by an empty one
+
+    All numbers are little endian, and all columns are aligned to 8 bytes. The version changes
+    each time the fields saved for a type are changed
+*/
+
+#define SNAPSHOT_MAGIC          "OGD-SNAP"
+#define SNAPSHOT_VERSION        1
+#define TYPE_NAME_SIZE          32
+
+typedef struct {
+    gchar           magic [8];
+    guint32         version;
+    guint32         n_sections;
+    guint64         strings_offset;
+    guint64         strings_size;
+} SnapshotHeader;
+
+typedef struct {
+    gchar           type_name [TYPE_NAME_SIZE];
+    guint32         n_rows;
+    guint32         n_columns;
+    guint64         columns_offset;
+} SnapshotSectionHeader;
+
+typedef struct {
+    GType                   type;
+    const OGDSnapshotSchema *schema;
+    gulong                  n_rows;
+    const guint64           *columns;
+} SnapshotSection;
+
+struct _OGDSnapshot {
+    OGDProvider             *provider;
+    GMappedFile             *file;
+    OGDArena                *arena;
+    const gchar             *strings;
+    gsize                   strings_size;
+    GList                   *sections;
+};
+
+typedef union {
+    gdouble         real;
+    guint64         bits;
+} DoubleBits;
+
+typedef struct {
+    GType           type;
+    const OGDSnapshotSchema *(*schema) ();
+} SchemaEntry;
+
+static const OGDSnapshotSchema* schema_for_type (GType type)
+{
+    int i;
+    SchemaEntry schemas [] = {
+        { OGD_CATEGORY_TYPE, ogd_category_get_snapshot_schema },
+        { OGD_CONTENT_TYPE, ogd_content_get_snapshot_schema },
+        { OGD_PERSON_TYPE, ogd_person_get_snapshot_schema },
+    };
+
+    for (i = 0; i < G_N_ELEMENTS (schemas); i++)
+        if (schemas [i].type == type)
+            return schemas [i].schema ();
+
+    return NULL;
+}
+
+/*
+    To be used by fill_by_values() callbacks to fill sub-objects. @obj keeps a reference to the
+    current arena, which owns the strings it points to
+*/
+void ogd_snapshot_fill_object (OGDObject *obj, const OGDSnapshotValue *values)
+{
+    OGDArena *arena;
+
+    schema_for_type (G_OBJECT_TYPE (obj))->fill_by_values (obj, values);
+
+    arena = ogd_arena_get_current ();
+    if (arena != NULL)
+        ogd_object_attach_arena (obj, arena);
+}
+
+/*
+    Elements of the returned list point into @block: only the list has to be freed
+*/
+GList* ogd_snapshot_unpack_list (const gchar *block)
+{
+    GList *ret;
+
+    ret = NULL;
+
+    if (block == NULL)
+        return NULL;
+
+    while (*block != '\0') {
+        ret = g_list_prepend (ret, (gchar*) block);
+        block += strlen (block) + 1;
+    }
+
+    return g_list_reverse (ret);
+}
+
+gint64 ogd_snapshot_pack_date (const GDate *date)
+{
+    if (date == NULL || g_date_valid (date) == FALSE)
+        return 0;
+    else
+        return g_date_get_julian (date);
+}
+
+GDate* ogd_snapshot_unpack_date (gint64 julian)
+{
+    if (julian <= 0)
+        return NULL;
+    else
+        return g_date_new_julian ((guint32) julian);
+}
+
+/*
+    Writing
+*/
+
+typedef struct {
+    GString         *strings;
+    GHashTable      *offsets;
+} StringTable;
+
+static guint64 intern_string (StringTable *table, const gchar *str)
+{
+    gpointer offset;
+
+    if (str == NULL)
+        return 0;
+
+    if (g_hash_table_lookup_extended (table->offsets, str, NULL, &offset) == TRUE)
+        return GPOINTER_TO_SIZE (offset);
+
+    offset = GSIZE_TO_POINTER (table->strings->len);
+    g_string_append_len (table->strings, str, strlen (str) + 1);
+    g_hash_table_insert (table->offsets, (gchar*) str, offset);
+    return GPOINTER_TO_SIZE (offset);
+}
+
+static guint64 append_list (StringTable *table, const GList *list)
+{
+    guint64 ret;
+
+    if (list == NULL)
+        return 0;
+
+    ret = table->strings->len;
+
+    for (; list; list = g_list_next (list))
+        g_string_append_len (table->strings, list->data, strlen (list->data) + 1);
+
+    g_string_append_c (table->strings, '\0');
+    return ret;
+}
+
+static guint64 encode_value (StringTable *table, OGD_SNAPSHOT_KIND kind, OGDSnapshotValue *value)
+{
+    DoubleBits bits;
+
+    switch (kind) {
+        case OGD_SNAPSHOT_STRING:
+            return intern_string (table, value->string);
+
+        case OGD_SNAPSHOT_STRING_LIST:
+            return append_list (table, value->list);
+
+        case OGD_SNAPSHOT_INTEGER:
+            return (guint64) value->integer;
+
+        case OGD_SNAPSHOT_DOUBLE:
+            bits.real = value->real;
+            return bits.bits;
+
+        default:
+            return 0;
+    }
+}
+
+/*
+    Columns are encoded in memory, column by column, while strings are collected in @table
+*/
+static guint64* encode_section (StringTable *table, const OGDSnapshotSchema *schema, GPtrArray *objects)
+{
+    guint i;
+    guint field;
+    guint64 *columns;
+    OGDSnapshotValue *values;
+
+    columns = g_new0 (guint64, (gsize) schema->n_fields * objects->len);
+    values = g_new0 (OGDSnapshotValue, schema->n_fields);
+
+    for (i = 0; i < objects->len; i++) {
+        memset (values, 0, sizeof (OGDSnapshotValue) * schema->n_fields);
+        schema->to_values (g_ptr_array_index (objects, i), values);
+
+        for (field = 0; field < schema->n_fields; field++)
+            columns [(gsize) field * objects->len + i] = GUINT64_TO_LE (encode_value (table, schema->kinds [field], &values [field]));
+    }
+
+    g_free (values);
+    return columns;
+}
+
+static void free_sections (GHashTable *sections)
+{
+    GHashTableIter iter;
+    gpointer array;
+
+    g_hash_table_iter_init (&iter, sections);
+
+    while (g_hash_table_iter_next (&iter, NULL, &array))
+        g_ptr_array_free (array, TRUE);
+
+    g_hash_table_destroy (sections);
+}
+
+/*
+    The file is written aside and then moved to @path, so that readers never map a partial file
+*/
+static gboolean write_file (const gchar *path, SnapshotHeader *header, GArray *section_headers, GList *columns,
+                            GArray *column_sizes, GString *strings, GError **error)
+{
+    guint i;
+    gboolean ret;
+    gchar *temp_path;
+    FILE *file;
+    GList *iter;
+
+    temp_path = g_strdup_printf ("%s.tmp", path);
+    file = fopen (temp_path, "wb");
+
+    if (file == NULL) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to write snapshot %s: %s", path, g_strerror (errno));
+        g_free (temp_path);
+        return FALSE;
+    }
+
+    fwrite (header, sizeof (SnapshotHeader), 1, file);
+    fwrite (section_headers->data, sizeof (SnapshotSectionHeader), section_headers->len, file);
+
+    for (iter = columns, i = 0; iter; iter = g_list_next (iter), i++)
+        fwrite (iter->data, sizeof (guint64), g_array_index (column_sizes, gsize, i), file);
+
+    fwrite (strings->str, 1, strings->len, file);
+
+    ret = (ferror (file) == 0);
+    ret = (fclose (file) == 0) && ret;
+    ret = ret && (g_rename (temp_path, path) == 0);
+
+    if (ret == FALSE) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to write snapshot %s: %s", path, g_strerror (errno));
+        g_unlink (temp_path);
+    }
+
+    g_free (temp_path);
+    return ret;
+}
+
+/**
+ * ogd_snapshot_write:
+ * @path:           path of the file to write
+ * @objects:        list of #OGDObject to save
+ * @error:          a #GError filled if the function return %FALSE
+ *
+ * Saves @objects in a snapshot, to be opened with ogd_snapshot_open(). Only #OGDCategory,
+ * #OGDContent and #OGDPerson may be saved, other objects in @objects are skipped. Objects are
+ * saved with the data they hold at the moment, no request is sent to the server
+ *
+ * Return value:    %TRUE if the snapshot has been written, %FALSE otherwise
+ */
+gboolean ogd_snapshot_write (const gchar *path, GList *objects, GError **error)
+{
+    gboolean ret;
+    guint64 offset;
+    GType type;
+    GList *iter;
+    GList *columns;
+    GArray *section_headers;
+    GArray *column_sizes;
+    GHashTable *sections;
+    GHashTableIter sections_iter;
+    gpointer key;
+    gpointer value;
+    GPtrArray *array;
+    StringTable table;
+    SnapshotHeader header;
+    SnapshotSectionHeader section;
+    gsize size;
+    const OGDSnapshotSchema *schema;
+
+    sections = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    for (iter = objects; iter; iter = g_list_next (iter)) {
+        type = G_OBJECT_TYPE (iter->data);
+
+        if (schema_for_type (type) == NULL) {
+            g_warning ("Objects of type %s cannot be saved in a snapshot", g_type_name (type));
+            continue;
+        }
+
+        array = g_hash_table_lookup (sections, GSIZE_TO_POINTER (type));
+
+        if (array == NULL) {
+            array = g_ptr_array_new ();
+            g_hash_table_insert (sections, GSIZE_TO_POINTER (type), array);
+        }
+
+        g_ptr_array_add (array, iter->data);
+    }
+
+    table.strings = g_string_new_len ("\0", 2);
+    table.offsets = g_hash_table_new (g_str_hash, g_str_equal);
+    g_hash_table_insert (table.offsets, "", GSIZE_TO_POINTER (1));
+
+    section_headers = g_array_new (FALSE, TRUE, sizeof (SnapshotSectionHeader));
+    column_sizes = g_array_new (FALSE, FALSE, sizeof (gsize));
+    columns = NULL;
+
+    offset = sizeof (SnapshotHeader) + sizeof (SnapshotSectionHeader) * g_hash_table_size (sections);
+    g_hash_table_iter_init (&sections_iter, sections);
+
+    while (g_hash_table_iter_next (&sections_iter, &key, &value)) {
+        type = (GType) GPOINTER_TO_SIZE (key);
+        array = value;
+        schema = schema_for_type (type);
+
+        memset (&section, 0, sizeof (SnapshotSectionHeader));
+        g_strlcpy (section.type_name, g_type_name (type), TYPE_NAME_SIZE);
+        section.n_rows = GUINT32_TO_LE (array->len);
+        section.n_columns = GUINT32_TO_LE (schema->n_fields);
+        section.columns_offset = GUINT64_TO_LE (offset);
+        g_array_append_val (section_headers, section);
+
+        columns = g_list_prepend (columns, encode_section (&table, schema, array));
+        size = (gsize) schema->n_fields * array->len;
+        g_array_append_val (column_sizes, size);
+        offset += size * sizeof (guint64);
+    }
+
+    columns = g_list_reverse (columns);
+
+    memset (&header, 0, sizeof (SnapshotHeader));
+    memcpy (header.magic, SNAPSHOT_MAGIC, sizeof (header.magic));
+    header.version = GUINT32_TO_LE (SNAPSHOT_VERSION);
+    header.n_sections = GUINT32_TO_LE (section_headers->len);
+    header.strings_offset = GUINT64_TO_LE (offset);
+    header.strings_size = GUINT64_TO_LE (table.strings->len);
+
+    ret = write_file (path, &header, section_headers, columns, column_sizes, table.strings, error);
+
+    for (iter = columns; iter; iter = g_list_next (iter))
+        g_free (iter->data);
+
+    g_list_free (columns);
+    g_array_free (column_sizes, TRUE);
+    g_array_free (section_headers, TRUE);
+    g_hash_table_destroy (table.offsets);
+    g_string_free (table.strings, TRUE);
+    free_sections (sections);
+    return ret;
+}
+
+/*
+    Reading
+*/
+
+static gboolean invalid_snapshot (GError **error, const gchar *path, const gchar *reason)
+{
+    g_set_error (error, OGD_PARSING_ERROR_DOMAIN, OGD_XML_ERROR, "Invalid snapshot %s: %s", path, reason);
+    return FALSE;
+}
+
+static gboolean load_sections (OGDSnapshot *snapshot, const gchar *path, const gchar *data, gsize length, GError **error)
+{
+    guint i;
+    guint32 n_sections;
+    guint64 offset;
+    guint64 size;
+    gchar type_name [TYPE_NAME_SIZE + 1];
+    const SnapshotHeader *header;
+    const SnapshotSectionHeader *sections;
+    SnapshotSection *section;
+
+    if (length < sizeof (SnapshotHeader))
+        return invalid_snapshot (error, path, "truncated header");
+
+    header = (const SnapshotHeader*) data;
+
+    if (memcmp (header->magic, SNAPSHOT_MAGIC, sizeof (header->magic)) != 0)
+        return invalid_snapshot (error, path, "not a snapshot");
+
+    if (GUINT32_FROM_LE (header->version) != SNAPSHOT_VERSION)
+        return invalid_snapshot (error, path, "unsupported version");
+
+    n_sections = GUINT32_FROM_LE (header->n_sections);
+    offset = GUINT64_FROM_LE (header->strings_offset);
+    size = GUINT64_FROM_LE (header->strings_size);
+
+    /*
+        A table terminated by NUL grants that no string read from it runs outside the file
+    */
+    if (size < 2 || offset > length || size > length - offset || data [offset + size - 1] != '\0')
+        return invalid_snapshot (error, path, "invalid string table");
+
+    snapshot->strings = data + offset;
+    snapshot->strings_size = size;
+
+    if ((length - sizeof (SnapshotHeader)) / sizeof (SnapshotSectionHeader) < n_sections)
+        return invalid_snapshot (error, path, "truncated sections");
+
+    sections = (const SnapshotSectionHeader*) (data + sizeof (SnapshotHeader));
+
+    for (i = 0; i < n_sections; i++) {
+        memcpy (type_name, sections [i].type_name, TYPE_NAME_SIZE);
+        type_name [TYPE_NAME_SIZE] = '\0';
+
+        section = g_new0 (SnapshotSection, 1);
+        section->type = g_type_from_name (type_name);
+        section->schema = schema_for_type (section->type);
+        section->n_rows = GUINT32_FROM_LE (sections [i].n_rows);
+        offset = GUINT64_FROM_LE (sections [i].columns_offset);
+        snapshot->sections = g_list_prepend (snapshot->sections, section);
+
+        if (section->schema == NULL || section->schema->n_fields != GUINT32_FROM_LE (sections [i].n_columns))
+            return invalid_snapshot (error, path, "unknown type of objects");
+
+        size = (guint64) section->schema->n_fields * section->n_rows * sizeof (guint64);
+        if (offset % sizeof (guint64) != 0 || offset > length || size > length - offset)
+            return invalid_snapshot (error, path, "truncated columns");
+
+        section->columns = (const guint64*) (data + offset);
+    }
+
+    return TRUE;
+}
+
+/**
+ * ogd_snapshot_open:
+ * @provider:       the #OGDProvider assigned to objects built from the snapshot
+ * @path:           path of the snapshot, written with ogd_snapshot_write()
+ * @error:          a #GError filled if the function return %NULL
+ *
+ * Maps a snapshot in memory. Objects are not built until requested with ogd_snapshot_get_object()
+ *
+ * Return value:    a newly allocated #OGDSnapshot, to be freed with ogd_snapshot_free(), or %NULL
+ *                  if the file cannot be read or is not a valid snapshot
+ */
+OGDSnapshot* ogd_snapshot_open (OGDProvider *provider, const gchar *path, GError **error)
+{
+    gsize length;
+    const gchar *data;
+    GMappedFile *file;
+    OGDSnapshot *snapshot;
+
+    file = g_mapped_file_new (path, FALSE, error);
+    if (file == NULL)
+        return NULL;
+
+    data = g_mapped_file_get_contents (file);
+    length = g_mapped_file_get_length (file);
+
+    snapshot = g_new0 (OGDSnapshot, 1);
+    snapshot->provider = provider;
+    snapshot->file = file;
+
+    if (load_sections (snapshot, path, data, length, error) == FALSE) {
+        ogd_snapshot_free (snapshot);
+        return NULL;
+    }
+
+    /*
+        The mapping is released with the arena, so it stays valid while objects built from it are
+        alive, also after the snapshot has been freed
+    */
+    snapshot->arena = ogd_arena_new_for_data (snapshot->strings, snapshot->strings_size,
+                                              (GDestroyNotify) g_mapped_file_free, file);
+    return snapshot;
+}
+
+/**
+ * ogd_snapshot_free:
+ * @snapshot:       the #OGDSnapshot to free
+ *
+ * Frees a #OGDSnapshot. Objects built from it remain valid
+ */
+void ogd_snapshot_free (OGDSnapshot *snapshot)
+{
+    GList *iter;
+
+    for (iter = snapshot->sections; iter; iter = g_list_next (iter))
+        g_free (iter->data);
+
+    g_list_free (snapshot->sections);
+
+    if (snapshot->arena != NULL)
+        ogd_arena_unref (snapshot->arena);
+    else
+        g_mapped_file_free (snapshot->file);
+
+    g_free (snapshot);
+}
+
+static SnapshotSection* find_section (OGDSnapshot *snapshot, GType type)
+{
+    GList *iter;
+
+    for (iter = snapshot->sections; iter; iter = g_list_next (iter))
+        if (((SnapshotSection*) iter->data)->type == type)
+            return iter->data;
+
+    return NULL;
+}
+
+static inline guint64 read_cell (SnapshotSection *section, guint field, gulong row)
+{
+    return GUINT64_FROM_LE (section->columns [(gsize) field * section->n_rows + row]);
+}
+
+static inline const gchar* read_string (OGDSnapshot *snapshot, guint64 offset)
+{
+    if (offset == 0 || offset >= snapshot->strings_size)
+        return NULL;
+
+    return snapshot->strings + offset;
+}
+
+/**
+ * ogd_snapshot_get_n_objects:
+ * @snapshot:       the #OGDSnapshot to query
+ * @type:           type of the objects, such as OGD_CONTENT_TYPE
+ *
+ * To know how many objects of a type are saved in a snapshot
+ *
+ * Return value:    the number of objects of type @type
+ */
+gulong ogd_snapshot_get_n_objects (OGDSnapshot *snapshot, GType type)
+{
+    SnapshotSection *section;
+
+    section = find_section (snapshot, type);
+    return (section != NULL) ? section->n_rows : 0;
+}
+
+/**
+ * ogd_snapshot_get_id:
+ * @snapshot:       the #OGDSnapshot to query
+ * @type:           type of the object
+ * @index:          index of the object, from 0 to ogd_snapshot_get_n_objects() - 1
+ *
+ * To read the ID of an object without building it
+ *
+ * Return value:    the ID of the object, owned by the snapshot, or %NULL if @index is out of range
+ */
+const gchar* ogd_snapshot_get_id (OGDSnapshot *snapshot, GType type, gulong index)
+{
+    SnapshotSection *section;
+
+    section = find_section (snapshot, type);
+    if (section == NULL || index >= section->n_rows)
+        return NULL;
+
+    return read_string (snapshot, read_cell (section, 0, index));
+}
+
+/**
+ * ogd_snapshot_get_object:
+ * @snapshot:       the #OGDSnapshot to query
+ * @type:           type of the object
+ * @index:          index of the object, from 0 to ogd_snapshot_get_n_objects() - 1
+ *
+ * Builds an object saved in the snapshot. When the identity map of the #OGDProvider is enabled
+ * ( ogd_provider_set_identity_map() ) and an instance of the same item is already alive, that
+ * instance is returned instead
+ *
+ * Return value:    a new reference to the #OGDObject, or %NULL if @index is out of range
+ */
+OGDObject* ogd_snapshot_get_object (OGDSnapshot *snapshot, GType type, gulong index)
+{
+    guint field;
+    guint64 cell;
+    DoubleBits bits;
+    SnapshotSection *section;
+    OGDSnapshotValue *values;
+    OGDArena *previous_arena;
+    OGDObject *obj;
+
+    section = find_section (snapshot, type);
+    if (section == NULL || index >= section->n_rows)
+        return NULL;
+
+    obj = ogd_provider_lookup_object (snapshot->provider, type, read_string (snapshot, read_cell (section, 0, index)));
+    if (obj != NULL)
+        return obj;
+
+    values = g_new0 (OGDSnapshotValue, section->schema->n_fields);
+
+    for (field = 0; field < section->schema->n_fields; field++) {
+        cell = read_cell (section, field, index);
+
+        switch (section->schema->kinds [field]) {
+            case OGD_SNAPSHOT_STRING:
+            case OGD_SNAPSHOT_STRING_LIST:
+                values [field].string = read_string (snapshot, cell);
+                break;
+
+            case OGD_SNAPSHOT_INTEGER:
+                values [field].integer = (gint64) cell;
+                break;
+
+            case OGD_SNAPSHOT_DOUBLE:
+                bits.bits = cell;
+                values [field].real = bits.real;
+                break;
+        }
+    }
+
+    obj = g_object_new (type, NULL);
+    ogd_object_set_provider (obj, snapshot->provider);
+
+    previous_arena = ogd_arena_set_current (snapshot->arena);
+    ogd_snapshot_fill_object (obj, values);
+    ogd_arena_set_current (previous_arena);
+
+    g_free (values);
+    return obj;
+}
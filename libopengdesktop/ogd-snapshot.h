@@ -0,0 +1,39 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_SNAPSHOT_H
+#define OGD_SNAPSHOT_H
+
+G_BEGIN_DECLS
+
+#include "ogd-provider.h"
+#include "ogd-object.h"
+
+typedef struct _OGDSnapshot OGDSnapshot;
+
+gboolean        ogd_snapshot_write                  (const gchar *path, GList *objects, GError **error);
+
+OGDSnapshot*    ogd_snapshot_open                   (OGDProvider *provider, const gchar *path, GError **error);
+void            ogd_snapshot_free                   (OGDSnapshot *snapshot);
+
+gulong          ogd_snapshot_get_n_objects          (OGDSnapshot *snapshot, GType type);
+const gchar*    ogd_snapshot_get_id                 (OGDSnapshot *snapshot, GType type, gulong index);
+OGDObject*      ogd_snapshot_get_object             (OGDSnapshot *snapshot, GType type, gulong index);
+
+G_END_DECLS
+
+#endif /* OGD_SNAPSHOT_H */
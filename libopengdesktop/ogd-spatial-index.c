@@ -0,0 +1,502 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+
+#include "ogd.h"
+#include "ogd-spatial-index.h"
+#include "ogd-private-utils.h"
+
+/**
+ * SECTION: ogd-spatial-index
+ * @short_description:  in-memory index of persons and events by location
+ *
+ * An #OGDSpatialIndex collects #OGDPerson s and #OGDEvent s already fetched from the server, and
+ * permits to find those within a given distance from a point or the nearest ones, without
+ * scanning all of them. Objects may be inserted one by one while they are delivered, e.g. using
+ * ogd_spatial_index_collect() as callback for ogd_iterator_fetch_async().
+ * Points are placed on a sphere of the radius of the Earth, so distances are correct also near
+ * the poles and across the 180th meridian
+ */
+
+/*
+    Each point is kept as a vector on the unit sphere: the straight distance between two vectors
+    grows with the distance on the surface, so it can be compared with a limit converted once
+    for the whole query.
+    Points are stored in a single array, split in segments whose lengths are different powers of
+    two, the longest first. Each segment is an implicit k-d tree: the median of the range along an
+    axis chosen by depth is placed in the middle, with smaller values before it and greater after
+    it, recursively. A new point is appended as a segment of length 1 and, while the last two
+    segments have the same length, they are merged rebuilding the tree over both, like carrying in
+    a binary counter. So each point is moved in at most log (n) rebuilds, and queries visit at
+    most log (n) trees
+*/
+
+#define EARTH_RADIUS_KM         6371.0
+#define INITIAL_POINTS          64
+#define MAX_SEGMENTS            64
+
+typedef struct {
+    gdouble         pos [3];
+    OGDObject       *obj;
+} SpatialPoint;
+
+struct _OGDSpatialIndex {
+    SpatialPoint    *points;
+    gulong          size;
+    gulong          allocated;
+
+    gulong          segments [MAX_SEGMENTS];
+    guint           num_segments;
+};
+
+typedef struct {
+    gdouble         *dists;
+    SpatialPoint    **points;
+    guint           count;
+    guint           size;
+} NearestHeap;
+
+/**
+ * ogd_spatial_index_new:
+ *
+ * To allocate an empty #OGDSpatialIndex
+ *
+ * Return value:    a newly allocated #OGDSpatialIndex, to be freed with ogd_spatial_index_free()
+ */
+OGDSpatialIndex* ogd_spatial_index_new ()
+{
+    return g_new0 (OGDSpatialIndex, 1);
+}
+
+/**
+ * ogd_spatial_index_free:
+ * @index:          the #OGDSpatialIndex to free
+ *
+ * Frees an #OGDSpatialIndex, releasing the references to the objects it contains
+ */
+void ogd_spatial_index_free (OGDSpatialIndex *index)
+{
+    gulong i;
+
+    for (i = 0; i < index->size; i++)
+        g_object_unref (index->points [i].obj);
+
+    g_free (index->points);
+    g_free (index);
+}
+
+static void to_vector (gdouble latitude, gdouble longitude, gdouble *pos)
+{
+    gdouble lat;
+    gdouble lon;
+
+    lat = latitude * G_PI / 180;
+    lon = longitude * G_PI / 180;
+
+    pos [0] = cos (lat) * cos (lon);
+    pos [1] = cos (lat) * sin (lon);
+    pos [2] = sin (lat);
+}
+
+static inline gdouble distance2 (const gdouble *a, const gdouble *b)
+{
+    gdouble x;
+    gdouble y;
+    gdouble z;
+
+    x = a [0] - b [0];
+    y = a [1] - b [1];
+    z = a [2] - b [2];
+    return x * x + y * y + z * z;
+}
+
+/*
+    Moves in position @nth of the range [@lo, @hi) the point which would be there if the range
+    was sorted along @axis, with no greater point before and no smaller point after it
+*/
+static void select_nth (SpatialPoint *points, glong lo, glong hi, glong nth, guint axis)
+{
+    glong i;
+    glong j;
+    glong right;
+    gdouble pivot;
+    SpatialPoint tmp;
+
+    right = hi - 1;
+
+    while (right > lo) {
+        pivot = points [lo + (right - lo) / 2].pos [axis];
+        i = lo;
+        j = right;
+
+        while (i <= j) {
+            while (points [i].pos [axis] < pivot)
+                i++;
+            while (points [j].pos [axis] > pivot)
+                j--;
+
+            if (i <= j) {
+                tmp = points [i];
+                points [i] = points [j];
+                points [j] = tmp;
+                i++;
+                j--;
+            }
+        }
+
+        if (nth <= j)
+            right = j;
+        else if (nth >= i)
+            lo = i;
+        else
+            break;
+    }
+}
+
+static void build_tree (SpatialPoint *points, glong lo, glong hi, guint depth)
+{
+    glong mid;
+
+    while (hi - lo > 1) {
+        mid = lo + (hi - lo) / 2;
+        select_nth (points, lo, hi, mid, depth % 3);
+        build_tree (points, lo, mid, depth + 1);
+        lo = mid + 1;
+        depth++;
+    }
+}
+
+/**
+ * ogd_spatial_index_insert_point:
+ * @index:          the #OGDSpatialIndex in which insert the point
+ * @latitude:       latitude of the point, in degrees
+ * @longitude:      longitude of the point, in degrees
+ * @obj:            the #OGDObject to which the point refers. The index takes a reference to it
+ *
+ * Inserts an object in the index, at the given position. Useful for objects of types
+ * not handled by ogd_spatial_index_insert(), or whose position is known otherwise
+ */
+void ogd_spatial_index_insert_point (OGDSpatialIndex *index, gdouble latitude, gdouble longitude, OGDObject *obj)
+{
+    gulong start;
+    SpatialPoint *point;
+
+    if (index->size == index->allocated) {
+        index->allocated = MAX (index->allocated * 2, INITIAL_POINTS);
+        index->points = g_renew (SpatialPoint, index->points, index->allocated);
+    }
+
+    point = &(index->points [index->size]);
+    to_vector (latitude, longitude, point->pos);
+    point->obj = g_object_ref (obj);
+    index->size++;
+
+    index->segments [index->num_segments] = 1;
+    index->num_segments++;
+
+    while (index->num_segments > 1 &&
+            index->segments [index->num_segments - 1] == index->segments [index->num_segments - 2]) {
+        index->num_segments--;
+        index->segments [index->num_segments - 1] *= 2;
+        start = index->size - index->segments [index->num_segments - 1];
+        build_tree (index->points, start, index->size, 0);
+    }
+}
+
+/*
+    Persons and events which never set their position are reported at 0,0, which is so considered
+    as unknown
+*/
+static gboolean object_location (OGDObject *obj, gdouble *latitude, gdouble *longitude)
+{
+    if (IS_OGD_PERSON (obj)) {
+        *latitude = ogd_person_get_latitude (OGD_PERSON (obj));
+        *longitude = ogd_person_get_longitude (OGD_PERSON (obj));
+    }
+    else if (IS_OGD_EVENT (obj)) {
+        *latitude = ogd_event_get_latitude (OGD_EVENT (obj));
+        *longitude = ogd_event_get_longitude (OGD_EVENT (obj));
+    }
+    else {
+        return FALSE;
+    }
+
+    return (*latitude != 0 || *longitude != 0);
+}
+
+/**
+ * ogd_spatial_index_insert:
+ * @index:          the #OGDSpatialIndex in which insert the object
+ * @obj:            an #OGDPerson or an #OGDEvent. The index takes a reference to it
+ *
+ * Inserts an object in the index, at the position it reports. The cost of insertion is
+ * amortized along many objects, so inserting them one by one is as fast as inserting many of
+ * them at once
+ *
+ * Return value:    %TRUE if @obj has been inserted, %FALSE if it has no known position or is of
+ *                  a type which has no position
+ */
+gboolean ogd_spatial_index_insert (OGDSpatialIndex *index, OGDObject *obj)
+{
+    gdouble latitude;
+    gdouble longitude;
+
+    if (object_location (obj, &latitude, &longitude) == FALSE)
+        return FALSE;
+
+    ogd_spatial_index_insert_point (index, latitude, longitude, obj);
+    return TRUE;
+}
+
+/**
+ * ogd_spatial_index_collect:
+ * @obj:            an #OGDObject, or %NULL
+ * @index:          the #OGDSpatialIndex in which insert the object
+ *
+ * As ogd_spatial_index_insert(), but usable as #OGDAsyncCallback to fill the index while objects
+ * are delivered, e.g. by ogd_iterator_fetch_async(). %NULL objects are ignored
+ */
+void ogd_spatial_index_collect (OGDObject *obj, gpointer index)
+{
+    if (obj != NULL)
+        ogd_spatial_index_insert ((OGDSpatialIndex*) index, obj);
+}
+
+/**
+ * ogd_spatial_index_get_size:
+ * @index:          the #OGDSpatialIndex to query
+ *
+ * To know how many objects have been inserted in the index
+ *
+ * Return value:    the number of objects in @index
+ */
+gulong ogd_spatial_index_get_size (OGDSpatialIndex *index)
+{
+    return index->size;
+}
+
+static void radius_search (SpatialPoint *points, glong lo, glong hi, guint depth, const gdouble *query,
+                           gdouble limit, GList **found)
+{
+    guint axis;
+    glong mid;
+    gdouble diff;
+    SpatialPoint *point;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        axis = depth % 3;
+        point = &(points [mid]);
+
+        if (distance2 (point->pos, query) <= limit)
+            *found = g_list_prepend (*found, point->obj);
+
+        diff = query [axis] - point->pos [axis];
+
+        if (diff < 0) {
+            if (diff * diff <= limit)
+                radius_search (points, mid + 1, hi, depth + 1, query, limit, found);
+            hi = mid;
+        }
+        else {
+            if (diff * diff <= limit)
+                radius_search (points, lo, mid, depth + 1, query, limit, found);
+            lo = mid + 1;
+        }
+
+        depth++;
+    }
+}
+
+/**
+ * ogd_spatial_index_within_radius:
+ * @index:          the #OGDSpatialIndex to query
+ * @latitude:       latitude of the center, in degrees
+ * @longitude:      longitude of the center, in degrees
+ * @kilometers:     maximum distance from the center, along the surface of the Earth
+ *
+ * To retrieve the objects placed within a given distance from a point
+ *
+ * Return value:    a #GList of the #OGDObject s found, in no particular order. Objects are still
+ *                  owned by @index, only the list has to be freed
+ */
+GList* ogd_spatial_index_within_radius (OGDSpatialIndex *index, gdouble latitude, gdouble longitude,
+                                        gdouble kilometers)
+{
+    guint i;
+    gulong start;
+    gdouble angle;
+    gdouble limit;
+    gdouble query [3];
+    GList *ret;
+
+    ret = NULL;
+    to_vector (latitude, longitude, query);
+
+    angle = kilometers / EARTH_RADIUS_KM;
+    if (angle >= G_PI)
+        limit = 5;
+    else
+        limit = pow (2 * sin (angle / 2), 2);
+
+    for (i = 0, start = 0; i < index->num_segments; start += index->segments [i], i++)
+        radius_search (index->points, start, start + index->segments [i], 0, query, limit, &ret);
+
+    return ret;
+}
+
+static void heap_sift_down (NearestHeap *heap, guint node)
+{
+    guint child;
+    gdouble dist;
+    SpatialPoint *point;
+
+    while ((child = node * 2 + 1) < heap->count) {
+        if (child + 1 < heap->count && heap->dists [child + 1] > heap->dists [child])
+            child++;
+
+        if (heap->dists [node] >= heap->dists [child])
+            break;
+
+        dist = heap->dists [node];
+        heap->dists [node] = heap->dists [child];
+        heap->dists [child] = dist;
+        point = heap->points [node];
+        heap->points [node] = heap->points [child];
+        heap->points [child] = point;
+        node = child;
+    }
+}
+
+/*
+    The heap keeps the nearest points found so far, with the farthest of them at the root
+*/
+static void heap_offer (NearestHeap *heap, SpatialPoint *point, gdouble dist)
+{
+    guint node;
+    guint parent;
+
+    if (heap->count < heap->size) {
+        node = heap->count;
+        heap->count++;
+
+        while (node > 0) {
+            parent = (node - 1) / 2;
+            if (heap->dists [parent] >= dist)
+                break;
+
+            heap->dists [node] = heap->dists [parent];
+            heap->points [node] = heap->points [parent];
+            node = parent;
+        }
+
+        heap->dists [node] = dist;
+        heap->points [node] = point;
+    }
+    else if (dist < heap->dists [0]) {
+        heap->dists [0] = dist;
+        heap->points [0] = point;
+        heap_sift_down (heap, 0);
+    }
+}
+
+static inline gdouble heap_worst (NearestHeap *heap)
+{
+    return (heap->count < heap->size) ? G_MAXDOUBLE : heap->dists [0];
+}
+
+static void nearest_search (SpatialPoint *points, glong lo, glong hi, guint depth, const gdouble *query,
+                            NearestHeap *heap)
+{
+    guint axis;
+    glong mid;
+    gdouble diff;
+    SpatialPoint *point;
+
+    if (lo >= hi)
+        return;
+
+    mid = lo + (hi - lo) / 2;
+    axis = depth % 3;
+    point = &(points [mid]);
+
+    heap_offer (heap, point, distance2 (point->pos, query));
+    diff = query [axis] - point->pos [axis];
+
+    if (diff < 0) {
+        nearest_search (points, lo, mid, depth + 1, query, heap);
+        if (diff * diff < heap_worst (heap))
+            nearest_search (points, mid + 1, hi, depth + 1, query, heap);
+    }
+    else {
+        nearest_search (points, mid + 1, hi, depth + 1, query, heap);
+        if (diff * diff < heap_worst (heap))
+            nearest_search (points, lo, mid, depth + 1, query, heap);
+    }
+}
+
+/**
+ * ogd_spatial_index_nearest:
+ * @index:          the #OGDSpatialIndex to query
+ * @latitude:       latitude of the point, in degrees
+ * @longitude:      longitude of the point, in degrees
+ * @count:          maximum number of objects to retrieve
+ *
+ * To retrieve the objects nearest to a point
+ *
+ * Return value:    a #GList of at most @count #OGDObject s, sorted from the nearest. Objects are
+ *                  still owned by @index, only the list has to be freed
+ */
+GList* ogd_spatial_index_nearest (OGDSpatialIndex *index, gdouble latitude, gdouble longitude, guint count)
+{
+    guint i;
+    gulong start;
+    gdouble query [3];
+    GList *ret;
+    NearestHeap heap;
+
+    if (count == 0 || index->size == 0)
+        return NULL;
+
+    heap.size = MIN (count, index->size);
+    heap.count = 0;
+    heap.dists = g_new (gdouble, heap.size);
+    heap.points = g_new (SpatialPoint*, heap.size);
+
+    to_vector (latitude, longitude, query);
+
+    for (i = 0, start = 0; i < index->num_segments; start += index->segments [i], i++)
+        nearest_search (index->points, start, start + index->segments [i], 0, query, &heap);
+
+    /*
+        Extracting the farthest first, and prepending it, the list is sorted from the nearest
+    */
+    ret = NULL;
+
+    while (heap.count > 0) {
+        ret = g_list_prepend (ret, heap.points [0]->obj);
+        heap.count--;
+        heap.dists [0] = heap.dists [heap.count];
+        heap.points [0] = heap.points [heap.count];
+        heap_sift_down (&heap, 0);
+    }
+
+    g_free (heap.dists);
+    g_free (heap.points);
+    return ret;
+}
@@ -0,0 +1,43 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_SPATIAL_INDEX_H
+#define OGD_SPATIAL_INDEX_H
+
+G_BEGIN_DECLS
+
+#include "ogd-object.h"
+
+typedef struct _OGDSpatialIndex OGDSpatialIndex;
+
+OGDSpatialIndex*    ogd_spatial_index_new               ();
+void                ogd_spatial_index_free              (OGDSpatialIndex *index);
+
+gboolean            ogd_spatial_index_insert            (OGDSpatialIndex *index, OGDObject *obj);
+void                ogd_spatial_index_insert_point      (OGDSpatialIndex *index, gdouble latitude, gdouble longitude,
+                                                         OGDObject *obj);
+void                ogd_spatial_index_collect           (OGDObject *obj, gpointer index);
+gulong              ogd_spatial_index_get_size          (OGDSpatialIndex *index);
+
+GList*              ogd_spatial_index_within_radius     (OGDSpatialIndex *index, gdouble latitude, gdouble longitude,
+                                                         gdouble kilometers);
+GList*              ogd_spatial_index_nearest           (OGDSpatialIndex *index, gdouble latitude, gdouble longitude,
+                                                         guint count);
+
+G_END_DECLS
+
+#endif /* OGD_SPATIAL_INDEX_H */
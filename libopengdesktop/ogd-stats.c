@@ -0,0 +1,385 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-stats.h"
+#include "ogd-private-utils.h"
+
+/*
+    Collects, for each endpoint of the OCS API, counters and latency histograms about requests sent
+    to the server. Messages are observed directly from the SoupSessions: timings are taken when a
+    message enters the session, when it is actually written on a connection, when the response
+    headers arrive and when the message leaves the session, so requests issued by any path of the
+    library (and each retry of them) are measured. Parsing is instead reported explicitly by the
+    OGDProvider, as only it knows when XML and objects are built
+*/
+
+#define TIMING_KEY          "ogd-stats-timing"
+
+typedef struct {
+    OGDStats            *stats;
+    gint64              queued;
+    gint64              started;
+    gint64              first_byte;
+} RequestTiming;
+
+struct _OGDStats {
+    GHashTable          *endpoints;
+    guint               dump_timer;
+};
+
+OGDStats* ogd_stats_new ()
+{
+    OGDStats *stats;
+
+    stats = g_new0 (OGDStats, 1);
+    stats->endpoints = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    return stats;
+}
+
+void ogd_stats_free (OGDStats *stats)
+{
+    if (stats->dump_timer != 0)
+        g_source_remove (stats->dump_timer);
+
+    g_hash_table_destroy (stats->endpoints);
+    g_free (stats);
+}
+
+/*
+    Reduces a query to the endpoint it refers to, keeping at most the first two segments and
+    stopping at the first identifier: "content/data/1234?format=xml" becomes "content/data",
+    "message/2" becomes "message"
+*/
+static gchar* query_to_endpoint (const gchar *query)
+{
+    int i;
+    int segments;
+
+    while (*query == '/')
+        query++;
+
+    for (i = 0, segments = 0; query [i] != '\0' && query [i] != '?'; i++) {
+        if (query [i] == '/') {
+            segments++;
+            if (segments == 2 || g_ascii_isdigit (query [i + 1]))
+                break;
+        }
+    }
+
+    if (i == 0)
+        return g_strdup ("/");
+    else
+        return g_strndup (query, i);
+}
+
+static gchar* message_to_endpoint (SoupMessage *msg)
+{
+    gchar *query;
+    gchar *ret;
+
+    query = message_to_query (msg);
+    ret = query_to_endpoint (query);
+    g_free (query);
+    return ret;
+}
+
+static OGDEndpointStats* get_endpoint (OGDStats *stats, gchar *endpoint)
+{
+    OGDEndpointStats *ret;
+
+    ret = g_hash_table_lookup (stats->endpoints, endpoint);
+
+    if (ret == NULL) {
+        ret = g_new0 (OGDEndpointStats, 1);
+        g_hash_table_insert (stats->endpoints, endpoint, ret);
+    }
+    else {
+        g_free (endpoint);
+    }
+
+    return ret;
+}
+
+static void add_to_histogram (guint *histogram, gint64 elapsed)
+{
+    int i;
+    gint64 ms;
+
+    ms = elapsed / 1000;
+
+    for (i = 0; i < OGD_STATS_HISTOGRAM_BUCKETS - 1 && ms >= (1 << i); i++);
+    histogram [i]++;
+}
+
+static void count_header (const char *name, const char *value, gpointer userdata)
+{
+    *((guint64*) userdata) += strlen (name) + strlen (value) + 4;
+}
+
+static guint64 message_bytes_out (SoupMessage *msg)
+{
+    guint64 ret;
+    SoupURI *uri;
+
+    uri = soup_message_get_uri (msg);
+    ret = strlen (msg->method) + strlen (uri->path) + (uri->query != NULL ? strlen (uri->query) + 1 : 0) + 12;
+    soup_message_headers_foreach (msg->request_headers, count_header, &ret);
+
+    if (msg->request_body != NULL)
+        ret += msg->request_body->length;
+
+    return ret;
+}
+
+static guint64 message_bytes_in (SoupMessage *msg)
+{
+    guint64 ret;
+
+    ret = 0;
+    soup_message_headers_foreach (msg->response_headers, count_header, &ret);
+
+    if (msg->response_body != NULL)
+        ret += msg->response_body->length;
+
+    return ret;
+}
+
+static void message_got_headers (SoupMessage *msg, RequestTiming *timing)
+{
+    if (timing->first_byte == 0)
+        timing->first_byte = current_usec ();
+}
+
+static void request_queued (SoupSession *session, SoupMessage *msg, OGDStats *stats)
+{
+    RequestTiming *timing;
+
+    timing = g_new0 (RequestTiming, 1);
+    timing->stats = stats;
+    timing->queued = current_usec ();
+
+    g_object_set_data_full (G_OBJECT (msg), TIMING_KEY, timing, g_free);
+    g_signal_connect (msg, "got-headers", G_CALLBACK (message_got_headers), timing);
+}
+
+static void request_started (SoupSession *session, SoupMessage *msg, SoupSocket *socket, OGDStats *stats)
+{
+    RequestTiming *timing;
+
+    timing = g_object_get_data (G_OBJECT (msg), TIMING_KEY);
+    if (timing != NULL && timing->started == 0)
+        timing->started = current_usec ();
+}
+
+static void request_unqueued (SoupSession *session, SoupMessage *msg, OGDStats *stats)
+{
+    gint64 now;
+    RequestTiming *timing;
+    OGDEndpointStats *endpoint;
+
+    timing = g_object_get_data (G_OBJECT (msg), TIMING_KEY);
+    if (timing == NULL)
+        return;
+
+    now = current_usec ();
+    endpoint = get_endpoint (stats, message_to_endpoint (msg));
+
+    endpoint->requests++;
+    if (SOUP_STATUS_IS_SUCCESSFUL (msg->status_code) == FALSE)
+        endpoint->failures++;
+
+    endpoint->bytes_out += message_bytes_out (msg);
+    endpoint->bytes_in += message_bytes_in (msg);
+
+    /*
+        A message cancelled while still in queue has never been started
+    */
+    if (timing->started != 0)
+        add_to_histogram (endpoint->connect, timing->started - timing->queued);
+    if (timing->first_byte != 0)
+        add_to_histogram (endpoint->first_byte, timing->first_byte - timing->queued);
+
+    add_to_histogram (endpoint->total, now - timing->queued);
+    endpoint->total_time += (gdouble) (now - timing->queued) / 1000;
+
+    g_signal_handlers_disconnect_by_func (msg, message_got_headers, timing);
+    g_object_set_data (G_OBJECT (msg), TIMING_KEY, NULL);
+}
+
+/*
+    To be called once for each session owned by the OGDProvider, before any message is sent
+*/
+void ogd_stats_watch_session (OGDStats *stats, SoupSession *session)
+{
+    g_signal_connect (session, "request-queued", G_CALLBACK (request_queued), stats);
+    g_signal_connect (session, "request-started", G_CALLBACK (request_started), stats);
+    g_signal_connect (session, "request-unqueued", G_CALLBACK (request_unqueued), stats);
+}
+
+/*
+    Params:
+        query:      the query, relative to the access URL of the provider, whose response has
+                    been parsed
+        elapsed:    microseconds spent parsing XML and building objects
+        objects:    number of objects built
+*/
+void ogd_stats_record_parse (OGDStats *stats, const gchar *query, gint64 elapsed, guint objects)
+{
+    OGDEndpointStats *endpoint;
+
+    endpoint = get_endpoint (stats, query_to_endpoint (query));
+    endpoint->parse_time += (gdouble) elapsed / 1000;
+    endpoint->objects += objects;
+}
+
+/*
+    As ogd_stats_record_parse(), for the response of an async message
+*/
+void ogd_stats_record_message_parse (OGDStats *stats, SoupMessage *msg, gint64 elapsed, guint objects)
+{
+    OGDEndpointStats *endpoint;
+
+    endpoint = get_endpoint (stats, message_to_endpoint (msg));
+    endpoint->parse_time += (gdouble) elapsed / 1000;
+    endpoint->objects += objects;
+}
+
+/*
+    Returns the sorted list of endpoints for which something has been recorded. Strings in the
+    list are owned by the OGDStats, only the list itself has to be freed
+*/
+GList* ogd_stats_get_endpoints (OGDStats *stats)
+{
+    GList *ret;
+
+    ret = g_hash_table_get_keys (stats->endpoints);
+    return g_list_sort (ret, (GCompareFunc) strcmp);
+}
+
+gboolean ogd_stats_get (OGDStats *stats, const gchar *endpoint, OGDEndpointStats *ret)
+{
+    OGDEndpointStats *found;
+
+    found = g_hash_table_lookup (stats->endpoints, endpoint);
+
+    if (found == NULL) {
+        memset (ret, 0, sizeof (OGDEndpointStats));
+        return FALSE;
+    }
+    else {
+        memcpy (ret, found, sizeof (OGDEndpointStats));
+        return TRUE;
+    }
+}
+
+/*
+    Approximates a percentile with the upper bound of the bucket in which it falls, in
+    milliseconds. The last bucket has no upper bound, its lower one is returned
+*/
+static guint histogram_percentile (guint *histogram, gdouble rank)
+{
+    int i;
+    guint total;
+    guint count;
+    guint target;
+
+    for (i = 0, total = 0; i < OGD_STATS_HISTOGRAM_BUCKETS; i++)
+        total += histogram [i];
+
+    if (total == 0)
+        return 0;
+
+    target = (guint) (total * rank + 0.5);
+    if (target == 0)
+        target = 1;
+
+    for (i = 0, count = 0; i < OGD_STATS_HISTOGRAM_BUCKETS - 1; i++) {
+        count += histogram [i];
+        if (count >= target)
+            return 1 << i;
+    }
+
+    return 1 << (OGD_STATS_HISTOGRAM_BUCKETS - 2);
+}
+
+gchar* ogd_stats_dump (OGDStats *stats)
+{
+    GList *endpoints;
+    GList *iter;
+    GString *ret;
+    OGDEndpointStats *endpoint;
+
+    ret = g_string_new ("");
+    g_string_append_printf (ret, "%-18s %8s %8s %10s %10s %8s %10s %8s %8s %8s %8s\n",
+                            "endpoint", "requests", "failures", "KB in", "KB out", "objects",
+                            "parse ms", "mean ms", "ttfb p50", "p50 ms", "p99 ms");
+
+    endpoints = ogd_stats_get_endpoints (stats);
+
+    for (iter = endpoints; iter; iter = g_list_next (iter)) {
+        endpoint = g_hash_table_lookup (stats->endpoints, iter->data);
+
+        g_string_append_printf (ret, "%-18s %8" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT " %10.1f %10.1f %8" G_GUINT64_FORMAT " %10.1f %8.1f %8u %8u %8u\n",
+                                (gchar*) iter->data, endpoint->requests, endpoint->failures,
+                                (gdouble) endpoint->bytes_in / 1024, (gdouble) endpoint->bytes_out / 1024,
+                                endpoint->objects, endpoint->parse_time,
+                                endpoint->requests > 0 ? endpoint->total_time / endpoint->requests : 0,
+                                histogram_percentile (endpoint->first_byte, 0.5),
+                                histogram_percentile (endpoint->total, 0.5),
+                                histogram_percentile (endpoint->total, 0.99));
+    }
+
+    g_list_free (endpoints);
+    return g_string_free (ret, FALSE);
+}
+
+void ogd_stats_reset (OGDStats *stats)
+{
+    g_hash_table_remove_all (stats->endpoints);
+}
+
+static gboolean periodic_dump (gpointer userdata)
+{
+    gchar *dump;
+    OGDStats *stats;
+
+    stats = (OGDStats*) userdata;
+
+    if (g_hash_table_size (stats->endpoints) != 0) {
+        dump = ogd_stats_dump (stats);
+        g_message ("Requests statistics\n%s", dump);
+        g_free (dump);
+    }
+
+    return TRUE;
+}
+
+/*
+    Params:
+        seconds:    interval between two dumps in the log, or 0 to stop them
+*/
+void ogd_stats_set_dump_interval (OGDStats *stats, guint seconds)
+{
+    if (stats->dump_timer != 0) {
+        g_source_remove (stats->dump_timer);
+        stats->dump_timer = 0;
+    }
+
+    if (seconds != 0)
+        stats->dump_timer = g_timeout_add_seconds (seconds, periodic_dump, stats);
+}
@@ -0,0 +1,38 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_STATS_H
+#define OGD_STATS_H
+
+#include "ogd-provider-private.h"
+
+typedef struct _OGDStats OGDStats;
+
+OGDStats*       ogd_stats_new                       ();
+void            ogd_stats_free                      (OGDStats *stats);
+
+void            ogd_stats_watch_session             (OGDStats *stats, SoupSession *session);
+void            ogd_stats_record_parse              (OGDStats *stats, const gchar *query, gint64 elapsed, guint objects);
+void            ogd_stats_record_message_parse      (OGDStats *stats, SoupMessage *msg, gint64 elapsed, guint objects);
+
+GList*          ogd_stats_get_endpoints             (OGDStats *stats);
+gboolean        ogd_stats_get                       (OGDStats *stats, const gchar *endpoint, OGDEndpointStats *ret);
+gchar*          ogd_stats_dump                      (OGDStats *stats);
+void            ogd_stats_reset                     (OGDStats *stats);
+void            ogd_stats_set_dump_interval         (OGDStats *stats, guint seconds);
+
+#endif /* OGD_STATS_H */
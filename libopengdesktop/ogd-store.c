@@ -0,0 +1,917 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+
+#include "ogd.h"
+#include "ogd-store.h"
+#include "ogd-private-utils.h"
+
+/*
+    A store keeps on disk the objects received from a provider, so they may be used again without
+    asking the server, also in a later run of the application. The file is an append-only log:
+    each time an object is received a new record is added, and the last record for an object
+    replaces the previous ones. Lists received for a query are saved as well, as references to
+    the objects they contained.
+    When the store is opened the log is read once to build an index in memory, which points to the
+    position of the last version of each object in the file: bodies are read only when required.
+    Objects are also indexed by category, author, time of change and score, so they may be found
+    without any query to the server.
+
+    The file starts with a line identifying the format, followed by records:
+
+        O <type> <id> <fetched> <category> <author> <changed> <score> <body length>
+        <XML of the object>
+
+        Q <query> <fetched> <total> <number of objects>
+        <type> <id>                 repeated for each object
+
+    where strings are escaped as in URIs (so they never contain spaces), empty when missing, and
+    times are in seconds since the Epoch. Superseded records are dropped only by
+    ogd_store_compact()
+
+    The last objects read are kept parsed in memory, in a list bounded to STORE_CACHE_SIZE items
+    and ordered by last use, so hits on the same objects do not seek and parse the file again
+*/
+
+#define STORE_SIGNATURE         "OGD-STORE 1\n"
+#define STORE_CACHE_SIZE        128
+
+typedef struct {
+    OGDStoreKey     key;
+    const gchar     *type_name;
+    gchar           *index_key;
+
+    gint64          fetched;
+    gchar           *category;
+    gchar           *author;
+    gint64          changed;
+    guint           score;
+
+    glong           offset;
+    gsize           length;
+
+    GSequenceIter   *by_changed;
+    GSequenceIter   *by_score;
+
+    xmlDocPtr       cached;
+    GList           *cache_link;
+} StoredObject;
+
+typedef struct {
+    gint64          fetched;
+    gulong          total;
+    GList           *objects;
+} StoredQuery;
+
+struct _OGDStore {
+    gchar           *path;
+    FILE            *file;
+
+    GHashTable      *objects;
+    GHashTable      *queries;
+    GHashTable      *by_category;
+    GHashTable      *by_author;
+    GSequence       *by_changed;
+    GSequence       *by_score;
+    GQueue          *cache;
+
+    gulong          garbage;
+};
+
+static gchar* escape (const gchar *value)
+{
+    return g_uri_escape_string (value != NULL ? value : "", NULL, FALSE);
+}
+
+static gchar* unescape (const gchar *value)
+{
+    if (*value == '\0')
+        return NULL;
+
+    return g_uri_unescape_string (value, NULL);
+}
+
+static gchar* object_index_key (const gchar *type_name, const gchar *id)
+{
+    return g_strdup_printf ("%s/%s", type_name, id);
+}
+
+static gint64 now_seconds ()
+{
+    return wall_clock_usec () / G_USEC_PER_SEC;
+}
+
+static gboolean is_fresh (gint64 fetched, guint max_age)
+{
+    if (max_age == 0)
+        return FALSE;
+    else if (max_age == G_MAXUINT)
+        return TRUE;
+    else
+        return (now_seconds () - fetched <= max_age);
+}
+
+static void free_stored_object (StoredObject *object)
+{
+    if (object->cached != NULL)
+        xmlFreeDoc (object->cached);
+
+    g_free (object->index_key);
+    g_free (object->category);
+    g_free (object->author);
+    g_free (object);
+}
+
+static void free_stored_query (StoredQuery *query)
+{
+    GList *iter;
+
+    for (iter = query->objects; iter; iter = g_list_next (iter))
+        g_free (iter->data);
+
+    g_list_free (query->objects);
+    g_free (query);
+}
+
+static gint compare_by_changed (gconstpointer a, gconstpointer b, gpointer userdata)
+{
+    const StoredObject *first;
+    const StoredObject *second;
+
+    first = a;
+    second = b;
+
+    if (first->changed != second->changed)
+        return (first->changed < second->changed) ? -1 : 1;
+    else
+        return strcmp (first->index_key, second->index_key);
+}
+
+static gint compare_by_score (gconstpointer a, gconstpointer b, gpointer userdata)
+{
+    const StoredObject *first;
+    const StoredObject *second;
+
+    first = a;
+    second = b;
+
+    if (first->score != second->score)
+        return (first->score < second->score) ? -1 : 1;
+    else
+        return strcmp (first->index_key, second->index_key);
+}
+
+static void add_to_set (GHashTable *index, const gchar *value, StoredObject *object)
+{
+    GHashTable *set;
+
+    if (value == NULL)
+        return;
+
+    set = g_hash_table_lookup (index, value);
+
+    if (set == NULL) {
+        set = g_hash_table_new (g_direct_hash, g_direct_equal);
+        g_hash_table_insert (index, g_strdup (value), set);
+    }
+
+    g_hash_table_insert (set, object, object);
+}
+
+static void remove_from_set (GHashTable *index, const gchar *value, StoredObject *object)
+{
+    GHashTable *set;
+
+    if (value == NULL)
+        return;
+
+    set = g_hash_table_lookup (index, value);
+    if (set == NULL)
+        return;
+
+    g_hash_table_remove (set, object);
+
+    if (g_hash_table_size (set) == 0)
+        g_hash_table_remove (index, value);
+}
+
+static void uncache_object (OGDStore *store, StoredObject *object)
+{
+    if (object->cached == NULL)
+        return;
+
+    g_queue_delete_link (store->cache, object->cache_link);
+    object->cache_link = NULL;
+    xmlFreeDoc (object->cached);
+    object->cached = NULL;
+}
+
+/*
+    @doc becomes the most recently used item of the cache, and the least recently used one is
+    dropped if the cache is full
+*/
+static void cache_object (OGDStore *store, StoredObject *object, xmlDocPtr doc)
+{
+    g_queue_push_head (store->cache, object);
+    object->cache_link = g_queue_peek_head_link (store->cache);
+    object->cached = doc;
+
+    if (g_queue_get_length (store->cache) > STORE_CACHE_SIZE)
+        uncache_object (store, g_queue_peek_tail (store->cache));
+}
+
+/*
+    The new object replaces in all indexes the previous version with the same type and ID, if any
+*/
+static void index_object (OGDStore *store, StoredObject *object)
+{
+    StoredObject *previous;
+
+    previous = g_hash_table_lookup (store->objects, object->index_key);
+
+    if (previous != NULL) {
+        uncache_object (store, previous);
+        remove_from_set (store->by_category, previous->category, previous);
+        remove_from_set (store->by_author, previous->author, previous);
+        g_sequence_remove (previous->by_changed);
+        g_sequence_remove (previous->by_score);
+        store->garbage++;
+    }
+
+    g_hash_table_replace (store->objects, object->index_key, object);
+
+    add_to_set (store->by_category, object->category, object);
+    add_to_set (store->by_author, object->author, object);
+    object->by_changed = g_sequence_insert_sorted (store->by_changed, object, compare_by_changed, NULL);
+    object->by_score = g_sequence_insert_sorted (store->by_score, object, compare_by_score, NULL);
+}
+
+static void index_query (OGDStore *store, const gchar *query, StoredQuery *stored)
+{
+    if (g_hash_table_lookup (store->queries, query) != NULL)
+        store->garbage++;
+
+    g_hash_table_replace (store->queries, g_strdup (query), stored);
+}
+
+static gchar* next_line (gchar **cursor, gchar *end)
+{
+    gchar *ret;
+    gchar *newline;
+
+    if (*cursor >= end)
+        return NULL;
+
+    newline = memchr (*cursor, '\n', end - *cursor);
+    if (newline == NULL)
+        return NULL;
+
+    *newline = '\0';
+    ret = *cursor;
+    *cursor = newline + 1;
+    return ret;
+}
+
+static gboolean load_object (OGDStore *store, gchar **tokens, gchar **cursor, gchar *contents, gchar *end)
+{
+    gchar *id;
+    StoredObject *object;
+
+    if (g_strv_length (tokens) != 9)
+        return FALSE;
+
+    object = g_new0 (StoredObject, 1);
+    object->type_name = g_intern_string (tokens [1]);
+    object->key.type = g_type_from_name (object->type_name);
+    id = unescape (tokens [2]);
+    object->index_key = object_index_key (object->type_name, id);
+    object->key.id = object->index_key + strlen (object->type_name) + 1;
+    g_free (id);
+
+    object->fetched = g_ascii_strtoll (tokens [3], NULL, 10);
+    object->category = unescape (tokens [4]);
+    object->author = unescape (tokens [5]);
+    object->changed = g_ascii_strtoll (tokens [6], NULL, 10);
+    object->score = (guint) g_ascii_strtoull (tokens [7], NULL, 10);
+    object->length = (gsize) g_ascii_strtoull (tokens [8], NULL, 10);
+    object->offset = *cursor - contents;
+
+    if (*cursor + object->length + 1 > end || object->key.type == 0) {
+        free_stored_object (object);
+        return FALSE;
+    }
+
+    *cursor += object->length + 1;
+    index_object (store, object);
+    return TRUE;
+}
+
+static gboolean load_query (OGDStore *store, gchar **tokens, gchar **cursor, gchar *end)
+{
+    gulong i;
+    gulong count;
+    gchar *query;
+    gchar *line;
+    gchar **reference;
+    StoredQuery *stored;
+
+    if (g_strv_length (tokens) != 5)
+        return FALSE;
+
+    stored = g_new0 (StoredQuery, 1);
+    stored->fetched = g_ascii_strtoll (tokens [2], NULL, 10);
+    stored->total = (gulong) g_ascii_strtoull (tokens [3], NULL, 10);
+    count = (gulong) g_ascii_strtoull (tokens [4], NULL, 10);
+
+    for (i = 0; i < count; i++) {
+        line = next_line (cursor, end);
+        if (line == NULL) {
+            free_stored_query (stored);
+            return FALSE;
+        }
+
+        reference = g_strsplit (line, " ", 2);
+
+        if (g_strv_length (reference) == 2) {
+            query = unescape (reference [1]);
+            stored->objects = g_list_prepend (stored->objects, object_index_key (reference [0], query));
+            g_free (query);
+        }
+
+        g_strfreev (reference);
+    }
+
+    stored->objects = g_list_reverse (stored->objects);
+
+    query = unescape (tokens [1]);
+    index_query (store, query, stored);
+    g_free (query);
+    return TRUE;
+}
+
+/*
+    A truncated record at the end of the file (e.g. if the application crashed while writing it)
+    is ignored, and overwritten by the next compaction
+*/
+static gboolean load_store (OGDStore *store, GError **error)
+{
+    gsize length;
+    gboolean valid;
+    gchar *contents;
+    gchar *cursor;
+    gchar *end;
+    gchar *line;
+    gchar **tokens;
+
+    if (g_file_get_contents (store->path, &contents, &length, error) == FALSE)
+        return FALSE;
+
+    if (length < strlen (STORE_SIGNATURE) || strncmp (contents, STORE_SIGNATURE, strlen (STORE_SIGNATURE)) != 0) {
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s is not a valid store", store->path);
+        g_free (contents);
+        return FALSE;
+    }
+
+    cursor = contents + strlen (STORE_SIGNATURE);
+    end = contents + length;
+
+    while ((line = next_line (&cursor, end)) != NULL) {
+        tokens = g_strsplit (line, " ", 0);
+
+        if (tokens [0] != NULL && strcmp (tokens [0], "O") == 0)
+            valid = load_object (store, tokens, &cursor, contents, end);
+        else if (tokens [0] != NULL && strcmp (tokens [0], "Q") == 0)
+            valid = load_query (store, tokens, &cursor, end);
+        else
+            valid = FALSE;
+
+        g_strfreev (tokens);
+
+        if (valid == FALSE) {
+            g_warning ("Invalid record in store %s, ignoring the rest of the file", store->path);
+            break;
+        }
+    }
+
+    g_free (contents);
+    return TRUE;
+}
+
+/*
+    Opens the store saved in @path, or creates it if the file does not exist
+*/
+OGDStore* ogd_store_open (const gchar *path, GError **error)
+{
+    gboolean exists;
+    OGDStore *store;
+
+    store = g_new0 (OGDStore, 1);
+    store->path = g_strdup (path);
+    store->objects = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) free_stored_object);
+    store->queries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) free_stored_query);
+    store->by_category = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_destroy);
+    store->by_author = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_destroy);
+    store->by_changed = g_sequence_new (NULL);
+    store->by_score = g_sequence_new (NULL);
+    store->cache = g_queue_new ();
+
+    exists = g_file_test (path, G_FILE_TEST_EXISTS);
+
+    if (exists == TRUE && load_store (store, error) == FALSE) {
+        ogd_store_free (store);
+        return NULL;
+    }
+
+    store->file = fopen (path, "a+b");
+    if (store->file == NULL) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to open store %s: %s", path, g_strerror (errno));
+        ogd_store_free (store);
+        return NULL;
+    }
+
+    if (exists == FALSE) {
+        fputs (STORE_SIGNATURE, store->file);
+        fflush (store->file);
+    }
+
+    return store;
+}
+
+void ogd_store_free (OGDStore *store)
+{
+    if (store->file != NULL)
+        fclose (store->file);
+
+    /*
+        Sequences, sets and the cache only point to objects, which are owned by the main table
+    */
+    g_queue_free (store->cache);
+    g_sequence_free (store->by_changed);
+    g_sequence_free (store->by_score);
+    g_hash_table_destroy (store->by_category);
+    g_hash_table_destroy (store->by_author);
+    g_hash_table_destroy (store->queries);
+    g_hash_table_destroy (store->objects);
+
+    g_free (store->path);
+    g_free (store);
+}
+
+static void write_object_header (FILE *file, StoredObject *object)
+{
+    gchar *id;
+    gchar *category;
+    gchar *author;
+
+    id = escape (object->key.id);
+    category = escape (object->category);
+    author = escape (object->author);
+
+    fprintf (file, "O %s %s %" G_GINT64_FORMAT " %s %s %" G_GINT64_FORMAT " %u %" G_GSIZE_FORMAT "\n",
+             object->type_name, id, object->fetched, category, author, object->changed, object->score,
+             object->length);
+
+    g_free (id);
+    g_free (category);
+    g_free (author);
+}
+
+static void write_query (FILE *file, const gchar *query, StoredQuery *stored)
+{
+    gchar *escaped;
+    gchar *separator;
+    GList *iter;
+
+    escaped = escape (query);
+    fprintf (file, "Q %s %" G_GINT64_FORMAT " %lu %u\n", escaped, stored->fetched, stored->total,
+             g_list_length (stored->objects));
+    g_free (escaped);
+
+    for (iter = stored->objects; iter; iter = g_list_next (iter)) {
+        separator = strchr (iter->data, '/');
+        escaped = escape (separator + 1);
+        fprintf (file, "%.*s %s\n", (int) (separator - (gchar*) iter->data), (gchar*) iter->data, escaped);
+        g_free (escaped);
+    }
+}
+
+/*
+    Values used for secondary indexes are read from the XML, so the same code is valid for all
+    types of objects: those fields have the same meaning where present
+*/
+static void extract_index_values (StoredObject *object, const xmlNode *xml)
+{
+    gboolean is_person;
+    xmlNode *cursor;
+
+    is_person = (MYSTRCMP (xml->name, "person") == 0);
+
+    for (cursor = xml->children; cursor; cursor = cursor->next) {
+        if (cursor->type != XML_ELEMENT_NODE)
+            continue;
+
+        if (MYSTRCMP (cursor->name, "typeid") == 0 || MYSTRCMP (cursor->name, "category") == 0) {
+            g_free (object->category);
+            object->category = (gchar*) xmlNodeGetContent (cursor);
+        }
+        else if ((MYSTRCMP (cursor->name, "personid") == 0 && is_person == FALSE) || MYSTRCMP (cursor->name, "user") == 0) {
+            g_free (object->author);
+            object->author = (gchar*) xmlNodeGetContent (cursor);
+        }
+        else if (MYSTRCMP (cursor->name, "changed") == 0 || (MYSTRCMP (cursor->name, "date") == 0 && object->changed == 0)) {
+            object->changed = node_to_time (cursor);
+        }
+        else if (MYSTRCMP (cursor->name, "score") == 0) {
+            object->score = (guint) node_to_num (cursor);
+        }
+    }
+}
+
+/*
+    To be called each time @obj has been filled from @xml received by the server
+*/
+void ogd_store_put_object (OGDStore *store, OGDObject *obj, const xmlNode *xml)
+{
+    const gchar *id;
+    xmlBufferPtr buffer;
+    StoredObject *object;
+
+    id = ogd_object_get_id (obj);
+    if (id == NULL)
+        return;
+
+    if (MYSTRCMP (xml->name, "data") == 0)
+        xml = xml->children;
+
+    if (xml == NULL)
+        return;
+
+    buffer = xmlBufferCreate ();
+    xmlNodeDump (buffer, xml->doc, (xmlNode*) xml, 0, 0);
+
+    object = g_new0 (StoredObject, 1);
+    object->type_name = g_intern_string (G_OBJECT_TYPE_NAME (obj));
+    object->key.type = G_OBJECT_TYPE (obj);
+    object->index_key = object_index_key (object->type_name, id);
+    object->key.id = object->index_key + strlen (object->type_name) + 1;
+    object->fetched = now_seconds ();
+    object->length = xmlBufferLength (buffer);
+    extract_index_values (object, xml);
+
+    fseek (store->file, 0, SEEK_END);
+    write_object_header (store->file, object);
+    object->offset = ftell (store->file);
+    fwrite (xmlBufferContent (buffer), 1, object->length, store->file);
+    fputc ('\n', store->file);
+    fflush (store->file);
+
+    xmlBufferFree (buffer);
+    index_object (store, object);
+}
+
+static xmlNode* read_object (OGDStore *store, StoredObject *object)
+{
+    gchar *body;
+    xmlDocPtr doc;
+
+    if (object->cached != NULL) {
+        g_queue_unlink (store->cache, object->cache_link);
+        g_queue_push_head_link (store->cache, object->cache_link);
+        return xmlDocGetRootElement (xmlCopyDoc (object->cached, 1));
+    }
+
+    body = g_malloc (object->length);
+    fseek (store->file, object->offset, SEEK_SET);
+
+    if (fread (body, 1, object->length, store->file) != object->length) {
+        g_warning ("Unable to read %s from store %s", object->index_key, store->path);
+        g_free (body);
+        return NULL;
+    }
+
+    doc = xmlReadMemory (body, object->length, NULL, NULL, XML_PARSE_NOBLANKS);
+    g_free (body);
+
+    if (doc == NULL)
+        return NULL;
+
+    cache_object (store, object, doc);
+    return xmlDocGetRootElement (xmlCopyDoc (doc, 1));
+}
+
+/*
+    Returns the XML saved for the given object, to be freed with xmlFreeDoc(), or NULL if it is
+    not in the store or older than @max_age seconds. The XML is a copy of the one in the cache,
+    so it may be modified by the caller
+*/
+xmlNode* ogd_store_get_object (OGDStore *store, GType type, const gchar *id, guint max_age)
+{
+    gchar *key;
+    StoredObject *object;
+
+    key = object_index_key (g_type_name (type), id);
+    object = g_hash_table_lookup (store->objects, key);
+    g_free (key);
+
+    if (object == NULL || is_fresh (object->fetched, max_age) == FALSE)
+        return NULL;
+
+    return read_object (store, object);
+}
+
+/*
+    Saves the list of objects received for @query: all of them are expected to be already saved
+    with ogd_store_put_object()
+*/
+void ogd_store_put_query (OGDStore *store, const gchar *query, gulong total, GList *objects)
+{
+    const gchar *id;
+    GList *iter;
+    StoredQuery *stored;
+
+    stored = g_new0 (StoredQuery, 1);
+    stored->fetched = now_seconds ();
+    stored->total = total;
+
+    for (iter = objects; iter; iter = g_list_next (iter)) {
+        id = ogd_object_get_id (iter->data);
+
+        /*
+            A list with objects which cannot be referenced could not be rebuilt
+        */
+        if (id == NULL) {
+            free_stored_query (stored);
+            return;
+        }
+
+        stored->objects = g_list_prepend (stored->objects, object_index_key (G_OBJECT_TYPE_NAME (iter->data), id));
+    }
+
+    stored->objects = g_list_reverse (stored->objects);
+
+    fseek (store->file, 0, SEEK_END);
+    write_query (store->file, query, stored);
+    fflush (store->file);
+
+    index_query (store, query, stored);
+}
+
+/*
+    If the result of @query is in the store and not older than @max_age seconds, @total is filled
+    with the total number of items declared by the server and @keys with a list of OGDStoreKey
+    for the objects, in order. The list has to be freed, but not its elements, which are valid
+    until the store is modified
+*/
+gboolean ogd_store_get_query (OGDStore *store, const gchar *query, guint max_age, gulong *total, GList **keys)
+{
+    GList *iter;
+    StoredQuery *stored;
+    StoredObject *object;
+
+    stored = g_hash_table_lookup (store->queries, query);
+    if (stored == NULL || is_fresh (stored->fetched, max_age) == FALSE)
+        return FALSE;
+
+    *keys = NULL;
+
+    for (iter = stored->objects; iter; iter = g_list_next (iter)) {
+        object = g_hash_table_lookup (store->objects, iter->data);
+
+        if (object == NULL) {
+            g_list_free (*keys);
+            *keys = NULL;
+            return FALSE;
+        }
+
+        *keys = g_list_prepend (*keys, &(object->key));
+    }
+
+    *keys = g_list_reverse (*keys);
+
+    if (total != NULL)
+        *total = stored->total;
+
+    return TRUE;
+}
+
+static gint compare_objects_descending (gconstpointer a, gconstpointer b, gpointer userdata)
+{
+    OGD_PROVIDER_STORE_ORDER order;
+
+    order = GPOINTER_TO_INT (userdata);
+
+    if (order == OGD_STORE_ORDER_CHANGED)
+        return compare_by_changed (*(StoredObject**) b, *(StoredObject**) a, NULL);
+    else
+        return compare_by_score (*(StoredObject**) b, *(StoredObject**) a, NULL);
+}
+
+static inline gboolean object_matches (StoredObject *object, GType type, const gchar *category, const gchar *author)
+{
+    if (type != 0 && object->key.type != type)
+        return FALSE;
+
+    if (category != NULL && (object->category == NULL || strcmp (object->category, category) != 0))
+        return FALSE;
+
+    if (author != NULL && (object->author == NULL || strcmp (object->author, author) != 0))
+        return FALSE;
+
+    return TRUE;
+}
+
+static GList* keys_from_array (GPtrArray *array, guint limit)
+{
+    guint i;
+    GList *ret;
+    StoredObject *object;
+
+    ret = NULL;
+
+    for (i = 0; i < array->len && (limit == 0 || i < limit); i++) {
+        object = g_ptr_array_index (array, i);
+        ret = g_list_prepend (ret, &(object->key));
+    }
+
+    return g_list_reverse (ret);
+}
+
+/*
+    When filtering by category or author the smallest set is scanned, otherwise the requested
+    order is walked from the top, stopping once @limit objects are found. Returns a list of
+    OGDStoreKey as ogd_store_get_query()
+*/
+GList* ogd_store_find (OGDStore *store, GType type, const gchar *category, const gchar *author,
+                       OGD_PROVIDER_STORE_ORDER order, guint limit)
+{
+    guint found;
+    GList *ret;
+    GHashTable *set;
+    GHashTable *other;
+    GHashTableIter iter;
+    GPtrArray *candidates;
+    GSequenceIter *cursor;
+    StoredObject *object;
+
+    if (category == NULL && author == NULL && order != OGD_STORE_ORDER_NONE) {
+        ret = NULL;
+        found = 0;
+        cursor = g_sequence_get_end_iter (order == OGD_STORE_ORDER_CHANGED ? store->by_changed : store->by_score);
+
+        while (g_sequence_iter_is_begin (cursor) == FALSE && (limit == 0 || found < limit)) {
+            cursor = g_sequence_iter_prev (cursor);
+            object = g_sequence_get (cursor);
+
+            if (object_matches (object, type, NULL, NULL)) {
+                ret = g_list_prepend (ret, &(object->key));
+                found++;
+            }
+        }
+
+        return g_list_reverse (ret);
+    }
+
+    if (category != NULL || author != NULL) {
+        set = (category != NULL) ? g_hash_table_lookup (store->by_category, category) : NULL;
+        other = (author != NULL) ? g_hash_table_lookup (store->by_author, author) : NULL;
+
+        if ((category != NULL && set == NULL) || (author != NULL && other == NULL))
+            return NULL;
+
+        if (set == NULL || (other != NULL && g_hash_table_size (other) < g_hash_table_size (set)))
+            set = other;
+    }
+    else {
+        set = store->objects;
+    }
+
+    candidates = g_ptr_array_new ();
+    g_hash_table_iter_init (&iter, set);
+
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer*) &object))
+        if (object_matches (object, type, category, author))
+            g_ptr_array_add (candidates, object);
+
+    if (order != OGD_STORE_ORDER_NONE)
+        g_ptr_array_sort_with_data (candidates, compare_objects_descending, GINT_TO_POINTER (order));
+
+    ret = keys_from_array (candidates, limit);
+    g_ptr_array_free (candidates, TRUE);
+    return ret;
+}
+
+/*
+    Rewrites the file with only the last record for each object and query. The new file is
+    written aside and then moved in place of the old one, so an interrupted compaction leaves the
+    store untouched
+*/
+gboolean ogd_store_compact (OGDStore *store, GError **error)
+{
+    gchar *temp_path;
+    gchar *body;
+    FILE *output;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    GList *objects;
+    GList *offsets;
+    GList *cursor;
+    GList *offset_cursor;
+    StoredObject *object;
+
+    temp_path = g_strdup_printf ("%s.compact", store->path);
+    output = fopen (temp_path, "wb");
+
+    if (output == NULL) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to compact store %s: %s", store->path, g_strerror (errno));
+        g_free (temp_path);
+        return FALSE;
+    }
+
+    fputs (STORE_SIGNATURE, output);
+
+    /*
+        Offsets in the new file are applied only once it is in place
+    */
+    objects = g_hash_table_get_values (store->objects);
+    offsets = NULL;
+
+    for (cursor = objects; cursor; cursor = g_list_next (cursor)) {
+        object = cursor->data;
+
+        body = g_malloc (object->length);
+        fseek (store->file, object->offset, SEEK_SET);
+
+        if (fread (body, 1, object->length, store->file) != object->length) {
+            g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_IO, "Unable to read %s from store %s",
+                         object->index_key, store->path);
+            g_free (body);
+            break;
+        }
+
+        write_object_header (output, object);
+        offsets = g_list_prepend (offsets, GSIZE_TO_POINTER ((gsize) ftell (output)));
+        fwrite (body, 1, object->length, output);
+        fputc ('\n', output);
+        g_free (body);
+    }
+
+    offsets = g_list_reverse (offsets);
+
+    if (cursor == NULL) {
+        g_hash_table_iter_init (&iter, store->queries);
+
+        while (g_hash_table_iter_next (&iter, &key, &value))
+            write_query (output, key, value);
+    }
+
+    if (fclose (output) != 0 || cursor != NULL || g_rename (temp_path, store->path) != 0) {
+        if (cursor == NULL)
+            g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                         "Unable to compact store %s: %s", store->path, g_strerror (errno));
+
+        g_unlink (temp_path);
+        g_list_free (offsets);
+        g_list_free (objects);
+        g_free (temp_path);
+        return FALSE;
+    }
+
+    for (cursor = objects, offset_cursor = offsets; cursor; cursor = g_list_next (cursor), offset_cursor = g_list_next (offset_cursor))
+        ((StoredObject*) cursor->data)->offset = (glong) GPOINTER_TO_SIZE (offset_cursor->data);
+
+    fclose (store->file);
+    store->file = fopen (store->path, "a+b");
+    store->garbage = 0;
+
+    g_list_free (offsets);
+    g_list_free (objects);
+    g_free (temp_path);
+
+    if (store->file == NULL) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to open store %s: %s", store->path, g_strerror (errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
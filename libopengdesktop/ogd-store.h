@@ -0,0 +1,43 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_STORE_H
+#define OGD_STORE_H
+
+#include "ogd-provider-private.h"
+
+typedef struct _OGDStore OGDStore;
+
+typedef struct {
+    GType           type;
+    const gchar     *id;
+} OGDStoreKey;
+
+OGDStore*       ogd_store_open                      (const gchar *path, GError **error);
+void            ogd_store_free                      (OGDStore *store);
+gboolean        ogd_store_compact                   (OGDStore *store, GError **error);
+
+void            ogd_store_put_object                (OGDStore *store, OGDObject *obj, const xmlNode *xml);
+xmlNode*        ogd_store_get_object                (OGDStore *store, GType type, const gchar *id, guint max_age);
+
+void            ogd_store_put_query                 (OGDStore *store, const gchar *query, gulong total, GList *objects);
+gboolean        ogd_store_get_query                 (OGDStore *store, const gchar *query, guint max_age, gulong *total, GList **keys);
+
+GList*          ogd_store_find                      (OGDStore *store, GType type, const gchar *category, const gchar *author,
+                                                     OGD_PROVIDER_STORE_ORDER order, guint limit);
+
+#endif /* OGD_STORE_H */
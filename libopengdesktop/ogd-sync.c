@@ -0,0 +1,297 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-sync.h"
+#include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
+
+/**
+ * SECTION: ogd-sync
+ * @short_description:  incremental synchronization of the contents of categories
+ *
+ * An #OGDSync keeps a local copy of some categories up to date fetching only the contents changed
+ * since the previous synchronization. For each category it remembers a watermark, the most
+ * recent time of change seen, optionally saved in a file to be reused by the next run of the
+ * application. Contents are requested from the newest, and pages stop being requested as soon as
+ * a content older than the watermark is found, so the cost of a synchronization depends on the
+ * number of contents changed and not on the size of the category. The first synchronization of a
+ * category, with no watermark, fetches all its contents.
+ * This relies on the server sorting contents by date of change with the
+ * %OGD_CATEGORY_SORT_NEWEST mode, and on the change date reported for each content: contents
+ * without it are always passed to the #OGDSyncUpsertCallback
+ */
+
+#define SYNC_PAGE_SIZE          100
+#define WATERMARKS_GROUP        "watermarks"
+
+struct _OGDSync {
+    OGDProvider     *provider;
+    gchar           *state_path;
+    GKeyFile        *state;
+};
+
+typedef struct {
+    OGDSync                 *sync;
+    gchar                   *category;
+    gint64                  watermark;
+
+    OGDSyncUpsertCallback   upsert;
+    OGDSyncDoneCallback     done;
+    gpointer                userdata;
+} SyncRun;
+
+static gboolean content_change_time (OGDObject *obj, gint64 *time);
+static void upsert_content (OGDObject *obj, gpointer userdata);
+static void finish_run (gpointer userdata, gint64 newest, gulong changed, const GError *error);
+
+static const OGDChangesFeed ContentsFeed = {
+    SYNC_PAGE_SIZE, content_change_time, upsert_content, finish_run
+};
+
+/**
+ * ogd_sync_new:
+ * @provider:       the #OGDProvider from which contents are fetched
+ * @state_path:     path of the file in which watermarks are saved, or %NULL to keep them only in
+ *                  memory
+ *
+ * To create a new #OGDSync. If @state_path already exists, watermarks saved by a previous
+ * #OGDSync are loaded from it
+ *
+ * Return value:    a newly allocated #OGDSync, to be freed with ogd_sync_free()
+ */
+OGDSync* ogd_sync_new (OGDProvider *provider, const gchar *state_path)
+{
+    GError *error;
+    OGDSync *sync;
+
+    sync = g_new0 (OGDSync, 1);
+    sync->provider = provider;
+    sync->state_path = g_strdup (state_path);
+    sync->state = g_key_file_new ();
+
+    if (state_path != NULL && g_file_test (state_path, G_FILE_TEST_EXISTS) == TRUE) {
+        error = NULL;
+
+        if (g_key_file_load_from_file (sync->state, state_path, G_KEY_FILE_NONE, &error) == FALSE) {
+            g_warning ("Unable to load synchronization state from %s: %s", state_path, error->message);
+            g_error_free (error);
+        }
+    }
+
+    return sync;
+}
+
+/**
+ * ogd_sync_free:
+ * @sync:           the #OGDSync to free
+ *
+ * Frees an #OGDSync. Must not be called while a synchronization started with
+ * ogd_sync_category_async() is still running
+ */
+void ogd_sync_free (OGDSync *sync)
+{
+    g_key_file_free (sync->state);
+    g_free (sync->state_path);
+    g_free (sync);
+}
+
+static void save_state (OGDSync *sync)
+{
+    gchar *data;
+    gsize length;
+    GError *error;
+
+    if (sync->state_path == NULL)
+        return;
+
+    error = NULL;
+    data = g_key_file_to_data (sync->state, &length, NULL);
+
+    if (g_file_set_contents (sync->state_path, data, length, &error) == FALSE) {
+        g_warning ("Unable to save synchronization state to %s: %s", sync->state_path, error->message);
+        g_error_free (error);
+    }
+
+    g_free (data);
+}
+
+/**
+ * ogd_sync_get_watermark:
+ * @sync:           the #OGDSync to query
+ * @category:       ID of the category
+ *
+ * To know up to when a category has been synchronized
+ *
+ * Return value:    the most recent time of change seen for contents of @category, in seconds
+ *                  since the Epoch, or 0 if the category has never been synchronized
+ */
+gint64 ogd_sync_get_watermark (OGDSync *sync, const gchar *category)
+{
+    gint64 ret;
+    gchar *value;
+
+    value = g_key_file_get_string (sync->state, WATERMARKS_GROUP, category, NULL);
+    if (value == NULL)
+        return 0;
+
+    ret = g_ascii_strtoll (value, NULL, 10);
+    g_free (value);
+    return ret;
+}
+
+/**
+ * ogd_sync_set_watermark:
+ * @sync:           the #OGDSync to modify
+ * @category:       ID of the category
+ * @watermark:      new watermark for @category, in seconds since the Epoch
+ *
+ * To explicitely set up to when a category has been synchronized, for example to 0 when the
+ * local copy has been lost and all contents have to be fetched again. The new value is
+ * immediately saved, if the #OGDSync has a file for its state
+ */
+void ogd_sync_set_watermark (OGDSync *sync, const gchar *category, gint64 watermark)
+{
+    gchar *value;
+
+    value = g_strdup_printf ("%" G_GINT64_FORMAT, watermark);
+    g_key_file_set_string (sync->state, WATERMARKS_GROUP, category, value);
+    g_free (value);
+    save_state (sync);
+}
+
+static SyncRun* new_run (OGDSync *sync, OGDCategory *category, OGDSyncUpsertCallback upsert,
+                         OGDSyncDoneCallback done, gpointer userdata)
+{
+    SyncRun *run;
+
+    run = g_new0 (SyncRun, 1);
+    run->sync = sync;
+    run->category = g_strdup (ogd_category_get_id (category));
+    run->watermark = ogd_sync_get_watermark (sync, run->category);
+    run->upsert = upsert;
+    run->done = done;
+    run->userdata = userdata;
+    return run;
+}
+
+static gchar* run_query (SyncRun *run)
+{
+    return g_strdup_printf ("content/data?categories=%s&sortmode=new", run->category);
+}
+
+static gboolean content_change_time (OGDObject *obj, gint64 *time)
+{
+    if (IS_OGD_CONTENT (obj) == FALSE)
+        return FALSE;
+
+    *time = ogd_content_get_change_time (OGD_CONTENT (obj));
+    return TRUE;
+}
+
+static void upsert_content (OGDObject *obj, gpointer userdata)
+{
+    SyncRun *run;
+
+    run = (SyncRun*) userdata;
+    TRACED_CALLBACK ("callback", run->upsert (OGD_CONTENT (obj), run->userdata));
+}
+
+static void finish_run (gpointer userdata, gint64 newest, gulong changed, const GError *error)
+{
+    SyncRun *run;
+
+    run = (SyncRun*) userdata;
+
+    if (error == NULL && newest > run->watermark)
+        ogd_sync_set_watermark (run->sync, run->category, newest);
+
+    if (run->done != NULL) {
+        TRACED_CALLBACK ("callback", run->done (run->sync, run->category, changed, error, run->userdata));
+    }
+
+    g_free (run->category);
+    g_free (run);
+}
+
+/**
+ * ogd_sync_category:
+ * @sync:           the #OGDSync used to synchronize
+ * @category:       the #OGDCategory to synchronize
+ * @upsert:         callback invoked for each content created or changed since the previous
+ *                  synchronization
+ * @userdata:       the user data for @upsert
+ * @changed:        if not %NULL, filled with the number of contents passed to @upsert
+ * @error:          a #GError filled if the function returns %FALSE
+ *
+ * Fetches the contents of @category changed since the previous synchronization, and updates its
+ * watermark. If one of the requests fails the watermark is not changed, but contents already
+ * received have been passed to @upsert anyway
+ *
+ * Return value:    %TRUE if the synchronization completed, %FALSE otherwise
+ */
+gboolean ogd_sync_category (OGDSync *sync, OGDCategory *category, OGDSyncUpsertCallback upsert,
+                            gpointer userdata, gulong *changed, GError **error)
+{
+    gint64 newest;
+    gulong count;
+    gchar *query;
+    GError *page_error;
+    SyncRun *run;
+
+    run = new_run (sync, category, upsert, NULL, userdata);
+    query = run_query (run);
+    page_error = NULL;
+    fetch_changes (sync->provider, query, &ContentsFeed, run->watermark, run, &newest, &count, &page_error);
+    g_free (query);
+
+    if (changed != NULL)
+        *changed = count;
+
+    finish_run (run, newest, count, page_error);
+
+    if (page_error != NULL) {
+        g_propagate_error (error, page_error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * ogd_sync_category_async:
+ * @sync:           the #OGDSync used to synchronize
+ * @category:       the #OGDCategory to synchronize
+ * @upsert:         callback invoked for each content created or changed since the previous
+ *                  synchronization
+ * @done:           callback invoked at the end of the synchronization, or %NULL
+ * @userdata:       the user data for the callbacks
+ *
+ * Async version of ogd_sync_category(). Pages are requested one after the other, with
+ * %OGD_PROVIDER_PRIORITY_BULK priority
+ */
+void ogd_sync_category_async (OGDSync *sync, OGDCategory *category, OGDSyncUpsertCallback upsert,
+                              OGDSyncDoneCallback done, gpointer userdata)
+{
+    gchar *query;
+    SyncRun *run;
+
+    run = new_run (sync, category, upsert, done, userdata);
+    query = run_query (run);
+    fetch_changes_async (sync->provider, query, &ContentsFeed, run->watermark, run);
+    g_free (query);
+}
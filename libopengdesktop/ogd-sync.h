@@ -0,0 +1,65 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_SYNC_H
+#define OGD_SYNC_H
+
+G_BEGIN_DECLS
+
+#include "ogd-category.h"
+#include "ogd-content.h"
+
+typedef struct _OGDSync OGDSync;
+
+/**
+ * OGDSyncUpsertCallback:
+ * @content:        an #OGDContent created or changed since the previous synchronization
+ * @userdata:       the user data passed with the callback
+ *
+ * Invoked by an #OGDSync for each content to insert or update in the local copy. The same content
+ * may be passed more than once, also in different synchronizations, so the update has to be
+ * idempotent. @content is unref'd after the callback, which has to take its own reference to
+ * keep it
+ */
+typedef void (*OGDSyncUpsertCallback) (OGDContent *content, gpointer userdata);
+
+/**
+ * OGDSyncDoneCallback:
+ * @sync:           the #OGDSync which has completed the synchronization
+ * @category:       ID of the synchronized category
+ * @changed:        number of contents passed to the #OGDSyncUpsertCallback
+ * @error:          the reason of the failure, or %NULL if the synchronization succeeded
+ * @userdata:       the user data passed with the callback
+ *
+ * Invoked by ogd_sync_category_async() at the end of the synchronization of a category
+ */
+typedef void (*OGDSyncDoneCallback) (OGDSync *sync, const gchar *category, gulong changed, const GError *error, gpointer userdata);
+
+OGDSync*        ogd_sync_new                        (OGDProvider *provider, const gchar *state_path);
+void            ogd_sync_free                       (OGDSync *sync);
+
+gint64          ogd_sync_get_watermark              (OGDSync *sync, const gchar *category);
+void            ogd_sync_set_watermark              (OGDSync *sync, const gchar *category, gint64 watermark);
+
+gboolean        ogd_sync_category                   (OGDSync *sync, OGDCategory *category, OGDSyncUpsertCallback upsert,
+                                                     gpointer userdata, gulong *changed, GError **error);
+void            ogd_sync_category_async             (OGDSync *sync, OGDCategory *category, OGDSyncUpsertCallback upsert,
+                                                     OGDSyncDoneCallback done, gpointer userdata);
+
+G_END_DECLS
+
+#endif /* OGD_SYNC_H */
@@ -0,0 +1,37 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_TRACING_PRIVATE_H
+#define OGD_TRACING_PRIVATE_H
+
+#include "ogd.h"
+
+#define TRACED_CALLBACK(__name, __call) {       \
+    ogd_tracing_begin ("callback", __name);     \
+    __call;                                     \
+    ogd_tracing_end ("callback", __name);       \
+}
+
+void            ogd_tracing_check_environment       ();
+
+void            ogd_tracing_begin                   (const gchar *category, const gchar *name);
+void            ogd_tracing_end                     (const gchar *category, const gchar *name);
+void            ogd_tracing_request_begin           (SoupMessage *msg, gboolean async, gpointer operation);
+void            ogd_tracing_request_end             (SoupMessage *msg, gboolean async);
+gpointer        ogd_tracing_set_operation           (gpointer operation);
+
+#endif /* OGD_TRACING_PRIVATE_H */
@@ -0,0 +1,252 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "ogd.h"
+#include "ogd-tracing.h"
+#include "ogd-tracing-private.h"
+#include "ogd-private-utils.h"
+
+/**
+ * SECTION: ogd-tracing
+ * @short_description:  record library activity in a trace file
+ *
+ * When tracing is enabled every HTTP request, every parsing of a response, every fill_by_xml()
+ * of an #OGDObject and every invocation of a callback is written as a span in a file, using the
+ * JSON format of Chrome's tracing tool: the file may be opened with chrome://tracing or with
+ * Perfetto UI, to see how async operations fan out in many requests and where time is spent.
+ * Async requests are drawn as separate tracks, and each of them carries the identifier of the
+ * operation which issued it (e.g. an #OGDIterator fetching its pages), as do spans produced
+ * handling its response.
+ *
+ * Tracing may be enabled with ogd_tracing_start(), or setting the environment variable OGD_TRACE
+ * to the path of the file to write before the first #OGDProvider is created. In the latter case
+ * the file is completed when the process exits
+ */
+
+#define REQUEST_ID_KEY          "ogd-tracing-request-id"
+
+static FILE         *TraceFile          = NULL;
+static gint64       TraceStart          = 0;
+static guint        RequestsCounter     = 0;
+static gpointer     CurrentOperation    = NULL;
+
+static gulong current_thread ()
+{
+    if (g_thread_supported ())
+        return (gulong) g_thread_self ();
+    else
+        return 1;
+}
+
+/*
+    Params:
+        phase:      one of the event types of the trace format: "B" and "E" delimit a span in the
+                    current thread, "b" and "e" an async span identified by @id
+        id:         identifier of the async span, ignored for other phases
+        args:       comma separated list of JSON members, or NULL
+*/
+static void write_event (const gchar *category, const gchar *name, const gchar *phase, guint id, const gchar *args)
+{
+    fprintf (TraceFile, ",\n{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%" G_GINT64_FORMAT ",\"pid\":%d,\"tid\":%lu",
+             category, name, phase, current_usec () - TraceStart, getpid (), current_thread ());
+
+    if (phase [0] == 'b' || phase [0] == 'e')
+        fprintf (TraceFile, ",\"id\":%u", id);
+
+    if (args != NULL)
+        fprintf (TraceFile, ",\"args\":{%s}", args);
+
+    fputs ("}", TraceFile);
+}
+
+/**
+ * ogd_tracing_start:
+ * @path:           path of the file to write. If it exists it is overwritten
+ * @error:          a #GError filled if the function returns %FALSE
+ *
+ * Starts writing a trace of the activity of the library. If a trace is already being written,
+ * it is completed before opening the new one
+ *
+ * Return value:    %TRUE if the file has been opened, %FALSE otherwise
+ */
+gboolean ogd_tracing_start (const gchar *path, GError **error)
+{
+    FILE *file;
+
+    file = fopen (path, "w");
+    if (file == NULL) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Unable to open trace file %s: %s", path, g_strerror (errno));
+        return FALSE;
+    }
+
+    ogd_tracing_stop ();
+
+    TraceFile = file;
+    TraceStart = current_usec ();
+
+    /*
+        The first event only names the process, so all others may be written with a leading comma
+    */
+    fprintf (TraceFile, "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"libopengdesktop\"}}",
+             getpid ());
+    return TRUE;
+}
+
+/**
+ * ogd_tracing_stop:
+ *
+ * Completes and closes the trace file opened by ogd_tracing_start(), if any
+ */
+void ogd_tracing_stop ()
+{
+    if (TraceFile == NULL)
+        return;
+
+    fputs ("\n]\n", TraceFile);
+    fclose (TraceFile);
+    TraceFile = NULL;
+}
+
+/*
+    Invoked when the first OGDProvider is inited. The trace format tolerates a missing closing
+    bracket, and the file is flushed by exit(), so the trace started here is never explicitely
+    stopped
+*/
+void ogd_tracing_check_environment ()
+{
+    const gchar *path;
+    GError *error;
+
+    path = g_getenv ("OGD_TRACE");
+    if (path == NULL || *path == '\0' || TraceFile != NULL)
+        return;
+
+    error = NULL;
+
+    if (ogd_tracing_start (path, &error) == FALSE) {
+        g_warning ("%s", error->message);
+        g_error_free (error);
+    }
+}
+
+static gchar* operation_args ()
+{
+    if (CurrentOperation == NULL)
+        return NULL;
+    else
+        return g_strdup_printf ("\"operation\":\"%p\"", CurrentOperation);
+}
+
+void ogd_tracing_begin (const gchar *category, const gchar *name)
+{
+    gchar *args;
+
+    if (TraceFile == NULL)
+        return;
+
+    args = operation_args ();
+    write_event (category, name, "B", 0, args);
+    g_free (args);
+}
+
+void ogd_tracing_end (const gchar *category, const gchar *name)
+{
+    if (TraceFile == NULL)
+        return;
+
+    write_event (category, name, "E", 0, NULL);
+}
+
+/*
+    Params:
+        async:      %TRUE if the message is sent by the async session, so the span has to be drawn
+                    in its own track
+        operation:  pointer identifying the operation which issued the request, or NULL
+*/
+void ogd_tracing_request_begin (SoupMessage *msg, gboolean async, gpointer operation)
+{
+    guint id;
+    gchar *name;
+    gchar *query;
+    gchar *args;
+    SoupURI *uri;
+
+    if (TraceFile == NULL)
+        return;
+
+    id = ++RequestsCounter;
+    g_object_set_data (G_OBJECT (msg), REQUEST_ID_KEY, GUINT_TO_POINTER (id));
+
+    uri = soup_message_get_uri (msg);
+    name = g_strdup_printf ("%s %s", msg->method, uri->path);
+    query = g_strescape (uri->query != NULL ? uri->query : "", NULL);
+
+    if (operation != NULL)
+        args = g_strdup_printf ("\"request\":%u,\"operation\":\"%p\",\"query\":\"%s\"", id, operation, query);
+    else
+        args = g_strdup_printf ("\"request\":%u,\"query\":\"%s\"", id, query);
+
+    write_event ("http", name, async ? "b" : "B", id, args);
+
+    g_free (args);
+    g_free (query);
+    g_free (name);
+}
+
+void ogd_tracing_request_end (SoupMessage *msg, gboolean async)
+{
+    guint id;
+    gchar *name;
+    gchar *args;
+
+    if (TraceFile == NULL)
+        return;
+
+    /*
+        Tracing may have been enabled while the request was running
+    */
+    id = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (msg), REQUEST_ID_KEY));
+    if (id == 0)
+        return;
+
+    name = g_strdup_printf ("%s %s", msg->method, soup_message_get_uri (msg)->path);
+    args = g_strdup_printf ("\"status\":%u,\"bytes\":%" G_GOFFSET_FORMAT, msg->status_code,
+                            msg->response_body != NULL ? msg->response_body->length : (goffset) 0);
+
+    write_event ("http", name, async ? "e" : "E", id, args);
+
+    g_free (args);
+    g_free (name);
+}
+
+/*
+    Sets the operation to which spans generated from now on belong, and returns the previous one
+    so it can be restored when done
+*/
+gpointer ogd_tracing_set_operation (gpointer operation)
+{
+    gpointer ret;
+
+    ret = CurrentOperation;
+    CurrentOperation = operation;
+    return ret;
+}
@@ -0,0 +1,315 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ogd.h"
+#include "ogd-write-queue.h"
+#include "ogd-provider-private.h"
+#include "ogd-private-utils.h"
+#include "ogd-tracing-private.h"
+
+/*
+    The write queue collects the editing operations issued by bulk tools (votes, fans, comments)
+    without blocking the caller. Operations pushed in the same iteration of the main loop are
+    dispatched together from an idle callback, and at most as many are passed at the same time to
+    the scheduler as permitted by the queue's limit: they travel pipelined on the pooled
+    connections of the async session, while the others wait here. While an operation is still
+    waiting, a new one with the same key (e.g. the fan status or the vote of a given content)
+    replaces it, since the final state on the server is the same: only one request is sent, and
+    the callbacks of both operations receive its result
+*/
+
+#define DEFAULT_WRITE_LIMIT         4
+
+typedef struct {
+    OGDPutAsyncCallback     callback;
+    gpointer                userdata;
+} WriteWaiter;
+
+typedef struct {
+    OGDWriteQueue           *queue;
+    gchar                   *key;
+    gchar                   *query;
+    GHashTable              *data;
+    GList                   *waiters;
+} PendingWrite;
+
+struct _OGDWriteQueue {
+    OGDProvider             *provider;
+    GQueue                  *pending;
+    GHashTable              *pending_by_key;
+    GList                   *running;
+    guint                   limit;
+    guint                   failed;
+    guint                   idle;
+    gboolean                closed;
+};
+
+/*
+    Each OGDProvider owns one write queue, which pushes requests on its scheduler. Free it with
+    ogd_write_queue_free()
+*/
+OGDWriteQueue* ogd_write_queue_new (OGDProvider *provider)
+{
+    OGDWriteQueue *queue;
+
+    queue = g_new0 (OGDWriteQueue, 1);
+    queue->provider = provider;
+    queue->pending = g_queue_new ();
+    queue->pending_by_key = g_hash_table_new (g_str_hash, g_str_equal);
+    queue->limit = DEFAULT_WRITE_LIMIT;
+    return queue;
+}
+
+static void free_write (PendingWrite *write)
+{
+    g_free (write->key);
+    g_free (write->query);
+
+    if (write->data != NULL)
+        g_hash_table_unref (write->data);
+
+    g_list_foreach (write->waiters, (GFunc) g_free, NULL);
+    g_list_free (write->waiters);
+    g_free (write);
+}
+
+/*
+    Stops dispatching operations. The ones already passed to the scheduler are detached from the
+    queue, and their callbacks are still invoked when the scheduler completes or aborts them; the
+    ones still waiting stay in queue until ogd_write_queue_free()
+*/
+void ogd_write_queue_close (OGDWriteQueue *queue)
+{
+    GList *iter;
+    PendingWrite *write;
+
+    if (queue->closed == TRUE)
+        return;
+
+    queue->closed = TRUE;
+
+    if (queue->idle != 0) {
+        g_source_remove (queue->idle);
+        queue->idle = 0;
+    }
+
+    for (iter = queue->running; iter; iter = g_list_next (iter)) {
+        write = (PendingWrite*) iter->data;
+        write->queue = NULL;
+    }
+
+    g_list_free (queue->running);
+    queue->running = NULL;
+}
+
+/*
+    Closes the queue, if not already done. Operations still waiting in queue are saved in the
+    journal of the provider, if any, and their callbacks are invoked as failed. To keep the order
+    of writes, call it after the scheduler has aborted the operations it holds
+*/
+void ogd_write_queue_free (OGDWriteQueue *queue)
+{
+    GList *iter;
+    WriteWaiter *waiter;
+    PendingWrite *write;
+
+    ogd_write_queue_close (queue);
+
+    while ((write = g_queue_pop_head (queue->pending)) != NULL) {
+        ogd_provider_journal_put (queue->provider, write->query, write->data);
+
+        for (iter = write->waiters; iter; iter = g_list_next (iter)) {
+            waiter = (WriteWaiter*) iter->data;
+
+            if (waiter->callback != NULL) {
+                TRACED_CALLBACK ("callback", waiter->callback (FALSE, waiter->userdata));
+            }
+        }
+
+        free_write (write);
+    }
+
+    g_queue_free (queue->pending);
+    g_hash_table_destroy (queue->pending_by_key);
+    g_free (queue);
+}
+
+static GHashTable* copy_params (GHashTable *data)
+{
+    gpointer key;
+    gpointer value;
+    GHashTable *ret;
+    GHashTableIter iter;
+
+    if (data == NULL)
+        return NULL;
+
+    ret = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    g_hash_table_iter_init (&iter, data);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+        g_hash_table_insert (ret, g_strdup (key), g_strdup (value));
+
+    return ret;
+}
+
+static void dispatch_writes (OGDWriteQueue *queue);
+
+static void write_completed (gboolean successfull, gpointer userdata)
+{
+    GList *iter;
+    WriteWaiter *waiter;
+    PendingWrite *write;
+    OGDWriteQueue *queue;
+
+    write = (PendingWrite*) userdata;
+    queue = write->queue;
+
+    for (iter = write->waiters; iter; iter = g_list_next (iter)) {
+        waiter = (WriteWaiter*) iter->data;
+
+        if (waiter->callback != NULL) {
+            TRACED_CALLBACK ("callback", waiter->callback (successfull, waiter->userdata));
+        }
+    }
+
+    if (queue != NULL) {
+        queue->running = g_list_remove (queue->running, write);
+        if (successfull == FALSE)
+            queue->failed++;
+    }
+
+    free_write (write);
+
+    if (queue != NULL)
+        dispatch_writes (queue);
+}
+
+static void dispatch_writes (OGDWriteQueue *queue)
+{
+    PendingWrite *write;
+
+    while (g_list_length (queue->running) < queue->limit) {
+        write = g_queue_pop_head (queue->pending);
+        if (write == NULL)
+            break;
+
+        /*
+            Once sent the operation can no longer be replaced: a new one with the same key will be
+            enqueued again, and sent after this one
+        */
+        if (write->key != NULL)
+            g_hash_table_remove (queue->pending_by_key, write->key);
+
+        queue->running = g_list_prepend (queue->running, write);
+        ogd_provider_put_async_full (queue->provider, write->query, write->data, OGD_PROVIDER_PRIORITY_NORMAL,
+                                     queue, write_completed, write);
+    }
+}
+
+static gboolean dispatch_idle (gpointer userdata)
+{
+    OGDWriteQueue *queue;
+
+    queue = (OGDWriteQueue*) userdata;
+    queue->idle = 0;
+    dispatch_writes (queue);
+    return FALSE;
+}
+
+/*
+    Enqueues a POST of @query with @data, both copied. If @key is not NULL and another operation
+    with the same key is still waiting in queue, that one is replaced by the new one. @callback is
+    invoked when the request is completed, and never before this function returns
+*/
+void ogd_write_queue_push (OGDWriteQueue *queue, const gchar *key, gchar *query, GHashTable *data,
+                           OGDPutAsyncCallback callback, gpointer userdata)
+{
+    WriteWaiter *waiter;
+    PendingWrite *write;
+
+    write = NULL;
+
+    if (key != NULL)
+        write = g_hash_table_lookup (queue->pending_by_key, key);
+
+    if (write != NULL) {
+        g_free (write->query);
+        if (write->data != NULL)
+            g_hash_table_unref (write->data);
+    }
+    else {
+        write = g_new0 (PendingWrite, 1);
+        write->queue = queue;
+        write->key = g_strdup (key);
+        g_queue_push_tail (queue->pending, write);
+
+        if (key != NULL)
+            g_hash_table_insert (queue->pending_by_key, write->key, write);
+    }
+
+    write->query = g_strdup (query);
+    write->data = copy_params (data);
+
+    waiter = g_new0 (WriteWaiter, 1);
+    waiter->callback = callback;
+    waiter->userdata = userdata;
+    write->waiters = g_list_append (write->waiters, waiter);
+
+    if (queue->idle == 0 && queue->closed == FALSE)
+        queue->idle = g_idle_add (dispatch_idle, queue);
+}
+
+/*
+    Sets the maximum number of operations passed to the scheduler at the same time. At least 1
+*/
+void ogd_write_queue_set_limit (OGDWriteQueue *queue, guint limit)
+{
+    queue->limit = MAX (limit, 1);
+    dispatch_writes (queue);
+}
+
+/*
+    Runs the default main context until all enqueued operations are completed. Returns FALSE, and
+    fills @error, if at least one of the operations completed since the previous flush has failed.
+    Must not be called from the callback of an enqueued operation
+*/
+gboolean ogd_write_queue_flush (OGDWriteQueue *queue, GError **error)
+{
+    guint failed;
+
+    if (queue->idle != 0) {
+        g_source_remove (queue->idle);
+        queue->idle = 0;
+    }
+
+    dispatch_writes (queue);
+
+    while (g_queue_is_empty (queue->pending) == FALSE || queue->running != NULL)
+        g_main_context_iteration (NULL, TRUE);
+
+    failed = queue->failed;
+    queue->failed = 0;
+
+    if (failed != 0) {
+        g_set_error (error, OGD_NETWORK_ERROR_DOMAIN, OGD_NETWORK_ERROR,
+                     "%u of the enqueued operations failed", failed);
+        return FALSE;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,34 @@
+/*  libopengdesktop
+ *  Copyright (C) 2009/2012 Roberto -MadBob- Guido <bob4job@gmail.com>
+ *
+ *  This is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGD_WRITE_QUEUE_H
+#define OGD_WRITE_QUEUE_H
+
+#include "ogd-provider-private.h"
+
+typedef struct _OGDWriteQueue OGDWriteQueue;
+
+OGDWriteQueue*  ogd_write_queue_new                 (OGDProvider *provider);
+void            ogd_write_queue_close               (OGDWriteQueue *queue);
+void            ogd_write_queue_free                (OGDWriteQueue *queue);
+
+void            ogd_write_queue_push                (OGDWriteQueue *queue, const gchar *key, gchar *query, GHashTable *data,
+                                                     OGDPutAsyncCallback callback, gpointer userdata);
+void            ogd_write_queue_set_limit           (OGDWriteQueue *queue, guint limit);
+gboolean        ogd_write_queue_flush               (OGDWriteQueue *queue, GError **error);
+
+#endif /* OGD_WRITE_QUEUE_H */
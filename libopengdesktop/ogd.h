@@ -29,15 +29,25 @@
 
 #include "ogd-errors.h"
 #include "ogd-provider.h"
+#include "ogd-columns.h"
 #include "ogd-iterator.h"
 #include "ogd-object.h"
 #include "ogd-person.h"
 #include "ogd-category.h"
 #include "ogd-content.h"
+#include "ogd-content-query.h"
+#include "ogd-sync.h"
+#include "ogd-snapshot.h"
 #include "ogd-activity.h"
+#include "ogd-activity-follower.h"
 #include "ogd-event.h"
+#include "ogd-event-index.h"
+#include "ogd-spatial-index.h"
 #include "ogd-folder.h"
 #include "ogd-message.h"
+#include "ogd-mailbox.h"
 #include "ogd-comment.h"
+#include "ogd-comment-tree.h"
+#include "ogd-tracing.h"
 
 #endif /* OGD_H */